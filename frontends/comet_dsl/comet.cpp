@@ -29,6 +29,7 @@
 #include "comet/Dialect/TensorAlgebra/Passes.h"
 #include "comet/Dialect/IndexTree/IR/ITDialect.h"
 #include "comet/Dialect/IndexTree/Passes.h"
+#include "comet/ExecutionEngine/GemmBlocking.h"
 #include "MLIRGen.h"
 #include "Parser.h"
 
@@ -112,18 +113,27 @@ static cl::opt<int> selectedPermNum("perm-num", cl::init(1),
 static cl::opt<bool> OptMatmulTiling("opt-matmul-tiling",
                                      cl::desc("Optimize LinAlg matmul operation with tiling"));
 
+static cl::opt<std::string> MatmulBlocking("matmul-blocking", cl::init("host"),
+                                           cl::desc("Blocking of --opt-matmul-tiling: host (derived from the caches of the host), haswell (BLIS Haswell), or MC,KC,NC"));
+
 static cl::opt<bool> OptCallToMatMulMicroKernel("opt-matmul-mkernel",
                                                 cl::desc("Replace the inner linalg.matmul that introduced after tiling with the blis micro kernel"));
 
 static cl::opt<bool> OptDenseTransposeOp("opt-dense-transpose",
                                          cl::desc("Optimize transpose operation: optimal loop ordering and tiling"));
 
+static cl::opt<bool> OptDenseTransposeLib("opt-dense-transpose-lib",
+                                          cl::desc("Replace dense transpose operations with calls to the blocked, multithreaded transpose of the runtime library"));
+
 // =============================================================================
 // Sparse kernel optimizations
 // =============================================================================
 static cl::opt<bool> OptWorkspace("opt-comp-workspace", cl::init(false),
                                   cl::desc("Optimize sparse output code generation while reducing iteration space for nonzero elements"));
 
+static cl::opt<bool> OptStreamPanels("opt-stream-panels", cl::init(false),
+                                     cl::desc("Stream the CSR input of SpMV/SpMM products in row panels, without reading the whole matrix"));
+
 // The details of the fusion algorithm can be found in the following paper.
 // ReACT: Redundancy-Aware Code Generation for Tensor Expressions.
 // Tong Zhou, Ruiqin Tian, Rizwan A Ashraf, Roberto Gioiosa, Gokcen Kestor, Vivek Sarkar.
@@ -252,6 +262,12 @@ int loadAndProcessMLIR(mlir::MLIRContext &context,
   optPM.addPass(mlir::tensorAlgebra::createPreLoweringPass()); // Creating tensor declarations for temporal tensors in chain operations
   //  =============================================================================
 
+  if (OptStreamPanels)
+  {
+    /// The streamed products are taken out of the TA dialect before they are lowered to the Index Tree dialect
+    optPM.addPass(mlir::tensorAlgebra::createStreamRowPanelsPass());
+  }
+
   // ===================================================================================
   // Lowering of TC (tensor contraction) operation to Index Tree dialect
   // Also performs optimization at the Index Tree dialect
@@ -307,19 +323,35 @@ int loadAndProcessMLIR(mlir::MLIRContext &context,
   // =============================================================================
   // Operation based optimizations
   // =============================================================================
-  if (OptDenseTransposeOp) // Optimize Dense Transpose operation
+  if (OptDenseTransposeOp || OptDenseTransposeLib) // Optimize Dense Transpose operation
   {
     // If it is a dense transpose ops, the rewrites rules replaces ta.transpose with linalg.copy, then
     /// Create a pass to optimize LinAlg Copy Op - follow in HPTT paper
     /// HPTT: A High-Performance Tensor Transposition C++ Library
     /// https://arxiv.org/abs/1704.04374
     optPM.addPass(mlir::tensorAlgebra::createTensorOpsLoweringPass());
-    optPM.addPass(mlir::tensorAlgebra::createOptDenseTransposePass());
+    // The library call takes the copies it supports (f32/f64, static permutations),
+    // and the loop optimization the others
+    if (OptDenseTransposeLib)
+      optPM.addPass(mlir::tensorAlgebra::createDenseTransposeLibraryCallPass());
+    if (OptDenseTransposeOp)
+      optPM.addPass(mlir::tensorAlgebra::createOptDenseTransposePass());
   }
 
   if (OptMatmulTiling)
   {
-    optPM.addPass(mlir::tensorAlgebra::createLinAlgMatmulTilingPass());
+    // tiles for the dgemm micro-kernel of the runtime library on this host
+    // (14x16 with AVX-512, 6x8 otherwise) and its 6x16 sgemm micro-kernel
+    int64_t mr, nr;
+    getHostDgemmKernelShape(mr, nr);
+    GemmBlocking f64_blocking, f32_blocking;
+    if (!parseGemmBlocking(MatmulBlocking, mr, nr, sizeof(double), 1, f64_blocking) ||
+        !parseGemmBlocking(MatmulBlocking, 6, 16, sizeof(float), 1, f32_blocking))
+    {
+      llvm::errs() << "Invalid --matmul-blocking: " << MatmulBlocking << "\n";
+      return 5;
+    }
+    optPM.addPass(mlir::tensorAlgebra::createLinAlgMatmulTilingPass(f64_blocking, f32_blocking));
   }
 
   if (OptCallToMatMulMicroKernel)
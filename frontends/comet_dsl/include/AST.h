@@ -78,6 +78,7 @@ namespace tensorAlgebra
       Expr_Call,
       Expr_FileRead,
       Expr_Print,
+      Expr_Write,
       Expr_IndexLabelDecl,
       Expr_IndexLabelDeclDynamic,
       Expr_TensorDecl,
@@ -446,13 +447,19 @@ namespace tensorAlgebra
     std::string Callee;
     std::unique_ptr<ExprAST> fileID;
     std::unique_ptr<ExprAST> ReadMode;
+    std::unique_ptr<ExprAST> IndexWidth;
+    std::unique_ptr<ExprAST> Pattern;
 
   public:
-    FileReadExprAST(Location loc, const std::string &Callee, std::unique_ptr<ExprAST> id, std::unique_ptr<ExprAST> mode)
-        : ExprAST(Expr_FileRead, loc), Callee(Callee), fileID(std::move(id)), ReadMode(std::move(mode)) {}
+    FileReadExprAST(Location loc, const std::string &Callee, std::unique_ptr<ExprAST> id, std::unique_ptr<ExprAST> mode,
+                    std::unique_ptr<ExprAST> width, std::unique_ptr<ExprAST> pattern)
+        : ExprAST(Expr_FileRead, loc), Callee(Callee), fileID(std::move(id)), ReadMode(std::move(mode)),
+          IndexWidth(std::move(width)), Pattern(std::move(pattern)) {}
 
     ExprAST *getFileID() { return fileID.get(); }
     ExprAST *getReadMode() { return ReadMode.get(); }
+    ExprAST *getIndexWidth() { return IndexWidth.get(); }
+    ExprAST *getPattern() { return Pattern.get(); }
     llvm::StringRef getCallee() { return Callee; }
 
     /// LLVM style RTTI
@@ -512,6 +519,24 @@ namespace tensorAlgebra
     static bool classof(const ExprAST *C) { return C->getKind() == Expr_Print; }
   };
 
+  /// Expression class for builtin comet_write calls: comet_write(tensor, fileID)
+  /// writes the tensor to the file of the OUTPUT_FILE_NAME<fileID> env var.
+  class WriteExprAST : public ExprAST
+  {
+    std::unique_ptr<ExprAST> Arg;
+    std::unique_ptr<ExprAST> fileID;
+
+  public:
+    WriteExprAST(Location loc, std::unique_ptr<ExprAST> Arg, std::unique_ptr<ExprAST> fileID)
+        : ExprAST(Expr_Write, loc), Arg(std::move(Arg)), fileID(std::move(fileID)) {}
+
+    ExprAST *getArg() { return Arg.get(); }
+    ExprAST *getFileID() { return fileID.get(); }
+
+    /// LLVM style RTTI
+    static bool classof(const ExprAST *C) { return C->getKind() == Expr_Write; }
+  };
+
   /// Expression class for builtin print calls.
   class PrintElapsedTimeExprAST : public ExprAST
   {
@@ -424,15 +424,29 @@ namespace tensorAlgebra
         return std::make_unique<PrintExprAST>(std::move(loc), std::move(args[0]));
       }
 
+      // It can be a builtin call to comet_write: comet_write(A); comet_write(A, 0);
+      if (name == "comet_write")
+      {
+        if (args.size() < 1 || args.size() > 2)
+          return parseError<ExprAST>("<one or two args>", "as argument to comet_write()");
+        if (args.size() == 1)
+          args.push_back(nullptr);
+
+        return std::make_unique<WriteExprAST>(std::move(loc), std::move(args[0]), std::move(args[1]));
+      }
+
       if (name == "comet_read")
       { // It can be a builtin call to comet_read
         comet_debug() << "comet_read\n";
-        if (args.size() == 0 || args.size() == 1)  // comet_read(0);
+        if (args.size() > 4)
+          return parseError<ExprAST>("<at most 4 args>", "as argument to comet_read()");
+
+        while (args.size() < 4)  // comet_read(0); comet_read(0, 1);
         {
           args.push_back(nullptr);
         }
 
-        return std::make_unique<FileReadExprAST>(std::move(loc), name, std::move(args[0]), std::move(args[1]));
+        return std::make_unique<FileReadExprAST>(std::move(loc), name, std::move(args[0]), std::move(args[1]), std::move(args[2]), std::move(args[3]));
       }
 
       if (name == "random")
@@ -1231,6 +1231,39 @@ namespace
       return mlir::success();
     }
 
+    /// Emit a write expression: comet_write(x) or comet_write(x, fileID).
+    /// The storage format of the declaration of x is kept on the op so that
+    /// the sparse arrays can be interpreted when the op is lowered.
+    mlir::LogicalResult mlirGen(WriteExprAST &call)
+    {
+      auto arg = mlirGen(*call.getArg());
+      if (!arg)
+        return mlir::failure();
+
+      // comet_write(x) --> OUTPUT_FILE_NAME, comet_write(x, 0) --> OUTPUT_FILE_NAME0
+      int fileID = 9999;
+      if (call.getFileID())
+      {
+        if (call.getFileID()->getKind() != NumberExprAST::Expr_Num)
+        {
+          emitError(loc(call.loc()), "the file ID of comet_write() should be a number");
+          return mlir::failure();
+        }
+        fileID = (int)cast<NumberExprAST>(call.getFileID())->getValue();
+      }
+
+      std::string format = "Dense";
+      if (auto decl = dyn_cast_or_null<SparseTensorDeclOp>(arg.getDefiningOp()))
+        format = decl.format().str();
+      else if (auto decl = dyn_cast_or_null<SparseOutputTensorDeclOp>(arg.getDefiningOp()))
+        format = decl.format().str();
+      else if (auto decl = dyn_cast_or_null<DenseTensorDeclOp>(arg.getDefiningOp()))
+        format = decl.format().str();
+
+      builder.create<WriteOp>(loc(call.loc()), arg, builder.getI32IntegerAttr(fileID), builder.getStringAttr(format));
+      return mlir::success();
+    }
+
     /// Emit a constant for a single number (FIXME: semantic? broadcast?)
     mlir::Value mlirGen(NumberExprAST &num)
     {
@@ -1949,6 +1982,12 @@ namespace
             return mlir::success();
           continue;
         }
+        if (auto *write = dyn_cast<WriteExprAST>(expr.get()))
+        {
+          if (mlir::failed(mlirGen(*write)))
+            return mlir::success();
+          continue;
+        }
 
         if (auto *printElapsedTime = dyn_cast<PrintElapsedTimeExprAST>(expr.get()))
         {
@@ -2026,6 +2065,8 @@ namespace
               llvm::StringRef callee = call->getCallee();
 
               int readModeVal = 1; // DEFAULT, standard matrix read
+              int indexWidthVal = 64; // DEFAULT, index-typed pos and crd arrays
+              bool patternVal = false; // DEFAULT, the values are read
 
               // Builting calls have their custom operation, meaning this is a
               // straightforward emission.
@@ -2109,7 +2150,38 @@ namespace
                   }
                 }
 
-                if (mlir::failed(mlirGenTensorFillFromFile(loc(tensor_op->loc()), tensor_name, filenamestr, readModeVal)))
+                // check 3rd arg: bit width of the pos and crd arrays (32 or 64)
+                ExprAST *indexWidth = call->getIndexWidth();
+                if (indexWidth != nullptr)
+                {
+                  if (indexWidth->getKind() == NumberExprAST::Expr_Num)
+                  {
+                    indexWidthVal = (int)cast<NumberExprAST>(indexWidth)->getValue();
+                    assert((indexWidthVal == 32 || indexWidthVal == 64) && "index width of comet_read() should be 32 or 64!");
+                  }
+                  else
+                  {
+                    assert(false && "un-recognized args provided to comet_read!");
+                  }
+                }
+
+                // check 4th arg: pattern-only read (1) that skips the values
+                ExprAST *pattern = call->getPattern();
+                if (pattern != nullptr)
+                {
+                  if (pattern->getKind() == NumberExprAST::Expr_Num)
+                  {
+                    int val = (int)cast<NumberExprAST>(pattern)->getValue();
+                    assert((val == 0 || val == 1) && "pattern argument of comet_read() should be 0 or 1!");
+                    patternVal = (val == 1);
+                  }
+                  else
+                  {
+                    assert(false && "un-recognized args provided to comet_read!");
+                  }
+                }
+
+                if (mlir::failed(mlirGenTensorFillFromFile(loc(tensor_op->loc()), tensor_name, filenamestr, readModeVal, indexWidthVal, patternVal)))
                   return mlir::success();
               }
               // TODO: put check here, if the user mis-spells something...
@@ -2688,7 +2760,7 @@ namespace
 
     mlir::LogicalResult mlirGenTensorFillFromFile(mlir::Location loc,
                                                   StringRef tensor_name, StringRef filename,
-                                                  int readMode)
+                                                  int readMode, int indexWidth, bool pattern)
     {
       mlir::Value tensorValue = symbolTable.lookup(tensor_name);
       if (tensorValue == nullptr)
@@ -2698,7 +2770,9 @@ namespace
       }
       mlir::StringAttr filenameAttr = builder.getStringAttr(filename);
       mlir::IntegerAttr readModeAttr = builder.getI32IntegerAttr(readMode);
-      builder.create<TensorFillFromFileOp>(loc, tensorValue, filenameAttr, readModeAttr);
+      mlir::IntegerAttr indexWidthAttr = builder.getI32IntegerAttr(indexWidth);
+      mlir::BoolAttr patternAttr = builder.getBoolAttr(pattern);
+      builder.create<TensorFillFromFileOp>(loc, tensorValue, filenameAttr, readModeAttr, indexWidthAttr, patternAttr);
 
       return mlir::success();
     }
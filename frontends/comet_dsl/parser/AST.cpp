@@ -63,6 +63,7 @@ namespace
     void dump(BinaryExprAST *Node);
     void dump(CallExprAST *Node);
     void dump(PrintExprAST *Node);
+    void dump(WriteExprAST *Node);
     void dump(PrototypeAST *Node);
     void dump(FunctionAST *Node);
     void dump(IndexLabelDeclExprAST *node);
@@ -116,6 +117,7 @@ void ASTDumper::dump(ExprAST *expr)
   dispatch(BinaryExprAST);
   dispatch(CallExprAST);
   dispatch(PrintExprAST);
+  dispatch(WriteExprAST);
   dispatch(IndexLabelDeclExprAST);
   dispatch(TensorDeclExprAST);
   dispatch(LabeledTensorExprAST);
@@ -263,6 +265,18 @@ void ASTDumper::dump(PrintExprAST *Node)
   llvm::errs() << "]\n";
 }
 
+/// Print a builtin comet_write call, first the builtin name and then the arguments.
+void ASTDumper::dump(WriteExprAST *Node)
+{
+  INDENT();
+  llvm::errs() << "Write [ " << loc(Node) << "\n";
+  dump(Node->getArg());
+  if (Node->getFileID())
+    dump(Node->getFileID());
+  indent();
+  llvm::errs() << "]\n";
+}
+
 /// Print type: only the shape is printed in between '<' and '>'
 void ASTDumper::dump(VarType &type)
 {
@@ -29,6 +29,7 @@
 #define TENSORALGEBRA_PASSES_H
 
 #include "mlir/Pass/Pass.h"
+#include "comet/ExecutionEngine/GemmBlocking.h"
 #include <memory>
 
 namespace mlir
@@ -37,7 +38,11 @@ namespace mlir
 
     namespace tensorAlgebra
     {
-        std::unique_ptr<Pass> createLinAlgMatmulTilingPass();
+        // Tile linalg.matmul for the blocking of BLIS: MC x NC x KC tiles, then
+        // MR x NR x KC tiles for the micro-kernel, with the blocking of the f64
+        // or f32 micro-kernel depending on the element type (BLIS Haswell by default)
+        std::unique_ptr<Pass> createLinAlgMatmulTilingPass(const GemmBlocking &f64_blocking = getHaswellGemmBlocking(sizeof(double)),
+                                                           const GemmBlocking &f32_blocking = getHaswellGemmBlocking(sizeof(float)));
 
         // Optimize dense transpose (linalg.copy) based on the following paper:
         // HPTT: A High-Performance Tensor Transposition C++ Library
@@ -45,6 +50,10 @@ namespace mlir
         std::unique_ptr<Pass> createOptDenseTransposePass(uint64_t tile_size = 1,
                                                           bool seperate_tiles = false);
 
+        // Replace permuting linalg.copy with calls to the blocked, multithreaded
+        // dense transpose of the runtime library
+        std::unique_ptr<Pass> createDenseTransposeLibraryCallPass();
+
         std::unique_ptr<Pass> createLinAlgMatmulMicroKernelPass();
 
         std::unique_ptr<Pass> createLowerLinAlgFillPass();
@@ -95,6 +104,10 @@ namespace mlir
         /// Create a pass for lowering sparse TA operations to SCFDimAttr
         std::unique_ptr<Pass> createSTCRemoveDeadOpsPass();
 
+        /// Create a pass that streams the CSR input of SpMV/SpMM products in
+        /// row panels, instead of reading the whole matrix before the product
+        std::unique_ptr<Pass> createStreamRowPanelsPass();
+
         /// Create a pass for lowering sparse TA operations to SCFDimAttrGPU
         std::unique_ptr<Pass> createSCFToSCFParallelPass();
 
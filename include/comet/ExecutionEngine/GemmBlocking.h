@@ -0,0 +1,267 @@
+//===- GemmBlocking.h - Cache blocking parameters of GEMM ----------------===//
+//
+// Copyright 2022 Battelle Memorial Institute
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+// and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+// and the following disclaimer in the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//
+// This file provides the blocking parameters (MC, KC, NC) of the BLIS-style
+// GEMM, derived from the cache hierarchy of the host and the shape (MR x NR)
+// of the micro-kernel. It is shared by the matmul tiling pass and the GEMM
+// driver of the runtime library, so that both block the same way.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef COMET_EXECUTIONENGINE_GEMMBLOCKING_H_
+#define COMET_EXECUTIONENGINE_GEMMBLOCKING_H_
+
+#include <algorithm>
+#include <fstream>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+// Blocking of C += A * B: the micro-kernel computes MR x NR blocks of C, MC x
+// KC blocks of A are packed to stay in the L2 cache and KC x NC panels of B
+// to stay in the L3 cache, while KC x NR micro-panels of B stay in the L1.
+struct GemmBlocking
+{
+  int64_t mr, nr;
+  int64_t mc, kc, nc;
+};
+
+// Sizes in bytes of the data caches of a core, 0 when unknown. l3 is the
+// size of the L3 cache, which l3_sharing cores share.
+struct CacheSizes
+{
+  int64_t l1 = 0, l2 = 0, l3 = 0;
+  int64_t l3_sharing = 1;
+};
+
+// The parameters of the BLIS Haswell configuration, for its 6 x 8 dgemm or
+// 6 x 16 sgemm micro-kernel
+inline GemmBlocking getHaswellGemmBlocking(int64_t element_bytes = sizeof(double))
+{
+  if (element_bytes == sizeof(float))
+    return GemmBlocking{6, 16, 168, 256, 4080};
+  return GemmBlocking{6, 8, 72, 256, 4080};
+}
+
+// Parses a cache size of sysfs, e.g., "32K"
+inline int64_t parseCacheSize(const std::string &text)
+{
+  char *end;
+  int64_t size = strtoll(text.c_str(), &end, 10);
+  if (*end == 'K')
+    size <<= 10;
+  else if (*end == 'M')
+    size <<= 20;
+  return size;
+}
+
+// Number of CPUs of a list of sysfs, e.g., "0-3,8-11"
+inline int64_t countCpuList(const std::string &text)
+{
+  int64_t count = 0;
+  const char *s = text.c_str();
+  while (*s >= '0' && *s <= '9')
+  {
+    char *end;
+    long first = strtol(s, &end, 10), last = first;
+    if (*end == '-')
+      last = strtol(end + 1, &end, 10);
+    count += last - first + 1;
+    s = (*end == ',') ? end + 1 : end;
+  }
+  return std::max<int64_t>(count, 1);
+}
+
+// Returns true if the host supports AVX-512 (AVX512F), and its OS saves the
+// zmm registers
+inline bool hostSupportsAvx512()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  unsigned eax, ebx, ecx, edx;
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & (1u << 27))) // OSXSAVE
+    return false;
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) || !(ebx & (1u << 16))) // AVX512F
+    return false;
+  unsigned xcr0_lo, xcr0_hi;
+  __asm__ __volatile__("xgetbv"
+                       : "=a"(xcr0_lo), "=d"(xcr0_hi)
+                       : "c"(0));
+  return (xcr0_lo & 0xe6) == 0xe6; // xmm, ymm and zmm state
+#else
+  return false;
+#endif
+}
+
+// Shape (MR x NR) of the dgemm micro-kernel of the runtime library on this
+// host: the 14 x 16 AVX-512 kernel, or the 6 x 8 Haswell kernel
+inline void getHostDgemmKernelShape(int64_t &mr, int64_t &nr)
+{
+  bool avx512 = hostSupportsAvx512();
+  mr = avx512 ? 14 : 6;
+  nr = avx512 ? 16 : 8;
+}
+
+/**
+ * Reads the cache sizes of the host from sysfs (/sys/devices/system/cpu/cpu0/
+ * cache) or, on x86 hosts without it, from the deterministic cache
+ * parameters of cpuid (leaf 4). The sizes are read once.
+ */
+inline CacheSizes getHostCacheSizes()
+{
+  static const CacheSizes sizes = []()
+  {
+    CacheSizes cs;
+    for (int index = 0; index < 16; index++)
+    {
+      std::string dir = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/";
+      std::ifstream level_file(dir + "level"), type_file(dir + "type"), size_file(dir + "size");
+      if (!level_file || !type_file || !size_file)
+        break;
+      int level = 0;
+      std::string type, size, shared;
+      level_file >> level;
+      type_file >> type;
+      size_file >> size;
+      if (type == "Instruction")
+        continue;
+      if (level == 1)
+        cs.l1 = parseCacheSize(size);
+      else if (level == 2)
+        cs.l2 = parseCacheSize(size);
+      else if (level == 3)
+      {
+        cs.l3 = parseCacheSize(size);
+        std::ifstream shared_file(dir + "shared_cpu_list");
+        if (shared_file >> shared)
+          cs.l3_sharing = countCpuList(shared);
+      }
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    if (cs.l1 == 0 && cs.l2 == 0 && cs.l3 == 0)
+    {
+      unsigned eax, ebx, ecx, edx;
+      for (unsigned sub = 0; __get_cpuid_count(4, sub, &eax, &ebx, &ecx, &edx); sub++)
+      {
+        unsigned type = eax & 0x1f; // 0: no more caches, 1: data, 2: instruction, 3: unified
+        if (type == 0)
+          break;
+        if (type == 2)
+          continue;
+        unsigned level = (eax >> 5) & 0x7;
+        int64_t size = (int64_t)(((ebx >> 22) & 0x3ff) + 1) * (((ebx >> 12) & 0x3ff) + 1) *
+                       ((ebx & 0xfff) + 1) * ((int64_t)ecx + 1);
+        if (level == 1)
+          cs.l1 = size;
+        else if (level == 2)
+          cs.l2 = size;
+        else if (level == 3)
+        {
+          cs.l3 = size;
+          cs.l3_sharing = ((eax >> 14) & 0xfff) + 1;
+        }
+      }
+    }
+#endif
+    return cs;
+  }();
+
+  return sizes;
+}
+
+/**
+ * Derives MC, KC and NC for an MR x NR micro-kernel on elements of
+ * element_bytes bytes from the cache sizes, as in the analytical model of
+ * BLIS: a KC x NR micro-panel of B fills half of the L1 cache, an MC x KC
+ * block of A half of the L2, and a KC x NC panel of B half of the share of
+ * the L3 of num_threads threads (each thread of the runtime GEMM packs its
+ * own panels). The parameters of a cache of unknown size are those of the
+ * BLIS Haswell configuration, and NC is at most 4 times its Haswell value,
+ * as hosts may report large, distant L3 caches (e.g., on virtual machines).
+ */
+inline GemmBlocking computeGemmBlocking(const CacheSizes &cs, int64_t mr, int64_t nr,
+                                        int64_t element_bytes, int num_threads = 1)
+{
+  GemmBlocking haswell = getHaswellGemmBlocking(element_bytes);
+  GemmBlocking b;
+  b.mr = mr;
+  b.nr = nr;
+
+  b.kc = cs.l1 > 0 ? cs.l1 / (2 * nr * element_bytes) : haswell.kc;
+  b.kc = std::max<int64_t>(b.kc / 8 * 8, 64);
+
+  b.mc = cs.l2 > 0 ? cs.l2 / (2 * b.kc * element_bytes) : haswell.mc;
+  b.mc = std::max<int64_t>(b.mc / mr * mr, mr);
+
+  if (cs.l3 > 0)
+  {
+    int64_t l3 = cs.l3 / std::min<int64_t>(std::max(num_threads, 1), cs.l3_sharing);
+    b.nc = l3 / (2 * b.kc * element_bytes);
+  }
+  else
+    b.nc = haswell.nc;
+  b.nc = std::min(b.nc, 4 * haswell.nc);
+  b.nc = std::max<int64_t>(b.nc / nr * nr, b.mc / nr * nr + nr);
+
+  return b;
+}
+
+/**
+ * Parses a blocking specification for an MR x NR micro-kernel: "host" (the
+ * parameters of computeGemmBlocking for the caches of the host), "haswell"
+ * (those of the BLIS Haswell configuration) or "MC,KC,NC". Returns false if
+ * the specification is not valid.
+ */
+inline bool parseGemmBlocking(const std::string &spec, int64_t mr, int64_t nr,
+                              int64_t element_bytes, int num_threads,
+                              GemmBlocking &blocking)
+{
+  if (spec == "host")
+  {
+    blocking = computeGemmBlocking(getHostCacheSizes(), mr, nr, element_bytes, num_threads);
+    return true;
+  }
+  if (spec == "haswell")
+  {
+    blocking = getHaswellGemmBlocking(element_bytes);
+    blocking.mr = mr;
+    blocking.nr = nr;
+    blocking.mc = std::max(blocking.mc / mr * mr, mr);
+    blocking.nc = std::max(blocking.nc / nr * nr, nr);
+    return true;
+  }
+
+  long long mc, kc, nc;
+  char end;
+  if (sscanf(spec.c_str(), "%lld,%lld,%lld%c", &mc, &kc, &nc, &end) != 3 ||
+      mc <= 0 || kc <= 0 || nc <= 0)
+    return false;
+  blocking = GemmBlocking{mr, nr, mc, kc, nc};
+  return true;
+}
+
+#endif // COMET_EXECUTIONENGINE_GEMMBLOCKING_H_
@@ -0,0 +1,86 @@
+//===- ParallelUtils.h - Threading helpers for the runtime ---------------===//
+//
+// Copyright 2022 Battelle Memorial Institute
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+// and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+// and the following disclaimer in the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares small helpers that the runtime library uses to spread
+// work (file parsing, sorting, ...) over several threads.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef COMET_EXECUTIONENGINE_PARALLELUTILS_H_
+#define COMET_EXECUTIONENGINE_PARALLELUTILS_H_
+
+#include <stdlib.h>
+#include <thread>
+#include <vector>
+
+// Number of threads used by the runtime library. It is taken from the
+// COMET_NUM_THREADS environmental variable, and defaults to the number of
+// hardware threads of the host.
+inline int getNumThreads()
+{
+  static const int num_threads = []()
+  {
+    int n = 0;
+    if (char *env = getenv("COMET_NUM_THREADS"))
+      n = atoi(env);
+    if (n <= 0)
+      n = (int)std::thread::hardware_concurrency();
+    return n > 0 ? n : 1;
+  }();
+
+  return num_threads;
+}
+
+// Calls func(task) for every task in [0, num_tasks), distributing the tasks
+// round-robin over at most num_threads threads. The calling thread takes
+// part in the work, so no thread is created when num_threads <= 1.
+template <typename Func>
+void parallelFor(int num_tasks, int num_threads, Func func)
+{
+  if (num_threads > num_tasks)
+    num_threads = num_tasks;
+
+  if (num_threads <= 1)
+  {
+    for (int task = 0; task < num_tasks; task++)
+      func(task);
+    return;
+  }
+
+  std::vector<std::thread> workers;
+  for (int tid = 1; tid < num_threads; tid++)
+  {
+    workers.emplace_back([tid, num_tasks, num_threads, &func]()
+                         {
+                           for (int task = tid; task < num_tasks; task += num_threads)
+                             func(task);
+                         });
+  }
+  for (int task = 0; task < num_tasks; task += num_threads)
+    func(task);
+
+  for (auto &worker : workers)
+    worker.join();
+}
+
+#endif // COMET_EXECUTIONENGINE_PARALLELUTILS_H_
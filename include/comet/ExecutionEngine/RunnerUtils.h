@@ -118,6 +118,317 @@ extern "C" COMET_RUNNERUTILS_EXPORT void read_input_3D_f64(int32_t fileID, int32
                                                            int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
                                                            int Aval_rank, void *Aval_ptr, int32_t readMode);
 
+// Same as read_input_2D_* and read_input_3D_*, filling in 32-bit pos and crd arrays
+extern "C" COMET_RUNNERUTILS_EXPORT void read_input_2D_f32_i32(int32_t fileID, int32_t A1format, int32_t A2format,
+                                                               int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                                               int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                                               int Aval_rank, void *Aval_ptr, int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void read_input_2D_f64_i32(int32_t fileID, int32_t A1format, int32_t A2format,
+                                                               int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                                               int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                                               int Aval_rank, void *Aval_ptr, int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void read_input_3D_f32_i32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format,
+                                                               int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                                               int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                                               int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                                               int Aval_rank, void *Aval_ptr, int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void read_input_3D_f64_i32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format,
+                                                               int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                                               int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                                               int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                                               int Aval_rank, void *Aval_ptr, int32_t readMode);
+
+// Start parsing an input in the background, for the read calls above with the same arguments
+extern "C" COMET_RUNNERUTILS_EXPORT void prefetch_input_2D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t readMode);
+extern "C" COMET_RUNNERUTILS_EXPORT void prefetch_input_2D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t readMode);
+extern "C" COMET_RUNNERUTILS_EXPORT void prefetch_input_3D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format,
+                                                               int32_t readMode);
+extern "C" COMET_RUNNERUTILS_EXPORT void prefetch_input_3D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format,
+                                                               int32_t readMode);
+
+// Same as the 3D calls above, for tensors of rank 4 to 8 read from FROSTT files with any per-dimension format
+
+extern "C" COMET_RUNNERUTILS_EXPORT void read_input_sizes_4D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format,
+                                                                 int A1pos_rank, void *A1pos_ptr, int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void read_input_sizes_4D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format,
+                                                                 int A1pos_rank, void *A1pos_ptr, int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void read_input_4D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format,
+                                                           int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                                           int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                                           int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                                           int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                                           int Aval_rank, void *Aval_ptr, int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void read_input_4D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format,
+                                                           int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                                           int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                                           int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                                           int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                                           int Aval_rank, void *Aval_ptr, int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void read_input_4D_f32_i32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format,
+                                                               int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                                               int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                                               int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                                               int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                                               int Aval_rank, void *Aval_ptr, int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void read_input_4D_f64_i32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format,
+                                                               int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                                               int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                                               int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                                               int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                                               int Aval_rank, void *Aval_ptr, int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void prefetch_input_4D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format,
+                                                               int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void prefetch_input_4D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format,
+                                                               int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void read_input_sizes_5D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format,
+                                                                 int A1pos_rank, void *A1pos_ptr, int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void read_input_sizes_5D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format,
+                                                                 int A1pos_rank, void *A1pos_ptr, int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void read_input_5D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format,
+                                                           int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                                           int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                                           int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                                           int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                                           int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                                           int Aval_rank, void *Aval_ptr, int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void read_input_5D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format,
+                                                           int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                                           int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                                           int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                                           int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                                           int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                                           int Aval_rank, void *Aval_ptr, int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void read_input_5D_f32_i32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format,
+                                                               int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                                               int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                                               int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                                               int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                                               int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                                               int Aval_rank, void *Aval_ptr, int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void read_input_5D_f64_i32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format,
+                                                               int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                                               int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                                               int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                                               int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                                               int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                                               int Aval_rank, void *Aval_ptr, int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void prefetch_input_5D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format,
+                                                               int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void prefetch_input_5D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format,
+                                                               int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void read_input_sizes_6D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format,
+                                                                 int A1pos_rank, void *A1pos_ptr, int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void read_input_sizes_6D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format,
+                                                                 int A1pos_rank, void *A1pos_ptr, int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void read_input_6D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format,
+                                                           int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                                           int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                                           int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                                           int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                                           int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                                           int A6pos_rank, void *A6pos_ptr, int A6crd_rank, void *A6crd_ptr,
+                                                           int Aval_rank, void *Aval_ptr, int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void read_input_6D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format,
+                                                           int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                                           int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                                           int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                                           int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                                           int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                                           int A6pos_rank, void *A6pos_ptr, int A6crd_rank, void *A6crd_ptr,
+                                                           int Aval_rank, void *Aval_ptr, int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void read_input_6D_f32_i32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format,
+                                                               int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                                               int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                                               int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                                               int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                                               int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                                               int A6pos_rank, void *A6pos_ptr, int A6crd_rank, void *A6crd_ptr,
+                                                               int Aval_rank, void *Aval_ptr, int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void read_input_6D_f64_i32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format,
+                                                               int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                                               int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                                               int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                                               int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                                               int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                                               int A6pos_rank, void *A6pos_ptr, int A6crd_rank, void *A6crd_ptr,
+                                                               int Aval_rank, void *Aval_ptr, int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void prefetch_input_6D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format,
+                                                               int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void prefetch_input_6D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format,
+                                                               int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void read_input_sizes_7D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format, int32_t A7format,
+                                                                 int A1pos_rank, void *A1pos_ptr, int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void read_input_sizes_7D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format, int32_t A7format,
+                                                                 int A1pos_rank, void *A1pos_ptr, int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void read_input_7D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format, int32_t A7format,
+                                                           int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                                           int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                                           int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                                           int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                                           int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                                           int A6pos_rank, void *A6pos_ptr, int A6crd_rank, void *A6crd_ptr,
+                                                           int A7pos_rank, void *A7pos_ptr, int A7crd_rank, void *A7crd_ptr,
+                                                           int Aval_rank, void *Aval_ptr, int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void read_input_7D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format, int32_t A7format,
+                                                           int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                                           int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                                           int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                                           int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                                           int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                                           int A6pos_rank, void *A6pos_ptr, int A6crd_rank, void *A6crd_ptr,
+                                                           int A7pos_rank, void *A7pos_ptr, int A7crd_rank, void *A7crd_ptr,
+                                                           int Aval_rank, void *Aval_ptr, int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void read_input_7D_f32_i32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format, int32_t A7format,
+                                                               int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                                               int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                                               int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                                               int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                                               int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                                               int A6pos_rank, void *A6pos_ptr, int A6crd_rank, void *A6crd_ptr,
+                                                               int A7pos_rank, void *A7pos_ptr, int A7crd_rank, void *A7crd_ptr,
+                                                               int Aval_rank, void *Aval_ptr, int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void read_input_7D_f64_i32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format, int32_t A7format,
+                                                               int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                                               int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                                               int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                                               int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                                               int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                                               int A6pos_rank, void *A6pos_ptr, int A6crd_rank, void *A6crd_ptr,
+                                                               int A7pos_rank, void *A7pos_ptr, int A7crd_rank, void *A7crd_ptr,
+                                                               int Aval_rank, void *Aval_ptr, int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void prefetch_input_7D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format, int32_t A7format,
+                                                               int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void prefetch_input_7D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format, int32_t A7format,
+                                                               int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void read_input_sizes_8D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format, int32_t A7format, int32_t A8format,
+                                                                 int A1pos_rank, void *A1pos_ptr, int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void read_input_sizes_8D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format, int32_t A7format, int32_t A8format,
+                                                                 int A1pos_rank, void *A1pos_ptr, int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void read_input_8D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format, int32_t A7format, int32_t A8format,
+                                                           int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                                           int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                                           int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                                           int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                                           int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                                           int A6pos_rank, void *A6pos_ptr, int A6crd_rank, void *A6crd_ptr,
+                                                           int A7pos_rank, void *A7pos_ptr, int A7crd_rank, void *A7crd_ptr,
+                                                           int A8pos_rank, void *A8pos_ptr, int A8crd_rank, void *A8crd_ptr,
+                                                           int Aval_rank, void *Aval_ptr, int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void read_input_8D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format, int32_t A7format, int32_t A8format,
+                                                           int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                                           int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                                           int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                                           int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                                           int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                                           int A6pos_rank, void *A6pos_ptr, int A6crd_rank, void *A6crd_ptr,
+                                                           int A7pos_rank, void *A7pos_ptr, int A7crd_rank, void *A7crd_ptr,
+                                                           int A8pos_rank, void *A8pos_ptr, int A8crd_rank, void *A8crd_ptr,
+                                                           int Aval_rank, void *Aval_ptr, int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void read_input_8D_f32_i32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format, int32_t A7format, int32_t A8format,
+                                                               int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                                               int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                                               int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                                               int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                                               int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                                               int A6pos_rank, void *A6pos_ptr, int A6crd_rank, void *A6crd_ptr,
+                                                               int A7pos_rank, void *A7pos_ptr, int A7crd_rank, void *A7crd_ptr,
+                                                               int A8pos_rank, void *A8pos_ptr, int A8crd_rank, void *A8crd_ptr,
+                                                               int Aval_rank, void *Aval_ptr, int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void read_input_8D_f64_i32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format, int32_t A7format, int32_t A8format,
+                                                               int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                                               int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                                               int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                                               int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                                               int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                                               int A6pos_rank, void *A6pos_ptr, int A6crd_rank, void *A6crd_ptr,
+                                                               int A7pos_rank, void *A7pos_ptr, int A7crd_rank, void *A7crd_ptr,
+                                                               int A8pos_rank, void *A8pos_ptr, int A8crd_rank, void *A8crd_ptr,
+                                                               int Aval_rank, void *Aval_ptr, int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void prefetch_input_8D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format, int32_t A7format, int32_t A8format,
+                                                               int32_t readMode);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void prefetch_input_8D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format, int32_t A7format, int32_t A8format,
+                                                               int32_t readMode);
+
+// Tensor cache of the inputs read by the calls above
+extern "C" COMET_RUNNERUTILS_EXPORT void comet_tensor_cache_set_budget(int64_t bytes);
+extern "C" COMET_RUNNERUTILS_EXPORT void comet_tensor_cache_pin(int32_t fileID);
+extern "C" COMET_RUNNERUTILS_EXPORT void comet_tensor_cache_unpin(int32_t fileID);
+extern "C" COMET_RUNNERUTILS_EXPORT void comet_tensor_cache_clear();
+extern "C" COMET_RUNNERUTILS_EXPORT void comet_tensor_cache_print_stats();
+
+// C = A * B, with the CSR matrix A of SPARSE_FILE_NAME<fileID> streamed in row panels
+extern "C" COMET_RUNNERUTILS_EXPORT void comet_stream_csr_mult_f32(int32_t fileID, int32_t readMode,
+                                                                   int64_t B_rank, void *B_ptr, int64_t C_rank, void *C_ptr);
+extern "C" COMET_RUNNERUTILS_EXPORT void comet_stream_csr_mult_f64(int32_t fileID, int32_t readMode,
+                                                                   int64_t B_rank, void *B_ptr, int64_t C_rank, void *C_ptr);
+
+// Write result tensors to the file of OUTPUT_FILE_NAME<fileID> (.mtx, .tns or .cbin)
+extern "C" COMET_RUNNERUTILS_EXPORT void comet_write_dense_f64(int32_t fileID, int64_t rank, void *ptr);
+extern "C" COMET_RUNNERUTILS_EXPORT void comet_write_sparse_2D_f64(int32_t fileID, int32_t A1format, int32_t A2format,
+                                                                   int64_t dim1, int64_t dim2,
+                                                                   int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                                                   int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                                                   int Aval_rank, void *Aval_ptr);
+extern "C" COMET_RUNNERUTILS_EXPORT void comet_write_sparse_3D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format,
+                                                                   int64_t dim1, int64_t dim2, int64_t dim3,
+                                                                   int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                                                   int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                                                   int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                                                   int Aval_rank, void *Aval_ptr);
+extern "C" COMET_RUNNERUTILS_EXPORT void comet_write_sparse_2D_f64_i32(int32_t fileID, int32_t A1format, int32_t A2format,
+                                                                       int64_t dim1, int64_t dim2,
+                                                                       int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                                                       int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                                                       int Aval_rank, void *Aval_ptr);
+extern "C" COMET_RUNNERUTILS_EXPORT void comet_write_sparse_3D_f64_i32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format,
+                                                                       int64_t dim1, int64_t dim2, int64_t dim3,
+                                                                       int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                                                       int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                                                       int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                                                       int Aval_rank, void *Aval_ptr);
+
 // Transpose operations
 extern "C" COMET_RUNNERUTILS_EXPORT void transpose_2D_f32(int32_t A1format, int32_t A2format,
                                                           int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
@@ -159,6 +470,108 @@ extern "C" COMET_RUNNERUTILS_EXPORT void transpose_3D_f64(int32_t radix_sum1, in
                                                           int B3pos_rank, void *B3pos_ptr, int B3crd_rank, void *B3crd_ptr,
                                                           int Bval_rank, void *Bval_ptr, int sizes_rank, void *sizes_ptr);
 
+extern "C" COMET_RUNNERUTILS_EXPORT void transpose_4D_f32(int32_t input_permutation, int32_t output_permutation,
+                                                          int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format,
+                                                          int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                                          int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                                          int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                                          int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                                          int Aval_rank, void *Aval_ptr,
+                                                          int32_t B1format, int32_t B2format, int32_t B3format, int32_t B4format,
+                                                          int B1pos_rank, void *B1pos_ptr, int B1crd_rank, void *B1crd_ptr,
+                                                          int B2pos_rank, void *B2pos_ptr, int B2crd_rank, void *B2crd_ptr,
+                                                          int B3pos_rank, void *B3pos_ptr, int B3crd_rank, void *B3crd_ptr,
+                                                          int B4pos_rank, void *B4pos_ptr, int B4crd_rank, void *B4crd_ptr,
+                                                          int Bval_rank, void *Bval_ptr, int sizes_rank, void *sizes_ptr);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void transpose_4D_f64(int32_t input_permutation, int32_t output_permutation,
+                                                          int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format,
+                                                          int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                                          int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                                          int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                                          int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                                          int Aval_rank, void *Aval_ptr,
+                                                          int32_t B1format, int32_t B2format, int32_t B3format, int32_t B4format,
+                                                          int B1pos_rank, void *B1pos_ptr, int B1crd_rank, void *B1crd_ptr,
+                                                          int B2pos_rank, void *B2pos_ptr, int B2crd_rank, void *B2crd_ptr,
+                                                          int B3pos_rank, void *B3pos_ptr, int B3crd_rank, void *B3crd_ptr,
+                                                          int B4pos_rank, void *B4pos_ptr, int B4crd_rank, void *B4crd_ptr,
+                                                          int Bval_rank, void *Bval_ptr, int sizes_rank, void *sizes_ptr);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void transpose_5D_f32(int32_t input_permutation, int32_t output_permutation,
+                                                          int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format,
+                                                          int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                                          int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                                          int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                                          int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                                          int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                                          int Aval_rank, void *Aval_ptr,
+                                                          int32_t B1format, int32_t B2format, int32_t B3format, int32_t B4format, int32_t B5format,
+                                                          int B1pos_rank, void *B1pos_ptr, int B1crd_rank, void *B1crd_ptr,
+                                                          int B2pos_rank, void *B2pos_ptr, int B2crd_rank, void *B2crd_ptr,
+                                                          int B3pos_rank, void *B3pos_ptr, int B3crd_rank, void *B3crd_ptr,
+                                                          int B4pos_rank, void *B4pos_ptr, int B4crd_rank, void *B4crd_ptr,
+                                                          int B5pos_rank, void *B5pos_ptr, int B5crd_rank, void *B5crd_ptr,
+                                                          int Bval_rank, void *Bval_ptr, int sizes_rank, void *sizes_ptr);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void transpose_5D_f64(int32_t input_permutation, int32_t output_permutation,
+                                                          int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format,
+                                                          int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                                          int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                                          int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                                          int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                                          int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                                          int Aval_rank, void *Aval_ptr,
+                                                          int32_t B1format, int32_t B2format, int32_t B3format, int32_t B4format, int32_t B5format,
+                                                          int B1pos_rank, void *B1pos_ptr, int B1crd_rank, void *B1crd_ptr,
+                                                          int B2pos_rank, void *B2pos_ptr, int B2crd_rank, void *B2crd_ptr,
+                                                          int B3pos_rank, void *B3pos_ptr, int B3crd_rank, void *B3crd_ptr,
+                                                          int B4pos_rank, void *B4pos_ptr, int B4crd_rank, void *B4crd_ptr,
+                                                          int B5pos_rank, void *B5pos_ptr, int B5crd_rank, void *B5crd_ptr,
+                                                          int Bval_rank, void *Bval_ptr, int sizes_rank, void *sizes_ptr);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void transpose_6D_f32(int32_t input_permutation, int32_t output_permutation,
+                                                          int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format,
+                                                          int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                                          int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                                          int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                                          int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                                          int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                                          int A6pos_rank, void *A6pos_ptr, int A6crd_rank, void *A6crd_ptr,
+                                                          int Aval_rank, void *Aval_ptr,
+                                                          int32_t B1format, int32_t B2format, int32_t B3format, int32_t B4format, int32_t B5format, int32_t B6format,
+                                                          int B1pos_rank, void *B1pos_ptr, int B1crd_rank, void *B1crd_ptr,
+                                                          int B2pos_rank, void *B2pos_ptr, int B2crd_rank, void *B2crd_ptr,
+                                                          int B3pos_rank, void *B3pos_ptr, int B3crd_rank, void *B3crd_ptr,
+                                                          int B4pos_rank, void *B4pos_ptr, int B4crd_rank, void *B4crd_ptr,
+                                                          int B5pos_rank, void *B5pos_ptr, int B5crd_rank, void *B5crd_ptr,
+                                                          int B6pos_rank, void *B6pos_ptr, int B6crd_rank, void *B6crd_ptr,
+                                                          int Bval_rank, void *Bval_ptr, int sizes_rank, void *sizes_ptr);
+
+extern "C" COMET_RUNNERUTILS_EXPORT void transpose_6D_f64(int32_t input_permutation, int32_t output_permutation,
+                                                          int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format,
+                                                          int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                                          int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                                          int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                                          int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                                          int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                                          int A6pos_rank, void *A6pos_ptr, int A6crd_rank, void *A6crd_ptr,
+                                                          int Aval_rank, void *Aval_ptr,
+                                                          int32_t B1format, int32_t B2format, int32_t B3format, int32_t B4format, int32_t B5format, int32_t B6format,
+                                                          int B1pos_rank, void *B1pos_ptr, int B1crd_rank, void *B1crd_ptr,
+                                                          int B2pos_rank, void *B2pos_ptr, int B2crd_rank, void *B2crd_ptr,
+                                                          int B3pos_rank, void *B3pos_ptr, int B3crd_rank, void *B3crd_ptr,
+                                                          int B4pos_rank, void *B4pos_ptr, int B4crd_rank, void *B4crd_ptr,
+                                                          int B5pos_rank, void *B5pos_ptr, int B5crd_rank, void *B5crd_ptr,
+                                                          int B6pos_rank, void *B6pos_ptr, int B6crd_rank, void *B6crd_ptr,
+                                                          int Bval_rank, void *Bval_ptr, int sizes_rank, void *sizes_ptr);
+
+// Dense transpose (permuting linalg.copy)
+extern "C" COMET_RUNNERUTILS_EXPORT void comet_dense_transpose_f32(int32_t input_permutation, int32_t output_permutation,
+                                                                   int64_t A_rank, void *A_ptr, int64_t B_rank, void *B_ptr);
+extern "C" COMET_RUNNERUTILS_EXPORT void comet_dense_transpose_f64(int32_t input_permutation, int32_t output_permutation,
+                                                                   int64_t A_rank, void *A_ptr, int64_t B_rank, void *B_ptr);
+
 //===----------------------------------------------------------------------===//
 // Small runtime support library for timing execution, printing elapse time, printing GFLOPS
 //===----------------------------------------------------------------------===//
@@ -170,6 +583,36 @@ extern "C" COMET_RUNNERUTILS_EXPORT void print_flops(double flops);
 // Small runtime support library for printing output scalar and tensors
 //===----------------------------------------------------------------------===//
 
+/// Binary dump mode of the print functions. When the COMET_PRINT_BINARY
+/// environment variable is set, comet_print_memref_* write every memref as a
+/// record to a file (or to a file descriptor if the value is a number)
+/// instead of formatting it: the header, the sizes of the memref and its
+/// elements in row-major order, with a single write. comet-print-check reads
+/// the records back to print or compare them.
+enum CometPrintDumpType
+{
+    PRINT_DUMP_F64 = 0,
+    PRINT_DUMP_I64 = 1,
+    PRINT_DUMP_I32 = 2
+};
+
+struct CometPrintDumpHeader
+{
+    char magic[8];        // "COMETDMP"
+    uint32_t version;     // COMET_PRINT_DUMP_VERSION
+    uint32_t type;        // CometPrintDumpType of the elements
+    int64_t rank;         // followed by int64_t sizes[rank]
+    int64_t num_elements; // followed by the elements
+};
+
+#define COMET_PRINT_DUMP_MAGIC "COMETDMP"
+#define COMET_PRINT_DUMP_VERSION 1
+
+inline int64_t cometPrintDumpElementBytes(uint32_t type)
+{
+    return type == PRINT_DUMP_I32 ? 4 : 8;
+}
+
 template <typename T>
 void printData(std::ostream &os, T *base, int64_t dim,
                int64_t rank, int64_t offset,
@@ -58,6 +58,11 @@ _mlir_ciface_linalg_matmul_viewsxsxf64_viewsxsxf64_viewsxsxf64(
     StridedMemRefType<double, 2> *A, StridedMemRefType<double, 2> *B,
     StridedMemRefType<double, 2> *C);
 
+extern "C" COMET_BLIS_INTERFACE_EXPORT void
+_mlir_ciface_linalg_matmul_viewsxsxf32_viewsxsxf32_viewsxsxf32(
+    StridedMemRefType<float, 2> *A, StridedMemRefType<float, 2> *B,
+    StridedMemRefType<float, 2> *C);
+
 #ifdef __clang__
 #pragma clang diagnostic pop
 #endif
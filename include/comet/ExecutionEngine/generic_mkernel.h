@@ -22,14 +22,17 @@
 //               rs_c == 1 && cs_c == 0: means contiguous col-storage desired for C,
 //               rs_c == 0 && cs_c == 1: means contiguous row-storage desired for C.
 
-void dgemm_generic_noopt_mxn (
+//   T: element type (double for dgemm, float for sgemm).
+
+template <typename T>
+void gemm_generic_noopt_mxn (
   int64_t m,
   int64_t n,  
   int64_t k,
-  double* alpha,
-  double* a, double* b, 
-  double* beta,
-  double* c, 
+  T* alpha,
+  T* a, T* b, 
+  T* beta,
+  T* c, 
   int64_t rs_c, int64_t cs_c)
   {
 
@@ -41,9 +44,9 @@ void dgemm_generic_noopt_mxn (
     int64_t rs_ab = 1;
     int64_t cs_ab = MR; 
 
-    double ai, bj; 
-    double* abij;
-    double ab[MR*NR];  // holds the computed values 
+    T ai, bj; 
+    T* abij;
+    T ab[MR*NR];  // holds the computed values 
     for (i = 0; i < MR*NR; i++)  // initialization
       ab[i] = 0.0;
        
@@ -85,4 +88,20 @@ void dgemm_generic_noopt_mxn (
 
   };
 
+inline void dgemm_generic_noopt_mxn (
+  int64_t m, int64_t n, int64_t k,
+  double* alpha, double* a, double* b, double* beta,
+  double* c, int64_t rs_c, int64_t cs_c)
+  {
+    gemm_generic_noopt_mxn<double>(m, n, k, alpha, a, b, beta, c, rs_c, cs_c);
+  }
+
+inline void sgemm_generic_noopt_mxn (
+  int64_t m, int64_t n, int64_t k,
+  float* alpha, float* a, float* b, float* beta,
+  float* c, int64_t rs_c, int64_t cs_c)
+  {
+    gemm_generic_noopt_mxn<float>(m, n, k, alpha, a, b, beta, c, rs_c, cs_c);
+  }
+
 #endif /** COMET_GENERIC_MKERNEL_H */
@@ -21395,6 +21395,7 @@ GEMM_UKR_PROT( float ,   s, gemm_skx_asm_12x32_l2 )
 
 GEMM_UKR_PROT( double,   d, gemm_skx_asm_16x12_l2 )
 GEMM_UKR_PROT( double,   d, gemm_skx_asm_16x14 )
+GEMM_UKR_PROT( double,   d, gemm_skx_avx512_14x16 ) // COMET
 
 
 // end bli_kernels_skx.h
@@ -21427,6 +21428,7 @@ PACKM_KER_PROT( double,   d, packm_knl_asm_30xk )
 #endif
 #ifdef BLIS_KERNELS_HASWELL
 // begin bli_kernels_haswell.h
+GEMM_UKR_PROT( float,    s, gemm_haswell_asm_6x16 )
 GEMM_UKR_PROT( double,   d, gemm_haswell_asm_6x8 )
 // end bli_kernels_haswell.h
 #endif
@@ -224,6 +224,30 @@ Value findCorrespondingAlloc(Value iOp)
   }
 }
 
+/// Load an entry of a pos or crd array as an index value. The arrays of
+/// input tensors read with 32-bit indices are memref<?xi32>.
+Value loadIndexValue(Location loc, Value alloc, ValueRange indices, PatternRewriter &rewriter)
+{
+  Value value = rewriter.create<memref::LoadOp>(loc, alloc, indices);
+  if (!value.getType().isIndex())
+    value = rewriter.create<IndexCastOp>(loc, value, rewriter.getIndexType());
+  return value;
+}
+
+/// Load a nonzero value of a tensor. Pattern-only input tensors have an
+/// empty value array (memref<0xf64>): all their nonzeros are 1, so no load
+/// is emitted for them.
+Value loadTensorValue(Location loc, Value alloc, ValueRange indices, PatternRewriter &rewriter)
+{
+  MemRefType memrefType = alloc.getType().dyn_cast<MemRefType>();
+  if (memrefType && memrefType.hasStaticShape() && memrefType.getNumElements() == 0)
+  {
+    Type elementType = memrefType.getElementType();
+    return rewriter.create<mlir::ConstantOp>(loc, elementType, rewriter.getFloatAttr(elementType, 1.0));
+  }
+  return rewriter.create<memref::LoadOp>(loc, alloc, indices);
+}
+
 /// Get allocs for a tensor (sparse or dense)
 std::vector<Value> getAllocs(Value tensor)
 {
@@ -472,7 +496,7 @@ void genForOps(std::vector<Value> tensors,
         lowerBound = rewriter.create<ConstantIndexOp>(loc, 0);
         auto index_0 = rewriter.create<ConstantIndexOp>(loc, 0);
         std::vector<Value> upper_indices = {index_0};
-        upperBound = rewriter.create<memref::LoadOp>(loc, allAllocs[i][2 * id], upper_indices);
+        upperBound = loadIndexValue(loc, allAllocs[i][2 * id], upper_indices, rewriter);
 
         auto step = rewriter.create<ConstantIndexOp>(loc, 1);
         auto loop = rewriter.create<scf::ForOp>(loc, lowerBound, upperBound, step);
@@ -559,10 +583,10 @@ void genForOps(std::vector<Value> tensors,
         comet_vdump(index_upper);
 
         std::vector<Value> lower_indices = {index_lower};
-        lowerBound = rewriter.create<memref::LoadOp>(loc, allAllocs[i][2 * id], lower_indices);
+        lowerBound = loadIndexValue(loc, allAllocs[i][2 * id], lower_indices, rewriter);
 
         std::vector<Value> upper_indices = {index_upper};
-        upperBound = rewriter.create<memref::LoadOp>(loc, allAllocs[i][2 * id], upper_indices);
+        upperBound = loadIndexValue(loc, allAllocs[i][2 * id], upper_indices, rewriter);
         auto step = rewriter.create<ConstantIndexOp>(loc, 1);
         auto loop = rewriter.create<scf::ForOp>(loc, lowerBound, upperBound, step);
 
@@ -572,7 +596,7 @@ void genForOps(std::vector<Value> tensors,
         rewriter.setInsertionPoint(loop.getBody()->getTerminator());
 
         std::vector<Value> crd_indices = {loop.getInductionVar()};
-        auto get_index = rewriter.create<memref::LoadOp>(loc, allAllocs[i][2 * id + 1], crd_indices);
+        auto get_index = loadIndexValue(loc, allAllocs[i][2 * id + 1], crd_indices, rewriter);
 
         comet_debug() << "CU loop generated\n";
         comet_vdump(loop);
@@ -587,11 +611,11 @@ void genForOps(std::vector<Value> tensors,
       {
         auto index_0 = rewriter.create<ConstantIndexOp>(loc, 0);
         std::vector<Value> lower_indices = {index_0};
-        lowerBound = rewriter.create<memref::LoadOp>(loc, allAllocs[i][2 * id], lower_indices);
+        lowerBound = loadIndexValue(loc, allAllocs[i][2 * id], lower_indices, rewriter);
 
         auto index_1 = rewriter.create<ConstantIndexOp>(loc, 1);
         std::vector<Value> upper_indices = {index_1};
-        upperBound = rewriter.create<memref::LoadOp>(loc, allAllocs[i][2 * id], upper_indices);
+        upperBound = loadIndexValue(loc, allAllocs[i][2 * id], upper_indices, rewriter);
         auto step = rewriter.create<ConstantIndexOp>(loc, 1);
         auto loop = rewriter.create<scf::ForOp>(loc, lowerBound, upperBound, step);
 
@@ -601,7 +625,7 @@ void genForOps(std::vector<Value> tensors,
         rewriter.setInsertionPoint(loop.getBody()->getTerminator());
 
         std::vector<Value> crd_indices = {loop.getInductionVar()};
-        auto get_index = rewriter.create<memref::LoadOp>(loc, allAllocs[i][2 * id + 1], crd_indices);
+        auto get_index = loadIndexValue(loc, allAllocs[i][2 * id + 1], crd_indices, rewriter);
 
         opstree->forOps.push_back(loop);
         opstree->accessIdx.push_back(get_index);
@@ -630,7 +654,7 @@ void genForOps(std::vector<Value> tensors,
         }
 
         std::vector<Value> crd_indices = {last_forop.getInductionVar()};
-        auto get_index = rewriter.create<memref::LoadOp>(loc, allAllocs[i][2 * id + 1], crd_indices);
+        auto get_index = loadIndexValue(loc, allAllocs[i][2 * id + 1], crd_indices, rewriter);
 
         /// Adding one iteration loop to provide consistency with the corresponding index tree.
         /// Index tree includes an index node for the dimension but "S" format for this dimension
@@ -924,7 +948,7 @@ void formSemiringLoopBody(bool comp_worksp_opt, llvm::StringRef &semiringFirst,
       std::vector<Value> allLoadsIf(main_tensor_nums);
       for (int m = 0; m < main_tensor_nums; m++)
       {
-        Value s = rewriter.create<memref::LoadOp>(loc, main_tensors_all_Allocs[m][main_tensors_all_Allocs[m].size() - 1], allValueAccessIdx[m]);
+        Value s = loadTensorValue(loc, main_tensors_all_Allocs[m][main_tensors_all_Allocs[m].size() - 1], allValueAccessIdx[m], rewriter);
         allLoadsIf[m] = s;
         comet_debug() << " ";
         comet_vdump(s);
@@ -966,7 +990,7 @@ void formSemiringLoopBody(bool comp_worksp_opt, llvm::StringRef &semiringFirst,
       std::vector<Value> allLoadsElse(main_tensor_nums);
       for (auto m = 0; m < main_tensor_nums; m++)
       {
-        Value s = rewriter.create<memref::LoadOp>(loc, main_tensors_all_Allocs[m][main_tensors_all_Allocs[m].size() - 1], allValueAccessIdx[m]);
+        Value s = loadTensorValue(loc, main_tensors_all_Allocs[m][main_tensors_all_Allocs[m].size() - 1], allValueAccessIdx[m], rewriter);
         allLoadsElse[m] = s;
         comet_debug() << " ";
         comet_vdump(s);
@@ -984,7 +1008,7 @@ void formSemiringLoopBody(bool comp_worksp_opt, llvm::StringRef &semiringFirst,
     std::vector<Value> allLoads(main_tensor_nums);
     for (auto m = 0; m < main_tensor_nums; m++)
     {
-      Value load_op = rewriter.create<memref::LoadOp>(loc, main_tensors_all_Allocs[m][main_tensors_all_Allocs[m].size() - 1], allValueAccessIdx[m]);
+      Value load_op = loadTensorValue(loc, main_tensors_all_Allocs[m][main_tensors_all_Allocs[m].size() - 1], allValueAccessIdx[m], rewriter);
       allLoads[m] = load_op;
       comet_debug() << " ";
       comet_vdump(load_op);
@@ -1561,7 +1585,7 @@ void genCmptOps(indexTree::IndexTreeComputeOp cur_op,
             // Get dense dim size
             auto index_0 = rewriter.create<ConstantIndexOp>(loc, 0);
             std::vector<Value> upper_indices = {index_0};
-            auto upperBound = rewriter.create<memref::LoadOp>(loc, main_tensors_all_Allocs[i][2 * d], upper_indices);
+            auto upperBound = loadIndexValue(loc, main_tensors_all_Allocs[i][2 * d], upper_indices, rewriter);
             comet_vdump(upperBound);
             valueAccessIdx_part = rewriter.create<mlir::MulIOp>(loc, upperBound, valueAccessIdx_part);
             last_d = d;
@@ -1652,7 +1676,7 @@ void genCmptOps(indexTree::IndexTreeComputeOp cur_op,
         // store %1, a[...]
         comet_debug() << " main_tensors_all_Allocs[" << rhs_loc << "].size(): " << main_tensors_all_Allocs[rhs_loc].size() << ", allValueAccessIdx[" << rhs_loc << "].size(): " << allValueAccessIdx[rhs_loc].size() << "\n";
 
-        Value rhs_value = rewriter.create<memref::LoadOp>(loc, main_tensors_all_Allocs[rhs_loc][main_tensors_all_Allocs[rhs_loc].size() - 1], allValueAccessIdx[rhs_loc]);
+        Value rhs_value = loadTensorValue(loc, main_tensors_all_Allocs[rhs_loc][main_tensors_all_Allocs[rhs_loc].size() - 1], allValueAccessIdx[rhs_loc], rewriter);
         comet_debug() << " ";
         comet_vdump(rhs_value);
 
@@ -1837,7 +1861,7 @@ void genCmptOps(indexTree::IndexTreeComputeOp cur_op,
           //    store Cnnz+1, Cop.operand(4d+1)
           // }
           comet_debug() << " main_tensors_all_Allocs[" << rhs_loc << "].size(): " << main_tensors_all_Allocs[rhs_loc].size() << ", allValueAccessIdx[" << rhs_loc << "].size(): " << allValueAccessIdx[rhs_loc].size() << "\n";
-          Value rhs_value = rewriter.create<memref::LoadOp>(loc, main_tensors_all_Allocs[rhs_loc][main_tensors_all_Allocs[rhs_loc].size() - 1], allValueAccessIdx[rhs_loc]);
+          Value rhs_value = loadTensorValue(loc, main_tensors_all_Allocs[rhs_loc][main_tensors_all_Allocs[rhs_loc].size() - 1], allValueAccessIdx[rhs_loc], rewriter);
           comet_debug() << " ";
           comet_vdump(rhs_value);
           Value isNonzero = rewriter.create<mlir::CmpFOp>(loc, CmpFPredicate::ONE, rhs_value, const_f64_0);
@@ -1974,7 +1998,7 @@ void genCmptOps(indexTree::IndexTreeComputeOp cur_op,
       std::vector<Value> allLoads(main_tensor_nums);
       for (auto m = 0; m < main_tensor_nums; m++)
       {
-        Value s = rewriter.create<memref::LoadOp>(loc, main_tensors_all_Allocs[m][main_tensors_all_Allocs[m].size() - 1], allValueAccessIdx[m]);
+        Value s = loadTensorValue(loc, main_tensors_all_Allocs[m][main_tensors_all_Allocs[m].size() - 1], allValueAccessIdx[m], rewriter);
         allLoads[m] = s;
         comet_debug() << " ";
         comet_vdump(s);
@@ -2264,6 +2288,8 @@ void LowerIndexTreeIRToSCFPass::runOnFunction()
 
   target.addIllegalDialect<tensorAlgebra::TADialect>();
   target.addLegalOp<tensorAlgebra::PrintOp,
+                    tensorAlgebra::WriteOp,
+                    tensorAlgebra::StreamMultOp,
                     tensorAlgebra::TAReturnOp,
                     tensorAlgebra::ReduceOp,
                     tensorAlgebra::TransposeOp,
@@ -371,7 +371,7 @@ namespace
     }
   };
 
-  void insertReadFileLibCall(int rank_size, MLIRContext *ctx, ModuleOp &module, FuncOp function)
+  void insertReadFileLibCall(int rank_size, int indexWidth, MLIRContext *ctx, ModuleOp &module, FuncOp function)
   {
     comet_debug() << "Inserting insertReadFileLibCall\n";
     FloatType f32Type, f64Type;
@@ -390,18 +390,26 @@ namespace
     // TODO(gkestor): there is an issue with F32 UnrankedMemRefType
     auto unrankedMemref_f32 = mlir::UnrankedMemRefType::get(f64Type, 0);
     auto unrankedMemref_index = mlir::UnrankedMemRefType::get(indexType, 0);
+    // pos and crd arrays are index-typed, or i32 for tensors read with 32-bit indices
+    auto unrankedMemref_crd = unrankedMemref_index;
+    std::string crd_suffix = "";
+    if (indexWidth == 32)
+    {
+      unrankedMemref_crd = mlir::UnrankedMemRefType::get(i32Type, 0);
+      crd_suffix = "_i32";
+    }
 
     if (rank_size == 2)
     {
       comet_debug() << " Rank Size is 2\n";
-      auto readInput2DF32Func = FunctionType::get(ctx, {i32Type, indexType, indexType, unrankedMemref_index, unrankedMemref_index, unrankedMemref_index, unrankedMemref_index, unrankedMemref_f32, i32Type}, {});  // last arg (i32Type): readMode
-      auto readInput2DF64Func = FunctionType::get(ctx, {i32Type, indexType, indexType, unrankedMemref_index, unrankedMemref_index, unrankedMemref_index, unrankedMemref_index, unrankedMemref_f64, i32Type}, {});
+      auto readInput2DF32Func = FunctionType::get(ctx, {i32Type, indexType, indexType, unrankedMemref_crd, unrankedMemref_crd, unrankedMemref_crd, unrankedMemref_crd, unrankedMemref_f32, i32Type}, {});  // last arg (i32Type): readMode
+      auto readInput2DF64Func = FunctionType::get(ctx, {i32Type, indexType, indexType, unrankedMemref_crd, unrankedMemref_crd, unrankedMemref_crd, unrankedMemref_crd, unrankedMemref_f64, i32Type}, {});
 
       if (VALUETYPE.compare("f32") == 0)
       {
-        if (isFuncInMod("read_input_2D_f32", module) == false)
+        if (isFuncInMod("read_input_2D_f32" + crd_suffix, module) == false)
         {
-          FuncOp func1 = FuncOp::create(function.getLoc(), "read_input_2D_f32",
+          FuncOp func1 = FuncOp::create(function.getLoc(), "read_input_2D_f32" + crd_suffix,
                                         readInput2DF32Func, ArrayRef<NamedAttribute>{});
           func1.setPrivate();
           module.push_back(func1);
@@ -409,9 +417,9 @@ namespace
       }
       else // f64
       {
-        if (isFuncInMod("read_input_2D_f64", module) == false)
+        if (isFuncInMod("read_input_2D_f64" + crd_suffix, module) == false)
         {
-          FuncOp func1 = FuncOp::create(function.getLoc(), "read_input_2D_f64",
+          FuncOp func1 = FuncOp::create(function.getLoc(), "read_input_2D_f64" + crd_suffix,
                                         readInput2DF64Func, ArrayRef<NamedAttribute>{});
           func1.setPrivate();
           module.push_back(func1);
@@ -419,6 +427,7 @@ namespace
       }
 
       auto readInputSizes2DF64Func = FunctionType::get(ctx, {i32Type, indexType, indexType, unrankedMemref_index, i32Type}, {});  // last arg (i32Type): readMode
+      auto prefetchInput2DFunc = FunctionType::get(ctx, {i32Type, indexType, indexType, i32Type}, {});
 
       if (VALUETYPE.compare("f32") == 0)
       {
@@ -429,6 +438,13 @@ namespace
           func1.setPrivate();
           module.push_back(func1);
         }
+        if (isFuncInMod("prefetch_input_2D_f32", module) == false)
+        {
+          FuncOp func1 = FuncOp::create(function.getLoc(), "prefetch_input_2D_f32",
+                                        prefetchInput2DFunc, ArrayRef<NamedAttribute>{});
+          func1.setPrivate();
+          module.push_back(func1);
+        }
       }
       else
       {
@@ -440,65 +456,128 @@ namespace
           func1.setPrivate();
           module.push_back(func1);
         }
+        if (isFuncInMod("prefetch_input_2D_f64", module) == false)
+        {
+          FuncOp func1 = FuncOp::create(function.getLoc(), "prefetch_input_2D_f64",
+                                        prefetchInput2DFunc, ArrayRef<NamedAttribute>{});
+          func1.setPrivate();
+          module.push_back(func1);
+        }
       }
     }
 
-    // 3D tensor
-    else if (rank_size == 3)
+    // 3D and higher-order tensors, up to 8D: the formats are passed one per dimension,
+    // followed by the pos and crd arrays of every dimension
+    else if (rank_size <= 8)
     {
-      auto readInput3DF32Func = FunctionType::get(ctx, {i32Type, indexType, indexType, indexType, unrankedMemref_index, unrankedMemref_index, unrankedMemref_index, unrankedMemref_index, unrankedMemref_index, unrankedMemref_index, unrankedMemref_f32, i32Type}, {});  // last arg (i32Type): readMode
-      auto readInput3DF64Func = FunctionType::get(ctx, {i32Type, indexType, indexType, indexType, unrankedMemref_index, unrankedMemref_index, unrankedMemref_index, unrankedMemref_index, unrankedMemref_index, unrankedMemref_index, unrankedMemref_f64, i32Type}, {});
-
-      if (VALUETYPE.compare("f32") == 0)
+      comet_debug() << " Rank Size is " << rank_size << "\n";
+      std::string rank_str = std::to_string(rank_size) + "D_";
+      std::string value_str = (VALUETYPE.compare("f32") == 0) ? "f32" : "f64";
+      Type unrankedMemref_val = (VALUETYPE.compare("f32") == 0) ? unrankedMemref_f32 : unrankedMemref_f64;
+
+      SmallVector<Type, 20> readInputArgs{i32Type};
+      readInputArgs.append(rank_size, indexType);
+      readInputArgs.append(2 * rank_size, unrankedMemref_crd);
+      readInputArgs.push_back(unrankedMemref_val);
+      readInputArgs.push_back(i32Type); // readMode
+      auto readInputFunc = FunctionType::get(ctx, readInputArgs, {});
+
+      SmallVector<Type, 11> readInputSizesArgs{i32Type};
+      readInputSizesArgs.append(rank_size, indexType);
+      readInputSizesArgs.push_back(unrankedMemref_index);
+      readInputSizesArgs.push_back(i32Type); // readMode
+      auto readInputSizesFunc = FunctionType::get(ctx, readInputSizesArgs, {});
+
+      SmallVector<Type, 10> prefetchInputArgs{i32Type};
+      prefetchInputArgs.append(rank_size, indexType);
+      prefetchInputArgs.push_back(i32Type); // readMode
+      auto prefetchInputFunc = FunctionType::get(ctx, prefetchInputArgs, {});
+
+      std::pair<std::string, FunctionType> decls[] = {
+          {"read_input_" + rank_str + value_str + crd_suffix, readInputFunc},
+          {"read_input_sizes_" + rank_str + value_str, readInputSizesFunc},
+          {"prefetch_input_" + rank_str + value_str, prefetchInputFunc}};
+      for (auto &decl : decls)
       {
-        if (isFuncInMod("read_input_3D_f32", module) == false)
+        if (isFuncInMod(decl.first, module) == false)
         {
-          FuncOp func1 = FuncOp::create(function.getLoc(), "read_input_3D_f32",
-                                        readInput3DF32Func, ArrayRef<NamedAttribute>{});
+          comet_debug() << " Insert " << decl.first << " decl\n";
+          FuncOp func1 = FuncOp::create(function.getLoc(), decl.first,
+                                        decl.second, ArrayRef<NamedAttribute>{});
           func1.setPrivate();
           module.push_back(func1);
         }
       }
-      else
+    }
+    else
+    {
+      llvm::errs() << __LINE__ << "Not supported dims\n";
+    }
+  }
+
+  /// Emits the runtime call that starts parsing the input file of a sparse
+  /// tensor in the background. The call is placed at the function entry, after
+  /// the calls emitted for the tensors declared before, so that all the inputs
+  /// of the function are parsed while the code in between runs.
+  void insertPrefetchCall(int rank_size, int fileID, std::string formats_str, int readModeVal,
+                          PatternRewriter &rewriter, FuncOp function)
+  {
+    if (fileID < 0)
+      return;
+
+    OpBuilder::InsertionGuard guard(rewriter);
+    Block &entry = function.getBody().front();
+    rewriter.setInsertionPointToStart(&entry);
+    for (Operation &op : entry)
+    {
+      if (auto callOp = dyn_cast<mlir::CallOp>(&op))
       {
-        if (isFuncInMod("read_input_3D_f64", module) == false)
-        {
-          comet_debug() << " Insert read_input_sizes_3D_f64 decl\n";
-          FuncOp func1 = FuncOp::create(function.getLoc(), "read_input_3D_f64",
-                                        readInput3DF64Func, ArrayRef<NamedAttribute>{});
-          func1.setPrivate();
-          module.push_back(func1);
-        }
+        if (callOp.getCallee().startswith("prefetch_input_"))
+          rewriter.setInsertionPointAfter(callOp);
       }
+    }
 
-      auto readInputSizes3DF64Func = FunctionType::get(ctx, {i32Type, indexType, indexType, indexType, unrankedMemref_index, i32Type}, {});  // last arg (i32Type): readMode
+    Location loc = function.getLoc();
+    IndexType indexType = IndexType::get(function.getContext());
+    IntegerType i32Type = IntegerType::get(function.getContext(), 32);
+    Value fileIDConst = rewriter.create<mlir::ConstantOp>(loc, i32Type, rewriter.getIntegerAttr(i32Type, fileID));
+    Value readModeConst = rewriter.create<mlir::ConstantOp>(loc, i32Type, rewriter.getIntegerAttr(i32Type, readModeVal));
+    std::vector<Value> dim_format = mlir::tensorAlgebra::getFormatsValue(formats_str, rank_size, rewriter, loc, indexType);
+
+    std::string prefetch_str = "prefetch_input_" + std::to_string(rank_size) + "D_";
+    prefetch_str += (VALUETYPE.compare(0, 3, "f32") == 0) ? "f32" : "f64";
+
+    SmallVector<Value, 5> args{fileIDConst};
+    args.append(dim_format.begin(), dim_format.end());
+    args.push_back(readModeConst);
+    rewriter.create<mlir::CallOp>(loc, prefetch_str, SmallVector<Type, 2>{}, args);
+  }
 
-      if (VALUETYPE.compare("f32") == 0)
+  /// Replaces the dynamic index labels of a sparse input tensor by static
+  /// ones, whose upper bounds are the dimension sizes read by the runtime.
+  void replaceDynamicIndexLabels(tensorAlgebra::SparseTensorDeclOp tensor_decl_value, std::vector<Value> &array_sizes,
+                                 PatternRewriter &rewriter, Location loc)
+  {
+    unsigned int rank_size = tensor_decl_value.labels().size();
+    LLVM_DEBUG(comet_debug() << " " << rank_size << "\n");
+    for (unsigned int i = 0; i < rank_size; i++)
+    {
+      comet_vdump(tensor_decl_value.labels()[i]);
+      comet_pdump(tensor_decl_value.labels()[i].getDefiningOp());
+      if (isa<tensorAlgebra::IndexLabelDynamicOp>(tensor_decl_value.labels()[i].getDefiningOp()))
       {
-        if (isFuncInMod("read_input_sizes_3D_f32", module) == false)
-        {
-          FuncOp func1 = FuncOp::create(function.getLoc(), "read_input_sizes_3D_f32",
-                                        readInputSizes3DF64Func, ArrayRef<NamedAttribute>{});
-          func1.setPrivate();
-          module.push_back(func1);
-        }
+        auto label_decl_value = cast<tensorAlgebra::IndexLabelDynamicOp>(tensor_decl_value.labels()[i].getDefiningOp());
+        auto lo = label_decl_value.min();
+        auto step = label_decl_value.step();
+        auto hi = array_sizes[2 * rank_size + 1 + i];
+        Value new_index = rewriter.create<IndexLabelStaticOp>(loc, lo, hi, step);
+        label_decl_value.replaceAllUsesWith(new_index);
       }
-      else
+      else if (isa<tensorAlgebra::IndexLabelStaticOp>(tensor_decl_value.labels()[i].getDefiningOp()))
       {
-        if (isFuncInMod("read_input_sizes_3D_f64", module) == false)
-        {
-          comet_debug() << " Insert read_input_sizes_3D_f64 decl\n";
-          FuncOp func1 = FuncOp::create(function.getLoc(), "read_input_sizes_3D_f64",
-                                        readInputSizes3DF64Func, ArrayRef<NamedAttribute>{});
-          func1.setPrivate();
-          module.push_back(func1);
-        }
+        comet_debug() << " isa<tensorAlgebra::IndexLabelStaticOp\n";
       }
     }
-    else
-    {
-      llvm::errs() << __LINE__ << "Not supported dims\n";
-    }
   }
 
   struct SparseTensorDeclOpLowering : public OpRewritePattern<tensorAlgebra::SparseTensorDeclOp>
@@ -622,6 +701,10 @@ namespace
         {
           comet_debug() << " the tensor is in PrintOp\n";
         }
+        else if (isa<tensorAlgebra::WriteOp>(u1))
+        {
+          comet_debug() << " the tensor is in WriteOp\n";
+        }
         else if (isa<tensorAlgebra::ReduceOp>(u1))
         {
           comet_debug() << " the tensor is in ReduceOp\n";
@@ -679,6 +762,8 @@ namespace
         // Currently, has no filename
         std::string input_filename;
         int readModeVal = -1;
+        int indexWidthVal = 64;
+        bool patternVal = false;
         for (auto u : op.getOperation()->getUsers())
         {
           // Used in LabeledTensorOp and then the LabeledTensorOp is used in ChainSetOp
@@ -728,6 +813,8 @@ namespace
             // Can get filename, from "filename" attribute of fillfromfileop
             StringAttr filename = fillfromfileop.filename().cast<StringAttr>();
             IntegerAttr readModeAttr = fillfromfileop.readMode().cast<IntegerAttr>();
+            IntegerAttr indexWidthAttr = fillfromfileop.indexWidth().cast<IntegerAttr>();
+            BoolAttr patternAttr = fillfromfileop.pattern().cast<BoolAttr>();
             rewriter.eraseOp(fillfromfileop);
             
             comet_debug() << " filename: " << filename.getValue() << "\n";
@@ -738,6 +825,12 @@ namespace
 
             readModeVal = readModeAttr.getInt();
             comet_debug() << " readMode: " << readModeVal << "\n";
+
+            indexWidthVal = indexWidthAttr.getInt();
+            comet_debug() << " indexWidth: " << indexWidthVal << "\n";
+
+            patternVal = patternAttr.getValue();
+            comet_debug() << " pattern: " << patternVal << "\n";
           }
         }
 
@@ -754,6 +847,7 @@ namespace
         // inform the runtime of what env var to use for parsing input file
         IntegerType i32Type = IntegerType::get(op.getContext(), 32);
         Value sparseFileID;
+        int intFileID = -1;
         std::size_t pos = input_filename.find("SPARSE_FILE_NAME");
         if (pos == std::string::npos) // not found
         {
@@ -764,30 +858,31 @@ namespace
         std::string fileID = input_filename.substr(pos + 16, 1); // this will only catch 0..9
         if (fileID.empty())
         { // SPARSE_FILE_NAME
-          sparseFileID = rewriter.create<mlir::ConstantOp>(loc, i32Type, rewriter.getIntegerAttr(i32Type, 9999));
+          intFileID = 9999;
+          sparseFileID = rewriter.create<mlir::ConstantOp>(loc, i32Type, rewriter.getIntegerAttr(i32Type, intFileID));
         }
         else
         { // SPARSE_FILE_NAME{int}
           comet_debug() << " Parsed fileID: " << fileID << "\n";
-          int intFileID = std::stoi(fileID);
+          intFileID = std::stoi(fileID);
           sparseFileID = rewriter.create<mlir::ConstantOp>(loc, i32Type, rewriter.getIntegerAttr(i32Type, intFileID));
         }
 
-        Value readModeConst;
         if (readModeVal == -1) // none specified
         { // 1, Default: standard matrix read
-          readModeConst = rewriter.create<mlir::ConstantOp>(loc, i32Type, rewriter.getIntegerAttr(i32Type, 1));
+          readModeVal = 1;
         }
-        else
-        { // readMode specified by user
-          readModeConst = rewriter.create<mlir::ConstantOp>(loc, i32Type, rewriter.getIntegerAttr(i32Type, readModeVal));
+        if (patternVal)
+        { // 16: flag of pattern-only reads, the runtime skips the values
+          readModeVal |= 16;
         }
+        Value readModeConst = rewriter.create<mlir::ConstantOp>(loc, i32Type, rewriter.getIntegerAttr(i32Type, readModeVal));
 
         // Now, setup the runtime calls
         if (rank_size == 2)
         { // 2D
           comet_debug() << " 2D\n";
-          insertReadFileLibCall(rank_size, ctx, module, function);
+          insertReadFileLibCall(rank_size, indexWidthVal, ctx, module, function);
 
           std::string read_input_sizes_str;
           if (VALUETYPE.compare(0, 3, "f32") == 0)
@@ -802,30 +897,32 @@ namespace
                 loc, read_input_sizes_str, SmallVector<Type, 2>{}, ValueRange{sparseFileID, dim_format[0], dim_format[1], alloc_sizes_cast, readModeConst});
           read_input_sizes_Call.getOperation()->setAttr("filename", rewriter.getStringAttr(input_filename));
 
+          // a streamed matrix is never read whole, see below
+          if (!op->hasAttr("stream_panels"))
+            insertPrefetchCall(rank_size, intFileID, formats_str, readModeVal, rewriter, function);
         }
-        else if (rank_size == 3)
-        { // 3D
-
-          comet_debug() << " 3D\n";
-          insertReadFileLibCall(rank_size, ctx, module, function);
-
-          std::string read_input_sizes_str;
-          if (VALUETYPE.compare(0, 3, "f32") == 0)
-          {
-            read_input_sizes_str = "read_input_sizes_3D_f32";
-          }
-          else
-          { // default f64
-            read_input_sizes_str = "read_input_sizes_3D_f64";
-          }
-          auto read_input_sizes_3D_Call = rewriter.create<mlir::CallOp>(
-                loc, read_input_sizes_str, SmallVector<Type, 2>{}, ValueRange{sparseFileID, dim_format[0], dim_format[1], dim_format[2], alloc_sizes_cast, readModeConst});
-          read_input_sizes_3D_Call.getOperation()->setAttr("filename", rewriter.getStringAttr(input_filename));
+        else if (rank_size <= 8)
+        { // 3D and higher-order tensors
+          comet_debug() << " " << rank_size << "D\n";
+          insertReadFileLibCall(rank_size, indexWidthVal, ctx, module, function);
+
+          std::string read_input_sizes_str = "read_input_sizes_" + std::to_string(rank_size) + "D_";
+          read_input_sizes_str += (VALUETYPE.compare(0, 3, "f32") == 0) ? "f32" : "f64";
+
+          SmallVector<Value, 11> read_input_sizes_args{sparseFileID};
+          read_input_sizes_args.append(dim_format.begin(), dim_format.end());
+          read_input_sizes_args.push_back(alloc_sizes_cast);
+          read_input_sizes_args.push_back(readModeConst);
+          auto read_input_sizes_Call = rewriter.create<mlir::CallOp>(
+                loc, read_input_sizes_str, SmallVector<Type, 2>{}, read_input_sizes_args);
+          read_input_sizes_Call.getOperation()->setAttr("filename", rewriter.getStringAttr(input_filename));
           comet_debug() << "\n";
+
+          insertPrefetchCall(rank_size, intFileID, formats_str, readModeVal, rewriter, function);
         }
         else
         {
-          assert(false && " Utility functions to read sparse tensors are supported up to 3 dimensions\n");
+          assert(false && " Utility functions to read sparse tensors are supported up to 8 dimensions\n");
         }
 
         std::vector<Value> array_sizes;
@@ -839,6 +936,26 @@ namespace
           array_sizes.push_back(cor);
         }
 
+        // The matrix is streamed in row panels by the kernel that uses it
+        // (--opt-stream-panels): only its sizes are read here.
+        if (op->hasAttr("stream_panels"))
+        {
+          replaceDynamicIndexLabels(op, array_sizes, rewriter, loc);
+          rewriter.eraseOp(op);
+          return success();
+        }
+
+        // pos and crd arrays are memref<?xindex>, or memref<?xi32> when the tensor is read with 32-bit indices
+        MemRefType dynamicmemTy_1d_crd = dynamicmemTy_1d_index;
+        Type unrankedMemTy_crd = unrankedMemTy_index;
+        std::string crd_suffix = "";
+        if (indexWidthVal == 32)
+        {
+          dynamicmemTy_1d_crd = MemRefType::get({ShapedType::kDynamicSize}, i32Type); // memref<?xi32>
+          unrankedMemTy_crd = UnrankedMemRefType::get(i32Type, 0);
+          crd_suffix = "_i32";
+        }
+
         std::vector<Value> alloc_sizes_cast_vec;
         std::vector<Value> alloc_sizes_vec;
         for (unsigned int i = 0; i < 2 * rank_size; i++)
@@ -846,12 +963,12 @@ namespace
           std::vector<Value> idxes;
           idxes.push_back(array_sizes[i]);
           comet_vdump(array_sizes[i]);
-          Value alloc_size = insertAllocAndInitialize(loc, dynamicmemTy_1d_index, ValueRange{idxes}, rewriter);
+          Value alloc_size = insertAllocAndInitialize(loc, dynamicmemTy_1d_crd, ValueRange{idxes}, rewriter);
           comet_debug() << " ";
           comet_vdump(alloc_size);
 
           alloc_sizes_vec.push_back(alloc_size);
-          Value alloc_size_cast = rewriter.create<memref::CastOp>(loc, alloc_size, unrankedMemTy_index);
+          Value alloc_size_cast = rewriter.create<memref::CastOp>(loc, alloc_size, unrankedMemTy_crd);
           alloc_sizes_cast_vec.push_back(alloc_size_cast);
         }
 
@@ -859,7 +976,17 @@ namespace
         {
           std::vector<Value> idxes;
           idxes.push_back(array_sizes[i]);
-          Value alloc_size = insertAllocAndInitialize(loc, dynamicmemTy_1d_f64, ValueRange{idxes}, rewriter);
+          Value alloc_size;
+          if (patternVal)
+          {
+            // pattern-only tensors have no values: the value array is memref<0xf64>,
+            // and the loops use 1 for all its nonzeros
+            alloc_size = rewriter.create<memref::AllocOp>(loc, MemRefType::get({0}, f64Type));
+          }
+          else
+          {
+            alloc_size = insertAllocAndInitialize(loc, dynamicmemTy_1d_f64, ValueRange{idxes}, rewriter);
+          }
           comet_debug() << " ";
           comet_vdump(alloc_size);
           alloc_sizes_vec.push_back(alloc_size);
@@ -872,37 +999,36 @@ namespace
           std::string read_input_str;
           if (VALUETYPE.compare(0, 3, "f32") == 0)
           {
-            read_input_str = "read_input_2D_f32";
+            read_input_str = "read_input_2D_f32" + crd_suffix;
           }
           else
           {
-            read_input_str = "read_input_2D_f64";
+            read_input_str = "read_input_2D_f64" + crd_suffix;
           }
           auto read_input_f64Call = rewriter.create<mlir::CallOp>(
               loc, read_input_str, SmallVector<Type, 2>{}, ValueRange{sparseFileID, dim_format[0], dim_format[1], alloc_sizes_cast_vec[0], alloc_sizes_cast_vec[1], alloc_sizes_cast_vec[2], alloc_sizes_cast_vec[3], alloc_sizes_cast_vec[4], readModeConst});
           read_input_f64Call.getOperation()->setAttr("filename", rewriter.getStringAttr(input_filename));
         }
-        else if (rank_size == 3)
-        { // 3D
-          std::string read_input_str;
-          if (VALUETYPE.compare(0, 3, "f32") == 0)
-          {
-            read_input_str = "read_input_3D_f32";
-          }
-          else
-          {
-            read_input_str = "read_input_3D_f64";
-          }
+        else if (rank_size <= 8)
+        { // 3D and higher-order tensors
+          std::string read_input_str = "read_input_" + std::to_string(rank_size) + "D_";
+          read_input_str += (VALUETYPE.compare(0, 3, "f32") == 0) ? "f32" : "f64";
+          read_input_str += crd_suffix;
+
+          SmallVector<Value, 26> read_input_args{sparseFileID};
+          read_input_args.append(dim_format.begin(), dim_format.end());
+          read_input_args.append(alloc_sizes_cast_vec.begin(), alloc_sizes_cast_vec.end());
+          read_input_args.push_back(readModeConst);
           auto read_input_f64Call = rewriter.create<mlir::CallOp>(
-              loc, read_input_str, SmallVector<Type, 2>{}, ValueRange{sparseFileID, dim_format[0], dim_format[1], dim_format[2], alloc_sizes_cast_vec[0], alloc_sizes_cast_vec[1], alloc_sizes_cast_vec[2], alloc_sizes_cast_vec[3], alloc_sizes_cast_vec[4], alloc_sizes_cast_vec[5], alloc_sizes_cast_vec[6], readModeConst});
+              loc, read_input_str, SmallVector<Type, 2>{}, read_input_args);
           read_input_f64Call.getOperation()->setAttr("filename", rewriter.getStringAttr(input_filename));
         }
         else
         {
-          llvm::errs() << __LINE__ << " more than 3D, not supported\n";
+          llvm::errs() << __LINE__ << " more than 8D, not supported\n";
         }
 
-        comet_debug() << " Generate read_input_2D or read_input_3D functions\n";
+        comet_debug() << " Generate read_input_*D functions\n";
         std::vector<Value> alloc_tensor_vec;
         for (unsigned int i = 0; i < 2 * rank_size + 1; i++)
         {
@@ -927,49 +1053,17 @@ namespace
 
         auto ty = tensorAlgebra::SparseTensorType::get(elementTypes);
 
-        Value sptensor;
-
-        if (rank_size == 2)
-        {
-          sptensor = rewriter.create<tensorAlgebra::SparseTensorConstructOp>(loc, ty, ValueRange{alloc_tensor_vec[0], alloc_tensor_vec[1], alloc_tensor_vec[2], alloc_tensor_vec[3], alloc_tensor_vec[4], array_sizes[0], array_sizes[1], array_sizes[2], array_sizes[3], array_sizes[4], array_sizes[5], array_sizes[6]});
-        }
-        else if (rank_size == 3)
-        {
-          sptensor = rewriter.create<tensorAlgebra::SparseTensorConstructOp>(loc, ty, ValueRange{alloc_tensor_vec[0], alloc_tensor_vec[1], alloc_tensor_vec[2], alloc_tensor_vec[3], alloc_tensor_vec[4], alloc_tensor_vec[5], alloc_tensor_vec[6], array_sizes[0], array_sizes[1], array_sizes[2], array_sizes[3], array_sizes[4], array_sizes[5], array_sizes[6], array_sizes[7], array_sizes[8], array_sizes[9]});
-        }
-        else
-        {
-          llvm::errs() << __LINE__ << " more than 3D, not supported\n";
-        }
+        // operands: the pos/crd/val tensors, then the sizes of the arrays and the dimensions
+        SmallVector<Value, 41> sptensor_operands(alloc_tensor_vec.begin(), alloc_tensor_vec.end());
+        sptensor_operands.append(array_sizes.begin(), array_sizes.end());
+        Value sptensor = rewriter.create<tensorAlgebra::SparseTensorConstructOp>(loc, ty, sptensor_operands);
 
         comet_debug() << "SparseTensorConstructOp generated for input sparse tensor:\n";
         comet_vdump(sptensor);
 
         // create ta.index_label operation.
         comet_vdump(op);
-
-        auto tensor_decl_value = cast<tensorAlgebra::SparseTensorDeclOp>(op);
-        LLVM_DEBUG(comet_debug() << " " << tensor_decl_value.labels().size() << "\n");
-        for (unsigned int i = 0; i < tensor_decl_value.labels().size(); i++)
-        {
-          comet_vdump(tensor_decl_value.labels()[i]);
-          comet_pdump(tensor_decl_value.labels()[i].getDefiningOp());
-          if (isa<tensorAlgebra::IndexLabelDynamicOp>(tensor_decl_value.labels()[i].getDefiningOp()))
-          {
-            // comet_vdump(tensor_decl_value.labels()[i]);
-            auto label_decl_value = cast<tensorAlgebra::IndexLabelDynamicOp>(tensor_decl_value.labels()[i].getDefiningOp());
-            auto lo = label_decl_value.min();
-            auto step = label_decl_value.step();
-            auto hi = array_sizes[2 * rank_size + 1 + i];
-            // mlir::Value value =
-            Value new_index = rewriter.create<IndexLabelStaticOp>(loc, lo, hi, step);
-            label_decl_value.replaceAllUsesWith(new_index);
-          }
-          else if (isa<tensorAlgebra::IndexLabelStaticOp>(tensor_decl_value.labels()[i].getDefiningOp()))
-          {
-            comet_debug() << " isa<tensorAlgebra::IndexLabelStaticOp\n";
-          }
-        }
+        replaceDynamicIndexLabels(op, array_sizes, rewriter, loc);
 
         op.replaceAllUsesWith(sptensor);
         rewriter.replaceOp(op, sptensor);
@@ -1377,6 +1471,11 @@ namespace
           comet_debug() << "The tensor is in print op,  no action taken\n";
           continue;
         }
+        else if (isa<tensorAlgebra::WriteOp>(u))
+        {
+          comet_debug() << "The tensor is in write op,  no action taken\n";
+          continue;
+        }
         else if (isa<tensorAlgebra::ReduceOp>(u))
         {
           comet_debug() << "The tensor is in sum op,  no action taken\n";
@@ -1678,6 +1777,8 @@ void DenseTensorDeclLoweringPass::runOnFunction()
 
   // target.addIllegalDialect<tensorAlgebra::TADialect>();
   target.addLegalOp<tensorAlgebra::PrintOp,
+                    tensorAlgebra::WriteOp,
+                    tensorAlgebra::StreamMultOp,
                     tensorAlgebra::TAReturnOp,
                     tensorAlgebra::ReduceOp,
                     tensorAlgebra::TransposeOp,
@@ -1727,6 +1828,8 @@ void SparseTensorDeclLoweringPass::runOnFunction()
 
   // target.addIllegalDialect<tensorAlgebra::TADialect>();
   target.addLegalOp<tensorAlgebra::PrintOp,
+                    tensorAlgebra::WriteOp,
+                    tensorAlgebra::StreamMultOp,
                     tensorAlgebra::TAReturnOp,
                     tensorAlgebra::ReduceOp,
                     tensorAlgebra::TransposeOp,
@@ -1771,6 +1874,8 @@ void SparseOutputTensorDeclLoweringPass::runOnFunction()
                          ITDialect>();
 
   target.addLegalOp<tensorAlgebra::PrintOp,
+                    tensorAlgebra::WriteOp,
+                    tensorAlgebra::StreamMultOp,
                     tensorAlgebra::TAReturnOp,
                     tensorAlgebra::ReduceOp,
                     tensorAlgebra::TransposeOp,
@@ -1812,6 +1917,8 @@ void TempSparseOutputTensorDeclLoweringPass::runOnFunction()
                          ITDialect>();
 
   target.addLegalOp<tensorAlgebra::PrintOp,
+                    tensorAlgebra::WriteOp,
+                    tensorAlgebra::StreamMultOp,
                     tensorAlgebra::TAReturnOp,
                     tensorAlgebra::ReduceOp,
                     tensorAlgebra::TransposeOp,
@@ -193,20 +193,40 @@ namespace
             int tensorRanks = (op->getOperand(0).getDefiningOp()->getNumOperands() - 2) / 5;
             Type unrankedMemref_index = mlir::UnrankedMemRefType::get(indexType, 0);
 
+            // pos and crd arrays of tensors read with 32-bit indices are printed with comet_print_memref_i32
+            auto printIndexArray = [&](memref::AllocOp alloc_rhs)
+            {
+              Type elementType = alloc_rhs.getType().getElementType();
+              if (elementType.isInteger(32))
+              {
+                std::string comet_print_i32Str = "comet_print_memref_i32";
+                if (isFuncInMod(comet_print_i32Str, module) == false)
+                {
+                  auto printTensorI32Func = FunctionType::get(ctx, {mlir::UnrankedMemRefType::get(elementType, 0)}, {});
+                  print_func = FuncOp::create(loc, comet_print_i32Str, printTensorI32Func, ArrayRef<NamedAttribute>{});
+                  print_func.setPrivate();
+                  module.push_back(print_func);
+                }
+                auto u = rewriter.create<memref::CastOp>(loc, alloc_rhs, mlir::UnrankedMemRefType::get(elementType, 0));
+                rewriter.create<mlir::CallOp>(loc, comet_print_i32Str, SmallVector<Type, 2>{}, ValueRange{u});
+              }
+              else
+              {
+                auto u = rewriter.create<memref::CastOp>(loc, alloc_rhs, unrankedMemref_index);
+                rewriter.create<mlir::CallOp>(loc, comet_print_i64Str, SmallVector<Type, 2>{}, ValueRange{u});
+              }
+            };
+
             auto rhs = op->getOperand(0).getDefiningOp();
             for (int rsize = 0; rsize < tensorRanks; rsize++)
             {
               // accessing xD_pos array and creating cast op for its alloc
               auto xD_pos = rhs->getOperand(rsize * 2).getDefiningOp();
-              auto alloc_rhs = cast<memref::AllocOp>(xD_pos->getOperand(0).getDefiningOp());
-              auto u = rewriter.create<memref::CastOp>(loc, alloc_rhs, unrankedMemref_index);
-              rewriter.create<mlir::CallOp>(loc, comet_print_i64Str, SmallVector<Type, 2>{}, ValueRange{u});
+              printIndexArray(cast<memref::AllocOp>(xD_pos->getOperand(0).getDefiningOp()));
 
               // accessing xD_crd array and creating cast op for its alloc
               auto xD_crd = rhs->getOperand((rsize * 2) + 1).getDefiningOp();
-              alloc_rhs = cast<memref::AllocOp>(xD_crd->getOperand(0).getDefiningOp());
-              u = rewriter.create<memref::CastOp>(loc, alloc_rhs, unrankedMemref_index);
-              rewriter.create<mlir::CallOp>(loc, comet_print_i64Str, SmallVector<Type, 2>{}, ValueRange{u});
+              printIndexArray(cast<memref::AllocOp>(xD_crd->getOperand(0).getDefiningOp()));
             }
 
             auto xD_value = rhs->getOperand(tensorRanks * 2).getDefiningOp();
@@ -225,6 +245,164 @@ namespace
     }
   };
 
+  /// Lowers `ta.write` to a call to the runtime writer of dense tensors
+  /// (comet_write_dense_f64) or of 2D/3D sparse tensors (comet_write_sparse_2D_f64,
+  /// comet_write_sparse_3D_f64), which take the format of each dimension, the
+  /// dimension sizes and the pos, crd and value arrays.
+  class WriteOpLowering : public ConversionPattern
+  {
+  public:
+    explicit WriteOpLowering(MLIRContext *context)
+        : ConversionPattern(tensorAlgebra::WriteOp::getOperationName(), 1, context) {}
+
+    LogicalResult
+    matchAndRewrite(Operation *op, ArrayRef<Value> operands,
+                    ConversionPatternRewriter &rewriter) const override
+    {
+      Location loc = op->getLoc();
+      auto module = op->getParentOfType<ModuleOp>();
+      auto *ctx = op->getContext();
+      auto writeOp = cast<tensorAlgebra::WriteOp>(op);
+      FloatType f64Type = FloatType::getF64(ctx);
+      IndexType indexType = IndexType::get(ctx);
+      IntegerType i32Type = IntegerType::get(ctx, 32);
+      Type unrankedMemrefType_f64 = UnrankedMemRefType::get(f64Type, 0);
+
+      Value fileID = rewriter.create<mlir::ConstantOp>(loc, i32Type, rewriter.getI32IntegerAttr(writeOp.fileID()));
+      auto inputType = op->getOperand(0).getType();
+
+      if (inputType.isa<MemRefType>() || inputType.isa<TensorType>())
+      {
+        // The dense tensor is written from its buffer
+        Value alloc_op = op->getOperand(0);
+        if (inputType.isa<TensorType>())
+          alloc_op = op->getOperand(0).getDefiningOp()->getOperand(0);
+
+        std::string comet_write_f64Str = "comet_write_dense_f64";
+        if (isFuncInMod(comet_write_f64Str, module) == false)
+        {
+          auto writeTensorF64Func = FunctionType::get(ctx, {i32Type, unrankedMemrefType_f64}, {});
+          FuncOp write_func = FuncOp::create(loc, comet_write_f64Str, writeTensorF64Func, ArrayRef<NamedAttribute>{});
+          write_func.setPrivate();
+          module.push_back(write_func);
+        }
+
+        auto u = rewriter.create<memref::CastOp>(loc, alloc_op, unrankedMemrefType_f64);
+        rewriter.create<mlir::CallOp>(loc, comet_write_f64Str, SmallVector<Type, 2>{}, ValueRange{fileID, u});
+      }
+      else if (inputType.isa<SparseTensorType>())
+      {
+        // SparseTensorType includes 5 metadata per dimension. Additionally, 2 elements for value array, value array size.
+        // TODO(gkestor): get tensor ranks by functions
+        auto rhs = op->getOperand(0).getDefiningOp();
+        int tensorRanks = (rhs->getNumOperands() - 2) / 5;
+        if (tensorRanks != 2 && tensorRanks != 3)
+        {
+          llvm::errs() << __FILE__ << " " << __LINE__ << " comet_write() supports 2D and 3D sparse tensors only\n";
+          return failure();
+        }
+
+        // the pos and crd arrays, then the value array
+        std::vector<memref::AllocOp> allocs;
+        for (int i = 0; i < 2 * tensorRanks + 1; i++)
+          allocs.push_back(cast<memref::AllocOp>(rhs->getOperand(i).getDefiningOp()->getOperand(0).getDefiningOp()));
+
+        // tensors read with 32-bit indices are written with the _i32 variant
+        Type indexElementType = allocs[0].getType().getElementType();
+        bool isI32 = indexElementType.isInteger(32);
+        Type unrankedMemrefType_index = UnrankedMemRefType::get(isI32 ? indexElementType : indexType, 0);
+
+        std::vector<Value> dim_format = mlir::tensorAlgebra::getFormatsValueInt(writeOp.format().str(), tensorRanks, rewriter, loc, i32Type);
+        assert((int)dim_format.size() == tensorRanks && "unsupported format of the tensor written by comet_write()");
+
+        SmallVector<Value, 16> args{fileID};
+        SmallVector<Type, 16> argTypes{i32Type};
+        for (int d = 0; d < tensorRanks; d++)
+        {
+          args.push_back(dim_format[d]);
+          argTypes.push_back(i32Type);
+        }
+        for (int d = 0; d < tensorRanks; d++)
+        {
+          args.push_back(rhs->getOperand(4 * tensorRanks + 2 + d));
+          argTypes.push_back(indexType);
+        }
+        for (int i = 0; i < 2 * tensorRanks; i++)
+        {
+          args.push_back(rewriter.create<memref::CastOp>(loc, allocs[i], unrankedMemrefType_index));
+          argTypes.push_back(unrankedMemrefType_index);
+        }
+        args.push_back(rewriter.create<memref::CastOp>(loc, allocs[2 * tensorRanks], unrankedMemrefType_f64));
+        argTypes.push_back(unrankedMemrefType_f64);
+
+        std::string comet_write_Str = "comet_write_sparse_" + std::to_string(tensorRanks) + "D_f64";
+        if (isI32)
+          comet_write_Str += "_i32";
+        if (isFuncInMod(comet_write_Str, module) == false)
+        {
+          auto writeTensorFunc = FunctionType::get(ctx, argTypes, {});
+          FuncOp write_func = FuncOp::create(loc, comet_write_Str, writeTensorFunc, ArrayRef<NamedAttribute>{});
+          write_func.setPrivate();
+          module.push_back(write_func);
+        }
+        rewriter.create<mlir::CallOp>(loc, comet_write_Str, SmallVector<Type, 2>{}, ValueRange(args));
+      }
+      else
+      {
+        llvm::errs() << __FILE__ << " " << __LINE__ << "Unknown Data type\n";
+        return failure();
+      }
+
+      rewriter.eraseOp(op);
+      return success();
+    }
+  };
+
+  /// Lowers `ta.stream_mult` to a call to the runtime kernel that streams the
+  /// CSR input of the fileID in row panels (comet_stream_csr_mult_f64), with
+  /// the buffers of the dense operand and of the output.
+  class StreamMultOpLowering : public ConversionPattern
+  {
+  public:
+    explicit StreamMultOpLowering(MLIRContext *context)
+        : ConversionPattern(tensorAlgebra::StreamMultOp::getOperationName(), 1, context) {}
+
+    LogicalResult
+    matchAndRewrite(Operation *op, ArrayRef<Value> operands,
+                    ConversionPatternRewriter &rewriter) const override
+    {
+      Location loc = op->getLoc();
+      auto module = op->getParentOfType<ModuleOp>();
+      auto *ctx = op->getContext();
+      auto streamOp = cast<tensorAlgebra::StreamMultOp>(op);
+      IntegerType i32Type = IntegerType::get(ctx, 32);
+
+      // the dense tensors are read from and written to their buffers
+      Value rhs_alloc = op->getOperand(0).getDefiningOp()->getOperand(0);
+      Value output_alloc = op->getOperand(1).getDefiningOp()->getOperand(0);
+      Type elementType = rhs_alloc.getType().cast<MemRefType>().getElementType();
+      Type unrankedMemrefType = UnrankedMemRefType::get(elementType, 0);
+
+      std::string comet_stream_Str = elementType.isF32() ? "comet_stream_csr_mult_f32" : "comet_stream_csr_mult_f64";
+      if (isFuncInMod(comet_stream_Str, module) == false)
+      {
+        auto streamFunc = FunctionType::get(ctx, {i32Type, i32Type, unrankedMemrefType, unrankedMemrefType}, {});
+        FuncOp stream_func = FuncOp::create(loc, comet_stream_Str, streamFunc, ArrayRef<NamedAttribute>{});
+        stream_func.setPrivate();
+        module.push_back(stream_func);
+      }
+
+      Value fileID = rewriter.create<mlir::ConstantOp>(loc, i32Type, rewriter.getI32IntegerAttr(streamOp.fileID()));
+      Value readMode = rewriter.create<mlir::ConstantOp>(loc, i32Type, rewriter.getI32IntegerAttr(streamOp.readMode()));
+      Value rhs = rewriter.create<memref::CastOp>(loc, rhs_alloc, unrankedMemrefType);
+      Value output = rewriter.create<memref::CastOp>(loc, output_alloc, unrankedMemrefType);
+      rewriter.create<mlir::CallOp>(loc, comet_stream_Str, SmallVector<Type, 2>{}, ValueRange{fileID, readMode, rhs, output});
+
+      rewriter.eraseOp(op);
+      return success();
+    }
+  };
+
   class GetTimeLowering : public ConversionPattern
   {
   public:
@@ -335,6 +513,8 @@ void LateLoweringPass::runOnFunction()
   OwningRewritePatternList patterns(&getContext());
   patterns.insert<ReturnOpLowering,
                   PrintOpLowering,
+                  WriteOpLowering,
+                  StreamMultOpLowering,
                   GetTimeLowering,
                   PrintElapsedTimeLowering>(&getContext());
 
@@ -338,12 +338,16 @@ namespace
             if (i < 2 * tensor_rank)
             {
               // indexes crd's
+              assert(alloc_op.getType().cast<MemRefType>().getElementType().isIndex() &&
+                     "ERROR: sparse transpose does not support tensors read with 32-bit indices.\n");
               mlir::Value v = rewriter.create<memref::CastOp>(loc, alloc_op, unrankedMemrefType_index);
               alloc_sizes_cast_vecs[n].push_back(v);
             }
             else
             {
               // NNZ vals
+              assert(!alloc_op.getType().cast<MemRefType>().hasStaticShape() &&
+                     "ERROR: sparse transpose does not support pattern-only tensors.\n");
               mlir::Value v = rewriter.create<memref::CastOp>(loc, alloc_op, unrankedMemrefType_f64);
               alloc_sizes_cast_vecs[n].push_back(v);
             }
@@ -398,33 +402,43 @@ namespace
                                                    alloc_sizes_cast_vecs[1][3], alloc_sizes_cast_vecs[1][4],
                                                    sparse_tensor_desc});
         }
-        else if (rank_size == 3)
-        { // 3D
-          auto transpose3DF64Func = FunctionType::get(ctx, {i32Type, i32Type, i32Type, i32Type, i32Type, unrankedMemrefType_index, unrankedMemrefType_index, unrankedMemrefType_index, unrankedMemrefType_index, unrankedMemrefType_index, unrankedMemrefType_index, unrankedMemrefType_f64, i32Type, i32Type, i32Type, unrankedMemrefType_index, unrankedMemrefType_index, unrankedMemrefType_index, unrankedMemrefType_index, unrankedMemrefType_index, unrankedMemrefType_index, unrankedMemrefType_f64, unrankedMemrefType_index},
-                                                      {});
+        else if (rank_size <= 6)
+        { // 3D to 6D: transpose_<rank>D_f64(input_perm, output_perm,
+          //   A formats, A pos/crd arrays, A vals, B formats, B pos/crd arrays, B vals, sizes)
+          std::vector<Type> transposeArgTypes = {i32Type, i32Type};
+          std::vector<Value> transposeArgs = {input_perm_num, output_perm_num};
+          for (unsigned int n = 0; n < tensors_num; n++)
+          {
+            std::vector<Value> &dim_format = (n == 0) ? dim_formatIn : dim_formatOut;
+            for (unsigned int d = 0; d < rank_size; d++)
+            {
+              transposeArgTypes.push_back(i32Type);
+              transposeArgs.push_back(dim_format[d]);
+            }
+            for (auto v : alloc_sizes_cast_vecs[n])
+            {
+              transposeArgTypes.push_back(v.getType());
+              transposeArgs.push_back(v);
+            }
+          }
+          transposeArgTypes.push_back(unrankedMemrefType_index);
+          transposeArgs.push_back(sparse_tensor_desc);
 
-          std::string print_transpose_3D_f64Str = "transpose_3D_f64";
-          if (isFuncInMod(print_transpose_3D_f64Str, module) == false)
+          auto transposeNDF64Func = FunctionType::get(ctx, transposeArgTypes, {});
+
+          std::string print_transpose_ND_f64Str = "transpose_" + std::to_string(rank_size) + "D_f64";
+          if (isFuncInMod(print_transpose_ND_f64Str, module) == false)
           {
-            transpose_func = FuncOp::create(loc, print_transpose_3D_f64Str, transpose3DF64Func, ArrayRef<NamedAttribute>{});
+            transpose_func = FuncOp::create(loc, print_transpose_ND_f64Str, transposeNDF64Func, ArrayRef<NamedAttribute>{});
             transpose_func.setPrivate();
             module.push_back(transpose_func);
           }
 
-          rewriter.create<mlir::CallOp>(loc, print_transpose_3D_f64Str, SmallVector<Type, 2>{},
-                                        ValueRange{input_perm_num, output_perm_num, dim_formatIn[0], dim_formatIn[1], dim_formatIn[2],
-                                                   alloc_sizes_cast_vecs[0][0], alloc_sizes_cast_vecs[0][1],
-                                                   alloc_sizes_cast_vecs[0][2], alloc_sizes_cast_vecs[0][3],
-                                                   alloc_sizes_cast_vecs[0][4], alloc_sizes_cast_vecs[0][5],
-                                                   alloc_sizes_cast_vecs[0][6], dim_formatOut[0], dim_formatOut[1],
-                                                   dim_formatOut[2], alloc_sizes_cast_vecs[1][0], alloc_sizes_cast_vecs[1][1],
-                                                   alloc_sizes_cast_vecs[1][2], alloc_sizes_cast_vecs[1][3],
-                                                   alloc_sizes_cast_vecs[1][4], alloc_sizes_cast_vecs[1][5], alloc_sizes_cast_vecs[1][6],
-                                                   sparse_tensor_desc});
+          rewriter.create<mlir::CallOp>(loc, print_transpose_ND_f64Str, SmallVector<Type, 2>{}, transposeArgs);
         }
         else
         {
-          assert(false && "ERROR: Tensors greater than 3 are not currently supported.\n");
+          assert(false && "ERROR: Tensors greater than 6 are not currently supported.\n");
         }
 
         rewriter.eraseOp(setOp);
@@ -565,6 +579,8 @@ namespace
         auto alloc_op = op->getOperand(0).getDefiningOp()->getOperand(indexValuePtr).getDefiningOp()->getOperand(0);
         comet_debug() << " ValueAllocOp";
         comet_vdump(alloc_op);
+        assert(!alloc_op.getType().cast<MemRefType>().hasStaticShape() &&
+               "ERROR: reduction does not support pattern-only tensors.\n");
         std::vector<Value> indices = {loop.getInductionVar()};
         auto load_rhs = rewriter.create<memref::LoadOp>(loc, alloc_op, indices);
         auto res_load = rewriter.create<memref::LoadOp>(loc, res, alloc_zero_loc);
@@ -70,6 +70,8 @@ namespace
   class LinAlgMatmulTilingPass : public PassWrapper<LinAlgMatmulTilingPass, FunctionPass>
   {
   public:
+    LinAlgMatmulTilingPass(const GemmBlocking &f64_blocking, const GemmBlocking &f32_blocking)
+        : f64_blocking(f64_blocking), f32_blocking(f32_blocking){};
     void runOnFunction() override
     {
       // OwningRewritePatternList patterns;
@@ -77,11 +79,23 @@ namespace
       auto funcOp = getFunction();
       MLIRContext *ctx = funcOp.getContext();
 
+      // f32 matmuls are tiled for the sgemm micro-kernel: mark them apart
+      funcOp.walk([&](MatmulOp op)
+                  {
+                    auto marker = op->getAttrOfType<StringAttr>(LinalgTransforms::kLinalgTransformMarker);
+                    auto outputType = op.getOperand(2).getType().dyn_cast<MemRefType>();
+                    if (marker && marker.getValue() == "__with_tiling__" &&
+                        outputType && outputType.getElementType().isF32())
+                      op->setAttr(LinalgTransforms::kLinalgTransformMarker,
+                                  StringAttr::get(ctx, "__with_tiling_f32__"));
+                  });
+
       OwningRewritePatternList patterns(&getContext());
 
       // Add the matmul tiling patterns to the list.
       //===----------------------------------------------------------------------===//
-      // BLIS HASWELL
+      // BLIS blocking: MC x NC x KC tiles (the packed blocks of A and B), then
+      // MR x NR x KC tiles (the micro-kernel). For BLIS HASWELL:
       //===----------------------------------------------------------------------===//
       //#define BLIS_DGEMM_UKERNEL         bli_dgemm_asm_8x6
       //#define BLIS_DEFAULT_MC_D          72
@@ -89,27 +103,39 @@ namespace
       //#define BLIS_DEFAULT_NC_D          4080
       //#define BLIS_DEFAULT_MR_D          8
       //#define BLIS_DEFAULT_NR_D          6
+      insertTilingPatterns(patterns, f64_blocking, "__with_tiling__", "L2__with_tiling__");
+      insertTilingPatterns(patterns, f32_blocking, "__with_tiling_f32__", "L2__with_tiling_f32__");
+
+      (void)applyPatternsAndFoldGreedily(funcOp, std::move(patterns));
+    }
+
+  private:
+    // Tiles the matmuls marked with marker for the given blocking
+    void insertTilingPatterns(OwningRewritePatternList &patterns, const GemmBlocking &blocking,
+                              StringRef marker, StringRef l2_marker)
+    {
+      MLIRContext *ctx = &getContext();
 
       patterns.insert<LinalgTilingPattern<MatmulOp>>(
           ctx,
           LinalgTilingOptions()
-              .setTileSizes({72, 4080, 256})
+              .setTileSizes({blocking.mc, blocking.nc, blocking.kc})
               .setInterchange({1, 2, 0})
               .setLoopType(LinalgTilingLoopType::Loops),
-          LinalgTransformationFilter(Identifier::get("__with_tiling__", ctx),
-                                     Identifier::get("L2__with_tiling__", ctx)));
+          LinalgTransformationFilter(Identifier::get(marker, ctx),
+                                     Identifier::get(l2_marker, ctx)));
 
       patterns.insert<LinalgTilingPattern<MatmulOp>>(
           ctx,
           LinalgTilingOptions()
-              .setTileSizes({6, 8, 256})
+              .setTileSizes({blocking.mr, blocking.nr, blocking.kc})
               .setInterchange({1, 0, 2})
               .setLoopType(LinalgTilingLoopType::Loops),
-          LinalgTransformationFilter(Identifier::get("L2__with_tiling__", ctx),
+          LinalgTransformationFilter(Identifier::get(l2_marker, ctx),
                                      Identifier::get("__micro_kernel__", ctx)));
-
-      (void)applyPatternsAndFoldGreedily(funcOp, std::move(patterns));
     }
+
+    GemmBlocking f64_blocking, f32_blocking;
   };
 } // end anonymous namespace
 
@@ -220,6 +246,15 @@ LogicalResult LinalgMatMulOpToLibraryCallRewrite::matchAndRewrite(
   if (!isa<MatmulOp>(op))
     return failure();
 
+  // the runtime library has f64 and f32 micro-kernels, for operands of the
+  // same element type
+  Type elementType = op->getOperand(0).getType().cast<MemRefType>().getElementType();
+  if (!elementType.isF64() && !elementType.isF32())
+    return failure();
+  for (Value operand : op->getOperands())
+    if (operand.getType().cast<MemRefType>().getElementType() != elementType)
+      return failure();
+
   auto libraryCallName = getLibraryCallSymbolRef(op, rewriter);
   if (!libraryCallName)
     return failure();
@@ -464,6 +499,86 @@ namespace
   };
 } // end anonymous namespace
 
+namespace
+{
+  // Replaces a permuting linalg.copy with a call to the blocked, multithreaded
+  // dense transpose of the runtime library:
+  //   comet_dense_transpose_f64(input_perm, output_perm, input, output)
+  // where the permutations have one decimal digit per dimension, as for the
+  // sparse transposes
+  class DenseTransposeToLibraryCall : public OpRewritePattern<CopyOp>
+  {
+  public:
+    using OpRewritePattern<CopyOp>::OpRewritePattern;
+    LogicalResult matchAndRewrite(CopyOp op,
+                                  PatternRewriter &rewriter) const override
+    {
+      if (!op.inputPermutation().hasValue() || !op.outputPermutation().hasValue())
+        return failure();
+
+      AffineMap inputMap = op.inputPermutation().getValue();
+      AffineMap outputMap = op.outputPermutation().getValue();
+      if (!inputMap.isPermutation() || !outputMap.isPermutation() ||
+          inputMap.getNumResults() > 9)
+        return failure();
+
+      auto inputType = op->getOperand(0).getType().cast<MemRefType>();
+      Type elementType = inputType.getElementType();
+      std::string funcName;
+      if (elementType.isF64())
+        funcName = "comet_dense_transpose_f64";
+      else if (elementType.isF32())
+        funcName = "comet_dense_transpose_f32";
+      else
+        return failure();
+
+      int32_t input_perm_num = 0, output_perm_num = 0;
+      for (auto expr : inputMap.getResults())
+        input_perm_num = input_perm_num * 10 + expr.cast<AffineDimExpr>().getPosition();
+      for (auto expr : outputMap.getResults())
+        output_perm_num = output_perm_num * 10 + expr.cast<AffineDimExpr>().getPosition();
+      comet_debug() << " DenseTransposeToLibraryCall: " << funcName << "(" << input_perm_num << ", " << output_perm_num << ")\n";
+
+      Location loc = op.getLoc();
+      auto module = op->getParentOfType<ModuleOp>();
+      IntegerType i32Type = rewriter.getI32Type();
+      Type unrankedMemrefType = UnrankedMemRefType::get(elementType, 0);
+
+      if (isFuncInMod(funcName, module) == false)
+      {
+        auto transposeFuncType = FunctionType::get(op.getContext(), {i32Type, i32Type, unrankedMemrefType, unrankedMemrefType}, {});
+        FuncOp transpose_func = FuncOp::create(loc, funcName, transposeFuncType, ArrayRef<NamedAttribute>{});
+        transpose_func.setPrivate();
+        module.push_back(transpose_func);
+      }
+
+      Value input_perm = rewriter.create<mlir::ConstantOp>(loc, i32Type, rewriter.getIntegerAttr(i32Type, input_perm_num));
+      Value output_perm = rewriter.create<mlir::ConstantOp>(loc, i32Type, rewriter.getIntegerAttr(i32Type, output_perm_num));
+      Value input = rewriter.create<memref::CastOp>(loc, op->getOperand(0), unrankedMemrefType);
+      Value output = rewriter.create<memref::CastOp>(loc, op->getOperand(1), unrankedMemrefType);
+
+      rewriter.replaceOpWithNewOp<mlir::CallOp>(op, funcName, SmallVector<Type, 2>{},
+                                                ValueRange{input_perm, output_perm, input, output});
+      return success();
+    }
+  };
+
+  class DenseTransposeLibraryCallPass : public PassWrapper<DenseTransposeLibraryCallPass, FunctionPass>
+  {
+  public:
+    void runOnFunction() override
+    {
+      comet_debug() << "DenseTransposeLibraryCallPass : public PassWrapper<DenseTransposeLibraryCallPass, FunctionPass>\n";
+      auto funcOp = getFunction();
+      MLIRContext *ctx = funcOp.getContext();
+
+      OwningRewritePatternList patterns(&getContext());
+      patterns.insert<DenseTransposeToLibraryCall>(ctx);
+      (void)applyPatternsAndFoldGreedily(funcOp, std::move(patterns));
+    }
+  };
+} // end anonymous namespace
+
 namespace
 {
   class LowerLinAlgFillOpPass : public PassWrapper<LowerLinAlgFillOpPass, FunctionPass>
@@ -484,12 +599,13 @@ namespace
 } // end anonymous namespace
 
 /// Create a pass to optimize LinAlg Matmul Op with tiling
-std::unique_ptr<mlir::Pass> mlir::tensorAlgebra::createLinAlgMatmulTilingPass()
+std::unique_ptr<mlir::Pass> mlir::tensorAlgebra::createLinAlgMatmulTilingPass(const GemmBlocking &f64_blocking,
+                                                                              const GemmBlocking &f32_blocking)
 {
-  return std::make_unique<LinAlgMatmulTilingPass>();
+  return std::make_unique<LinAlgMatmulTilingPass>(f64_blocking, f32_blocking);
 }
 
-/// Create a pass to call a blis micro kernel for the inner linalg.matmul after tiling
+/// Create a pass to call a blis micro kernel for the inner f64 and f32 linalg.matmul after tiling
 std::unique_ptr<mlir::Pass> mlir::tensorAlgebra::createLinAlgMatmulMicroKernelPass()
 {
   return std::make_unique<LinAlgMatmulMicroKernelPass>();
@@ -505,6 +621,13 @@ std::unique_ptr<mlir::Pass> mlir::tensorAlgebra::createOptDenseTransposePass(uin
   return std::make_unique<OptDenseTransposePass>(tile_size, seperate_tiles);
 }
 
+/// Create a pass to replace permuting LinAlg Copy Ops with calls to the
+/// blocked, multithreaded dense transpose of the runtime library
+std::unique_ptr<mlir::Pass> mlir::tensorAlgebra::createDenseTransposeLibraryCallPass()
+{
+  return std::make_unique<DenseTransposeLibraryCallPass>();
+}
+
 /// Create a pass to convert linalg.fill to loops
 std::unique_ptr<mlir::Pass> mlir::tensorAlgebra::createLowerLinAlgFillPass()
 {
@@ -134,6 +134,14 @@ namespace
     void runOnFunction() final;
   };
 
+  struct StreamRowPanelsPass
+      : public PassWrapper<StreamRowPanelsPass, FunctionPass>
+  {
+    void runOnFunction() final;
+
+    void StreamRowPanels(tensorAlgebra::TensorMultOp op);
+  };
+
 } // end anonymous namespace.
 
 void removeAllUsers(Operation *op)
@@ -565,6 +573,8 @@ void LowerTAMulChainPass::runOnFunction()
 
   // target.addIllegalDialect<tensorAlgebra::TADialect>();
   target.addLegalOp<tensorAlgebra::PrintOp,
+                    tensorAlgebra::WriteOp,
+                    tensorAlgebra::StreamMultOp,
                     tensorAlgebra::TAReturnOp,
                     tensorAlgebra::ReduceOp,
                     tensorAlgebra::TransposeOp,
@@ -605,6 +615,106 @@ void STCRemoveDeadOpsPass::runOnFunction()
   }
 }
 
+/**
+ * Replaces C = A * B, where A is a CSR matrix read from a file and B and C
+ * are dense vectors (SpMV) or matrices (SpMM), by a ta.stream_mult op. The
+ * runtime reads the rows of A in panels while it computes the product, so A
+ * is never materialized. A is left with its sizes only: its declaration gets
+ * a "stream_panels" attribute, and must have no other use.
+ */
+void StreamRowPanelsPass::StreamRowPanels(tensorAlgebra::TensorMultOp op)
+{
+  // C = A * B with the standard semiring, without scaling
+  if (op.semiring() != "plusxy_times")
+    return;
+  auto alphaAttr = op->getAttrOfType<FloatAttr>("__alpha__");
+  auto betaAttr = op->getAttrOfType<FloatAttr>("__beta__");
+  if ((alphaAttr && alphaAttr.getValueAsDouble() != 1.0) || (betaAttr && betaAttr.getValueAsDouble() != 0.0))
+    return;
+
+  // (i, j) * (j) -> (i), or (i, j) * (j, k) -> (i, k)
+  auto allPerms = getAllPerms(op.indexing_maps());
+  if (allPerms.size() != 3 || allPerms[0].size() != 2)
+    return;
+  unsigned i = allPerms[0][0], j = allPerms[0][1];
+  bool isSpMV = allPerms[1] == std::vector<unsigned>{j} && allPerms[2] == std::vector<unsigned>{i};
+  bool isSpMM = allPerms[1].size() == 2 && allPerms[1][0] == j && allPerms[1][1] != i && allPerms[1][1] != j &&
+                allPerms[2] == std::vector<unsigned>{i, allPerms[1][1]};
+  if (!isSpMV && !isSpMM)
+    return;
+
+  auto allFormats = getAllFormats(op.formatsAttr(), allPerms);
+  if (allFormats[0] != std::vector<std::string>{"D", "CU"})
+    return;
+  for (unsigned t = 1; t < 3; t++)
+  {
+    for (auto &format : allFormats[t])
+      if (format != "D")
+        return;
+  }
+
+  // the product is stored to a dense tensor
+  if (!op->hasOneUse() || !isa<tensorAlgebra::TensorSetOp>(*op->getUsers().begin()))
+    return;
+  auto setOp = cast<tensorAlgebra::TensorSetOp>(*op->getUsers().begin());
+  if (setOp.getOperand(0) != op.getResult())
+    return;
+  Value rhs = op.rhs2();
+  Value output = setOp.getOperand(1);
+  if (!rhs.getDefiningOp<tensorAlgebra::DenseTensorDeclOp>() || !output.getDefiningOp<tensorAlgebra::DenseTensorDeclOp>())
+    return;
+
+  // A is read from SPARSE_FILE_NAME<fileID> with 64-bit indices, and only used here
+  auto declOp = op.rhs1().getDefiningOp<tensorAlgebra::SparseTensorDeclOp>();
+  if (!declOp)
+    return;
+  tensorAlgebra::TensorFillFromFileOp fillOp;
+  for (auto u : declOp->getUsers())
+  {
+    if (u == op.getOperation())
+      continue;
+    if (!isa<tensorAlgebra::TensorFillFromFileOp>(u) || fillOp)
+      return;
+    fillOp = cast<tensorAlgebra::TensorFillFromFileOp>(u);
+  }
+  if (!fillOp || fillOp.indexWidth().cast<IntegerAttr>().getInt() != 64)
+    return;
+
+  std::string filename(fillOp.filename().cast<StringAttr>().getValue());
+  std::size_t pos = filename.find("SPARSE_FILE_NAME");
+  if (pos == std::string::npos)
+    return;
+  // 16 is the length of SPARSE_FILE_NAME
+  std::string fileID = filename.substr(pos + 16, 1);
+  int intFileID = fileID.empty() ? 9999 : std::stoi(fileID);
+
+  int readMode = fillOp.readMode().cast<IntegerAttr>().getInt();
+  if (readMode == -1)
+    readMode = 1;
+  if (fillOp.pattern().cast<BoolAttr>().getValue())
+    readMode |= 16;
+
+  comet_debug() << " streaming the rows of the CSR input of fileID " << intFileID << "\n";
+  OpBuilder builder(setOp);
+  builder.create<tensorAlgebra::StreamMultOp>(setOp.getLoc(), rhs, output,
+                                              builder.getI32IntegerAttr(intFileID),
+                                              builder.getI32IntegerAttr(readMode));
+  setOp.erase();
+  op.erase();
+  declOp->setAttr("stream_panels", builder.getUnitAttr());
+}
+
+void StreamRowPanelsPass::runOnFunction()
+{
+  comet_debug() << " start StreamRowPanelsPass \n";
+  std::vector<tensorAlgebra::TensorMultOp> mulOps;
+  getFunction().walk([&](tensorAlgebra::TensorMultOp op)
+                     { mulOps.push_back(op); });
+
+  for (auto op : mulOps)
+    StreamRowPanels(op);
+}
+
 std::unique_ptr<Pass> mlir::tensorAlgebra::createFindOptimalTCFactorizationPass()
 {
   return std::make_unique<FindOptimalTCFactorizationPass>();
@@ -620,3 +730,8 @@ std::unique_ptr<Pass> mlir::tensorAlgebra::createSTCRemoveDeadOpsPass()
 {
   return std::make_unique<STCRemoveDeadOpsPass>();
 }
+
+std::unique_ptr<Pass> mlir::tensorAlgebra::createStreamRowPanelsPass()
+{
+  return std::make_unique<StreamRowPanelsPass>();
+}
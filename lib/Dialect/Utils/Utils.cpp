@@ -146,6 +146,11 @@ namespace mlir
         comet_debug() << "Element type Index\n";
         cst_init = rewriter.create<ConstantIndexOp>(loc, 0);
       }
+      else if (elementType.isInteger(32))
+      {
+        comet_debug() << "Element type I32\n";
+        cst_init = rewriter.create<ConstantOp>(loc, rewriter.getI32Type(), rewriter.getI32IntegerAttr(0));
+      }
       else if (elementType.isInteger(1))
       {
         comet_debug() << "Element type I1 - boolean\n";
@@ -956,6 +961,48 @@ namespace mlir
           comet_debug() << " formats_str: " << formats_str << ", dim_format.size(): " << dim_format.size() << " \n";
         }
       }
+      else if (rank_size > 3)
+      { // 4D and higher: CSF, COO, or the format of every dimension
+        comet_debug() << " " << rank_size << "D\n";
+        if (formats_str.compare(0, 3, "CSF") == 0)
+        {
+          for (int d = 0; d < rank_size; d++)
+            dim_format.push_back(format_compressed);
+        }
+        else if (formats_str.compare(0, 3, "COO") == 0)
+        { // COO
+          dim_format.push_back(format_compressednonunique);
+          for (int d = 1; d < rank_size; d++)
+            dim_format.push_back(format_singleton);
+        }
+        else
+        {
+          std::vector<std::string> format_vec = stringSplit(formats_str, ", ");
+          for (auto n : format_vec)
+          {
+            if (n.compare(0, 1, "D") == 0)
+            {
+              dim_format.push_back(format_dense);
+            }
+            else if (n.compare(0, 2, "CU") == 0)
+            {
+              dim_format.push_back(format_compressed);
+            }
+            else if (n.compare(0, 2, "CN") == 0)
+            {
+              dim_format.push_back(format_compressednonunique);
+            }
+            else if (n.compare(0, 1, "S") == 0)
+            {
+              dim_format.push_back(format_singleton);
+            }
+            else
+            {
+              llvm::errs() << "Uncorrect format attribute: " << n << "---\n";
+            }
+          }
+        }
+      }
       else
       {
         llvm::errs() << "Unsupported formats: " << formats_str << " (tensor dimes: " << rank_size << ") \n";
@@ -1082,6 +1129,48 @@ namespace mlir
           comet_debug() << " formats_str: " << formats_str << ", dim_format.size(): " << dim_format.size() << " \n";
         }
       }
+      else if (rank_size > 3)
+      { // 4D and higher: CSF, COO, or the format of every dimension
+        comet_debug() << " " << rank_size << "D\n";
+        if (formats_str.compare(0, 3, "CSF") == 0)
+        {
+          for (int d = 0; d < rank_size; d++)
+            dim_format.push_back(format_compressed);
+        }
+        else if (formats_str.compare(0, 3, "COO") == 0)
+        { // COO
+          dim_format.push_back(format_compressednonunique);
+          for (int d = 1; d < rank_size; d++)
+            dim_format.push_back(format_singleton);
+        }
+        else
+        {
+          std::vector<std::string> format_vec = stringSplit(formats_str, ", ");
+          for (auto n : format_vec)
+          {
+            if (n.compare(0, 1, "D") == 0)
+            {
+              dim_format.push_back(format_dense);
+            }
+            else if (n.compare(0, 2, "CU") == 0)
+            {
+              dim_format.push_back(format_compressed);
+            }
+            else if (n.compare(0, 2, "CN") == 0)
+            {
+              dim_format.push_back(format_compressednonunique);
+            }
+            else if (n.compare(0, 1, "S") == 0)
+            {
+              dim_format.push_back(format_singleton);
+            }
+            else
+            {
+              llvm::errs() << "Uncorrect format attribute: " << n << "---\n";
+            }
+          }
+        }
+      }
       else
       {
         llvm::errs() << "Unsupported formats: " << formats_str << " (tensor dimes: " << rank_size << ") \n";
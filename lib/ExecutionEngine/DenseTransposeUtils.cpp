@@ -0,0 +1,484 @@
+//===- DenseTransposeUtils.cpp - Runtime dense tensor transpose -----------===//
+//
+// Copyright 2022 Battelle Memorial Institute
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+// and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+// and the following disclaimer in the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file includes the runtime function that dense tensor transposes
+// (permuting linalg.copy operations) are lowered to. It follows HPTT:
+//   HPTT: A High-Performance Tensor Transposition C++ Library
+//   https://arxiv.org/abs/1704.04374
+// The loops of the copy are ordered so that the output is written
+// contiguously, and the two dimensions that are contiguous in the input and
+// in the output are blocked and transposed in SIMD registers (AVX2 or
+// AVX-512, picked at run time). The blocks are spread over threads.
+//
+//===----------------------------------------------------------------------===//
+
+#include "comet/ExecutionEngine/RunnerUtils.h"
+#include "comet/ExecutionEngine/ParallelUtils.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define COMET_DENSE_TRANSPOSE_X86
+#endif
+
+using namespace std;
+
+// Instruction sets of the micro-kernels
+enum TransposeISA
+{
+  SCALAR = 0,
+  AVX2 = 1,
+  AVX512 = 2
+};
+
+// Best instruction set the host supports
+int getTransposeISA()
+{
+  static const int isa = []()
+  {
+#ifdef COMET_DENSE_TRANSPOSE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f"))
+      return (int)AVX512;
+    if (__builtin_cpu_supports("avx2"))
+      return (int)AVX2;
+#endif
+    return (int)SCALAR;
+  }();
+
+  return isa;
+}
+
+// Side of the square blocks that a thread transposes at once: a block of
+// the input and one of the output fit in the L1 cache together
+const int64_t block_size = 32;
+
+// Outputs larger than this are written with streaming stores, since they
+// would not stay in the cache anyway
+const int64_t streaming_bytes = 8 << 20;
+
+// Minimum number of elements per thread
+const int64_t min_elements_per_thread = 1 << 15;
+
+/**
+ * @brief Transposes an ni x nj block: B[i * ldb + j] = A[j * lda + i].
+ * i runs along the dimension that is contiguous in A, and j along the one
+ * that is contiguous in B.
+ */
+template <typename T>
+void transpose_block_scalar(const T *A, int64_t lda, T *B, int64_t ldb,
+                            int64_t ni, int64_t nj)
+{
+  for (int64_t i = 0; i < ni; i++)
+    for (int64_t j = 0; j < nj; j++)
+      B[i * ldb + j] = A[j * lda + i];
+}
+
+#ifdef COMET_DENSE_TRANSPOSE_X86
+//===----------------------------------------------------------------------===//
+// Micro-kernels: w x w in-register transposes, w being the vector length
+//===----------------------------------------------------------------------===//
+template <bool streaming>
+__attribute__((target("avx2"))) inline void store_avx2(double *B, __m256d v)
+{
+  if (streaming)
+    _mm256_stream_pd(B, v);
+  else
+    _mm256_storeu_pd(B, v);
+}
+
+template <bool streaming>
+__attribute__((target("avx2"))) inline void store_avx2(float *B, __m256 v)
+{
+  if (streaming)
+    _mm256_stream_ps(B, v);
+  else
+    _mm256_storeu_ps(B, v);
+}
+
+// 4 x 4 doubles
+template <bool streaming>
+__attribute__((target("avx2"))) inline void micro_kernel_avx2(const double *A, int64_t lda, double *B, int64_t ldb)
+{
+  __m256d r0 = _mm256_loadu_pd(A);
+  __m256d r1 = _mm256_loadu_pd(A + lda);
+  __m256d r2 = _mm256_loadu_pd(A + 2 * lda);
+  __m256d r3 = _mm256_loadu_pd(A + 3 * lda);
+
+  __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+  __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+  __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+  __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+
+  store_avx2<streaming>(B, _mm256_permute2f128_pd(t0, t2, 0x20));
+  store_avx2<streaming>(B + ldb, _mm256_permute2f128_pd(t1, t3, 0x20));
+  store_avx2<streaming>(B + 2 * ldb, _mm256_permute2f128_pd(t0, t2, 0x31));
+  store_avx2<streaming>(B + 3 * ldb, _mm256_permute2f128_pd(t1, t3, 0x31));
+}
+
+// 8 x 8 floats
+template <bool streaming>
+__attribute__((target("avx2"))) inline void micro_kernel_avx2(const float *A, int64_t lda, float *B, int64_t ldb)
+{
+  __m256 r[8], t[8];
+  for (int k = 0; k < 8; k++)
+    r[k] = _mm256_loadu_ps(A + k * lda);
+
+  for (int k = 0; k < 8; k += 2)
+  {
+    t[k] = _mm256_unpacklo_ps(r[k], r[k + 1]);
+    t[k + 1] = _mm256_unpackhi_ps(r[k], r[k + 1]);
+  }
+  for (int k = 0; k < 8; k += 4)
+  {
+    r[k] = _mm256_shuffle_ps(t[k], t[k + 2], 0x44);
+    r[k + 1] = _mm256_shuffle_ps(t[k], t[k + 2], 0xee);
+    r[k + 2] = _mm256_shuffle_ps(t[k + 1], t[k + 3], 0x44);
+    r[k + 3] = _mm256_shuffle_ps(t[k + 1], t[k + 3], 0xee);
+  }
+  for (int k = 0; k < 4; k++)
+  {
+    store_avx2<streaming>(B + k * ldb, _mm256_permute2f128_ps(r[k], r[k + 4], 0x20));
+    store_avx2<streaming>(B + (k + 4) * ldb, _mm256_permute2f128_ps(r[k], r[k + 4], 0x31));
+  }
+}
+
+// 8 x 8 doubles
+template <bool streaming>
+__attribute__((target("avx512f"))) inline void micro_kernel_avx512(const double *A, int64_t lda, double *B, int64_t ldb)
+{
+  __m512d r[8], t[8];
+  for (int k = 0; k < 8; k++)
+    r[k] = _mm512_loadu_pd(A + k * lda);
+
+  // t[k], t[k + 1]: the even and odd elements of rows k and k + 1, interleaved
+  for (int k = 0; k < 8; k += 2)
+  {
+    t[k] = _mm512_unpacklo_pd(r[k], r[k + 1]);
+    t[k + 1] = _mm512_unpackhi_pd(r[k], r[k + 1]);
+  }
+  // r[k], r[k + 1], ...: 128-bit lanes of rows k to k + 3 with the same elements
+  for (int k = 0; k < 8; k += 4)
+  {
+    r[k] = _mm512_shuffle_f64x2(t[k], t[k + 2], 0x88);
+    r[k + 1] = _mm512_shuffle_f64x2(t[k + 1], t[k + 3], 0x88);
+    r[k + 2] = _mm512_shuffle_f64x2(t[k], t[k + 2], 0xdd);
+    r[k + 3] = _mm512_shuffle_f64x2(t[k + 1], t[k + 3], 0xdd);
+  }
+  for (int k = 0; k < 4; k++)
+  {
+    __m512d lo = _mm512_shuffle_f64x2(r[k], r[k + 4], 0x88);
+    __m512d hi = _mm512_shuffle_f64x2(r[k], r[k + 4], 0xdd);
+    if (streaming)
+    {
+      _mm512_stream_pd(B + k * ldb, lo);
+      _mm512_stream_pd(B + (k + 4) * ldb, hi);
+    }
+    else
+    {
+      _mm512_storeu_pd(B + k * ldb, lo);
+      _mm512_storeu_pd(B + (k + 4) * ldb, hi);
+    }
+  }
+}
+
+// Transposes an ni x nj block (see transpose_block_scalar) with the
+// micro-kernels, and the edges that they do not cover with scalar code
+template <bool streaming, typename T>
+__attribute__((target("avx2"))) void transpose_block_avx2(const T *A, int64_t lda, T *B, int64_t ldb,
+                                                          int64_t ni, int64_t nj)
+{
+  const int64_t w = 32 / sizeof(T);
+  int64_t ni_w = ni - ni % w, nj_w = nj - nj % w;
+  for (int64_t i = 0; i < ni_w; i += w)
+  {
+    for (int64_t j = 0; j < nj_w; j += w)
+      micro_kernel_avx2<streaming>(A + j * lda + i, lda, B + i * ldb + j, ldb);
+    transpose_block_scalar(A + nj_w * lda + i, lda, B + i * ldb + nj_w, ldb, w, nj - nj_w);
+  }
+  transpose_block_scalar(A + ni_w, lda, B + ni_w * ldb, ldb, ni - ni_w, nj);
+}
+
+template <bool streaming>
+__attribute__((target("avx512f"))) void transpose_block_avx512(const double *A, int64_t lda, double *B, int64_t ldb,
+                                                               int64_t ni, int64_t nj)
+{
+  const int64_t w = 8;
+  int64_t ni_w = ni - ni % w, nj_w = nj - nj % w;
+  for (int64_t i = 0; i < ni_w; i += w)
+  {
+    for (int64_t j = 0; j < nj_w; j += w)
+      micro_kernel_avx512<streaming>(A + j * lda + i, lda, B + i * ldb + j, ldb);
+    transpose_block_scalar(A + nj_w * lda + i, lda, B + i * ldb + nj_w, ldb, w, nj - nj_w);
+  }
+  transpose_block_scalar(A + ni_w, lda, B + ni_w * ldb, ldb, ni - ni_w, nj);
+}
+
+// Vector length of the micro-kernel of isa, in bytes
+int vectorBytes(int isa)
+{
+  return (isa == AVX512) ? 64 : 32;
+}
+
+void transpose_block(int isa, bool streaming, const double *A, int64_t lda, double *B, int64_t ldb,
+                     int64_t ni, int64_t nj)
+{
+  if (isa == AVX512)
+    streaming ? transpose_block_avx512<true>(A, lda, B, ldb, ni, nj)
+              : transpose_block_avx512<false>(A, lda, B, ldb, ni, nj);
+  else if (isa == AVX2)
+    streaming ? transpose_block_avx2<true>(A, lda, B, ldb, ni, nj)
+              : transpose_block_avx2<false>(A, lda, B, ldb, ni, nj);
+  else
+    transpose_block_scalar(A, lda, B, ldb, ni, nj);
+}
+
+// floats use the 8 x 8 AVX2 micro-kernel on AVX-512 hosts too
+void transpose_block(int isa, bool streaming, const float *A, int64_t lda, float *B, int64_t ldb,
+                     int64_t ni, int64_t nj)
+{
+  if (isa != SCALAR)
+    streaming ? transpose_block_avx2<true>(A, lda, B, ldb, ni, nj)
+              : transpose_block_avx2<false>(A, lda, B, ldb, ni, nj);
+  else
+    transpose_block_scalar(A, lda, B, ldb, ni, nj);
+}
+
+int transposeISA(const float *) { return getTransposeISA() == SCALAR ? SCALAR : AVX2; }
+int transposeISA(const double *) { return getTransposeISA(); }
+#else
+int vectorBytes(int isa) { return 1; }
+
+template <typename T>
+void transpose_block(int isa, bool streaming, const T *A, int64_t lda, T *B, int64_t ldb,
+                     int64_t ni, int64_t nj)
+{
+  transpose_block_scalar(A, lda, B, ldb, ni, nj);
+}
+
+template <typename T>
+int transposeISA(const T *) { return SCALAR; }
+#endif
+
+// One loop of the copy: its extent and the strides of A and B along it
+struct transpose_loop_t
+{
+  int64_t extent;
+  int64_t strideA;
+  int64_t strideB;
+};
+
+/**
+ * @brief Copies A to B, permuted: B[output_permutation(ivs)] = A[input_permutation(ivs)]
+ * for every index ivs of the iteration space, as linalg.copy does.
+ *
+ * @param input_permutation, output_permutation results of the permutation
+ *      maps of the copy, one decimal digit per dimension: for example, 1023
+ *      for (d0, d1, d2, d3) -> (d1, d0, d2, d3)
+ */
+template <typename T>
+void transpose_dense(int32_t input_permutation, int32_t output_permutation,
+                     const DynamicMemRefType<T> &A, const DynamicMemRefType<T> &B)
+{
+  int rank = (int)A.rank;
+  assert(B.rank == rank && "ERROR: the input and output of a dense transpose have different ranks.\n");
+
+  vector<int> idigits(rank), odigits(rank);
+  for (int d = rank - 1; d >= 0; d--)
+  {
+    idigits[d] = input_permutation % 10;
+    odigits[d] = output_permutation % 10;
+    input_permutation /= 10;
+    output_permutation /= 10;
+  }
+
+  // loops[d]: loop of index d of the iteration space
+  vector<transpose_loop_t> loops(rank);
+  for (int p = 0; p < rank; p++)
+  {
+    loops[idigits[p]].extent = A.sizes[p];
+    loops[idigits[p]].strideA = A.strides[p];
+  }
+  for (int q = 0; q < rank; q++)
+  {
+    assert(B.sizes[q] == loops[odigits[q]].extent && "ERROR: the output of a dense transpose does not match its input.\n");
+    loops[odigits[q]].strideB = B.strides[q];
+  }
+
+  const T *Adata = A.data + A.offset;
+  T *Bdata = B.data + B.offset;
+
+  // drop the loops of a single iteration, and order the others by their
+  // stride in B, so that the innermost loop writes B contiguously
+  int64_t num_elements = 1;
+  for (auto &loop : loops)
+    num_elements *= loop.extent;
+  if (num_elements == 0)
+    return;
+  loops.erase(std::remove_if(loops.begin(), loops.end(), [](const transpose_loop_t &loop)
+                             { return loop.extent == 1; }),
+              loops.end());
+  std::stable_sort(loops.begin(), loops.end(), [](const transpose_loop_t &l, const transpose_loop_t &r)
+                   { return std::abs(l.strideB) > std::abs(r.strideB); });
+
+  // fuse neighbouring loops that are contiguous in both A and B
+  vector<transpose_loop_t> fused;
+  for (auto &loop : loops)
+  {
+    if (!fused.empty() &&
+        fused.back().strideA == loop.strideA * loop.extent &&
+        fused.back().strideB == loop.strideB * loop.extent)
+    {
+      fused.back().extent *= loop.extent;
+      fused.back().strideA = loop.strideA;
+      fused.back().strideB = loop.strideB;
+    }
+    else
+      fused.push_back(loop);
+  }
+  loops.swap(fused);
+  if (loops.empty())
+    loops.push_back({1, 1, 1});
+
+  // the loop along which B is contiguous is the innermost one (j); the one
+  // along which A is contiguous (i), if another, becomes the second
+  // innermost and the two are transposed block by block
+  transpose_loop_t loop_j = loops.back();
+  loops.pop_back();
+
+  transpose_loop_t loop_i = {1, 0, 0};
+  if (loop_j.strideB == 1 && loop_j.strideA != 1)
+  {
+    for (size_t d = 0; d < loops.size(); d++)
+    {
+      if (loops[d].strideA == 1)
+      {
+        loop_i = loops[d];
+        loops.erase(loops.begin() + d);
+        break;
+      }
+    }
+  }
+  bool blocked = (loop_i.extent > 1);
+
+  // when all the rows of B have the same alignment, a first narrow block
+  // along j brings the others to aligned addresses of B: the micro-kernels
+  // do not split cache lines, and can use streaming stores on large outputs
+  int isa = transposeISA(Adata);
+  bool aligned_rows = blocked && isa != SCALAR;
+  int64_t vector_length = aligned_rows ? vectorBytes(isa) / (int64_t)sizeof(T) : 1;
+  aligned_rows = aligned_rows && loop_i.strideB % vector_length == 0;
+  for (auto &loop : loops)
+    aligned_rows = aligned_rows && loop.strideB % vector_length == 0;
+  int64_t peel_j = 0;
+  if (aligned_rows)
+    peel_j = std::min<int64_t>(loop_j.extent, (vector_length - ((uintptr_t)Bdata / sizeof(T)) % vector_length) % vector_length);
+  bool streaming = aligned_rows && num_elements * (int64_t)sizeof(T) > streaming_bytes;
+
+  // the iteration space is split in tasks: every index of the outer loops,
+  // times every block of the two inner ones
+  int64_t block_i = blocked ? block_size : 1;
+  int64_t block_j = blocked ? block_size : min_elements_per_thread;
+  int64_t num_blocks_i = (loop_i.extent + block_i - 1) / block_i;
+  int64_t num_blocks_j = (peel_j > 0) + (loop_j.extent - peel_j + block_j - 1) / block_j;
+  int64_t num_outer = 1;
+  for (auto &loop : loops)
+    num_outer *= loop.extent;
+  int64_t num_tasks = num_outer * num_blocks_i * num_blocks_j;
+
+  int num_threads = (int)std::max<int64_t>(1, std::min<int64_t>(getNumThreads(), num_elements / min_elements_per_thread));
+  num_threads = (int)std::min<int64_t>(num_threads, num_tasks);
+
+  // every thread takes a contiguous range of tasks
+  parallelFor(num_threads, num_threads, [&](int t)
+              {
+                int64_t first = num_tasks * t / num_threads;
+                int64_t last = num_tasks * (t + 1) / num_threads;
+                for (int64_t task = first; task < last; task++)
+                {
+                  int64_t bj = task % num_blocks_j;
+                  int64_t bi = (task / num_blocks_j) % num_blocks_i;
+                  int64_t outer = task / (num_blocks_j * num_blocks_i);
+
+                  // offsets of the outer index, the last outer loop fastest
+                  const T *a = Adata;
+                  T *b = Bdata;
+                  for (int d = (int)loops.size() - 1; d >= 0; d--)
+                  {
+                    int64_t index = outer % loops[d].extent;
+                    outer /= loops[d].extent;
+                    a += index * loops[d].strideA;
+                    b += index * loops[d].strideB;
+                  }
+
+                  int64_t i0 = bi * block_i, j0 = 0;
+                  int64_t ni = std::min(block_i, loop_i.extent - i0);
+                  int64_t nj = peel_j;
+                  if (peel_j == 0 || bj > 0)
+                  {
+                    j0 = peel_j + (bj - (peel_j > 0)) * block_j;
+                    nj = std::min(block_j, loop_j.extent - j0);
+                  }
+                  a += i0 * loop_i.strideA + j0 * loop_j.strideA;
+                  b += i0 * loop_i.strideB + j0 * loop_j.strideB;
+
+                  if (blocked)
+                    transpose_block(isa, streaming, a, loop_j.strideA, b, loop_i.strideB, ni, nj);
+                  else if (loop_j.strideA == 1 && loop_j.strideB == 1)
+                    memcpy(b, a, nj * sizeof(T));
+                  else
+                  {
+                    for (int64_t j = 0; j < nj; j++)
+                      b[j * loop_j.strideB] = a[j * loop_j.strideA];
+                  }
+                }
+#ifdef COMET_DENSE_TRANSPOSE_X86
+                if (streaming)
+                  _mm_sfence();
+#endif
+              });
+}
+
+extern "C" void comet_dense_transpose_f32(int32_t input_permutation, int32_t output_permutation,
+                                          int64_t A_rank, void *A_ptr, int64_t B_rank, void *B_ptr)
+{
+  UnrankedMemRefType<float> A = {A_rank, A_ptr};
+  UnrankedMemRefType<float> B = {B_rank, B_ptr};
+  transpose_dense<float>(input_permutation, output_permutation,
+                         DynamicMemRefType<float>(A), DynamicMemRefType<float>(B));
+}
+
+extern "C" void comet_dense_transpose_f64(int32_t input_permutation, int32_t output_permutation,
+                                          int64_t A_rank, void *A_ptr, int64_t B_rank, void *B_ptr)
+{
+  UnrankedMemRefType<double> A = {A_rank, A_ptr};
+  UnrankedMemRefType<double> B = {B_rank, B_ptr};
+  transpose_dense<double>(input_permutation, output_permutation,
+                          DynamicMemRefType<double>(A), DynamicMemRefType<double>(B));
+}
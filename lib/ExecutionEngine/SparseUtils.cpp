@@ -29,11 +29,30 @@
 #include <sys/time.h>
 #include <math.h>
 #include <cstdio>
+#include <cinttypes>
+#include <cstdarg>
 #include <limits>
 #include <iomanip>
 
 #include <random>
 #include <map>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "comet/ExecutionEngine/ParallelUtils.h"
 
 enum MatrixReadOption
 {
@@ -41,13 +60,21 @@ enum MatrixReadOption
   LOWER_TRI_STRICT = 2, 
   LOWER_TRI = 3,
   UPPER_TRI_STRICT = 4,
-  UPPER_TRI = 5
+  UPPER_TRI = 5,
+  PATTERN_READ = 16  // flag added to the above: pattern-only read, the value array is left empty
 };
 
+// helper func: whether the tensor is read pattern-only, without its values
+inline bool isPatternRead(int32_t readMode)
+{
+  return (readMode & PATTERN_READ) != 0;
+}
+
 // helper func: inquire matrix read type 
 int getMatrixReadOption(int32_t readMode) 
 {
   int selected_matrix_read = DEFAULT;
+  readMode &= ~PATTERN_READ;
 
   if (readMode == LOWER_TRI_STRICT)
     selected_matrix_read = LOWER_TRI_STRICT;
@@ -61,6 +88,670 @@ int getMatrixReadOption(int32_t readMode)
   return selected_matrix_read;
 }
 
+// helper func: whether the selected matrix read keeps the nonzero at (row, col)
+inline bool keepMatrixEntry(int selected_matrix_read, int64_t row, int64_t col)
+{
+  if (selected_matrix_read == LOWER_TRI_STRICT)
+    return row > col;
+  else if (selected_matrix_read == LOWER_TRI)
+    return row >= col;
+  else if (selected_matrix_read == UPPER_TRI_STRICT)
+    return row < col;
+  else if (selected_matrix_read == UPPER_TRI)
+    return row <= col;
+  else // DEFAULT
+    return true;
+}
+
+//===----------------------------------------------------------------------===//
+// Memory-mapped input files and line-based parsing helpers.
+//===----------------------------------------------------------------------===//
+
+/**
+ * Read-only view of a whole input file. The file is memory-mapped, so the
+ * readers can split it into line-aligned chunks and parse them in parallel
+ * without copying the text around.
+ */
+struct MappedFile
+{
+  const char *data;
+  size_t size;
+  bool mapped;
+
+  MappedFile() : data(NULL), size(0), mapped(false) {}
+
+  bool Open(const string &filename)
+  {
+#ifndef _WIN32
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+      return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+      close(fd);
+      return false;
+    }
+
+    size = st.st_size;
+    if (size > 0)
+    {
+      void *addr = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr == MAP_FAILED)
+      {
+        close(fd);
+        return false;
+      }
+      madvise(addr, size, MADV_SEQUENTIAL);
+      data = static_cast<const char *>(addr);
+      mapped = true;
+    }
+    close(fd);
+    return true;
+#else
+    FILE *fp = fopen(filename.c_str(), "rb");
+    if (!fp)
+      return false;
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char *buffer = new char[size + 1];
+    size = fread(buffer, 1, size, fp);
+    fclose(fp);
+    data = buffer;
+    return true;
+#endif
+  }
+
+  void Clear()
+  {
+#ifndef _WIN32
+    if (mapped)
+      munmap(const_cast<char *>(data), size);
+#else
+    delete[] data;
+#endif
+    data = NULL;
+    size = 0;
+    mapped = false;
+  }
+
+  ~MappedFile()
+  {
+    Clear();
+  }
+};
+
+// Returns the end of the line starting at line: its newline character, or
+// end when the last line of the file is not terminated.
+static inline const char *findLineEnd(const char *line, const char *end)
+{
+  const char *eol = static_cast<const char *>(memchr(line, '\n', end - line));
+  return eol ? eol : end;
+}
+
+static inline const char *skipBlanks(const char *l, const char *eol)
+{
+  while (l < eol && (*l == ' ' || *l == '\t' || *l == '\r'))
+    l++;
+  return l;
+}
+
+// Data lines are all lines that are neither blank nor comments.
+static inline bool isDataLine(const char *line, const char *eol)
+{
+  const char *l = skipBlanks(line, eol);
+  return l < eol && *line != '%';
+}
+
+// Parses a decimal index at l (leading blanks are skipped) and moves l past
+// it. Returns false if no digits were found. Indices that do not fit in 64
+// bits saturate to the largest (or smallest) int64_t, which no dimension can
+// reach, so that they fail the range checks of the readers.
+static inline bool parseIndex(const char *&l, const char *eol, int64_t &value)
+{
+  l = skipBlanks(l, eol);
+  bool negative = false;
+  if (l < eol && (*l == '-' || *l == '+'))
+  {
+    negative = (*l == '-');
+    l++;
+  }
+  if (l == eol || *l < '0' || *l > '9')
+    return false;
+
+  const int64_t max_value = std::numeric_limits<int64_t>::max();
+  int64_t v = 0;
+  while (l < eol && *l >= '0' && *l <= '9')
+  {
+    int digit = *l - '0';
+    v = (v > (max_value - digit) / 10) ? max_value : v * 10 + digit;
+    l++;
+  }
+  value = negative ? -v : v;
+  return true;
+}
+
+// Parses a floating point value at l. The line must be followed by a
+// newline or a NUL character, so that strtod cannot run past its end.
+// Returns false if there is no value on the rest of the line.
+static inline bool parseValue(const char *&l, const char *eol, double &value)
+{
+  l = skipBlanks(l, eol);
+  if (l == eol)
+    return false;
+
+  char *t = NULL;
+  value = strtod(l, &t);
+  if (t == l)
+    return false;
+  l = t;
+  return true;
+}
+
+// Splits the text in [begin, end) into num_chunks pieces of about the same
+// size whose boundaries fall right after a newline. bounds receives the
+// num_chunks + 1 chunk boundaries.
+static void splitLines(const char *begin, const char *end, int num_chunks,
+                       std::vector<const char *> &bounds)
+{
+  bounds.assign(num_chunks + 1, end);
+  bounds[0] = begin;
+  size_t chunk_size = (end - begin) / num_chunks;
+  for (int c = 1; c < num_chunks; c++)
+  {
+    const char *l = bounds[c - 1] + chunk_size;
+    if (l < bounds[c - 1])
+      l = bounds[c - 1];
+    if (l >= end)
+      break;
+    l = findLineEnd(l, end);
+    bounds[c] = (l < end) ? l + 1 : end;
+  }
+}
+
+// Chunks below this size are not worth a thread of their own.
+static const size_t MIN_PARSE_CHUNK_BYTES = 1 << 20;
+
+// Number of chunks to parse a text of the given size with.
+static int getNumParseChunks(size_t size)
+{
+  size_t num_chunks = size / MIN_PARSE_CHUNK_BYTES + 1;
+  size_t num_threads = getNumThreads();
+  // Use a few chunks per thread to even out the work
+  if (num_chunks > 4 * num_threads)
+    num_chunks = 4 * num_threads;
+  return (int)num_chunks;
+}
+
+// Message of the first error met by the prefetcher running on this thread
+// (see TensorCache::Prefetch()), NULL on the other threads.
+static thread_local std::string *prefetch_error = NULL;
+
+// Reports a badly formed input. The read calls exit with the message; a
+// prefetcher keeps it for the read call that needs the input, and returns:
+// the parse then gives up and returns false.
+static void parseError(const char *format, ...)
+{
+  char message[1024];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(message, sizeof(message), format, args);
+  va_end(args);
+
+  if (prefetch_error)
+  {
+    if (prefetch_error->empty())
+      *prefetch_error = message;
+    return;
+  }
+  fputs(message, stderr);
+  exit(1);
+}
+
+/**
+ * A memory-mapped MARKET file. Open() reads the banner and the problem
+ * description, and splits the edges into line-aligned chunks. The readers
+ * then parse the chunks in parallel, straight into their own storage.
+ */
+struct MarketFile
+{
+  MappedFile file;
+  bool array;
+  bool symmetric;
+  bool skew;
+  bool pattern;                         // no values in the file, all nonzeros are 1
+  int64_t num_rows;
+  int64_t num_cols;
+  int64_t num_nonzeros;                 // as given by the problem description
+  int64_t num_edges;                    // data lines found in the file
+  std::vector<const char *> bounds; // boundaries of the chunks
+  std::vector<int64_t> first_edge;      // index of the first edge of every chunk
+
+  MarketFile() : array(false), symmetric(false), skew(false), pattern(false),
+                 num_rows(0), num_cols(0), num_nonzeros(0), num_edges(0) {}
+
+  int NumChunks() const
+  {
+    return (int)bounds.size() - 1;
+  }
+
+  // Returns false if the file cannot be read, see parseError()
+  bool Open(const string &market_filename, bool verbose = false)
+  {
+    if (!file.Open(market_filename))
+    {
+      parseError("Error opening file\n");
+      return false;
+    }
+
+    // Banner, comments and problem description
+    const char *file_end = file.data + file.size;
+    const char *l = file.data;
+    bool found_description = false;
+    while (l < file_end && !found_description)
+    {
+      const char *eol = findLineEnd(l, file_end);
+      string line(l, eol);
+      l = (eol < file_end) ? eol + 1 : file_end;
+
+      if (line[0] == '%')
+      {
+        // Comment
+        if (line.size() > 1 && line[1] == '%')
+        {
+          // Banner
+          symmetric = (strstr(line.c_str(), "symmetric") != NULL);
+          skew = (strstr(line.c_str(), "skew") != NULL);
+          array = (strstr(line.c_str(), "array") != NULL);
+          pattern = (strstr(line.c_str(), "pattern") != NULL);
+
+          if (verbose)
+          {
+            printf("(symmetric: %d, skew: %d, array: %d, pattern: %d) ", symmetric, skew, array, pattern);
+            fflush(stdout);
+          }
+        }
+      }
+      else if (isDataLine(line.c_str(), line.c_str() + line.size()))
+      {
+        // Problem description
+        const char *d = line.c_str();
+        const char *d_end = d + line.size();
+        int64_t *fields[3] = {&num_rows, &num_cols, &num_nonzeros};
+        int nparsed = 0;
+        while (nparsed < 3 && parseIndex(d, d_end, *fields[nparsed]))
+          nparsed++;
+
+        if (array && (nparsed == 2))
+        {
+          if (num_cols > 0 && num_rows > std::numeric_limits<int64_t>::max() / num_cols)
+          {
+            parseError("Error parsing MARKET matrix: too many entries: %s\n", line.c_str());
+            return false;
+          }
+          num_nonzeros = num_rows * num_cols;
+        }
+        else if (array || (nparsed != 3))
+        {
+          parseError("Error parsing MARKET matrix: invalid problem description: %s\n", line.c_str());
+          return false;
+        }
+        if (num_rows < 0 || num_cols < 0 || num_nonzeros < 0 ||
+            num_rows == std::numeric_limits<int64_t>::max() || num_cols == std::numeric_limits<int64_t>::max() ||
+            num_nonzeros == std::numeric_limits<int64_t>::max())
+        {
+          parseError("Error parsing MARKET matrix: sizes out of range: %s\n", line.c_str());
+          return false;
+        }
+        found_description = true;
+      }
+    }
+
+    // Split the edges into chunks, and count the edges of every chunk
+    int num_chunks = getNumParseChunks(file_end - l);
+    splitLines(l, file_end, num_chunks, bounds);
+
+    first_edge.assign(num_chunks + 1, 0);
+    parallelFor(num_chunks, getNumThreads(), [&](int c)
+                {
+                  int64_t chunk_edges = 0;
+                  for (const char *line = bounds[c]; line < bounds[c + 1]; line++)
+                  {
+                    const char *eol = findLineEnd(line, bounds[c + 1]);
+                    if (isDataLine(line, eol))
+                      chunk_edges++;
+                    line = eol;
+                  }
+                  first_edge[c + 1] = chunk_edges;
+                });
+
+    for (int c = 0; c < num_chunks; c++)
+      first_edge[c + 1] += first_edge[c];
+    num_edges = first_edge[num_chunks];
+
+    if (num_edges > num_nonzeros)
+    {
+      parseError("Error parsing MARKET matrix: encountered more than %" PRId64 " num_nonzeros\n", num_nonzeros);
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Calls func(edge, row, col, val) on the edges of chunk c in file order,
+   * with zero-based indices. Returns NULL, or a message about the first
+   * badly formed edge, whose index is stored in error_edge.
+   */
+  template <typename Func>
+  const char *ParseChunk(int c, double default_value, int64_t &error_edge, Func func) const
+  {
+    const char *file_end = file.data + file.size;
+    const char *end = bounds[c + 1];
+    int64_t edge = first_edge[c];
+    string last_line;
+
+    for (const char *line = bounds[c]; line < end; line++)
+    {
+      const char *eol = findLineEnd(line, end);
+      if (!isDataLine(line, eol))
+      {
+        line = eol;
+        continue;
+      }
+      const char *next_line = eol;
+
+      // strtod needs a terminated line: copy the last line if the file does
+      // not end with a newline
+      if (eol == file_end)
+      {
+        last_line.assign(line, eol);
+        line = last_line.c_str();
+        eol = line + last_line.size();
+      }
+
+      int64_t row, col;
+      double val;
+      const char *l = line;
+
+      if (array)
+      {
+        if (!parseValue(l, eol, val))
+        {
+          error_edge = edge;
+          return "badly formed current_nz";
+        }
+        col = (edge / num_rows);
+        row = (edge - (num_rows * col));
+      }
+      else
+      {
+        // Parse nonzero (note: using strtol and strtod is 2x faster than sscanf or istream parsing)
+        if (!parseIndex(l, eol, row))
+        {
+          error_edge = edge;
+          return "badly formed row";
+        }
+        if (!parseIndex(l, eol, col))
+        {
+          error_edge = edge;
+          return "badly formed col";
+        }
+        if (pattern || !parseValue(l, eol, val))
+        {
+          val = default_value;
+        }
+
+        // Convert indices to zero-based
+        row--;
+        col--;
+      }
+
+      if (row < 0 || row >= num_rows || col < 0 || col >= num_cols)
+      {
+        error_edge = edge;
+        return "index out of range";
+      }
+
+      func(edge, row, col, val);
+
+      edge++;
+      line = next_line;
+    }
+
+    return NULL;
+  }
+
+  /**
+   * Parses all chunks in parallel, calling func(c, edge, row, col, val) on
+   * every edge of chunk c. Reports the first badly formed edge, as a
+   * sequential read would do, and returns false then.
+   */
+  template <typename Func>
+  bool ParseAll(double default_value, Func func) const
+  {
+    int num_chunks = NumChunks();
+    std::vector<const char *> errors(num_chunks, (const char *)NULL);
+    std::vector<int64_t> error_edges(num_chunks, -1);
+
+    parallelFor(num_chunks, getNumThreads(), [&](int c)
+                {
+                  errors[c] = ParseChunk(c, default_value, error_edges[c],
+                                         [&](int64_t edge, int64_t row, int64_t col, double val)
+                                         { func(c, edge, row, col, val); });
+                });
+
+    for (int c = 0; c < num_chunks; c++)
+    {
+      if (errors[c])
+      {
+        parseError("Error parsing MARKET matrix: %s at edge %" PRId64 "\n", errors[c], error_edges[c]);
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+/**
+ * A memory-mapped FROSTT file (.tns) of a tensor of any rank. Open() reads
+ * the problem description, the sizes of the dimensions followed by the
+ * number of nonzeros, and splits the nonzeros into line-aligned chunks. The
+ * readers then parse the chunks in parallel, straight into their own storage.
+ *
+ * A problem description without the size of every dimension only gives the
+ * number of nonzeros: dims_given is false, and the readers take the sizes
+ * from the largest coordinates.
+ */
+struct FrosttFile
+{
+  MappedFile file;
+  int rank;
+  std::vector<int64_t> dims;            // as given by the problem description
+  bool dims_given;
+  int64_t num_nonzeros;                 // as given by the problem description
+  int64_t num_edges;                    // data lines found in the file
+  std::vector<const char *> bounds; // boundaries of the chunks
+  std::vector<int64_t> first_edge;      // index of the first nonzero of every chunk
+
+  FrosttFile() : rank(0), dims_given(false), num_nonzeros(0), num_edges(0) {}
+
+  int NumChunks() const
+  {
+    return (int)bounds.size() - 1;
+  }
+
+  // Returns false if the file cannot be read, see parseError()
+  bool Open(const string &frostt_filename, int tensor_rank)
+  {
+    rank = tensor_rank;
+    if (!file.Open(frostt_filename))
+    {
+      parseError("Error opening file\n");
+      return false;
+    }
+
+    // Problem description: the first data line
+    const char *file_end = file.data + file.size;
+    const char *l = file.data;
+    bool found_description = false;
+    while (l < file_end && !found_description)
+    {
+      const char *eol = findLineEnd(l, file_end);
+      string line(l, eol);
+      l = (eol < file_end) ? eol + 1 : file_end;
+      if (!isDataLine(line.c_str(), line.c_str() + line.size()))
+        continue;
+
+      const char *d = line.c_str();
+      const char *d_end = d + line.size();
+      std::vector<int64_t> fields;
+      int64_t field;
+      while (parseIndex(d, d_end, field))
+        fields.push_back(field);
+
+      bool valid = !fields.empty();
+      for (int64_t f : fields)
+        valid = valid && f >= 0 && f != std::numeric_limits<int64_t>::max();
+      if (!valid)
+      {
+        parseError("Error parsing FROSTT tensor: invalid problem description: %s\n", line.c_str());
+        return false;
+      }
+
+      num_nonzeros = fields.back();
+      dims_given = ((int)fields.size() == rank + 1);
+      dims.assign(rank, 0);
+      if (dims_given)
+        std::copy(fields.begin(), fields.begin() + rank, dims.begin());
+      found_description = true;
+    }
+
+    // Split the nonzeros into chunks, and count the nonzeros of every chunk
+    int num_chunks = getNumParseChunks(file_end - l);
+    splitLines(l, file_end, num_chunks, bounds);
+
+    first_edge.assign(num_chunks + 1, 0);
+    parallelFor(num_chunks, getNumThreads(), [&](int c)
+                {
+                  int64_t chunk_edges = 0;
+                  for (const char *line = bounds[c]; line < bounds[c + 1]; line++)
+                  {
+                    const char *eol = findLineEnd(line, bounds[c + 1]);
+                    if (isDataLine(line, eol))
+                      chunk_edges++;
+                    line = eol;
+                  }
+                  first_edge[c + 1] = chunk_edges;
+                });
+
+    for (int c = 0; c < num_chunks; c++)
+      first_edge[c + 1] += first_edge[c];
+    num_edges = first_edge[num_chunks];
+
+    if (num_edges > num_nonzeros)
+    {
+      parseError("Error parsing FROSTT tensor: encountered more than %" PRId64 " num_nonzeros\n", num_nonzeros);
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Calls func(edge, coords, val) on the nonzeros of chunk c in file order,
+   * with the rank coordinates of the file (they are not converted to
+   * zero-based indices). Returns NULL, or a message about the first badly
+   * formed nonzero, whose index is stored in error_edge.
+   */
+  template <typename Func>
+  const char *ParseChunk(int c, double default_value, int64_t &error_edge, Func func) const
+  {
+    const char *file_end = file.data + file.size;
+    const char *end = bounds[c + 1];
+    int64_t edge = first_edge[c];
+    string last_line;
+    std::vector<int64_t> coords(rank);
+
+    for (const char *line = bounds[c]; line < end; line++)
+    {
+      const char *eol = findLineEnd(line, end);
+      if (!isDataLine(line, eol))
+      {
+        line = eol;
+        continue;
+      }
+      const char *next_line = eol;
+
+      // strtod needs a terminated line: copy the last line if the file does
+      // not end with a newline
+      if (eol == file_end)
+      {
+        last_line.assign(line, eol);
+        line = last_line.c_str();
+        eol = line + last_line.size();
+      }
+
+      const char *l = line;
+      for (int d = 0; d < rank; d++)
+      {
+        if (!parseIndex(l, eol, coords[d]))
+        {
+          error_edge = edge;
+          return "badly formed coordinate";
+        }
+        // parseIndex saturates the indices that overflow
+        if (coords[d] < 0 || coords[d] == std::numeric_limits<int64_t>::max())
+        {
+          error_edge = edge;
+          return "index out of range";
+        }
+      }
+
+      double val;
+      if (!parseValue(l, eol, val))
+        val = default_value;
+
+      func(edge, coords.data(), val);
+
+      edge++;
+      line = next_line;
+    }
+
+    return NULL;
+  }
+
+  /**
+   * Parses all chunks in parallel, calling func(c, edge, coords, val) on
+   * every nonzero of chunk c. Reports the first badly formed nonzero, as a
+   * sequential read would do, and returns false then.
+   */
+  template <typename Func>
+  bool ParseAll(double default_value, Func func) const
+  {
+    int num_chunks = NumChunks();
+    std::vector<const char *> errors(num_chunks, (const char *)NULL);
+    std::vector<int64_t> error_edges(num_chunks, -1);
+
+    parallelFor(num_chunks, getNumThreads(), [&](int c)
+                {
+                  errors[c] = ParseChunk(c, default_value, error_edges[c],
+                                         [&](int64_t edge, const int64_t *coords, double val)
+                                         { func(c, edge, coords, val); });
+                });
+
+    for (int c = 0; c < num_chunks; c++)
+    {
+      if (errors[c])
+      {
+        parseError("Error parsing FROSTT tensor: %s at edge %" PRId64 "\n", errors[c], error_edges[c]);
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
 //===----------------------------------------------------------------------===//
 // Small runtime support library for sparse matrices/tensors.
 //===----------------------------------------------------------------------===//
@@ -69,13 +760,13 @@ int getMatrixReadOption(int32_t readMode)
 template <typename T>
 struct CooTuple
 {
-  int row;
-  int col;
+  int64_t row;
+  int64_t col;
   T val;
 
   CooTuple() {}
-  CooTuple(int row, int col) : row(row), col(col) {}
-  CooTuple(int row, int col, T val) : row(row), col(col), val(val) {}
+  CooTuple(int64_t row, int64_t col) : row(row), col(col) {}
+  CooTuple(int64_t row, int64_t col, T val) : row(row), col(col), val(val) {}
 };
 
 /**
@@ -85,18 +776,25 @@ struct CooTuple
 template <typename T>
 struct CooMatrix
 {
+  //---------------------------------------------------------------------
+  // Type definitions
+  //---------------------------------------------------------------------
+
+  // Tuples of one chunk of a MARKET file
+  struct MarketChunk
+  {
+    int64_t num_tuples = 0;  // including the mirrored symmetric ones
+  };
+
   //---------------------------------------------------------------------
   // Data members
   //---------------------------------------------------------------------
 
   // Fields
-  int num_rows;
-  int num_cols;
-  int num_nonzeros;
-  int num_nonzeros_lowerTri;   // triangular matrix read stats
-  int num_nonzeros_upperTri;
-  int num_nonzeros_lowerTri_strict;
-  int num_nonzeros_upperTri_strict;
+  int64_t num_rows;
+  int64_t num_cols;
+  int64_t num_nonzeros;  // after the triangular filter of the selected matrix read
+  int64_t capacity;      // tuples allocated in coo_tuples
   CooTuple<T> *coo_tuples;
 
   //---------------------------------------------------------------------
@@ -104,10 +802,16 @@ struct CooMatrix
   //---------------------------------------------------------------------
 
   // Constructor
-  CooMatrix() : num_rows(0), num_cols(0), num_nonzeros(0), 
-                num_nonzeros_lowerTri(0), num_nonzeros_upperTri(0), 
-                num_nonzeros_lowerTri_strict(0), num_nonzeros_upperTri_strict(0),
-                coo_tuples(NULL) {}
+  CooMatrix() : num_rows(0), num_cols(0), num_nonzeros(0), capacity(0), coo_tuples(NULL) {}
+
+  /**
+   * Bytes held in memory, for the tensor cache. The room of the mirrored
+   * entries of symmetric matrices is counted, even where it is unused.
+   */
+  size_t Bytes() const
+  {
+    return (size_t)capacity * sizeof(CooTuple<T>);
+  }
 
   /**
    * Clear
@@ -117,13 +821,13 @@ struct CooMatrix
     if (coo_tuples)
       delete[] coo_tuples;
     coo_tuples = NULL;
+    capacity = 0;
   }
 
   // Destructor
   ~CooMatrix()
   {
-    // do nothing. coo_tuples is now cleared from else-where.
-    //Clear();
+    Clear();
   }
 
   // Display matrix to stdout
@@ -131,7 +835,7 @@ struct CooMatrix
   {
     cout << "COO Matrix (" << num_rows << " rows, " << num_cols << " columns, " << num_nonzeros << " non-zeros):\n";
     cout << "Ordinal, Row, Column, Value\n";
-    for (int i = 0; i < num_nonzeros; i++)
+    for (int64_t i = 0; i < num_nonzeros; i++)
     {
       cout << '\t' << i << ',' << coo_tuples[i].row << ',' << coo_tuples[i].col << ',' << coo_tuples[i].val << "\n";
     }
@@ -139,9 +843,19 @@ struct CooMatrix
 
   /**
    * Builds a MARKET COO sparse from the given file.
+   *
+   * The chunks of the memory-mapped file are parsed in parallel, straight
+   * into their final position in coo_tuples. The triangular filter of the
+   * selected matrix read (see getMatrixReadOption()) is applied while
+   * parsing, and the mirrored nonzeros of symmetric matrices are only
+   * generated when they are kept, so that a triangular read of a symmetric
+   * matrix only stores one half of it. The result is the same as parsing
+   * the file line by line. Returns false if the file cannot be read, see
+   * parseError().
    */
-  void InitMarket(
+  bool InitMarket(
       const string &market_filename,
+      int readMode = DEFAULT,
       T default_value = 1.0,
       bool verbose = false)
   {
@@ -158,192 +872,69 @@ struct CooMatrix
       exit(1);
     }
 
-    std::ifstream ifs;
-    ifs.open(market_filename.c_str(), std::ifstream::in);
-    if (!ifs.good())
-    {
-      fprintf(stderr, "Error opening file\n");
-      exit(1);
-    }
-
-    bool array = false;
-    bool symmetric = false;
-    bool skew = false;
-    int current_nz = -1;
-    char line[1024];
-
     if (verbose)
     {
       printf("Parsing... ");
       fflush(stdout);
     }
 
-    while (true)
+    MarketFile market;
+    if (!market.Open(market_filename, verbose))
+      return false;
+
+    num_rows = market.num_rows;
+    num_cols = market.num_cols;
+    num_nonzeros = market.num_nonzeros;
+
+    // Allocate coo matrix, every chunk starts at the slot of its first edge.
+    // Symmetric matrices get room for two tuples per edge, unless a
+    // triangular filter is selected: at most one of an entry and its mirror
+    // is kept then.
+    int edge_stride = (market.symmetric && readMode == DEFAULT) ? 2 : 1;
+    bool symmetric = market.symmetric;
+    bool skew = market.skew;
+    capacity = num_nonzeros * edge_stride;
+    coo_tuples = new CooTuple<T>[capacity];
+
+    int num_chunks = market.NumChunks();
+    std::vector<MarketChunk> chunks(num_chunks);
+    bool parsed = market.ParseAll(default_value, [&](int c, int64_t edge, int64_t row, int64_t col, double val)
+                                  {
+                                    MarketChunk &chunk = chunks[c];
+                                    CooTuple<T> *tuples = coo_tuples + (size_t)market.first_edge[c] * edge_stride;
+
+                                    if (keepMatrixEntry(readMode, row, col))
+                                      tuples[chunk.num_tuples++] = CooTuple<T>(row, col, (T)val);
+
+                                    if (symmetric && (row != col) && keepMatrixEntry(readMode, col, row))
+                                      tuples[chunk.num_tuples++] = CooTuple<T>(col, row, (T)val * (skew ? -1 : 1));
+                                  });
+    if (!parsed)
+      return false;
+
+    // Close the gaps left by the diagonal entries of symmetric matrices,
+    // which are not mirrored, and by the filtered out entries.
+    int64_t current_nz = 0;
+    for (int c = 0; c < num_chunks; c++)
     {
-      ifs.getline(line, 1024);
-      if (!ifs.good())
-      {
-        // Done
-        break;
-      }
+      MarketChunk &chunk = chunks[c];
+      CooTuple<T> *chunk_tuples = coo_tuples + (size_t)market.first_edge[c] * edge_stride;
+      if (chunk_tuples != coo_tuples + current_nz)
+        memmove(coo_tuples + current_nz, chunk_tuples, chunk.num_tuples * sizeof(CooTuple<T>));
+      current_nz += chunk.num_tuples;
+    }
 
-      if (line[0] == '%')
-      {
-        // Comment
-        if (line[1] == '%')
-        {
-          // Banner
-          symmetric = (strstr(line, "symmetric") != NULL);
-          skew = (strstr(line, "skew") != NULL);
-          array = (strstr(line, "array") != NULL);
+    // Adjust nonzero count (nonzeros along the diagonal aren't reversed)
+    num_nonzeros = current_nz;
 
-          if (verbose)
-          {
-            printf("(symmetric: %d, skew: %d, array: %d) ", symmetric, skew, array);
-            fflush(stdout);
-          }
-        }
-      }
-      else if (current_nz == -1)
-      {
-        // Problem description
-        int nparsed = sscanf(line, "%d %d %d", &num_rows, &num_cols, &num_nonzeros);
-        if ((!array) && (nparsed == 3))
-        {
-          if (symmetric)
-            num_nonzeros *= 2;
-
-          // Allocate coo matrix
-          coo_tuples = new CooTuple<T>[num_nonzeros];
-          current_nz = 0;
-        }
-        else if (array && (nparsed == 2))
-        {
-          // Allocate coo matrix
-          num_nonzeros = num_rows * num_cols;
-          coo_tuples = new CooTuple<T>[num_nonzeros];
-          current_nz = 0;
-        }
-        else
-        {
-          fprintf(stderr, "Error parsing MARKET matrix: invalid problem description: %s\n", line);
-          exit(1);
-        }
-      }
-      else
-      {
-        // Edge
-        if (current_nz >= num_nonzeros)
-        {
-          fprintf(stderr, "Error parsing MARKET matrix: encountered more than %d num_nonzeros\n", num_nonzeros);
-          exit(1);
-        }
-
-        int row, col;
-        T val;
-        double tempVal = 0.0;
-
-        if (array)
-        {
-          if (sscanf(line, "%lf", &tempVal) != 1)  // using tempVal instead of templated T val to avoid warning
-          {
-            fprintf(stderr, "Error parsing MARKET matrix: badly formed current_nz: '%s' at edge %d\n", line, current_nz);
-            exit(1);
-          }
-          val = (T) tempVal;
-          col = (current_nz / num_rows);
-          row = (current_nz - (num_rows * col));
-          // std::cout << __LINE__ << "current_nz: " << current_nz << "\n";
-          coo_tuples[current_nz] = CooTuple<T>(row, col, val); // Convert indices to zero-based
-
-          if (row > col)
-          {
-            num_nonzeros_lowerTri_strict++;
-            num_nonzeros_lowerTri++;
-          }
-          else if (row < col)
-          {
-            num_nonzeros_upperTri_strict++;
-            num_nonzeros_upperTri++;
-          }
-          else // equal or diagonals
-          {
-            num_nonzeros_lowerTri++;
-            num_nonzeros_upperTri++;
-          }
-
-        }
-        else
-        {
-          // Parse nonzero (note: using strtol and strtod is 2x faster than sscanf or istream parsing)
-          char *l = line;
-          char *t = NULL;
-
-          // parse row
-          row = strtol(l, &t, 0);
-          if (t == l)
-          {
-            fprintf(stderr, "Error parsing MARKET matrix: badly formed row at edge %d\n", current_nz);
-            exit(1);
-          }
-          l = t;
-
-          // parse col
-          col = strtol(l, &t, 0);
-          if (t == l)
-          {
-            fprintf(stderr, "Error parsing MARKET matrix: badly formed col at edge %d\n", current_nz);
-            exit(1);
-          }
-          l = t;
-
-          // parse val
-          val = strtod(l, &t);
-          if (t == l)
-          {
-            val = default_value;
-          }
-
-          coo_tuples[current_nz] = CooTuple<T>(row - 1, col - 1, val); // Convert indices to zero-based
-
-          if (row - 1 > col - 1)
-          {
-            num_nonzeros_lowerTri_strict++;
-            num_nonzeros_lowerTri++;
-          }
-          else if (row - 1 < col - 1)
-          {
-            num_nonzeros_upperTri_strict++;
-            num_nonzeros_upperTri++;
-          }
-          else // equal or diagonals
-          {
-            num_nonzeros_lowerTri++;
-            num_nonzeros_upperTri++;
-          }
-
-        }
-
-        current_nz++;
-
-        if (symmetric && (row != col))
-        {
-          coo_tuples[current_nz].row = coo_tuples[current_nz - 1].col;
-          coo_tuples[current_nz].col = coo_tuples[current_nz - 1].row;
-          coo_tuples[current_nz].val = coo_tuples[current_nz - 1].val * (skew ? -1 : 1);
-          current_nz++;
-        }
-      }
-    }
-
-    // Adjust nonzero count (nonzeros along the diagonal aren't reversed)
-    num_nonzeros = current_nz;
-
-    if (symmetric)
-    { 
-      // we only do one half if matrix is symmetric, so update num according to lower Triangle read.
-      num_nonzeros_upperTri = num_nonzeros_lowerTri;
-      num_nonzeros_upperTri_strict = num_nonzeros_lowerTri_strict;
+    // Give the room of the filtered out entries back
+    if (readMode != DEFAULT && num_nonzeros < capacity)
+    {
+      CooTuple<T> *kept_tuples = new CooTuple<T>[num_nonzeros];
+      std::copy(coo_tuples, coo_tuples + num_nonzeros, kept_tuples);
+      delete[] coo_tuples;
+      coo_tuples = kept_tuples;
+      capacity = num_nonzeros;
     }
 
     if (verbose)
@@ -351,8 +942,7 @@ struct CooMatrix
       printf("done. ");
       fflush(stdout);
     }
-
-    ifs.close();
+    return true;
   }
 };
 
@@ -376,198 +966,274 @@ struct CooComparatorCol
   }
 };
 
-// /******************************************************************************
-//  * CSR matrix type
-//  ******************************************************************************/
-
 /**
- * CSR sparse format matrix
+ * Builds a CSR matrix straight from a MARKET file, without the COO matrix
+ * in between. Count() parses the file once to get the number of nonzeros
+ * of every row in every group of chunks, and Fill() parses it a second time
+ * to scatter the nonzeros into the CSR arrays of the caller. The groups are
+ * parsed in parallel, and every group scatters into the slots of a row that
+ * follow those of the groups before it: the nonzeros of a row are in file
+ * order whatever the number of threads. A file that Count() has parsed
+ * cannot fail Fill().
  */
 template <typename T>
-struct CsrMatrix
-{
-
-  int num_rows;
-  int num_cols;
-  int num_nonzeros;
-  int num_nonzeros_lowerTri; // triangular matrix read stats from COO
-  int num_nonzeros_upperTri;
-  int num_nonzeros_lowerTri_strict;
-  int num_nonzeros_upperTri_strict;
-  int *row_offsets;
-  int *column_indices;
-  T *values;
+struct CsrMarketReader
+{
+  MarketFile market;
+  int readMode; // selected matrix read, see getMatrixReadOption()
+  int64_t num_rows;
+  int64_t num_cols;
+  int64_t num_nonzeros; // after the triangular filter
+  int num_groups;       // groups of consecutive chunks of the file
+  std::vector<int64_t> group_counts; // nonzeros of every row, num_rows per group
+
+  // CSR arrays kept by Fill() when the tensor cache has room for them, for
+  // later reads of the same file. The values are not kept for pattern-only
+  // reads and pattern files.
+  bool filled;
+  std::vector<int64_t> csr_pos;
+  std::vector<int64_t> csr_crd;
+  std::vector<T> csr_val;
+
+  // Rows up to this length are sorted in place with an insertion sort
+  static const int64_t SHORT_ROW = 32;
 
   /**
-   * Initializer
+   * Calls func(g, row, col, val) on every kept nonzero of group g, in file
+   * order, including the mirrored nonzeros of symmetric matrices. The
+   * groups are parsed in parallel. Reports the first badly formed edge, as
+   * a sequential read would do, and returns false then.
    */
-  void Init(
-      CooMatrix<T> *coo_matrix,
-      int readMode, 
-      bool verbose = false)
+  template <typename Func>
+  bool ForEachEntry(Func func)
   {
-    num_rows = coo_matrix->num_rows;
-    num_cols = coo_matrix->num_cols;
-    num_nonzeros = coo_matrix->num_nonzeros;
-    num_nonzeros_lowerTri = coo_matrix->num_nonzeros_lowerTri;
-    num_nonzeros_upperTri = coo_matrix->num_nonzeros_upperTri;
-    num_nonzeros_lowerTri_strict = coo_matrix->num_nonzeros_lowerTri_strict;
-    num_nonzeros_upperTri_strict = coo_matrix->num_nonzeros_upperTri_strict;
-
-    // Sort by rows, then columns
-    if (verbose)
-      printf("Ordering...");
-    fflush(stdout);
-    std::stable_sort(coo_matrix->coo_tuples, coo_matrix->coo_tuples + num_nonzeros, CooComparatorRow());
-    if (verbose)
-      printf("done.");
-    fflush(stdout);
-
-    row_offsets = new int[num_rows + 1];
-    
-    if (readMode == LOWER_TRI_STRICT)
-    {
-      column_indices = new int[num_nonzeros_lowerTri_strict];
-      values = new T[num_nonzeros_lowerTri_strict];
-    }
-    else if (readMode == LOWER_TRI)
-    {
-      column_indices = new int[num_nonzeros_lowerTri];
-      values = new T[num_nonzeros_lowerTri];
-    }
-    else if (readMode == UPPER_TRI_STRICT)
+    bool symmetric = market.symmetric;
+    T mirror_sign = market.skew ? -1 : 1;
+    int mode = readMode;
+    int num_chunks = market.NumChunks();
+    std::vector<const char *> errors(num_groups, (const char *)NULL);
+    std::vector<int64_t> error_edges(num_groups, -1);
+
+    parallelFor(num_groups, getNumThreads(), [&](int g)
+                {
+                  int first_chunk = num_chunks * g / num_groups;
+                  int last_chunk = num_chunks * (g + 1) / num_groups;
+                  for (int c = first_chunk; c < last_chunk && !errors[g]; c++)
+                  {
+                    errors[g] = market.ParseChunk(c, 1.0, error_edges[g],
+                                                  [&](int64_t edge, int64_t row, int64_t col, double val)
+                                                  {
+                                                    if (keepMatrixEntry(mode, row, col))
+                                                      func(g, row, col, (T)val);
+                                                    if (symmetric && (row != col) && keepMatrixEntry(mode, col, row))
+                                                      func(g, col, row, (T)val * mirror_sign);
+                                                  });
+                  }
+                });
+
+    for (int g = 0; g < num_groups; g++)
     {
-      column_indices = new int[num_nonzeros_upperTri_strict];
-      values = new T[num_nonzeros_upperTri_strict];
-    }
-    else if (readMode == UPPER_TRI)
-    {
-      column_indices = new int[num_nonzeros_upperTri];
-      values = new T[num_nonzeros_upperTri];
-    }
-    else // DEFAULT
-    {
-      column_indices = new int[num_nonzeros];
-      values = new T[num_nonzeros];
+      if (errors[g])
+      {
+        parseError("Error parsing MARKET matrix: %s at edge %" PRId64 "\n", errors[g], error_edges[g]);
+        return false;
+      }
     }
+    return true;
+  }
 
+  /**
+   * Opens the file and reads its sizes. Returns false if the file cannot be
+   * read, see parseError().
+   */
+  bool Open(const string &market_filename)
+  {
+    if (!market.Open(market_filename))
+      return false;
+    num_rows = market.num_rows;
+    num_cols = market.num_cols;
+    return true;
+  }
 
-    int prev_row = -1;
-    int curr_idx = 0;
-    for (int current_nz = 0; current_nz < num_nonzeros; current_nz++)
-    { 
-      int current_row = coo_matrix->coo_tuples[current_nz].row;
-      int current_col = coo_matrix->coo_tuples[current_nz].col;
+  /**
+   * First pass: counts the nonzeros of every row in every group. Returns
+   * false if the file is badly formed, see parseError().
+   */
+  bool Count()
+  {
+    // A group per chunk, unless the counts would take more memory than the
+    // nonzeros themselves
+    int64_t max_groups = market.num_edges / (num_rows + 1) + 1;
+    num_groups = (int)std::min((int64_t)market.NumChunks(), max_groups);
+    group_counts.assign((size_t)num_groups * num_rows, 0);
+
+    int64_t *counts = group_counts.data();
+    bool parsed = ForEachEntry([&](int g, int64_t row, int64_t col, T val)
+                               { counts[g * num_rows + row]++; });
+
+    num_nonzeros = 0;
+    for (int64_t count : group_counts)
+      num_nonzeros += count;
+    return parsed;
+  }
 
-      if ( ( (readMode == LOWER_TRI_STRICT) || (readMode == LOWER_TRI) ) && 
-           (current_row > current_col) )
-      {
-        // Fill in rows up to and including the current row
-        //printf("\t\tLower> current_nz: %d, curr_idx: %d\n", current_nz, curr_idx);
-        for (int row = prev_row + 1; row <= current_row; row++)
-        {
-          row_offsets[row] = curr_idx;
-        }
-        prev_row = current_row;
+  /**
+   * Second pass: fills in the row offsets (num_rows + 1 entries), and the
+   * column indices and values (num_nonzeros entries) of the CSR matrix.
+   * Within a row, the nonzeros are ordered by column, and the nonzeros with
+   * the same column keep the order of the file. val is NULL for
+   * pattern-only reads. The CSR arrays are kept for the next Fill() if keep
+   * is set, see FilledBytes(); otherwise the next Fill() parses the file
+   * again.
+   */
+  void Fill(int64_t *pos, int64_t *crd, T *val, bool keep)
+  {
+    if (filled)
+    {
+      std::copy(csr_pos.begin(), csr_pos.end(), pos);
+      std::copy(csr_crd.begin(), csr_crd.end(), crd);
+      if (val && market.pattern)
+        std::fill(val, val + num_nonzeros, (T)1);
+      else if (val)
+        std::copy(csr_val.begin(), csr_val.end(), val);
+      return;
+    }
 
-        column_indices[curr_idx] = coo_matrix->coo_tuples[current_nz].col;
-        values[curr_idx] = coo_matrix->coo_tuples[current_nz].val;
-        curr_idx++;
-      }
-      else if ( ( (readMode == UPPER_TRI_STRICT) || (readMode == UPPER_TRI) ) && 
-                (current_row < current_col) )
+    // The counts become the insertion cursors of the groups in every row
+    int64_t *counts = group_counts.data();
+    pos[0] = 0;
+    for (int64_t row = 0; row < num_rows; row++)
+    {
+      int64_t cursor = pos[row];
+      for (int g = 0; g < num_groups; g++)
       {
-        for (int row = prev_row + 1; row <= current_row; row++)
-        {
-          row_offsets[row] = curr_idx;
-        }
-        prev_row = current_row;
-
-        column_indices[curr_idx] = coo_matrix->coo_tuples[current_nz].col;
-        values[curr_idx] = coo_matrix->coo_tuples[current_nz].val;
-        curr_idx++;
+        int64_t count = counts[g * num_rows + row];
+        counts[g * num_rows + row] = cursor;
+        cursor += count;
       }
-      else if ( ( (readMode == UPPER_TRI) || (readMode == LOWER_TRI) ) &&
-                (current_row == current_col) )  // diagonals
-      {
-        for (int row = prev_row + 1; row <= current_row; row++)
-        {
-          row_offsets[row] = curr_idx;
-        }
-        prev_row = current_row;
+      pos[row + 1] = cursor;
+    }
 
-        column_indices[curr_idx] = coo_matrix->coo_tuples[current_nz].col;
-        values[curr_idx] = coo_matrix->coo_tuples[current_nz].val;
-        curr_idx++;
-      }
-      else if ( readMode == DEFAULT ) // standard matrix read
-      {
-        // Fill in rows up to and including the current row
-        //printf("\t\tLower> current_nz: %d, curr_idx: %d\n", current_nz, curr_idx);
-        for (int row = prev_row + 1; row <= current_row; row++)
-        {
-          row_offsets[row] = curr_idx;
-        }
-        prev_row = current_row;
+    ForEachEntry([&](int g, int64_t row, int64_t col, T v)
+                 {
+                   int64_t k = counts[g * num_rows + row]++;
+                   crd[k] = col;
+                   if (val)
+                     val[k] = v;
+                 });
 
-        column_indices[curr_idx] = coo_matrix->coo_tuples[current_nz].col;
-        values[curr_idx] = coo_matrix->coo_tuples[current_nz].val;
-        curr_idx++;
-      }
+    SortRows(pos, crd, val);
 
-    } // end-loop
+    if (keep)
+    {
+      // Keep the CSR arrays instead of the file
+      csr_pos.assign(pos, pos + num_rows + 1);
+      csr_crd.assign(crd, crd + num_nonzeros);
+      if (val && !market.pattern)
+        csr_val.assign(val, val + num_nonzeros);
+      filled = true;
+      std::vector<int64_t>().swap(group_counts);
+      market.file.Clear();
+      return;
+    }
 
-    // Fill out any trailing edgeless vertices (and the end-of-list element)
-    for (int row = prev_row + 1; row <= num_rows; row++)
+    // Every cursor is now at the first slot of the next group: turn the
+    // cursors back into counts
+    for (int64_t row = 0; row < num_rows; row++)
     {
-      if (readMode == LOWER_TRI_STRICT)
-        row_offsets[row] = num_nonzeros_lowerTri_strict;
-      else if (readMode == UPPER_TRI_STRICT)
-        row_offsets[row] = num_nonzeros_upperTri_strict;
-      else if (readMode == UPPER_TRI)
-        row_offsets[row] = num_nonzeros_upperTri;
-      else if (readMode == LOWER_TRI)
-        row_offsets[row] = num_nonzeros_lowerTri;
-      else // DEFAULT
-        row_offsets[row] = num_nonzeros;
+      for (int g = num_groups - 1; g > 0; g--)
+        counts[g * num_rows + row] -= counts[(g - 1) * num_rows + row];
+      counts[row] -= pos[row];
     }
   }
 
   /**
-   * Clear
+   * Bytes of the CSR arrays that Fill() keeps, with or without the values
    */
-  void Clear()
+  size_t FilledBytes(bool values) const
   {
-    if (row_offsets)
-      delete[] row_offsets;
-    if (column_indices)
-      delete[] column_indices;
-    if (values)
-      delete[] values;
-
-    row_offsets = NULL;
-    column_indices = NULL;
-    values = NULL;
+    size_t bytes = (num_rows + 1 + num_nonzeros) * sizeof(int64_t);
+    if (values && !market.pattern)
+      bytes += num_nonzeros * sizeof(T);
+    return bytes;
   }
 
   /**
-   * Constructor
+   * Bytes held in memory, for the tensor cache
    */
-  CsrMatrix(
-      CooMatrix<T> *coo_matrix,
-      int readMode,
-      bool verbose = false)
+  size_t Bytes() const
   {
-    Init(coo_matrix, readMode, verbose);
+    if (filled)
+      return (csr_pos.capacity() + csr_crd.capacity()) * sizeof(int64_t) + csr_val.capacity() * sizeof(T);
+    return group_counts.capacity() * sizeof(int64_t);
   }
 
   /**
-   * Destructor
+   * Sorts the nonzeros of the rows that are not ordered by column, keeping
+   * the order of the nonzeros with the same column. val may be NULL.
    */
-  ~CsrMatrix()
+  void SortRows(const int64_t *pos, int64_t *crd, T *val)
   {
-    Clear();
+    int num_threads = getNumThreads();
+    int num_blocks = (int)std::min(num_rows, (int64_t)4 * num_threads);
+
+    parallelFor(num_blocks, num_threads, [&](int b)
+                {
+                  std::vector<int64_t> perm;
+                  std::vector<int64_t> tmp_crd;
+                  std::vector<T> tmp_val;
+
+                  int64_t first_row = num_rows * b / num_blocks;
+                  int64_t last_row = num_rows * (b + 1) / num_blocks;
+                  for (int64_t row = first_row; row < last_row; row++)
+                  {
+                    int64_t begin = pos[row];
+                    int64_t n = pos[row + 1] - begin;
+                    int64_t *row_crd = crd + begin;
+                    T *row_val = val ? val + begin : NULL;
+
+                    if (std::is_sorted(row_crd, row_crd + n))
+                      continue;
+
+                    if (n <= SHORT_ROW)
+                    {
+                      // stable insertion sort
+                      for (int64_t i = 1; i < n; i++)
+                      {
+                        for (int64_t j = i; j > 0 && row_crd[j] < row_crd[j - 1]; j--)
+                        {
+                          std::swap(row_crd[j], row_crd[j - 1]);
+                          if (row_val)
+                            std::swap(row_val[j], row_val[j - 1]);
+                        }
+                      }
+                      continue;
+                    }
+
+                    perm.resize(n);
+                    for (int64_t i = 0; i < n; i++)
+                      perm[i] = i;
+                    std::stable_sort(perm.begin(), perm.end(), [&](int64_t i, int64_t j)
+                                     { return row_crd[i] < row_crd[j]; });
+
+                    tmp_crd.assign(row_crd, row_crd + n);
+                    for (int64_t i = 0; i < n; i++)
+                      row_crd[i] = tmp_crd[perm[i]];
+                    if (row_val)
+                    {
+                      tmp_val.assign(row_val, row_val + n);
+                      for (int64_t i = 0; i < n; i++)
+                        row_val[i] = tmp_val[perm[i]];
+                    }
+                  }
+                });
   }
+
+  /**
+   * Constructor
+   */
+  CsrMarketReader(int readMode)
+      : readMode(readMode), num_rows(0), num_cols(0), num_nonzeros(0), num_groups(1), filled(false) {}
 };
 
 /**
@@ -577,11 +1243,11 @@ template <typename T>
 struct CscMatrix
 {
 
-  int num_rows;
-  int num_cols;
-  int num_nonzeros;
-  int *col_offsets;
-  int *row_indices;
+  int64_t num_rows;
+  int64_t num_cols;
+  int64_t num_nonzeros;
+  int64_t *col_offsets;
+  int64_t *row_indices;
   T *values;
 
   /**
@@ -604,17 +1270,17 @@ struct CscMatrix
       printf("done.");
     fflush(stdout);
 
-    col_offsets = new int[num_cols + 1];
-    row_indices = new int[num_nonzeros];
+    col_offsets = new int64_t[num_cols + 1];
+    row_indices = new int64_t[num_nonzeros];
     values = new T[num_nonzeros];
 
-    int prev_col = -1;
-    for (int current_nz = 0; current_nz < num_nonzeros; current_nz++)
+    int64_t prev_col = -1;
+    for (int64_t current_nz = 0; current_nz < num_nonzeros; current_nz++)
     {
-      int current_col = coo_matrix->coo_tuples[current_nz].col;
+      int64_t current_col = coo_matrix->coo_tuples[current_nz].col;
 
       // Fill in cols up to and including the current col
-      for (int col = prev_col + 1; col <= current_col; col++)
+      for (int64_t col = prev_col + 1; col <= current_col; col++)
       {
         col_offsets[col] = current_nz;
       }
@@ -625,7 +1291,7 @@ struct CscMatrix
     }
 
     // Fill out any trailing edgeless vertices (and the end-of-list element)
-    for (int col = prev_col + 1; col <= num_cols; col++)
+    for (int64_t col = prev_col + 1; col <= num_cols; col++)
     {
       col_offsets[col] = num_nonzeros;
     }
@@ -677,18 +1343,18 @@ struct CscMatrix
 template <typename T>
 struct DcsrMatrix
 {
-  int num_rows;
-  int num_cols;
-  int num_nonzeros;
-  int A1pos_size = 0;
-  int A1crd_size = 0;
-  int A2pos_size = 0;
-  int A2crd_size = 0;
-  int Aval_size = 0;
-  int *A1pos;
-  int *A1crd;
-  int *A2pos;
-  int *A2crd;
+  int64_t num_rows;
+  int64_t num_cols;
+  int64_t num_nonzeros;
+  int64_t A1pos_size = 0;
+  int64_t A1crd_size = 0;
+  int64_t A2pos_size = 0;
+  int64_t A2crd_size = 0;
+  int64_t Aval_size = 0;
+  int64_t *A1pos;
+  int64_t *A1crd;
+  int64_t *A2pos;
+  int64_t *A2crd;
   T *Aval;
 
   /**
@@ -711,16 +1377,16 @@ struct DcsrMatrix
       printf("done.");
     fflush(stdout);
 
-    A1pos = new int[2];
-    A1crd = new int[num_rows];
-    A2pos = new int[num_rows + 1];
-    A2crd = new int[num_nonzeros];
+    A1pos = new int64_t[2];
+    A1crd = new int64_t[num_rows];
+    A2pos = new int64_t[num_rows + 1];
+    A2crd = new int64_t[num_nonzeros];
     Aval = new T[num_nonzeros];
 
-    int prev_row = -1;
-    for (int current_nz = 0; current_nz < num_nonzeros; current_nz++)
+    int64_t prev_row = -1;
+    for (int64_t current_nz = 0; current_nz < num_nonzeros; current_nz++)
     {
-      int current_row = coo_matrix->coo_tuples[current_nz].row;
+      int64_t current_row = coo_matrix->coo_tuples[current_nz].row;
 
       // Fill in rows up to and including the current row
       if (current_row == prev_row)
@@ -745,6 +1411,14 @@ struct DcsrMatrix
     A1pos[A1pos_size++] = A1crd_size;
   }
 
+  /**
+   * Bytes held in memory, for the tensor cache
+   */
+  size_t Bytes() const
+  {
+    return (size_t)(A1pos_size + A1crd_size + A2pos_size + A2crd_size) * sizeof(int64_t) + (size_t)Aval_size * sizeof(T);
+  }
+
   /**
    * Clear
    */
@@ -801,14 +1475,14 @@ struct Coo3DTensor
   // COO edge tuple
   struct Coo3DTuple
   {
-    int index_i;
-    int index_j;
-    int index_k;
+    int64_t index_i;
+    int64_t index_j;
+    int64_t index_k;
     T val;
 
     Coo3DTuple() {}
-    Coo3DTuple(int index_i, int index_j, int index_k) : index_i(index_i), index_j(index_j), index_k(index_k) {}
-    Coo3DTuple(int index_i, int index_j, int index_k, T val) : index_i(index_i), index_j(index_j), index_k(index_k), val(val) {}
+    Coo3DTuple(int64_t index_i, int64_t index_j, int64_t index_k) : index_i(index_i), index_j(index_j), index_k(index_k) {}
+    Coo3DTuple(int64_t index_i, int64_t index_j, int64_t index_k, T val) : index_i(index_i), index_j(index_j), index_k(index_k), val(val) {}
   };
 
   //---------------------------------------------------------------------
@@ -816,10 +1490,10 @@ struct Coo3DTensor
   //---------------------------------------------------------------------
 
   // Fields
-  int num_index_i;
-  int num_index_j;
-  int num_index_k;
-  int num_nonzeros;
+  int64_t num_index_i;
+  int64_t num_index_j;
+  int64_t num_index_k;
+  int64_t num_nonzeros;
   Coo3DTuple *coo_3dtuples;
 
   //---------------------------------------------------------------------
@@ -829,6 +1503,14 @@ struct Coo3DTensor
   // Constructor
   Coo3DTensor() : num_index_i(0), num_index_j(0), num_index_k(0), num_nonzeros(0), coo_3dtuples(NULL) {}
 
+  /**
+   * Bytes held in memory, for the tensor cache
+   */
+  size_t Bytes() const
+  {
+    return (size_t)num_nonzeros * sizeof(Coo3DTuple);
+  }
+
   /**
    * Clear
    */
@@ -842,8 +1524,7 @@ struct Coo3DTensor
   // Destructor
   ~Coo3DTensor()
   {
-    // do nothing. coo_3dtuples is now cleared from else-where.
-    //Clear();
+    Clear();
   }
 
   // Display matrix to stdout
@@ -851,7 +1532,7 @@ struct Coo3DTensor
   {
     cout << "COO Tensor 3D (" << num_index_i << " index_i, " << num_index_j << " index_j, " << num_index_k << " index_k, " << num_nonzeros << " non-zeros):\n";
     cout << "Ordinal, index_i, index_j, index_k, Value\n";
-    for (int i = 0; i < num_nonzeros; i++)
+    for (int64_t i = 0; i < num_nonzeros; i++)
     {
       cout << '\t' << i << ',' << coo_3dtuples[i].index_i << ',' << coo_3dtuples[i].index_j << ',' << coo_3dtuples[i].index_k << ',' << coo_3dtuples[i].val << "\n";
     }
@@ -859,8 +1540,12 @@ struct Coo3DTensor
 
   /**
    * Builds a Frostt COO sparse from the given file.
+   *
+   * The chunks of the memory-mapped file are parsed in parallel, straight
+   * into their final position in coo_3dtuples. The coordinates are kept as
+   * they are in the file.
    */
-  void InitFrostt(
+  bool InitFrostt(
       const string &filename,
       T default_value = 1.0,
       bool verbose = false)
@@ -878,116 +1563,50 @@ struct Coo3DTensor
       exit(1);
     }
 
-    std::ifstream ifs;
-    ifs.open(filename.c_str(), std::ifstream::in);
-    if (!ifs.good())
-    {
-      fprintf(stderr, "Error opening file\n");
-      exit(1);
-    }
-
-    int current_nz = -1;
-    char line[1024];
-
     if (verbose)
     {
       printf("Parsing... ");
       fflush(stdout);
     }
 
-    while (true)
+    FrosttFile frostt;
+    if (!frostt.Open(filename, 3))
+      return false;
+
+    // Allocate coo tensor
+    num_nonzeros = frostt.num_nonzeros;
+    coo_3dtuples = new Coo3DTuple[num_nonzeros];
+
+    bool parsed = frostt.ParseAll(default_value, [&](int c, int64_t edge, const int64_t *coords, double val)
+                                  {
+                                    // coo_3dtuples[edge] = Coo3DTuple(coords[0] - 1, coords[1] - 1, coords[2] - 1, val);    // Convert indices to zero-based --> This is incorrect!!
+                                    coo_3dtuples[edge] = Coo3DTuple(coords[0], coords[1], coords[2], (T)val);
+                                  });
+    if (!parsed)
+      return false;
+
+    // Adjust nonzero count to the nonzeros found in the file
+    num_nonzeros = frostt.num_edges;
+
+    num_index_i = frostt.dims[0];
+    num_index_j = frostt.dims[1];
+    num_index_k = frostt.dims[2];
+    if (!frostt.dims_given)
     {
-      ifs.getline(line, 1024);
-      if (!ifs.good())
-      {
-        // Done
-        break;
-      }
-
-      if (current_nz == -1)
-      {
-        // Problem description
-        int nparsed = sscanf(line, "%d %d %d %d", &num_index_i, &num_index_j, &num_index_k, &num_nonzeros);
-
-        if (nparsed == 4)
-        {
-          // Allocate coo matrix
-          coo_3dtuples = new Coo3DTuple[num_nonzeros];
-          current_nz = 0;
-        }
-        else
-        {
-          fprintf(stderr, "Error parsing FROSTT tensor: invalid problem description: %s\n", line);
-          assert(false);
-        }
-      }
-      else
+      for (int64_t i = 0; i < num_nonzeros; i++)
       {
-        // Edge
-        if (current_nz >= num_nonzeros)
-        {
-          fprintf(stderr, "Error parsing FROSTT tensor: encountered more than %d num_nonzeros\n", num_nonzeros);
-          assert(false);
-        }
-
-        int idx_i, idx_j, idx_k;
-        T val;
-
-        // Parse nonzero (note: using strtol and strtod is 2x faster than sscanf or istream parsing)
-        char *l = line;
-        char *t = NULL;
-
-        // parse idx_i
-        idx_i = strtol(l, &t, 0);
-        if (t == l)
-        {
-          fprintf(stderr, "Error parsing FROSTT tensor: badly formed row at edge %d\n", current_nz);
-          assert(false);
-        }
-        l = t;
-
-        // parse idx_j
-        idx_j = strtol(l, &t, 0);
-        if (t == l)
-        {
-          fprintf(stderr, "Error parsing FROSTT tensor: badly formed col at edge %d\n", current_nz);
-          assert(false);
-        }
-        l = t;
-
-        // parse idx_k
-        idx_k = strtol(l, &t, 0);
-        if (t == l)
-        {
-          fprintf(stderr, "Error parsing FROSTT tensor: badly formed col at edge %d\n", current_nz);
-          assert(false);
-        }
-        l = t;
-
-        // parse val
-        val = strtod(l, &t);
-        if (t == l)
-        {
-          val = default_value;
-        }
-
-        // coo_3dtuples[current_nz] = Coo3DTuple(idx_i - 1, idx_j - 1, idx_k - 1, val);    // Convert indices to zero-based --> This is incorrect!!
-        coo_3dtuples[current_nz] = Coo3DTuple(idx_i, idx_j, idx_k, val);
-
-        current_nz++;
+        num_index_i = std::max(num_index_i, coo_3dtuples[i].index_i + 1);
+        num_index_j = std::max(num_index_j, coo_3dtuples[i].index_j + 1);
+        num_index_k = std::max(num_index_k, coo_3dtuples[i].index_k + 1);
       }
     }
 
-    // Adjust nonzero count (nonzeros along the diagonal aren't reversed)
-    num_nonzeros = current_nz;
-
     if (verbose)
     {
       printf("done. ");
       fflush(stdout);
     }
-
-    ifs.close();
+    return true;
   }
 };
 
@@ -1011,23 +1630,23 @@ struct Coo3DTensorComparator
 template <typename T>
 struct Csf3DTensor
 {
-  int num_index_i;
-  int num_index_j;
-  int num_index_k;
-  int num_nonzeros;
-  int A1pos_size = 0;
-  int A1crd_size = 0;
-  int A2pos_size = 0;
-  int A2crd_size = 0;
-  int A3pos_size = 0;
-  int A3crd_size = 0;
-  int Aval_size = 0;
-  int *A1pos;
-  int *A1crd;
-  int *A2pos;
-  int *A2crd;
-  int *A3pos;
-  int *A3crd;
+  int64_t num_index_i;
+  int64_t num_index_j;
+  int64_t num_index_k;
+  int64_t num_nonzeros;
+  int64_t A1pos_size = 0;
+  int64_t A1crd_size = 0;
+  int64_t A2pos_size = 0;
+  int64_t A2crd_size = 0;
+  int64_t A3pos_size = 0;
+  int64_t A3crd_size = 0;
+  int64_t Aval_size = 0;
+  int64_t *A1pos;
+  int64_t *A1crd;
+  int64_t *A2pos;
+  int64_t *A2crd;
+  int64_t *A3pos;
+  int64_t *A3crd;
   T *Aval;
 
   /**
@@ -1051,20 +1670,20 @@ struct Csf3DTensor
       printf("done.");
     fflush(stdout);
 
-    A1pos = new int[2];
-    A1crd = new int[num_nonzeros];
-    A2pos = new int[num_nonzeros + 1];
-    A2crd = new int[num_nonzeros];
-    A3pos = new int[num_nonzeros + 1];
-    A3crd = new int[num_nonzeros];
+    A1pos = new int64_t[2];
+    A1crd = new int64_t[num_nonzeros];
+    A2pos = new int64_t[num_nonzeros + 1];
+    A2crd = new int64_t[num_nonzeros];
+    A3pos = new int64_t[num_nonzeros + 1];
+    A3crd = new int64_t[num_nonzeros];
     Aval = new T[num_nonzeros];
 
-    int prev_index_i = -1;
-    int prev_index_j = -1;
-    for (int current_nz = 0; current_nz < num_nonzeros; current_nz++)
+    int64_t prev_index_i = -1;
+    int64_t prev_index_j = -1;
+    for (int64_t current_nz = 0; current_nz < num_nonzeros; current_nz++)
     {
-      int current_index_i = coo_3dtensor->coo_3dtuples[current_nz].index_i;
-      int current_index_j = coo_3dtensor->coo_3dtuples[current_nz].index_j;
+      int64_t current_index_i = coo_3dtensor->coo_3dtuples[current_nz].index_i;
+      int64_t current_index_j = coo_3dtensor->coo_3dtuples[current_nz].index_j;
 
       if (current_index_j != prev_index_j)
       {
@@ -1111,6 +1730,15 @@ struct Csf3DTensor
     A1pos[A1pos_size++] = A1crd_size;
   }
 
+  /**
+   * Bytes held in memory, for the tensor cache
+   */
+  size_t Bytes() const
+  {
+    return (size_t)(A1pos_size + A1crd_size + A2pos_size + A2crd_size + A3pos_size + A3crd_size) * sizeof(int64_t) +
+           (size_t)Aval_size * sizeof(T);
+  }
+
   /**
    * Clear
    */
@@ -1169,23 +1797,23 @@ struct Csf3DTensor
 template <typename T>
 struct Mg3DTensor
 {
-  int num_index_i;
-  int num_index_j;
-  int num_index_k;
-  int num_nonzeros;
-  int A1pos_size = 0;
-  int A1crd_size = 0;
-  int A2pos_size = 0;
-  int A2crd_size = 0;
-  int A3pos_size = 0;
-  int A3crd_size = 0;
-  int Aval_size = 0;
-  int *A1pos;
-  int *A1crd;
-  int *A2pos;
-  int *A2crd;
-  int *A3pos;
-  int *A3crd;
+  int64_t num_index_i;
+  int64_t num_index_j;
+  int64_t num_index_k;
+  int64_t num_nonzeros;
+  int64_t A1pos_size = 0;
+  int64_t A1crd_size = 0;
+  int64_t A2pos_size = 0;
+  int64_t A2crd_size = 0;
+  int64_t A3pos_size = 0;
+  int64_t A3crd_size = 0;
+  int64_t Aval_size = 0;
+  int64_t *A1pos;
+  int64_t *A1crd;
+  int64_t *A2pos;
+  int64_t *A2crd;
+  int64_t *A3pos;
+  int64_t *A3crd;
   T *Aval;
 
   /**
@@ -1210,13 +1838,13 @@ struct Mg3DTensor
     fflush(stdout);
 
     // Evaluate size of A1crd, A2crd
-    int alloc_size_A1crd = 0; // same with alloc_size_A2crd
-    int alloc_prev_index_i = -1;
-    int alloc_prev_index_j = -1;
-    for (int current_nz = 0; current_nz < num_nonzeros; current_nz++)
+    int64_t alloc_size_A1crd = 0; // same with alloc_size_A2crd
+    int64_t alloc_prev_index_i = -1;
+    int64_t alloc_prev_index_j = -1;
+    for (int64_t current_nz = 0; current_nz < num_nonzeros; current_nz++)
     {
-      int current_index_i = coo_3dtensor->coo_3dtuples[current_nz].index_i;
-      int current_index_j = coo_3dtensor->coo_3dtuples[current_nz].index_j;
+      int64_t current_index_i = coo_3dtensor->coo_3dtuples[current_nz].index_i;
+      int64_t current_index_j = coo_3dtensor->coo_3dtuples[current_nz].index_j;
 
       if (current_index_i != alloc_prev_index_i || current_index_j != alloc_prev_index_j)
       {
@@ -1225,24 +1853,24 @@ struct Mg3DTensor
         alloc_prev_index_j = current_index_j;
       }
     }
-    A1pos = new int[2];
-    A1crd = new int[alloc_size_A1crd];
-    A2pos = new int[1];
-    A2crd = new int[alloc_size_A1crd];
-    A3pos = new int[1];
-    A3crd = new int[1];
+    A1pos = new int64_t[2];
+    A1crd = new int64_t[alloc_size_A1crd];
+    A2pos = new int64_t[1];
+    A2crd = new int64_t[alloc_size_A1crd];
+    A3pos = new int64_t[1];
+    A3crd = new int64_t[1];
     Aval = new T[alloc_size_A1crd * num_index_k];
 
     A3pos[A3pos_size++] = num_index_k;
 
-    int prev_index_i = -1;
-    int prev_index_j = -1;
-    for (int current_nz = 0; current_nz < num_nonzeros; current_nz++)
+    int64_t prev_index_i = -1;
+    int64_t prev_index_j = -1;
+    for (int64_t current_nz = 0; current_nz < num_nonzeros; current_nz++)
     {
-      int current_index_i = coo_3dtensor->coo_3dtuples[current_nz].index_i;
-      int current_index_j = coo_3dtensor->coo_3dtuples[current_nz].index_j;
-      int current_index_k = coo_3dtensor->coo_3dtuples[current_nz].index_k;
-      int current_val = coo_3dtensor->coo_3dtuples[current_nz].val;
+      int64_t current_index_i = coo_3dtensor->coo_3dtuples[current_nz].index_i;
+      int64_t current_index_j = coo_3dtensor->coo_3dtuples[current_nz].index_j;
+      int64_t current_index_k = coo_3dtensor->coo_3dtuples[current_nz].index_k;
+      T current_val = coo_3dtensor->coo_3dtuples[current_nz].val;
 
       // Fill in rows up to and including the current row
       if (current_index_i != prev_index_i || current_index_j != prev_index_j)
@@ -1253,11 +1881,11 @@ struct Mg3DTensor
         // Fill previous (i,j)
         if (Aval_size % num_index_k != 0)
         {
-          for (int i = Aval_size % num_index_k; i < num_index_k; i++)
+          for (int64_t i = Aval_size % num_index_k; i < num_index_k; i++)
             Aval[Aval_size++] = 0;
         }
         // Fill current (i,j)
-        for (int i = Aval_size % num_index_k; i < current_index_k; i++)
+        for (int64_t i = Aval_size % num_index_k; i < current_index_k; i++)
           Aval[Aval_size++] = 0;
         Aval[Aval_size++] = current_val;
 
@@ -1266,7 +1894,7 @@ struct Mg3DTensor
       }
       else
       {
-        for (int i = Aval_size % num_index_k; i < current_index_k; i++)
+        for (int64_t i = Aval_size % num_index_k; i < current_index_k; i++)
           Aval[Aval_size++] = 0;
         Aval[Aval_size++] = current_val;
       }
@@ -1276,6 +1904,15 @@ struct Mg3DTensor
     A1pos[A1pos_size++] = A1crd_size;
   }
 
+  /**
+   * Bytes held in memory, for the tensor cache
+   */
+  size_t Bytes() const
+  {
+    return (size_t)(A1pos_size + A1crd_size + A2pos_size + A2crd_size + A3pos_size + A3crd_size) * sizeof(int64_t) +
+           (size_t)Aval_size * sizeof(T);
+  }
+
   /**
    * Clear
    */
@@ -1324,590 +1961,1832 @@ struct Mg3DTensor
   }
 };
 
-template <typename T>
-static std::map<int32_t, CooMatrix<T>*> CooTracking;
-
-template <typename T>
-static std::map<int32_t, Coo3DTensor<T>*> Coo3DTracking;
+// /******************************************************************************
+//  * Rank-generic tensor types
+//  ******************************************************************************/
 
-// matrix read wrapper: initiates file read only once. 
-// assumption: read_input_sizes_2D() and read_input_2D() are called in order 
-//             and only once for each fileID/file.
+/**
+ * COO tensor of any rank, read from a FROSTT file. The coordinates of
+ * nonzero e are coords[e * rank, (e + 1) * rank).
+ */
 template <typename T>
-struct FileReaderWrapper
+struct CooTensor
 {
-  std::string filename;
-  int32_t ID; 
-  bool is3D; 
+  int rank;
+  std::vector<int64_t> dims;
+  int64_t num_nonzeros;
+  std::vector<int64_t> coords;
+  std::vector<T> vals;
 
-  CooMatrix<T> *coo_matrix;
-  Coo3DTensor<T> *coo_3dtensor;
+  CooTensor() : rank(0), num_nonzeros(0) {}
 
-  bool readFileNameStr(int32_t fileID)
+  /**
+   * Bytes held in memory, for the tensor cache
+   */
+  size_t Bytes() const
   {
-    char *pSparseInput;
-    std::string envString;
-    if (fileID >= 0 && fileID < 9999)
-    {
-      envString = "SPARSE_FILE_NAME" + std::to_string(fileID);
-      pSparseInput = getenv(envString.c_str());
-    }
-    else if (fileID == 9999)
-    {
-      pSparseInput = getenv("SPARSE_FILE_NAME");
-    }
-    else
-    {
-      assert(false && "ERROR: SPARSE_FILE_NAME environmental variable is not set");
-    }
-
-    filename = pSparseInput; // update
+    return coords.capacity() * sizeof(int64_t) + vals.capacity() * sizeof(T);
+  }
 
-    return true;
+  const int64_t *Coords(int64_t e) const
+  {
+    return &coords[e * rank];
   }
 
-  void readMtxFile()
+  /**
+   * Builds a FROSTT COO tensor from the given file: the chunks of the
+   * memory-mapped file are parsed in parallel, straight into their final
+   * position. The coordinates are kept as they are in the file. If the
+   * problem description does not give all dimension sizes, they are taken
+   * from the largest coordinates. Returns false if the file cannot be read,
+   * see parseError().
+   */
+  bool InitFrostt(const string &filename, int tensor_rank, T default_value = 1.0)
   {
-    if (filename.find(".mtx") == std::string::npos)
+    FrosttFile frostt;
+    if (!frostt.Open(filename, tensor_rank))
+      return false;
+
+    rank = tensor_rank;
+    num_nonzeros = frostt.num_edges;
+    coords.resize(num_nonzeros * rank);
+    vals.resize(num_nonzeros);
+
+    std::vector<std::vector<int64_t>> chunk_dims(frostt.NumChunks(), std::vector<int64_t>(rank, 0));
+    bool parsed = frostt.ParseAll(default_value, [&](int c, int64_t edge, const int64_t *crd, double val)
+                                  {
+                                    for (int d = 0; d < rank; d++)
+                                    {
+                                      coords[edge * rank + d] = crd[d];
+                                      chunk_dims[c][d] = std::max(chunk_dims[c][d], crd[d] + 1);
+                                    }
+                                    vals[edge] = (T)val;
+                                  });
+    if (!parsed)
+      return false;
+
+    dims = frostt.dims;
+    if (!frostt.dims_given)
     {
-      assert(false && "ERROR: input file is not Market Matrix file");
+      for (auto &cd : chunk_dims)
+        for (int d = 0; d < rank; d++)
+          dims[d] = std::max(dims[d], cd[d]);
     }
-
-    // init matrix read
-    coo_matrix->InitMarket(filename);
+    return true;
   }
 
-  void readTnsFile()
+  // Lexicographic order of the coordinates of nonzeros p and q
+  bool Less(int64_t p, int64_t q) const
   {
-    if (filename.find(".tns") == std::string::npos)
+    const int64_t *cp = Coords(p);
+    const int64_t *cq = Coords(q);
+    for (int d = 0; d < rank; d++)
     {
-      assert(false && "ERROR: input file is not TNS format");
+      if (cp[d] != cq[d])
+        return cp[d] < cq[d];
     }
-
-    // init frostt file read
-    coo_3dtensor->InitFrostt(filename);
+    return false;
   }
 
   /**
-   * Constructor
+   * Stable sort of the nonzeros in lexicographic order of their
+   * coordinates. Chunks of the nonzeros are sorted in parallel, and then
+   * merged pairwise.
    */
-  FileReaderWrapper(int32_t fileID, bool tnsFile = false)
+  void Sort()
   {
-    ID = fileID;
+    bool sorted = true;
+    for (int64_t e = 1; sorted && e < num_nonzeros; e++)
+      sorted = !Less(e, e - 1);
+    if (sorted)
+      return;
 
-    if (CooTracking<T>.find(fileID) == CooTracking<T>.end() && !tnsFile) // not found, read the file
-    {
-      bool done = readFileNameStr(fileID);
-      if (done && !filename.empty())
-      { // file is read here
-        coo_matrix = new CooMatrix<T>();
-        readMtxFile();  // 2D
+    std::vector<int64_t> perm(num_nonzeros);
+    for (int64_t e = 0; e < num_nonzeros; e++)
+      perm[e] = e;
 
-        // update hash-map
-        CooTracking<T>[fileID] = coo_matrix;
-      }
-      else
-      {
-        fprintf(stderr, "No input specified.\n");
-        assert(false);
-      }
+    auto less = [this](int64_t p, int64_t q)
+    { return Less(p, q); };
 
-      is3D = false;
-    } 
-    else if (CooTracking<T>.count(fileID) == 1)
-    { // re-use the old file read
-      coo_matrix = CooTracking<T>[fileID];
+    int num_chunks = std::max(1, std::min(getNumThreads(), (int)(num_nonzeros / 4096)));
+    std::vector<int64_t> bounds(num_chunks + 1);
+    for (int c = 0; c <= num_chunks; c++)
+      bounds[c] = num_nonzeros * c / num_chunks;
 
-      is3D = false;
-    }
+    parallelFor(num_chunks, getNumThreads(), [&](int c)
+                { std::stable_sort(perm.begin() + bounds[c], perm.begin() + bounds[c + 1], less); });
 
-    if (Coo3DTracking<T>.find(fileID) == Coo3DTracking<T>.end() && tnsFile) // not found
+    for (int width = 1; width < num_chunks; width *= 2)
     {
-      bool done = readFileNameStr(fileID);
-      if (done && !filename.empty())
-      { // file is read here
-        coo_3dtensor = new Coo3DTensor<T>();
-        readTnsFile();  // 3D
-          
-        // update hash-map
-        Coo3DTracking<T>[fileID] = coo_3dtensor;
-      }
-      else
-      {
-        fprintf(stderr, "No input specified.\n");
-        assert(false);
-      }
-
-      is3D = true;
+      int num_merges = (num_chunks + 2 * width - 1) / (2 * width);
+      parallelFor(num_merges, getNumThreads(), [&](int m)
+                  {
+                    int first = 2 * width * m;
+                    int middle = std::min(first + width, num_chunks);
+                    int last = std::min(first + 2 * width, num_chunks);
+                    std::inplace_merge(perm.begin() + bounds[first], perm.begin() + bounds[middle],
+                                       perm.begin() + bounds[last], less);
+                  });
     }
-    else if (Coo3DTracking<T>.count(fileID) == 1 && tnsFile)
-    {
-      coo_3dtensor = Coo3DTracking<T>[fileID];
 
-      is3D = true;
-    }
-        
+    std::vector<int64_t> sorted_coords(coords.size());
+    std::vector<T> sorted_vals(num_nonzeros);
+    parallelFor(num_chunks, getNumThreads(), [&](int c)
+                {
+                  for (int64_t i = bounds[c]; i < bounds[c + 1]; i++)
+                  {
+                    std::copy(Coords(perm[i]), Coords(perm[i]) + rank, &sorted_coords[i * rank]);
+                    sorted_vals[i] = vals[perm[i]];
+                  }
+                });
+    coords.swap(sorted_coords);
+    vals.swap(sorted_vals);
   }
+};
+
+/**
+ * Sparse tensor of any rank stored with a per-dimension level format:
+ * pos[d] and crd[d] are the pos and crd arrays of dimension d, built from
+ * the sorted COO tensor the same way as the 3D tensors above:
+ *  - a Dense level stores its size in pos, and splits every position of
+ *    the level above into its size positions;
+ *  - a Compressed level stores one position for every distinct coordinate
+ *    under each position of the level above. A Compressed_nonunique level
+ *    also tells apart the coordinates of the singleton levels after it;
+ *    they have a single coordinate per position, and no pos array;
+ *  - the last Compressed level, or a Compressed_nonunique level followed
+ *    by singleton levels only, keeps every nonzero, duplicates included.
+ * Values of the nonzeros that end up in the same position are summed.
+ */
+template <typename T>
+struct LevelTensor
+{
+  int rank;
+  std::vector<int64_t> dims;
+  std::vector<std::vector<int64_t>> pos;
+  std::vector<std::vector<int64_t>> crd;
+  std::vector<T> vals;
+
+  LevelTensor() : rank(0) {}
 
   /**
-   * Destructor
+   * Builds the levels from the sorted COO tensor. Returns false if a
+   * coordinate is out of a dense dimension, see parseError().
    */
-  ~FileReaderWrapper()
+  bool Init(const CooTensor<T> *coo, const int32_t *formats)
   {
-    // Do nothing here, this is taken care of in Finalize() method.
-  }
+    rank = coo->rank;
+    dims = coo->dims;
+    pos.assign(rank, std::vector<int64_t>());
+    crd.assign(rank, std::vector<int64_t>());
 
-  void FileReaderWrapperFinalize()
-  {
+    // [bounds[p], bounds[p + 1]) are the sorted nonzeros under position p
+    std::vector<int64_t> bounds = {0, coo->num_nonzeros};
 
-    if (is3D)
+    for (int d = 0; d < rank; d++)
     {
-      if (Coo3DTracking<T>.count(ID) == 1)
-      {
-        coo_3dtensor = Coo3DTracking<T>[ID];
-      }
-      else
+      int64_t num_positions = bounds.size() - 1;
+      std::vector<int64_t> next_bounds;
+
+      if (formats[d] == Dense)
       {
-        // not found!
-        return;
+        pos[d] = {dims[d]};
+        crd[d] = {-1}; // unused, as in the 2D reads
+        next_bounds.reserve(num_positions * dims[d] + 1);
+        next_bounds.push_back(0);
+        for (int64_t p = 0; p < num_positions; p++)
+        {
+          int64_t e = bounds[p];
+          for (int64_t i = 0; i < dims[d]; i++)
+          {
+            while (e < bounds[p + 1] && coo->Coords(e)[d] == i)
+              e++;
+            next_bounds.push_back(e);
+          }
+          if (e != bounds[p + 1])
+          {
+            parseError("ERROR: coordinate %" PRId64 " out of the dense dimension %d of size %" PRId64 "\n",
+                       coo->Coords(e)[d], d, dims[d]);
+            return false;
+          }
+        }
       }
-    }
-    else
-    { // 2D
-      if (CooTracking<T>.count(ID) == 1)
+      else if (formats[d] == singleton)
       {
-        coo_matrix = CooTracking<T>[ID];
+        pos[d] = {-1}; // unused, as in the 2D reads
+        crd[d].resize(num_positions, 0);
+        for (int64_t p = 0; p < num_positions; p++)
+        {
+          if (bounds[p] < bounds[p + 1])
+            crd[d][p] = coo->Coords(bounds[p])[d];
+        }
+        next_bounds.swap(bounds);
       }
       else
       {
-        // not found!
-        return;
+        // coordinates [d, last] tell the positions of this level apart
+        int last = d;
+        if (formats[d] == Compressed_nonunique)
+        {
+          while (last + 1 < rank && formats[last + 1] == singleton)
+            last++;
+        }
+        bool keep_duplicates = (last == rank - 1);
+
+        pos[d].reserve(num_positions + 1);
+        pos[d].push_back(0);
+        next_bounds.push_back(0);
+        for (int64_t p = 0; p < num_positions; p++)
+        {
+          for (int64_t e = bounds[p]; e < bounds[p + 1];)
+          {
+            int64_t next = e + 1;
+            while (!keep_duplicates && next < bounds[p + 1] &&
+                   std::equal(coo->Coords(e) + d, coo->Coords(e) + last + 1, coo->Coords(next) + d))
+              next++;
+            crd[d].push_back(coo->Coords(e)[d]);
+            next_bounds.push_back(next);
+            e = next;
+          }
+          pos[d].push_back(crd[d].size());
+        }
       }
-    }
 
-    
+      bounds.swap(next_bounds);
+    }
 
-    if (is3D)
+    int64_t num_values = bounds.size() - 1;
+    vals.assign(num_values, 0);
+    for (int64_t p = 0; p < num_values; p++)
     {
-      coo_3dtensor->num_nonzeros = 0;  // reset
-      coo_3dtensor->Clear();
-
-      // update the hashMap
-      delete coo_3dtensor;
-      Coo3DTracking<T>.erase (ID);
+      for (int64_t e = bounds[p]; e < bounds[p + 1]; e++)
+        vals[p] += coo->vals[e];
     }
-    else
-    {
-      coo_matrix->num_nonzeros = 0;  // reset
-      coo_matrix->num_nonzeros_lowerTri = 0; 
-      coo_matrix->num_nonzeros_lowerTri_strict = 0;
-      coo_matrix->num_nonzeros_upperTri = 0;
-      coo_matrix->num_nonzeros_upperTri_strict = 0;
-      coo_matrix->Clear();
+    return true;
+  }
 
-      // update the hashMap
-      delete coo_matrix;
-      CooTracking<T>.erase (ID);
-    }
+  /**
+   * Bytes held in memory, for the tensor cache
+   */
+  size_t Bytes() const
+  {
+    size_t bytes = vals.capacity() * sizeof(T);
+    for (int d = 0; d < rank; d++)
+      bytes += (pos[d].capacity() + crd[d].capacity()) * sizeof(int64_t);
+    return bytes;
   }
-  
 };
 
-// helper func: get num of nonzeros based on selected matrix read
-template <typename T>
-int getNumNonZeros (CooMatrix<T> *coo_matrix, int32_t readMode)
+// helper func: name of the input file behind fileID, taken from the
+// SPARSE_FILE_NAME<fileID> (or SPARSE_FILE_NAME for fileID 9999)
+// environmental variable. Returns an empty string if it is not set.
+std::string getSparseFileName(int32_t fileID)
 {
-  int NumNonZeros = -1; 
+  char *pSparseInput = NULL;
+  std::string envString;
+  if (fileID >= 0 && fileID < 9999)
+  {
+    envString = "SPARSE_FILE_NAME" + std::to_string(fileID);
+    pSparseInput = getenv(envString.c_str());
+  }
+  else if (fileID == 9999)
+  {
+    pSparseInput = getenv("SPARSE_FILE_NAME");
+  }
+  else
+  {
+    assert(false && "ERROR: SPARSE_FILE_NAME environmental variable is not set");
+  }
 
-  int selected_matrix_read = getMatrixReadOption(readMode);
+  return pSparseInput ? std::string(pSparseInput) : std::string();
+}
 
-  if (selected_matrix_read == LOWER_TRI_STRICT)
-    NumNonZeros = coo_matrix->num_nonzeros_lowerTri_strict;
-  else if (selected_matrix_read == LOWER_TRI)
-    NumNonZeros = coo_matrix->num_nonzeros_lowerTri;
-  else if (selected_matrix_read == UPPER_TRI_STRICT)
-    NumNonZeros = coo_matrix->num_nonzeros_upperTri_strict;
-  else if (selected_matrix_read == UPPER_TRI)
-    NumNonZeros = coo_matrix->num_nonzeros_upperTri;
-  else // DEFAULT 
-    NumNonZeros = coo_matrix->num_nonzeros;
+//===----------------------------------------------------------------------===//
+// Binary sidecar cache for converted inputs.
+//===----------------------------------------------------------------------===//
 
-  return NumNonZeros;
+/**
+ * Parsing a large .mtx/.tns file dominates the startup of many programs, so
+ * the pos/crd/val arrays produced for a (file, format, readMode) can be
+ * saved to a binary sidecar file, and mapped back on later runs instead of
+ * parsing the text again.
+ *
+ * Caching is turned on by the COMET_BINARY_CACHE environmental variable:
+ * "1" puts the sidecar files next to the inputs, any other value except "0"
+ * is taken as the directory to put them in.
+ *
+ * A sidecar file holds a BinaryCacheHeader, the path of the input file, the
+ * sizes array returned by read_input_sizes_*, and then the arrays of the
+ * tensor in the order A1pos, A1crd, A2pos, A2crd, ..., Aval. Every part is
+ * padded to 8 bytes. A sidecar file is only used if the size and the
+ * modification time of the input file still match the ones it was built
+ * from.
+ *
+ * An input file named *.cbin is taken as such a container itself (e.g., one
+ * written by comet_write), whatever COMET_BINARY_CACHE is: its arrays are
+ * mapped as they are, without a text file to check them against.
+ */
+static const uint32_t BINARY_CACHE_VERSION = 1;
+static const int BINARY_CACHE_MAX_RANK = 8;
+
+struct BinaryCacheHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t value_bytes;      // sizeof the value type
+  int64_t source_size;       // size of the input file
+  int64_t source_mtime;      // modification time of the input file
+  int32_t rank;
+  int32_t read_mode;
+  int32_t formats[BINARY_CACHE_MAX_RANK];
+  int64_t path_size;         // length of the input path that follows the header
+  int64_t num_sizes;         // entries of the sizes array: 3 * rank + 1
+};
+
+// helper func: whether name ends with suffix
+static bool hasSuffix(const string &name, const string &suffix)
+{
+  return name.size() >= suffix.size() &&
+         name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
 }
 
-/***********Sparse Utility Functions*******************/
+static inline size_t alignTo8(size_t size)
+{
+  return (size + 7) & ~(size_t)7;
+}
 
-// Read input matrices based on the datatype
-template <typename T>
-void read_input_sizes_2D(int32_t fileID, int32_t A1format, int32_t A2format, int sizes_rank, void *sizes_ptr, int32_t readMode)
+struct BinaryCacheFile
 {
-  auto *desc_sizes = static_cast<StridedMemRefType<int64_t, 1> *>(sizes_ptr);
+  MappedFile file;
+  const int64_t *sizes;
+  std::vector<const char *> arrays;  // 2 * rank pos/crd arrays and the val array
 
-  int selected_matrix_read = getMatrixReadOption(readMode);
-  FileReaderWrapper<T> FileReader (fileID);  // init of COO
+  BinaryCacheFile() : sizes(NULL) {}
 
-  // SparseFormatAttribute A1format: COO
-  if (A1format == Compressed_nonunique && A2format == singleton)
+  // Returns true if binary caching is turned on
+  static bool Enabled()
   {
-    // get num-NNZs from coo_matrix struct.
-    int NumNonZeros = getNumNonZeros(FileReader.coo_matrix, readMode);
-
-    desc_sizes->data[0] = 2;
-    desc_sizes->data[1] = NumNonZeros;
-    desc_sizes->data[2] = 1;
-    desc_sizes->data[3] = NumNonZeros;
-    desc_sizes->data[4] = NumNonZeros;
-    desc_sizes->data[5] = FileReader.coo_matrix->num_rows;
-    desc_sizes->data[6] = FileReader.coo_matrix->num_cols;
+    char *env = getenv("COMET_BINARY_CACHE");
+    return env && strlen(env) > 0 && strcmp(env, "0") != 0;
   }
-  // CSR
-  else if (A1format == Dense && A2format == Compressed_unique)
-  {
-    // get num-NNZs from coo_matrix struct.
-    int NumNonZeros = getNumNonZeros(FileReader.coo_matrix, readMode);
-
-    desc_sizes->data[0] = 1;
-    desc_sizes->data[1] = 1;
-    desc_sizes->data[2] = FileReader.coo_matrix->num_rows + 1;
-    desc_sizes->data[3] = NumNonZeros;
-    desc_sizes->data[4] = NumNonZeros;
-    desc_sizes->data[5] = FileReader.coo_matrix->num_rows;
-    desc_sizes->data[6] = FileReader.coo_matrix->num_cols;
 
-    /*****************DEBUG******************/
-    // std::cout << "CSR detail: \n"
-    //           << "desc_sizes->data[0]: " << desc_sizes->data[0] << "\n"
-    //           << "desc_sizes->data[1]: " << desc_sizes->data[1] << "\n"
-    //           << "desc_sizes->data[2]: " << desc_sizes->data[2] << "\n"
-    //           << "desc_sizes->data[3]: " << desc_sizes->data[3] << "\n"
-    //           << "desc_sizes->data[4]: " << desc_sizes->data[4] << "\n"
-    //           << "desc_sizes->data[5]: " << desc_sizes->data[5] << "\n"
-    //           << "desc_sizes->data[6]: " << desc_sizes->data[6] << "\n";
-    /*****************DEBUG******************/
-  }
-  // CSC
-  else if (A1format == Compressed_unique && A2format == Dense)
+  // Fills in the header fields that identify the input file and the
+  // requested conversion. Returns false if the input cannot be cached.
+  static bool MakeHeader(const string &source, int rank, const int32_t *formats,
+                         int32_t readMode, size_t value_bytes, BinaryCacheHeader &header)
   {
-    int NumNonZeros = 0;
-    if (selected_matrix_read == DEFAULT)
-      NumNonZeros = FileReader.coo_matrix->num_nonzeros;
-    else
-      assert(false && "unsupported matrix format (CSC) for triangular reads.\n");
-
-    desc_sizes->data[0] = FileReader.coo_matrix->num_cols + 1;
-    desc_sizes->data[1] = NumNonZeros;
-    desc_sizes->data[2] = 1;
-    desc_sizes->data[3] = 1;
-    desc_sizes->data[4] = NumNonZeros;
-    desc_sizes->data[5] = FileReader.coo_matrix->num_rows;
-    desc_sizes->data[6] = FileReader.coo_matrix->num_cols;
-
-    /*****************DEBUG******************/
-    // std::cout << "CSC detail: \n"
-    //           << "desc_sizes->data[0]: " << desc_sizes->data[0] << "\n"
-    //           << "desc_sizes->data[1]: " << desc_sizes->data[1] << "\n"
-    //           << "desc_sizes->data[2]: " << desc_sizes->data[2] << "\n"
-    //           << "desc_sizes->data[3]: " << desc_sizes->data[3] << "\n"
-    //           << "desc_sizes->data[4]: " << desc_sizes->data[4] << "\n"
-    //           << "desc_sizes->data[5]: " << desc_sizes->data[5] << "\n"
-    //           << "desc_sizes->data[6]: " << desc_sizes->data[6] << "\n";
-    /*****************DEBUG******************/
+    if (rank > BINARY_CACHE_MAX_RANK)
+      return false;
+
+    struct stat st;
+    if (stat(source.c_str(), &st) != 0)
+      return false;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "COMETBIN", 8);
+    header.version = BINARY_CACHE_VERSION;
+    header.value_bytes = value_bytes;
+    header.source_size = st.st_size;
+    header.source_mtime = st.st_mtime;
+    header.rank = rank;
+    header.read_mode = readMode;
+    for (int64_t i = 0; i < rank; i++)
+      header.formats[i] = formats[i];
+    header.path_size = source.size();
+    header.num_sizes = 3 * rank + 1;
+    return true;
   }
-  // DCSR
-  else if (A1format == Compressed_unique && A2format == Compressed_unique)
-  {
-    DcsrMatrix<T> dcsr_matrix(FileReader.coo_matrix);
-    
-    if (selected_matrix_read != DEFAULT)
-      assert(false && "unsupported matrix format (DCSR) for triangular reads.\n");
 
-    desc_sizes->data[0] = dcsr_matrix.A1pos_size;
-    desc_sizes->data[1] = dcsr_matrix.A1crd_size;
-    desc_sizes->data[2] = dcsr_matrix.A2pos_size;
-    desc_sizes->data[3] = dcsr_matrix.A2crd_size;
-    desc_sizes->data[4] = dcsr_matrix.A2crd_size;
-    desc_sizes->data[5] = dcsr_matrix.num_rows;
-    desc_sizes->data[6] = dcsr_matrix.num_cols;
-  }
-  else
+  // Path of the sidecar file for the given input and conversion
+  static string GetPath(const string &source, int rank, const int32_t *formats,
+                        int32_t readMode, size_t value_bytes)
   {
-    assert(false && "unsupported matrix format\n");
+    string suffix = ".";
+    for (int64_t i = 0; i < rank; i++)
+      suffix += std::to_string(formats[i]);
+    suffix += "-r" + std::to_string(readMode);
+    suffix += (value_bytes == sizeof(float)) ? "-f32" : "-f64";
+    suffix += ".cbin";
+
+    string dir = getenv("COMET_BINARY_CACHE");
+    if (dir == "1")
+      return source + suffix;
+
+    // Inputs with the same name in different directories must not collide
+    string name = source.substr(source.find_last_of('/') + 1);
+    return dir + "/" + name + "." + std::to_string(std::hash<string>()(source)) + suffix;
   }
-}
-
-template <typename T>
-void read_input_2D(int32_t fileID, int32_t A1format, int32_t A2format,
-                   int A1pos_rank, void *A1pos_ptr,
-                   int A1crd_rank, void *A1crd_ptr,
-                   int A2pos_rank, void *A2pos_ptr,
-                   int A2crd_rank, void *A2crd_ptr,
-                   int Aval_rank, void *Aval_ptr,
-                   int32_t readMode)
-{
 
-  auto *desc_A1pos = static_cast<StridedMemRefType<int64_t, 1> *>(A1pos_ptr);
-  auto *desc_A1crd = static_cast<StridedMemRefType<int64_t, 1> *>(A1crd_ptr);
-  auto *desc_A2pos = static_cast<StridedMemRefType<int64_t, 1> *>(A2pos_ptr);
-  auto *desc_A2crd = static_cast<StridedMemRefType<int64_t, 1> *>(A2crd_ptr);
-  auto *desc_Aval = static_cast<StridedMemRefType<T, 1> *>(Aval_ptr);
-
-  // For example, A2pos is not used for COO, but initialized with -1 to speficify that it is not used
-  desc_A1pos->data[0] = -1;
-  desc_A1crd->data[0] = -1;
-  desc_A2pos->data[0] = -1;
-  desc_A2crd->data[0] = -1;
-
-  int selected_matrix_read = getMatrixReadOption(readMode);
-  FileReaderWrapper<T> FileReader (fileID);  // init of COO
-
-  // SparseFormatAttribute A1format: COO
-  if (A1format == Compressed_nonunique && A2format == singleton)
+  // Returns true if the input file is a container itself
+  static bool IsContainer(const string &source)
   {
-    std::stable_sort(FileReader.coo_matrix->coo_tuples, FileReader.coo_matrix->coo_tuples + FileReader.coo_matrix->num_nonzeros, CooComparatorRow());
-
-    desc_A1pos->data[0] = 0;
-    int actual_num_nonzeros = 0;
+    return hasSuffix(source, ".cbin");
+  }
 
-    for (int i = 0; i < FileReader.coo_matrix->num_nonzeros; i++)
+  /**
+   * Maps the sidecar file of the given input, if there is an up-to-date one,
+   * or the input itself if it is a container.
+   */
+  bool Open(const string &source, int rank, const int32_t *formats,
+            int32_t readMode, size_t value_bytes)
+  {
+    if (IsContainer(source))
     {
-      if ( ( (selected_matrix_read == LOWER_TRI_STRICT) || (selected_matrix_read == LOWER_TRI) ) &&   // filter lower triangular vals
-                (FileReader.coo_matrix->coo_tuples[i].row > FileReader.coo_matrix->coo_tuples[i].col) )
-      {
-        desc_A1crd->data[actual_num_nonzeros] = FileReader.coo_matrix->coo_tuples[i].row;
-        desc_A2crd->data[actual_num_nonzeros] = FileReader.coo_matrix->coo_tuples[i].col;
-        desc_Aval->data[actual_num_nonzeros] = FileReader.coo_matrix->coo_tuples[i].val;
-        actual_num_nonzeros++;
-      }
-      else if ( ( (selected_matrix_read == UPPER_TRI_STRICT) || (selected_matrix_read == UPPER_TRI) ) &&   // filter upper triangular vals
-                (FileReader.coo_matrix->coo_tuples[i].row < FileReader.coo_matrix->coo_tuples[i].col) )
-      {
-        desc_A1crd->data[actual_num_nonzeros] = FileReader.coo_matrix->coo_tuples[i].row;
-        desc_A2crd->data[actual_num_nonzeros] = FileReader.coo_matrix->coo_tuples[i].col;
-        desc_Aval->data[actual_num_nonzeros] = FileReader.coo_matrix->coo_tuples[i].val;
-        actual_num_nonzeros++;
-      }
-      else if ( ( (selected_matrix_read == UPPER_TRI) || (selected_matrix_read == LOWER_TRI) ) &&  // the diagonal vals go in both UPPER_TRI and LOWER_TRI
-                (FileReader.coo_matrix->coo_tuples[i].row == FileReader.coo_matrix->coo_tuples[i].col) )
+      if (getMatrixReadOption(readMode) != DEFAULT)
       {
-        desc_A1crd->data[actual_num_nonzeros] = FileReader.coo_matrix->coo_tuples[i].row;
-        desc_A2crd->data[actual_num_nonzeros] = FileReader.coo_matrix->coo_tuples[i].col;
-        desc_Aval->data[actual_num_nonzeros] = FileReader.coo_matrix->coo_tuples[i].val;
-        actual_num_nonzeros++;
+        fprintf(stderr, "ERROR: triangular reads of binary tensor files are not supported\n");
+        exit(1);
       }
-      else if ( selected_matrix_read == DEFAULT )// standard matrix vals
-      {
-        desc_A1crd->data[actual_num_nonzeros] = FileReader.coo_matrix->coo_tuples[i].row;
-        desc_A2crd->data[actual_num_nonzeros] = FileReader.coo_matrix->coo_tuples[i].col;
-        desc_Aval->data[actual_num_nonzeros] = FileReader.coo_matrix->coo_tuples[i].val;
-        actual_num_nonzeros++;
-      }      
+      return OpenContainer(source, rank, formats, value_bytes);
+    }
 
-    } // end-for
-    desc_A1pos->data[1] = actual_num_nonzeros;
+    BinaryCacheHeader expected;
+    if (!Enabled() || !MakeHeader(source, rank, formats, readMode, value_bytes, expected))
+      return false;
 
-    FileReader.FileReaderWrapperFinalize(); // clear coo_matrix
+    if (!file.Open(GetPath(source, rank, formats, readMode, value_bytes)))
+      return false;
+
+    size_t offset = sizeof(BinaryCacheHeader);
+    if (file.size < offset || memcmp(file.data, &expected, offset) != 0)
+      return Reject();
+
+    if (file.size < offset + alignTo8(source.size()) ||
+        memcmp(file.data + offset, source.data(), source.size()) != 0)
+      return Reject();
+    offset += alignTo8(source.size());
+
+    return MapArrays(offset, rank, value_bytes);
   }
-  // CSR
-  else if (A1format == Dense && A2format == Compressed_unique)
+
+  /**
+   * Maps an input file that is a container itself. Unlike sidecar files,
+   * a container that does not hold the requested tensor is an error.
+   */
+  bool OpenContainer(const string &filename, int rank, const int32_t *formats, size_t value_bytes)
   {
-    CsrMatrix<T> csr_matrix(FileReader.coo_matrix, selected_matrix_read); 
+    if (!file.Open(filename))
+      return false;
 
-    int upperBound_NNZ = getNumNonZeros(FileReader.coo_matrix, readMode);
-    FileReader.FileReaderWrapperFinalize();  // clear coo_matrix
-    
-    // /*****************DEBUG******************/
-    // std::cout << "CSR detail: " << csr_matrix.num_cols << ", " << csr_matrix.num_rows << ", " << csr_matrix.num_nonzeros << "\n";
-    // std::cout << "row_offsets: ";
-    // for (int i = 0; i < csr_matrix.num_rows + 1; i++)
-    // {
-    //   std::cout << csr_matrix.row_offsets[i] << " ";
-    // }
-    // std::cout << "\n";
-    // std::cout << "column_indices: ";
-    // for (int i = 0; i < csr_matrix.num_nonzeros; i++)
-    // {
-    //   std::cout << csr_matrix.column_indices[i] << " ";
-    // }
-    // std::cout << "\n";
-    // std::cout << "values: ";
-    // for (int i = 0; i < csr_matrix.num_nonzeros; i++)
-    // {
-    //   std::cout << csr_matrix.values[i] << " ";
-    // }
-    // std::cout << "\nfinished read_market\n";
-    // /*****************DEBUG******************/
+    const BinaryCacheHeader *header = reinterpret_cast<const BinaryCacheHeader *>(file.data);
+    size_t offset = sizeof(BinaryCacheHeader);
+    if (file.size < offset || memcmp(header->magic, "COMETBIN", 8) != 0 ||
+        header->version != BINARY_CACHE_VERSION)
+    {
+      fprintf(stderr, "ERROR: %s is not a binary tensor file\n", filename.c_str());
+      exit(1);
+    }
 
-    desc_A1pos->data[0] = csr_matrix.num_rows;
+    bool match = header->rank == rank && header->value_bytes == value_bytes &&
+                 header->num_sizes == 3 * rank + 1;
+    for (int64_t i = 0; match && i < rank; i++)
+      match = header->formats[i] == formats[i];
+    if (!match)
+    {
+      fprintf(stderr, "ERROR: %s does not hold a tensor of the declared rank, formats and element type\n",
+              filename.c_str());
+      exit(1);
+    }
 
-    for (int i = 0; i < csr_matrix.num_rows + 1; i++)
+    offset += alignTo8(header->path_size);
+    if (!MapArrays(offset, rank, value_bytes))
     {
-      desc_A2pos->data[i] = csr_matrix.row_offsets[i];
+      fprintf(stderr, "ERROR: %s is truncated\n", filename.c_str());
+      exit(1);
     }
+    return true;
+  }
 
-    for (int i = 0; i < upperBound_NNZ; i++)
+  // Maps the sizes array at offset and the arrays that follow it
+  bool MapArrays(size_t offset, int rank, size_t value_bytes)
+  {
+    sizes = reinterpret_cast<const int64_t *>(file.data + offset);
+    offset += (3 * rank + 1) * sizeof(int64_t);
+    if (file.size < offset)
+      return Reject();
+
+    int num_arrays = 2 * rank + 1;
+    arrays.resize(num_arrays);
+    for (int64_t i = 0; i < num_arrays; i++)
     {
-      desc_A2crd->data[i] = csr_matrix.column_indices[i];
-      desc_Aval->data[i] = csr_matrix.values[i];
+      size_t element_bytes = (i < 2 * rank) ? sizeof(int64_t) : value_bytes;
+      arrays[i] = file.data + offset;
+      offset += alignTo8(sizes[i] * element_bytes);
     }
+    if (file.size < offset)
+      return Reject();
+
+    return true;
   }
-  // CSC
-  else if (A1format == Compressed_unique && A2format == Dense)
+
+  bool Reject()
   {
-    CscMatrix<T> csc_matrix(FileReader.coo_matrix);
-    FileReader.FileReaderWrapperFinalize();  // clear coo_matrix
+    file.Clear();
+    sizes = NULL;
+    arrays.clear();
+    return false;
+  }
 
-    // NOTE: we do not need to check readMode, since this has already been taken care of in read_sizes() call
+  /**
+   * Writes the sidecar file of the given input. The file is written under a
+   * temporary name and renamed, so that concurrent runs never see a partial
+   * file. Failures are not fatal: the input will simply be parsed again.
+   */
+  static void Write(const string &source, int rank, const int32_t *formats,
+                    int32_t readMode, size_t value_bytes, const int64_t *sizes,
+                    const std::vector<const void *> &arrays)
+  {
+    BinaryCacheHeader header;
+    if (!Enabled() || !MakeHeader(source, rank, formats, readMode, value_bytes, header))
+      return;
 
-    // /*****************DEBUG******************/
-    // std::cout << "CSC detail: " << csc_matrix.num_rows << ", " << csc_matrix.num_cols << ", " << csc_matrix.num_nonzeros << "\n";
-    // std::cout << "col_offsets: ";
-    // for (int i = 0; i < csc_matrix.num_cols + 1; i++)
-    // {
-    //   std::cout << csc_matrix.col_offsets[i] << " ";
-    // }
-    // std::cout << "\n";
-    // std::cout << "row_indices: ";
-    // for (int i = 0; i < csc_matrix.num_nonzeros; i++)
-    // {
-    //   std::cout << csc_matrix.row_indices[i] << " ";
-    // }
-    // std::cout << "\n";
-    // std::cout << "values: ";
-    // for (int i = 0; i < csc_matrix.num_nonzeros; i++)
-    // {
-    //   std::cout << csc_matrix.values[i] << " ";
-    // }
-    // std::cout << "\nfinished read_market\n";
-    /*****************DEBUG******************/
+    string path = GetPath(source, rank, formats, readMode, value_bytes);
+    string tmp_path = path + ".tmp" + std::to_string(getpid());
+    FILE *fp = fopen(tmp_path.c_str(), "wb");
+    if (!fp)
+      return;
 
-    desc_A2pos->data[0] = csc_matrix.num_cols;
+    bool ok = WriteContents(fp, header, source, sizes, arrays);
+    ok = (fclose(fp) == 0) && ok;
 
-    for (int i = 0; i < csc_matrix.num_cols + 1; i++)
+    if (!ok || rename(tmp_path.c_str(), path.c_str()) != 0)
+      remove(tmp_path.c_str());
+  }
+
+  // Writes everything after the header: the path, the sizes array and the
+  // arrays, each padded to 8 bytes. Returns false if a write failed.
+  static bool WriteContents(FILE *fp, const BinaryCacheHeader &header, const string &source,
+                            const int64_t *sizes, const std::vector<const void *> &arrays)
+  {
+    static const char padding[8] = {0};
+    int rank = header.rank;
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+    ok = ok && fwrite(source.data(), 1, source.size(), fp) == source.size();
+    ok = ok && fwrite(padding, 1, alignTo8(source.size()) - source.size(), fp) == alignTo8(source.size()) - source.size();
+    ok = ok && fwrite(sizes, sizeof(int64_t), header.num_sizes, fp) == (size_t)header.num_sizes;
+    for (int64_t i = 0; ok && i < 2 * rank + 1; i++)
     {
-      desc_A1pos->data[i] = csc_matrix.col_offsets[i];
+      size_t bytes = sizes[i] * ((i < 2 * rank) ? sizeof(int64_t) : header.value_bytes);
+      ok = fwrite(arrays[i], 1, bytes, fp) == bytes;
+      ok = ok && fwrite(padding, 1, alignTo8(bytes) - bytes, fp) == alignTo8(bytes) - bytes;
     }
+    return ok;
+  }
+};
+
+//===----------------------------------------------------------------------===//
+// Tensor cache for the inputs read from files.
+//===----------------------------------------------------------------------===//
+
+// Kinds of objects kept in the tensor cache
+enum TensorCacheKind
+{
+  CACHE_COO_2D = 0,
+  CACHE_COO_3D,
+  CACHE_CSR,
+  CACHE_CSR_PATTERN,
+  CACHE_DCSR,
+  CACHE_CSF_3D,
+  CACHE_MG_3D,
+  CACHE_COO_ND,   // the rank is in the bits above the kind
+  CACHE_LEVELS_ND // the rank and the formats are in the bits above the kind
+};
+
+// Identifies a cached object: the input file, what was built from it, the
+// selected matrix read, and the size of the values.
+struct TensorCacheKey
+{
+  int32_t fileID;
+  int32_t kind;
+  int32_t readMode;
+  int32_t value_bytes;
+
+  TensorCacheKey(int32_t fileID, int32_t kind, int32_t readMode, int32_t value_bytes)
+      : fileID(fileID), kind(kind), readMode(readMode), value_bytes(value_bytes) {}
+
+  bool operator<(const TensorCacheKey &other) const
+  {
+    if (fileID != other.fileID)
+      return fileID < other.fileID;
+    if (kind != other.kind)
+      return kind < other.kind;
+    if (readMode != other.readMode)
+      return readMode < other.readMode;
+    return value_bytes < other.value_bytes;
+  }
+};
+
+template <typename T>
+TensorCacheKey cacheKey(int32_t fileID, int32_t kind, int32_t readMode)
+{
+  return TensorCacheKey(fileID, kind, readMode, sizeof(T));
+}
+
+/**
+ * LRU cache of the inputs parsed from files and of their conversions,
+ * shared by all read_input_* calls. Reading the same file again, in a loop
+ * or for another tensor, reuses the cached objects instead of parsing it.
+ *
+ * The cached objects take at most a budget of bytes, set by the
+ * COMET_TENSOR_CACHE_BYTES environmental variable (with an optional K, M or
+ * G suffix) or comet_tensor_cache_set_budget(); it defaults to a quarter of
+ * the physical memory. Least recently used objects are evicted to stay in
+ * the budget, unless they are pinned: by a read call while it uses them,
+ * from a prefetch or a read_input_sizes_* call until the next read call
+ * takes them over (see Hold()), or by comet_tensor_cache_pin() for all the
+ * objects of a file.
+ *
+ * Objects are built once: a read call that needs an object while another
+ * thread builds it (see the prefetch_input_* calls) waits for it. If the
+ * build fails in a prefetcher, the read call gets its error.
+ */
+struct TensorCache
+{
+  // Inputs parsed at the same time in the background. Large inputs are
+  // parsed by all the threads anyway, small ones by a single thread each.
+  static const int MAX_PREFETCHERS = 4;
+
+  struct Entry
+  {
+    void *object;
+    void (*deleter)(void *);
+    size_t bytes;
+    int pins;
+    std::list<TensorCacheKey>::iterator lru_pos;
+  };
 
-    for (int i = 0; i < csc_matrix.num_nonzeros; i++)
+  std::mutex mutex;
+  std::condition_variable built;      // notified when an object is inserted
+  std::set<TensorCacheKey> building;  // keys whose object is being built
+  std::map<TensorCacheKey, std::string> failed; // errors of the builds that failed in a prefetcher
+  std::map<TensorCacheKey, Entry> entries;
+  std::map<TensorCacheKey, int> held; // pins kept for the next Acquire() of the key
+  std::list<TensorCacheKey> lru; // most recently used first
+  std::map<int32_t, int> pinned_files;
+  size_t budget;
+  size_t used_bytes;
+  size_t peak_bytes;
+  int64_t hits;
+  int64_t misses;
+  int64_t evictions;
+
+  std::deque<std::function<void()>> prefetch_tasks;
+  std::vector<std::thread> prefetchers;
+  size_t prefetch_bytes; // estimated bytes of the queued and running prefetches
+  int idle_prefetchers;
+  std::condition_variable prefetch_queued; // notified when a task is queued
+  bool stopping;                           // set at exit, see Shutdown()
+
+  // The cache is never destroyed, so that it outlives the other static
+  // objects. Its prefetchers are joined at exit by Shutdown, which also
+  // releases the unused objects.
+  static TensorCache &Get()
+  {
+    static TensorCache *cache = []()
     {
-      desc_A1crd->data[i] = csc_matrix.row_indices[i];
-      desc_Aval->data[i] = csc_matrix.values[i];
+      TensorCache *c = new TensorCache();
+      atexit(Shutdown);
+      return c;
+    }();
+    return *cache;
+  }
+
+  // Parses a number of bytes, with an optional K, M or G suffix
+  static size_t ParseBytes(const char *str)
+  {
+    char *end;
+    size_t bytes = strtoull(str, &end, 10);
+    switch (*end)
+    {
+    case 'g':
+    case 'G':
+      return bytes << 30;
+    case 'm':
+    case 'M':
+      return bytes << 20;
+    case 'k':
+    case 'K':
+      return bytes << 10;
     }
+    return bytes;
   }
-  // DCSR
-  else if (A1format == Compressed_unique && A2format == Compressed_unique)
+
+  static size_t DefaultBudget()
   {
-    DcsrMatrix<T> dcsr_matrix(FileReader.coo_matrix);
-    FileReader.FileReaderWrapperFinalize();  // clear coo_matrix
+    if (char *env = getenv("COMET_TENSOR_CACHE_BYTES"))
+      return ParseBytes(env);
+
+#if defined(_SC_PHYS_PAGES) && defined(_SC_PAGE_SIZE)
+    long num_pages = sysconf(_SC_PHYS_PAGES);
+    long page_size = sysconf(_SC_PAGE_SIZE);
+    if (num_pages > 0 && page_size > 0)
+      return (size_t)num_pages * page_size / 4;
+#endif
+    return (size_t)1 << 30;
+  }
 
-    // NOTE: we do not need to check readMode, since this has already been taken care of in read_sizes() call
+  /**
+   * Returns the object cached for key, pinned, or NULL if there is none.
+   * Waits if the object is being built. After NULL, the caller builds the
+   * object and must Insert() it, or Abandon() the build, unless error is
+   * set: the object cannot be built then.
+   */
+  void *Acquire(const TensorCacheKey &key, std::string &error)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    built.wait(lock, [&]()
+               { return building.count(key) == 0 || stopping; });
 
-    /*****************DEBUG******************/
-    // std::cout << "DCSR detail: " << dcsr_matrix.num_cols << ", " << dcsr_matrix.num_rows << ", " << dcsr_matrix.num_nonzeros << "\n";
-    // std::cout << "A1pos: ";
-    // for (int i = 0; i < dcsr_matrix.A1pos_size; i++)
-    // {
-    //   std::cout << dcsr_matrix.A1pos[i] << " ";
-    // }
-    // std::cout << "\n";
-    // std::cout << "A1crd: ";
-    // for (int i = 0; i < dcsr_matrix.A1crd_size; i++)
-    // {
-    //   std::cout << dcsr_matrix.A1crd[i] << " ";
-    // }
-    // std::cout << "\n";
-    // std::cout << "A2pos: ";
-    // for (int i = 0; i < dcsr_matrix.A2pos_size; i++)
-    // {
-    //   std::cout << dcsr_matrix.A2pos[i] << " ";
-    // }
-    // std::cout << "\n";
-    // std::cout << "A2crd: ";
-    // for (int i = 0; i < dcsr_matrix.A2crd_size; i++)
-    // {
-    //   std::cout << dcsr_matrix.A2crd[i] << " ";
-    // }
+    if (stopping)
+    {
+      error = "ERROR: input read while the program exits\n";
+      return NULL;
+    }
 
-    // std::cout << "\n";
-    // std::cout << "Aval: ";
-    // for (int i = 0; i < dcsr_matrix.Aval_size; i++)
-    // {
-    //   std::cout << dcsr_matrix.Aval[i] << " ";
-    // }
-    // std::cout << "\n";
-    // std::cout << "finished read_market\n";
-    /*****************DEBUG******************/
+    std::map<TensorCacheKey, Entry>::iterator it = entries.find(key);
+    if (it == entries.end())
+    {
+      std::map<TensorCacheKey, std::string>::iterator failure = failed.find(key);
+      if (failure != failed.end())
+      {
+        error = failure->second;
+        return NULL;
+      }
+
+      misses++;
+      building.insert(key);
+      return NULL;
+    }
+
+    hits++;
+    Pin(it);
+    return it->second.object;
+  }
+
+  /**
+   * Caches object for key, pinned, and returns the object cached for key.
+   * That is another object if key was cached in the meantime; the given
+   * object is then left to the caller.
+   */
+  void *Insert(const TensorCacheKey &key, void *object, size_t bytes, void (*deleter)(void *))
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    building.erase(key);
+    built.notify_all();
 
-    for (int i = 0; i < dcsr_matrix.A1pos_size; i++)
+    std::map<TensorCacheKey, Entry>::iterator it = entries.find(key);
+    if (it != entries.end())
     {
-      desc_A1pos->data[i] = dcsr_matrix.A1pos[i];
+      Pin(it);
+      return it->second.object;
+    }
+
+    lru.push_front(key);
+    Entry &entry = entries[key];
+    entry.object = object;
+    entry.deleter = deleter;
+    entry.bytes = bytes;
+    entry.pins = 1;
+    entry.lru_pos = lru.begin();
+
+    used_bytes += bytes;
+    peak_bytes = std::max(peak_bytes, used_bytes);
+    EvictOverBudget();
+    return object;
+  }
+
+  /**
+   * Gives up building the object of key after Acquire() returned NULL: the
+   * next Acquire() of key, or one waiting for it, builds it instead, or
+   * gets the error of the build if there is one.
+   */
+  void Abandon(const TensorCacheKey &key, const std::string &error)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    building.erase(key);
+    if (!error.empty())
+      failed[key] = error;
+    built.notify_all();
+  }
+
+  /**
+   * Unpins the object cached for key
+   */
+  void Release(const TensorCacheKey &key)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::map<TensorCacheKey, Entry>::iterator it = entries.find(key);
+    if (it != entries.end() && it->second.pins > 0)
+      it->second.pins--;
+    EvictOverBudget();
+  }
+
+  /**
+   * Keeps the pin of the caller on the object cached for key until the next
+   * Acquire() of key takes it over, instead of releasing it. A sizes call
+   * hands its objects over to the matching data call this way, so that they
+   * are not evicted and parsed again in between.
+   */
+  void Hold(const TensorCacheKey &key)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (entries.count(key) == 1)
+      held[key]++;
+  }
+
+  /**
+   * Updates the size of a cached object that has grown or shrunk
+   */
+  void Resize(const TensorCacheKey &key, size_t bytes)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::map<TensorCacheKey, Entry>::iterator it = entries.find(key);
+    if (it == entries.end())
+      return;
+
+    used_bytes = used_bytes - it->second.bytes + bytes;
+    peak_bytes = std::max(peak_bytes, used_bytes);
+    it->second.bytes = bytes;
+  }
+
+  /**
+   * Returns true if bytes more fit in the budget, next to the pinned objects
+   */
+  bool HasRoom(size_t bytes)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    return PinnedBytes() + bytes <= budget;
+  }
+
+  void SetBudget(size_t bytes)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    budget = bytes;
+    EvictOverBudget();
+  }
+
+  void PinFile(int32_t fileID)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    pinned_files[fileID]++;
+  }
+
+  void UnpinFile(int32_t fileID)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::map<int32_t, int>::iterator it = pinned_files.find(fileID);
+    if (it != pinned_files.end() && --it->second == 0)
+      pinned_files.erase(it);
+    EvictOverBudget();
+  }
+
+  /**
+   * Drops all the objects that are not in use by a read call
+   */
+  void Clear()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::list<TensorCacheKey>::iterator pos = lru.begin();
+    while (pos != lru.end())
+    {
+      std::list<TensorCacheKey>::iterator victim = pos++;
+      std::map<TensorCacheKey, Entry>::iterator it = entries.find(*victim);
+      if (it->second.pins == 0)
+        Evict(it);
     }
+  }
 
-    for (int i = 0; i < dcsr_matrix.A1crd_size; i++)
+  void PrintStats()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    printf("Tensor cache: %lld hits, %lld misses, %lld evictions, %zu objects, %zu bytes used (peak %zu), budget %zu bytes\n",
+           (long long)hits, (long long)misses, (long long)evictions, entries.size(), used_bytes, peak_bytes, budget);
+  }
+
+  // Pins an object for a reader, which takes over a held pin if there is
+  // one. The caller holds the mutex.
+  void Pin(std::map<TensorCacheKey, Entry>::iterator it)
+  {
+    std::map<TensorCacheKey, int>::iterator held_it = held.find(it->first);
+    if (held_it != held.end())
     {
-      desc_A1crd->data[i] = dcsr_matrix.A1crd[i];
+      if (--held_it->second == 0)
+        held.erase(held_it);
     }
+    else
+      it->second.pins++;
+    lru.splice(lru.begin(), lru, it->second.lru_pos);
+  }
+
+  // The caller holds the mutex
+  void Evict(std::map<TensorCacheKey, Entry>::iterator it)
+  {
+    it->second.deleter(it->second.object);
+    used_bytes -= it->second.bytes;
+    lru.erase(it->second.lru_pos);
+    entries.erase(it);
+  }
 
-    for (int i = 0; i < dcsr_matrix.A2pos_size; i++)
+  // Bytes of the objects that cannot be evicted. The caller holds the mutex.
+  size_t PinnedBytes() const
+  {
+    size_t bytes = 0;
+    for (const auto &entry : entries)
     {
-      desc_A2pos->data[i] = dcsr_matrix.A2pos[i];
+      if (entry.second.pins > 0 || pinned_files.count(entry.first.fileID) == 1)
+        bytes += entry.second.bytes;
     }
+    return bytes;
+  }
 
-    for (int i = 0; i < dcsr_matrix.A2crd_size; i++)
+  // The caller holds the mutex
+  void EvictOverBudget()
+  {
+    std::list<TensorCacheKey>::iterator pos = lru.end();
+    while (used_bytes > budget && pos != lru.begin())
     {
-      desc_A2crd->data[i] = dcsr_matrix.A2crd[i];
-      desc_Aval->data[i] = dcsr_matrix.Aval[i];
+      --pos;
+      std::map<TensorCacheKey, Entry>::iterator it = entries.find(*pos);
+      if (it->second.pins > 0 || pinned_files.count(it->first.fileID) == 1)
+        continue;
+
+      pos++;
+      Evict(it);
+      evictions++;
     }
   }
-  else
+
+  /**
+   * Runs task on one of the prefetch threads of the cache, unless the bytes
+   * it is estimated to cache do not fit in the budget, next to the pinned
+   * objects and to the other prefetches. The parse errors of the task do
+   * not exit the program: they are kept for the read call that needs the
+   * input (see parseError()). Tasks that have not started when the program
+   * exits are dropped.
+   */
+  void Prefetch(std::function<void()> task, size_t bytes)
   {
-    assert(false && "unsupported matrix format\n");
+    std::lock_guard<std::mutex> lock(mutex);
+    if (stopping || PinnedBytes() + prefetch_bytes + bytes > budget)
+      return;
+
+    prefetch_bytes += bytes;
+    prefetch_tasks.push_back([this, task, bytes]()
+                             {
+                               task();
+                               std::lock_guard<std::mutex> lock(mutex);
+                               prefetch_bytes -= bytes;
+                             });
+    if (idle_prefetchers == 0 && (int)prefetchers.size() < MAX_PREFETCHERS)
+      prefetchers.emplace_back(&TensorCache::RunPrefetcher, this);
+    else
+      prefetch_queued.notify_one();
+  }
+
+  void RunPrefetcher()
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+      idle_prefetchers++;
+      prefetch_queued.wait(lock, [&]()
+                           { return stopping || !prefetch_tasks.empty(); });
+      idle_prefetchers--;
+      if (stopping)
+        return;
+
+      std::function<void()> task = prefetch_tasks.front();
+      prefetch_tasks.pop_front();
+      lock.unlock();
+
+      std::string error;
+      prefetch_error = &error;
+      task();
+      prefetch_error = NULL;
+
+      lock.lock();
+    }
+  }
+
+  TensorCache() : budget(DefaultBudget()), used_bytes(0), peak_bytes(0), hits(0), misses(0), evictions(0),
+                  prefetch_bytes(0), idle_prefetchers(0), stopping(false) {}
+
+  // Waits for the running prefetches, and releases the unused objects
+  static void Shutdown()
+  {
+    TensorCache &cache = Get();
+    std::vector<std::thread> threads;
+    {
+      std::lock_guard<std::mutex> lock(cache.mutex);
+      cache.stopping = true;
+      cache.prefetch_queued.notify_all();
+      cache.built.notify_all();
+      threads.swap(cache.prefetchers);
+    }
+    for (std::thread &thread : threads)
+    {
+      if (thread.get_id() == std::this_thread::get_id())
+        thread.detach();
+      else
+        thread.join();
+    }
+
+    if (getenv("COMET_TENSOR_CACHE_STATS"))
+      cache.PrintStats();
+    cache.Clear();
   }
+};
+
+template <typename Object>
+void deleteCachedObject(void *object)
+{
+  delete static_cast<Object *>(object);
 }
 
-template <typename T>
-void read_input_sizes_3D(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int sizes_rank, void *sizes_ptr, int32_t readMode)
+// Build of a tensor cache object: the build is abandoned when it goes out of
+// scope before Insert(), so that the readers waiting for it do not wait
+// forever.
+struct TensorCacheBuild
 {
-  // FIXME: readMode is for future use.
-  auto *desc_sizes = static_cast<StridedMemRefType<int64_t, 1> *>(sizes_ptr);
+  TensorCacheKey key;
+  bool inserted;
 
-  FileReaderWrapper<T> FileReader (fileID, true);  // init of COO_3d_tensor
+  TensorCacheBuild(const TensorCacheKey &key) : key(key), inserted(false) {}
 
-  if (A1format == Compressed_nonunique && A2format == singleton && A3format == singleton)
+  void *Insert(void *object, size_t bytes, void (*deleter)(void *))
   {
-    // A1pos, A1crd, A2pos, A2crd, A3pos, A3crd, Aval, I, J, K
-    desc_sizes->data[0] = 2;
-    desc_sizes->data[1] = FileReader.coo_3dtensor->num_nonzeros;
-    desc_sizes->data[2] = 1;
-    desc_sizes->data[3] = FileReader.coo_3dtensor->num_nonzeros;
-    desc_sizes->data[4] = 1;
-    desc_sizes->data[5] = FileReader.coo_3dtensor->num_nonzeros;
-    desc_sizes->data[6] = FileReader.coo_3dtensor->num_nonzeros;
-    desc_sizes->data[7] = FileReader.coo_3dtensor->num_index_i;
-    desc_sizes->data[8] = FileReader.coo_3dtensor->num_index_j;
-    desc_sizes->data[9] = FileReader.coo_3dtensor->num_index_k;
+    inserted = true;
+    return TensorCache::Get().Insert(key, object, bytes, deleter);
   }
-  // CSF
-  else if (A1format == Compressed_unique && A2format == Compressed_unique && A3format == Compressed_unique)
+
+  ~TensorCacheBuild()
   {
-    // std::cout << "CSF format\n";
-    Csf3DTensor<T> csf_3dtensor(FileReader.coo_3dtensor);
+    if (!inserted)
+      TensorCache::Get().Abandon(key, prefetch_error ? *prefetch_error : std::string());
+  }
+};
 
-    desc_sizes->data[0] = csf_3dtensor.A1pos_size;
-    desc_sizes->data[1] = csf_3dtensor.A1crd_size;
-    desc_sizes->data[2] = csf_3dtensor.A2pos_size;
-    desc_sizes->data[3] = csf_3dtensor.A2crd_size;
-    desc_sizes->data[4] = csf_3dtensor.A3pos_size;
-    desc_sizes->data[5] = csf_3dtensor.A3crd_size;
-    desc_sizes->data[6] = csf_3dtensor.Aval_size;
-    desc_sizes->data[7] = csf_3dtensor.num_index_i;
-    desc_sizes->data[8] = csf_3dtensor.num_index_j;
-    desc_sizes->data[9] = csf_3dtensor.num_index_k;
+// cache wrapper: returns the object cached for key, pinned for the caller,
+// or builds it with make() and caches it. Every call must be paired with a
+// releaseCached() call once the caller is done with the object. make()
+// returns NULL if the input cannot be read (see parseError()); so does
+// acquireCached() then, on the prefetch threads only.
+template <typename Object, typename Make>
+Object *acquireCached(const TensorCacheKey &key, Make make)
+{
+  TensorCache &cache = TensorCache::Get();
+  std::string error;
+  if (void *cached = cache.Acquire(key, error))
+    return static_cast<Object *>(cached);
+  if (!error.empty())
+  {
+    // the build failed in a prefetcher: report its error here
+    parseError("%s", error.c_str());
+    return NULL;
   }
-  // Mode-Generic
-  else if (A1format == Compressed_nonunique && A2format == singleton && A3format == Dense)
+
+  TensorCacheBuild build(key);
+  Object *object = make();
+  if (!object)
+    return NULL;
+  void *cached = build.Insert(object, object->Bytes(), deleteCachedObject<Object>);
+  if (cached != object)
+    delete object;
+  return static_cast<Object *>(cached);
+}
+
+inline void releaseCached(const TensorCacheKey &key)
+{
+  TensorCache::Get().Release(key);
+}
+
+// Like releaseCached(), for the sizes calls: the object stays pinned until
+// the matching data call acquires it.
+inline void holdCached(const TensorCacheKey &key)
+{
+  TensorCache::Get().Hold(key);
+}
+
+// conversion wrapper: converts the COO input once for all the reads of the
+// same fileID, format, and readMode, as long as the conversion is cached.
+template <typename Converted, typename Coo>
+Converted *getConversion(const TensorCacheKey &key, Coo *coo)
+{
+  return acquireCached<Converted>(key, [&]()
+                                  { return new Converted(coo); });
+}
+
+// CSR read wrapper: counts the nonzeros of every row in the first read of
+// fileID with the given readMode; the CSR arrays themselves are kept by the
+// first CsrMarketReader::Fill() if the cache has room for them. Pattern-only
+// reads keep no values, so they get a reader of their own.
+template <typename T>
+TensorCacheKey csrReaderKey(int32_t fileID, int readMode, bool pattern_read)
+{
+  return cacheKey<T>(fileID, pattern_read ? CACHE_CSR_PATTERN : CACHE_CSR, readMode);
+}
+
+template <typename T>
+CsrMarketReader<T> *getCsrMarketReader(int32_t fileID, int readMode, bool pattern_read)
+{
+  return acquireCached<CsrMarketReader<T>>(csrReaderKey<T>(fileID, readMode, pattern_read), [&]()
+                                           {
+                                             std::string filename = getSparseFileName(fileID);
+                                             if (filename.empty())
+                                             {
+                                               fprintf(stderr, "No input specified.\n");
+                                               assert(false);
+                                             }
+                                             if (filename.find(".mtx") == std::string::npos)
+                                             {
+                                               assert(false && "ERROR: input file is not Market Matrix file");
+                                             }
+
+                                             CsrMarketReader<T> *csr_reader = new CsrMarketReader<T>(readMode);
+                                             if (!csr_reader->Open(filename) || !csr_reader->Count())
+                                             {
+                                               delete csr_reader;
+                                               csr_reader = NULL;
+                                             }
+                                             return csr_reader;
+                                           });
+}
+
+// matrix read wrapper: takes the COO input of fileID from the tensor cache,
+// and reads the file only if it is not cached. The COO input stays pinned
+// until FileReaderWrapperFinalize(), or the end of the read call; sizes calls
+// hand it over to the data call with FileReaderWrapperHold().
+template <typename T>
+struct FileReaderWrapper
+{
+  std::string filename;
+  int32_t ID; 
+  bool is3D; 
+  int readMode; // selected matrix read of the COO matrix, see getMatrixReadOption()
+  bool pinned;
+
+  CooMatrix<T> *coo_matrix;
+  Coo3DTensor<T> *coo_3dtensor;
+
+  bool readFileNameStr(int32_t fileID)
   {
-    // std::cout << "Mode-Generic format\n";
-    Mg3DTensor<T> mg_3dtensor(FileReader.coo_3dtensor);
+    filename = getSparseFileName(fileID); // update
+
+    return true;
+  }
+
+  bool readMtxFile()
+  {
+    if (filename.find(".mtx") == std::string::npos)
+    {
+      assert(false && "ERROR: input file is not Market Matrix file");
+    }
+
+    // init matrix read, with the triangular filter of the selected matrix read
+    return coo_matrix->InitMarket(filename, readMode);
+  }
+
+  bool readTnsFile()
+  {
+    if (filename.find(".tns") == std::string::npos)
+    {
+      assert(false && "ERROR: input file is not TNS format");
+    }
+
+    // init frostt file read
+    return coo_3dtensor->InitFrostt(filename);
+  }
+
+  TensorCacheKey Key() const
+  {
+    // the COO matrix only holds the nonzeros kept by its selected matrix read
+    return cacheKey<T>(ID, is3D ? CACHE_COO_3D : CACHE_COO_2D, readMode);
+  }
+
+  /**
+   * Constructor
+   */
+  FileReaderWrapper(int32_t fileID, bool tnsFile = false, int selected_matrix_read = DEFAULT)
+      : ID(fileID), is3D(tnsFile), readMode(selected_matrix_read), pinned(true), coo_matrix(NULL), coo_3dtensor(NULL)
+  {
+    bool done = readFileNameStr(fileID);
+    if (!done || filename.empty())
+    {
+      fprintf(stderr, "No input specified.\n");
+      assert(false);
+    }
+
+    if (!tnsFile)
+    {
+      coo_matrix = acquireCached<CooMatrix<T>>(Key(), [&]()
+                                               { // file is read here
+                                                 coo_matrix = new CooMatrix<T>();
+                                                 if (!readMtxFile()) // 2D
+                                                 {
+                                                   delete coo_matrix;
+                                                   coo_matrix = NULL;
+                                                 }
+                                                 return coo_matrix;
+                                               });
+    }
+    else
+    {
+      coo_3dtensor = acquireCached<Coo3DTensor<T>>(Key(), [&]()
+                                                   { // file is read here
+                                                     coo_3dtensor = new Coo3DTensor<T>();
+                                                     if (!readTnsFile()) // 3D
+                                                     {
+                                                       delete coo_3dtensor;
+                                                       coo_3dtensor = NULL;
+                                                     }
+                                                     return coo_3dtensor;
+                                                   });
+    }
+    // only a prefetcher gets no input, see parseError()
+    pinned = (coo_matrix != NULL || coo_3dtensor != NULL);
+  }
+
+  /**
+   * Destructor
+   */
+  ~FileReaderWrapper()
+  {
+    FileReaderWrapperFinalize();
+  }
+
+  // Done with the COO input: the tensor cache may evict it from now on
+  void FileReaderWrapperFinalize()
+  {
+    if (pinned)
+    {
+      releaseCached(Key());
+      pinned = false;
+    }
+  }
+
+  // Done with the COO input in a sizes call: it stays pinned for the
+  // matching data call
+  void FileReaderWrapperHold()
+  {
+    if (pinned)
+    {
+      holdCached(Key());
+      pinned = false;
+    }
+  }
+};
+
+// rank-generic read wrapper: takes the sorted COO tensor of fileID, read as
+// a rank tensor, from the tensor cache, and reads the file if it is not
+// cached. Every call must be paired with a releaseCached(cooTensorKey()).
+template <typename T>
+TensorCacheKey cooTensorKey(int32_t fileID, int rank)
+{
+  return cacheKey<T>(fileID, CACHE_COO_ND + (rank << 4), DEFAULT);
+}
+
+template <typename T>
+CooTensor<T> *getCooTensor(int32_t fileID, int rank)
+{
+  return acquireCached<CooTensor<T>>(cooTensorKey<T>(fileID, rank), [&]()
+                                     {
+                                       std::string filename = getSparseFileName(fileID);
+                                       if (filename.empty())
+                                       {
+                                         fprintf(stderr, "No input specified.\n");
+                                         assert(false);
+                                       }
+                                       if (filename.find(".tns") == std::string::npos)
+                                       {
+                                         assert(false && "ERROR: input file is not TNS format");
+                                       }
+
+                                       CooTensor<T> *coo = new CooTensor<T>();
+                                       if (!coo->InitFrostt(filename, rank))
+                                       {
+                                         delete coo;
+                                         return (CooTensor<T> *)NULL;
+                                       }
+                                       coo->Sort();
+                                       return coo;
+                                     });
+}
+
+// conversion wrapper of the rank-generic tensors: the level tensor of the
+// same fileID, formats and readMode is built once. Every call must be paired
+// with a releaseCached(levelTensorKey()).
+template <typename T>
+TensorCacheKey levelTensorKey(int32_t fileID, int rank, const int32_t *formats, int readMode)
+{
+  int32_t code = rank;
+  for (int d = 0; d < rank; d++)
+    code = code * 4 + formats[d];
+  return cacheKey<T>(fileID, CACHE_LEVELS_ND + (code << 4), readMode);
+}
+
+template <typename T>
+LevelTensor<T> *getLevelTensor(int32_t fileID, int rank, const int32_t *formats, int readMode)
+{
+  return acquireCached<LevelTensor<T>>(levelTensorKey<T>(fileID, rank, formats, readMode), [&]()
+                                       {
+                                         CooTensor<T> *coo = getCooTensor<T>(fileID, rank);
+                                         if (!coo)
+                                           return (LevelTensor<T> *)NULL;
+
+                                         LevelTensor<T> *tensor = new LevelTensor<T>();
+                                         if (!tensor->Init(coo, formats))
+                                         {
+                                           delete tensor;
+                                           tensor = NULL;
+                                         }
+                                         releaseCached(cooTensorKey<T>(fileID, rank));
+                                         return tensor;
+                                       });
+}
+
+// helper func: fill in the sizes array of a read_input_sizes_* call from an
+// up-to-date binary sidecar file, if there is one.
+bool readSizesFromBinaryCache(int32_t fileID, int rank, const int32_t *formats, int32_t readMode,
+                              size_t value_bytes, StridedMemRefType<int64_t, 1> *desc_sizes)
+{
+  BinaryCacheFile cache;
+  if (!cache.Open(getSparseFileName(fileID), rank, formats, readMode, value_bytes))
+    return false;
+
+  for (int64_t i = 0; i < 3 * rank + 1; i++)
+    desc_sizes->data[i] = cache.sizes[i];
+  if (isPatternRead(readMode))
+    desc_sizes->data[2 * rank] = 0; // containers keep their values
+
+  return true;
+}
+
+// helper func: fill in the pos/crd/val arrays of a read_input_* call from an
+// up-to-date binary sidecar file, if there is one. desc_crds holds the pos
+// and crd arrays in the order A1pos, A1crd, A2pos, A2crd, ...
+template <typename T>
+bool readArraysFromBinaryCache(int32_t fileID, int rank, const int32_t *formats, int32_t readMode,
+                               StridedMemRefType<int64_t, 1> **desc_crds, StridedMemRefType<T, 1> *desc_val)
+{
+  BinaryCacheFile cache;
+  if (!cache.Open(getSparseFileName(fileID), rank, formats, readMode, sizeof(T)))
+    return false;
+
+  for (int64_t i = 0; i < 2 * rank; i++)
+  {
+    assert(desc_crds[i]->sizes[0] >= cache.sizes[i] && "ERROR: binary cache does not match the allocated arrays\n");
+    memcpy(desc_crds[i]->data, cache.arrays[i], cache.sizes[i] * sizeof(int64_t));
+  }
+  int64_t num_values = isPatternRead(readMode) ? 0 : cache.sizes[2 * rank];
+  assert(desc_val->sizes[0] >= num_values && "ERROR: binary cache does not match the allocated arrays\n");
+  memcpy(desc_val->data, cache.arrays[2 * rank], num_values * sizeof(T));
+
+  return true;
+}
+
+// helper func: save the arrays filled in by a read_input_* call to a binary
+// sidecar file, when binary caching is turned on. dims holds the rank
+// dimension sizes of the tensor.
+template <typename T>
+void writeBinaryCache(int32_t fileID, int rank, const int32_t *formats, int32_t readMode, const int64_t *dims,
+                      StridedMemRefType<int64_t, 1> **desc_crds, StridedMemRefType<T, 1> *desc_val)
+{
+  if (!BinaryCacheFile::Enabled())
+    return;
+
+  std::vector<int64_t> sizes;
+  std::vector<const void *> arrays;
+  for (int64_t i = 0; i < 2 * rank; i++)
+  {
+    sizes.push_back(desc_crds[i]->sizes[0]);
+    arrays.push_back(desc_crds[i]->data);
+  }
+  sizes.push_back(desc_val->sizes[0]);
+  arrays.push_back(desc_val->data);
+  for (int64_t i = 0; i < rank; i++)
+    sizes.push_back(dims[i]);
+
+  BinaryCacheFile::Write(getSparseFileName(fileID), rank, formats, readMode, sizeof(T), sizes.data(), arrays);
+}
+
+/***********Sparse Utility Functions*******************/
+
+// whether the 3D formats have a dedicated tensor type above; the others are
+// read by the rank-generic functions below
+inline bool isBuiltin3DFormat(int32_t A1format, int32_t A2format, int32_t A3format)
+{
+  return (A1format == Compressed_nonunique && A2format == singleton && (A3format == singleton || A3format == Dense)) ||
+         (A1format == Compressed_unique && A2format == Compressed_unique && A3format == Compressed_unique);
+}
+
+// Read tensors of any rank from FROSTT files, with any per-dimension format
+template <typename T>
+void read_input_sizes_ND(int32_t fileID, int rank, const int32_t *formats,
+                         StridedMemRefType<int64_t, 1> *desc_sizes, int32_t readMode)
+{
+  if (readSizesFromBinaryCache(fileID, rank, formats, readMode, sizeof(T), desc_sizes))
+    return;
+
+  int selected_read = getMatrixReadOption(readMode);
+  LevelTensor<T> &tensor = *getLevelTensor<T>(fileID, rank, formats, selected_read);
+
+  // A1pos, A1crd, ..., ANpos, ANcrd, Aval, dimension sizes
+  for (int d = 0; d < rank; d++)
+  {
+    desc_sizes->data[2 * d] = tensor.pos[d].size();
+    desc_sizes->data[2 * d + 1] = tensor.crd[d].size();
+  }
+  // the value array of pattern-only reads is empty
+  desc_sizes->data[2 * rank] = isPatternRead(readMode) ? 0 : tensor.vals.size();
+  for (int d = 0; d < rank; d++)
+    desc_sizes->data[2 * rank + 1 + d] = tensor.dims[d];
+
+  holdCached(levelTensorKey<T>(fileID, rank, formats, selected_read));
+}
+
+// desc_crds holds the pos and crd arrays in the order A1pos, A1crd, A2pos, ...
+template <typename T>
+void read_input_ND(int32_t fileID, int rank, const int32_t *formats,
+                   StridedMemRefType<int64_t, 1> **desc_crds, StridedMemRefType<T, 1> *desc_val, int32_t readMode)
+{
+  if (readArraysFromBinaryCache(fileID, rank, formats, readMode, desc_crds, desc_val))
+    return;
+
+  int selected_read = getMatrixReadOption(readMode);
+  LevelTensor<T> &tensor = *getLevelTensor<T>(fileID, rank, formats, selected_read);
+
+  for (int d = 0; d < rank; d++)
+  {
+    std::copy(tensor.pos[d].begin(), tensor.pos[d].end(), desc_crds[2 * d]->data);
+    std::copy(tensor.crd[d].begin(), tensor.crd[d].end(), desc_crds[2 * d + 1]->data);
+  }
+  if (!isPatternRead(readMode))
+    std::copy(tensor.vals.begin(), tensor.vals.end(), desc_val->data);
+
+  writeBinaryCache(fileID, rank, formats, readMode, tensor.dims.data(), desc_crds, desc_val);
+  releaseCached(levelTensorKey<T>(fileID, rank, formats, selected_read));
+}
+
+// Read input matrices based on the datatype
+template <typename T>
+void read_input_sizes_2D(int32_t fileID, int32_t A1format, int32_t A2format, int sizes_rank, void *sizes_ptr, int32_t readMode)
+{
+  auto *desc_sizes = static_cast<StridedMemRefType<int64_t, 1> *>(sizes_ptr);
+
+  int32_t formats[2] = {A1format, A2format};
+  if (readSizesFromBinaryCache(fileID, 2, formats, readMode, sizeof(T), desc_sizes))
+    return;
+
+  int selected_matrix_read = getMatrixReadOption(readMode);
+  bool pattern_read = isPatternRead(readMode);
+
+  // CSR: read straight from the file, without the COO matrix
+  if (A1format == Dense && A2format == Compressed_unique)
+  {
+    CsrMarketReader<T> *csr_reader = getCsrMarketReader<T>(fileID, selected_matrix_read, pattern_read);
+
+    desc_sizes->data[0] = 1;
+    desc_sizes->data[1] = 1;
+    desc_sizes->data[2] = csr_reader->num_rows + 1;
+    desc_sizes->data[3] = csr_reader->num_nonzeros;
+    desc_sizes->data[4] = pattern_read ? 0 : csr_reader->num_nonzeros;
+    desc_sizes->data[5] = csr_reader->num_rows;
+    desc_sizes->data[6] = csr_reader->num_cols;
+
+    holdCached(csrReaderKey<T>(fileID, selected_matrix_read, pattern_read));
+    return;
+  }
+
+  FileReaderWrapper<T> FileReader (fileID, false, selected_matrix_read);  // init of COO, with the triangular filter
+
+  // SparseFormatAttribute A1format: COO
+  if (A1format == Compressed_nonunique && A2format == singleton)
+  {
+    // the triangular filter was applied while reading the COO matrix
+    int64_t NumNonZeros = FileReader.coo_matrix->num_nonzeros;
+
+    desc_sizes->data[0] = 2;
+    desc_sizes->data[1] = NumNonZeros;
+    desc_sizes->data[2] = 1;
+    desc_sizes->data[3] = NumNonZeros;
+    desc_sizes->data[4] = NumNonZeros;
+    desc_sizes->data[5] = FileReader.coo_matrix->num_rows;
+    desc_sizes->data[6] = FileReader.coo_matrix->num_cols;
+  }
+  // CSC
+  else if (A1format == Compressed_unique && A2format == Dense)
+  {
+    int64_t NumNonZeros = 0;
+    if (selected_matrix_read == DEFAULT)
+      NumNonZeros = FileReader.coo_matrix->num_nonzeros;
+    else
+      assert(false && "unsupported matrix format (CSC) for triangular reads.\n");
+
+    desc_sizes->data[0] = FileReader.coo_matrix->num_cols + 1;
+    desc_sizes->data[1] = NumNonZeros;
+    desc_sizes->data[2] = 1;
+    desc_sizes->data[3] = 1;
+    desc_sizes->data[4] = NumNonZeros;
+    desc_sizes->data[5] = FileReader.coo_matrix->num_rows;
+    desc_sizes->data[6] = FileReader.coo_matrix->num_cols;
+
+    /*****************DEBUG******************/
+    // std::cout << "CSC detail: \n"
+    //           << "desc_sizes->data[0]: " << desc_sizes->data[0] << "\n"
+    //           << "desc_sizes->data[1]: " << desc_sizes->data[1] << "\n"
+    //           << "desc_sizes->data[2]: " << desc_sizes->data[2] << "\n"
+    //           << "desc_sizes->data[3]: " << desc_sizes->data[3] << "\n"
+    //           << "desc_sizes->data[4]: " << desc_sizes->data[4] << "\n"
+    //           << "desc_sizes->data[5]: " << desc_sizes->data[5] << "\n"
+    //           << "desc_sizes->data[6]: " << desc_sizes->data[6] << "\n";
+    /*****************DEBUG******************/
+  }
+  // DCSR
+  else if (A1format == Compressed_unique && A2format == Compressed_unique)
+  {
+    DcsrMatrix<T> &dcsr_matrix = *getConversion<DcsrMatrix<T>>(cacheKey<T>(fileID, CACHE_DCSR, selected_matrix_read), FileReader.coo_matrix);
+    
+    if (selected_matrix_read != DEFAULT)
+      assert(false && "unsupported matrix format (DCSR) for triangular reads.\n");
+
+    desc_sizes->data[0] = dcsr_matrix.A1pos_size;
+    desc_sizes->data[1] = dcsr_matrix.A1crd_size;
+    desc_sizes->data[2] = dcsr_matrix.A2pos_size;
+    desc_sizes->data[3] = dcsr_matrix.A2crd_size;
+    desc_sizes->data[4] = dcsr_matrix.A2crd_size;
+    desc_sizes->data[5] = dcsr_matrix.num_rows;
+    desc_sizes->data[6] = dcsr_matrix.num_cols;
+
+    holdCached(cacheKey<T>(fileID, CACHE_DCSR, selected_matrix_read));
+  }
+  else
+  {
+    assert(false && "unsupported matrix format\n");
+  }
+  FileReader.FileReaderWrapperHold();
+
+  // the value array of pattern-only reads is empty
+  if (pattern_read)
+    desc_sizes->data[4] = 0;
+}
+
+template <typename T>
+void read_input_2D(int32_t fileID, int32_t A1format, int32_t A2format,
+                   int A1pos_rank, void *A1pos_ptr,
+                   int A1crd_rank, void *A1crd_ptr,
+                   int A2pos_rank, void *A2pos_ptr,
+                   int A2crd_rank, void *A2crd_ptr,
+                   int Aval_rank, void *Aval_ptr,
+                   int32_t readMode)
+{
+
+  auto *desc_A1pos = static_cast<StridedMemRefType<int64_t, 1> *>(A1pos_ptr);
+  auto *desc_A1crd = static_cast<StridedMemRefType<int64_t, 1> *>(A1crd_ptr);
+  auto *desc_A2pos = static_cast<StridedMemRefType<int64_t, 1> *>(A2pos_ptr);
+  auto *desc_A2crd = static_cast<StridedMemRefType<int64_t, 1> *>(A2crd_ptr);
+  auto *desc_Aval = static_cast<StridedMemRefType<T, 1> *>(Aval_ptr);
+
+  int32_t formats[2] = {A1format, A2format};
+  StridedMemRefType<int64_t, 1> *desc_crds[4] = {desc_A1pos, desc_A1crd, desc_A2pos, desc_A2crd};
+  if (readArraysFromBinaryCache(fileID, 2, formats, readMode, desc_crds, desc_Aval))
+    return;
+
+  // For example, A2pos is not used for COO, but initialized with -1 to speficify that it is not used
+  desc_A1pos->data[0] = -1;
+  desc_A1crd->data[0] = -1;
+  desc_A2pos->data[0] = -1;
+  desc_A2crd->data[0] = -1;
+
+  int selected_matrix_read = getMatrixReadOption(readMode);
+  bool pattern_read = isPatternRead(readMode); // Aval is empty, the values are skipped
+
+  // CSR: read straight from the file into the CSR arrays
+  if (A1format == Dense && A2format == Compressed_unique)
+  {
+    CsrMarketReader<T> *csr_reader = getCsrMarketReader<T>(fileID, selected_matrix_read, pattern_read);
+    int64_t dims[2] = {csr_reader->num_rows, csr_reader->num_cols};
+
+    desc_A1pos->data[0] = csr_reader->num_rows;
+    TensorCacheKey key = csrReaderKey<T>(fileID, selected_matrix_read, pattern_read);
+    bool keep = TensorCache::Get().HasRoom(csr_reader->FilledBytes(!pattern_read));
+    csr_reader->Fill(desc_A2pos->data, desc_A2crd->data, pattern_read ? NULL : desc_Aval->data, keep);
+
+    TensorCache::Get().Resize(key, csr_reader->Bytes());
+    releaseCached(key);
+
+    writeBinaryCache(fileID, 2, formats, readMode, dims, desc_crds, desc_Aval);
+    return;
+  }
+
+  FileReaderWrapper<T> FileReader (fileID, false, selected_matrix_read);  // init of COO, with the triangular filter
+  int64_t dims[2] = {FileReader.coo_matrix->num_rows, FileReader.coo_matrix->num_cols};
+
+  // SparseFormatAttribute A1format: COO
+  if (A1format == Compressed_nonunique && A2format == singleton)
+  {
+    std::stable_sort(FileReader.coo_matrix->coo_tuples, FileReader.coo_matrix->coo_tuples + FileReader.coo_matrix->num_nonzeros, CooComparatorRow());
+
+    // the COO matrix only holds the nonzeros kept by the selected matrix read
+    CooTuple<T> *coo_tuples = FileReader.coo_matrix->coo_tuples;
+    int64_t actual_num_nonzeros = FileReader.coo_matrix->num_nonzeros;
+
+    desc_A1pos->data[0] = 0;
+    for (int64_t i = 0; i < actual_num_nonzeros; i++)
+    {
+      desc_A1crd->data[i] = coo_tuples[i].row;
+      desc_A2crd->data[i] = coo_tuples[i].col;
+    }
+    if (!pattern_read)
+    {
+      for (int64_t i = 0; i < actual_num_nonzeros; i++)
+        desc_Aval->data[i] = coo_tuples[i].val;
+    }
+    desc_A1pos->data[1] = actual_num_nonzeros;
+
+    FileReader.FileReaderWrapperFinalize(); // clear coo_matrix
+  }
+  // CSC
+  else if (A1format == Compressed_unique && A2format == Dense)
+  {
+    CscMatrix<T> csc_matrix(FileReader.coo_matrix);
+    FileReader.FileReaderWrapperFinalize();  // clear coo_matrix
+
+    // NOTE: we do not need to check readMode, since this has already been taken care of in read_sizes() call
+
+    // /*****************DEBUG******************/
+    // std::cout << "CSC detail: " << csc_matrix.num_rows << ", " << csc_matrix.num_cols << ", " << csc_matrix.num_nonzeros << "\n";
+    // std::cout << "col_offsets: ";
+    // for (int64_t i = 0; i < csc_matrix.num_cols + 1; i++)
+    // {
+    //   std::cout << csc_matrix.col_offsets[i] << " ";
+    // }
+    // std::cout << "\n";
+    // std::cout << "row_indices: ";
+    // for (int64_t i = 0; i < csc_matrix.num_nonzeros; i++)
+    // {
+    //   std::cout << csc_matrix.row_indices[i] << " ";
+    // }
+    // std::cout << "\n";
+    // std::cout << "values: ";
+    // for (int64_t i = 0; i < csc_matrix.num_nonzeros; i++)
+    // {
+    //   std::cout << csc_matrix.values[i] << " ";
+    // }
+    // std::cout << "\nfinished read_market\n";
+    /*****************DEBUG******************/
+
+    desc_A2pos->data[0] = csc_matrix.num_cols;
+
+    for (int64_t i = 0; i < csc_matrix.num_cols + 1; i++)
+    {
+      desc_A1pos->data[i] = csc_matrix.col_offsets[i];
+    }
+
+    for (int64_t i = 0; i < csc_matrix.num_nonzeros; i++)
+    {
+      desc_A1crd->data[i] = csc_matrix.row_indices[i];
+    }
+    if (!pattern_read)
+    {
+      for (int64_t i = 0; i < csc_matrix.num_nonzeros; i++)
+        desc_Aval->data[i] = csc_matrix.values[i];
+    }
+  }
+  // DCSR
+  else if (A1format == Compressed_unique && A2format == Compressed_unique)
+  {
+    DcsrMatrix<T> &dcsr_matrix = *getConversion<DcsrMatrix<T>>(cacheKey<T>(fileID, CACHE_DCSR, selected_matrix_read), FileReader.coo_matrix);
+    FileReader.FileReaderWrapperFinalize();  // clear coo_matrix
+
+    // NOTE: we do not need to check readMode, since this has already been taken care of in read_sizes() call
+
+    /*****************DEBUG******************/
+    // std::cout << "DCSR detail: " << dcsr_matrix.num_cols << ", " << dcsr_matrix.num_rows << ", " << dcsr_matrix.num_nonzeros << "\n";
+    // std::cout << "A1pos: ";
+    // for (int64_t i = 0; i < dcsr_matrix.A1pos_size; i++)
+    // {
+    //   std::cout << dcsr_matrix.A1pos[i] << " ";
+    // }
+    // std::cout << "\n";
+    // std::cout << "A1crd: ";
+    // for (int64_t i = 0; i < dcsr_matrix.A1crd_size; i++)
+    // {
+    //   std::cout << dcsr_matrix.A1crd[i] << " ";
+    // }
+    // std::cout << "\n";
+    // std::cout << "A2pos: ";
+    // for (int64_t i = 0; i < dcsr_matrix.A2pos_size; i++)
+    // {
+    //   std::cout << dcsr_matrix.A2pos[i] << " ";
+    // }
+    // std::cout << "\n";
+    // std::cout << "A2crd: ";
+    // for (int64_t i = 0; i < dcsr_matrix.A2crd_size; i++)
+    // {
+    //   std::cout << dcsr_matrix.A2crd[i] << " ";
+    // }
+
+    // std::cout << "\n";
+    // std::cout << "Aval: ";
+    // for (int64_t i = 0; i < dcsr_matrix.Aval_size; i++)
+    // {
+    //   std::cout << dcsr_matrix.Aval[i] << " ";
+    // }
+    // std::cout << "\n";
+    // std::cout << "finished read_market\n";
+    /*****************DEBUG******************/
+
+    for (int64_t i = 0; i < dcsr_matrix.A1pos_size; i++)
+    {
+      desc_A1pos->data[i] = dcsr_matrix.A1pos[i];
+    }
+
+    for (int64_t i = 0; i < dcsr_matrix.A1crd_size; i++)
+    {
+      desc_A1crd->data[i] = dcsr_matrix.A1crd[i];
+    }
+
+    for (int64_t i = 0; i < dcsr_matrix.A2pos_size; i++)
+    {
+      desc_A2pos->data[i] = dcsr_matrix.A2pos[i];
+    }
+
+    for (int64_t i = 0; i < dcsr_matrix.A2crd_size; i++)
+    {
+      desc_A2crd->data[i] = dcsr_matrix.A2crd[i];
+    }
+    if (!pattern_read)
+    {
+      for (int64_t i = 0; i < dcsr_matrix.Aval_size; i++)
+        desc_Aval->data[i] = dcsr_matrix.Aval[i];
+    }
+
+    releaseCached(cacheKey<T>(fileID, CACHE_DCSR, selected_matrix_read));
+  }
+  else
+  {
+    assert(false && "unsupported matrix format\n");
+  }
+
+  writeBinaryCache(fileID, 2, formats, readMode, dims, desc_crds, desc_Aval);
+}
+
+template <typename T>
+void read_input_sizes_3D(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int sizes_rank, void *sizes_ptr, int32_t readMode)
+{
+  // FIXME: readMode is for future use, except for pattern-only reads.
+  auto *desc_sizes = static_cast<StridedMemRefType<int64_t, 1> *>(sizes_ptr);
+  int selected_read = getMatrixReadOption(readMode);
+
+  int32_t formats[3] = {A1format, A2format, A3format};
+  if (!isBuiltin3DFormat(A1format, A2format, A3format))
+  {
+    read_input_sizes_ND<T>(fileID, 3, formats, desc_sizes, readMode);
+    return;
+  }
+  if (readSizesFromBinaryCache(fileID, 3, formats, readMode, sizeof(T), desc_sizes))
+    return;
+
+  FileReaderWrapper<T> FileReader (fileID, true);  // init of COO_3d_tensor
+
+  if (A1format == Compressed_nonunique && A2format == singleton && A3format == singleton)
+  {
+    // A1pos, A1crd, A2pos, A2crd, A3pos, A3crd, Aval, I, J, K
+    desc_sizes->data[0] = 2;
+    desc_sizes->data[1] = FileReader.coo_3dtensor->num_nonzeros;
+    desc_sizes->data[2] = 1;
+    desc_sizes->data[3] = FileReader.coo_3dtensor->num_nonzeros;
+    desc_sizes->data[4] = 1;
+    desc_sizes->data[5] = FileReader.coo_3dtensor->num_nonzeros;
+    desc_sizes->data[6] = FileReader.coo_3dtensor->num_nonzeros;
+    desc_sizes->data[7] = FileReader.coo_3dtensor->num_index_i;
+    desc_sizes->data[8] = FileReader.coo_3dtensor->num_index_j;
+    desc_sizes->data[9] = FileReader.coo_3dtensor->num_index_k;
+  }
+  // CSF
+  else if (A1format == Compressed_unique && A2format == Compressed_unique && A3format == Compressed_unique)
+  {
+    // std::cout << "CSF format\n";
+    Csf3DTensor<T> &csf_3dtensor = *getConversion<Csf3DTensor<T>>(cacheKey<T>(fileID, CACHE_CSF_3D, selected_read), FileReader.coo_3dtensor);
+
+    desc_sizes->data[0] = csf_3dtensor.A1pos_size;
+    desc_sizes->data[1] = csf_3dtensor.A1crd_size;
+    desc_sizes->data[2] = csf_3dtensor.A2pos_size;
+    desc_sizes->data[3] = csf_3dtensor.A2crd_size;
+    desc_sizes->data[4] = csf_3dtensor.A3pos_size;
+    desc_sizes->data[5] = csf_3dtensor.A3crd_size;
+    desc_sizes->data[6] = csf_3dtensor.Aval_size;
+    desc_sizes->data[7] = csf_3dtensor.num_index_i;
+    desc_sizes->data[8] = csf_3dtensor.num_index_j;
+    desc_sizes->data[9] = csf_3dtensor.num_index_k;
+
+    holdCached(cacheKey<T>(fileID, CACHE_CSF_3D, selected_read));
+  }
+  // Mode-Generic
+  else if (A1format == Compressed_nonunique && A2format == singleton && A3format == Dense)
+  {
+    // std::cout << "Mode-Generic format\n";
+    Mg3DTensor<T> &mg_3dtensor = *getConversion<Mg3DTensor<T>>(cacheKey<T>(fileID, CACHE_MG_3D, selected_read), FileReader.coo_3dtensor);
 
     desc_sizes->data[0] = mg_3dtensor.A1pos_size;
     desc_sizes->data[1] = mg_3dtensor.A1crd_size;
@@ -1919,283 +3798,1896 @@ void read_input_sizes_3D(int32_t fileID, int32_t A1format, int32_t A2format, int
     desc_sizes->data[7] = mg_3dtensor.num_index_i;
     desc_sizes->data[8] = mg_3dtensor.num_index_j;
     desc_sizes->data[9] = mg_3dtensor.num_index_k;
+
+    holdCached(cacheKey<T>(fileID, CACHE_MG_3D, selected_read));
+  }
+  else
+  {
+    assert(false && "unsupported tensor 3D format\n");
+  }
+  FileReader.FileReaderWrapperHold();
+
+  // the value array of pattern-only reads is empty
+  if (isPatternRead(readMode))
+    desc_sizes->data[6] = 0;
+}
+
+template <typename T>
+void read_input_3D(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int A1pos_rank, void *A1pos_ptr,
+                   int A1crd_rank, void *A1crd_ptr, int A2pos_rank, void *A2pos_ptr, int A2crd_rank,
+                   void *A2crd_ptr, int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                   int Aval_rank, void *Aval_ptr, int32_t readMode)
+{
+  // FIXME: readMode is for future use, except for pattern-only reads.
+  int selected_read = getMatrixReadOption(readMode);
+  bool pattern_read = isPatternRead(readMode); // Aval is empty, the values are skipped
+
+  auto *desc_A1pos = static_cast<StridedMemRefType<int64_t, 1> *>(A1pos_ptr);
+  auto *desc_A1crd = static_cast<StridedMemRefType<int64_t, 1> *>(A1crd_ptr);
+  auto *desc_A2pos = static_cast<StridedMemRefType<int64_t, 1> *>(A2pos_ptr);
+  auto *desc_A2crd = static_cast<StridedMemRefType<int64_t, 1> *>(A2crd_ptr);
+  auto *desc_A3pos = static_cast<StridedMemRefType<int64_t, 1> *>(A3pos_ptr);
+  auto *desc_A3crd = static_cast<StridedMemRefType<int64_t, 1> *>(A3crd_ptr);
+  auto *desc_Aval = static_cast<StridedMemRefType<T, 1> *>(Aval_ptr);
+
+  int32_t formats[3] = {A1format, A2format, A3format};
+  StridedMemRefType<int64_t, 1> *desc_crds[6] = {desc_A1pos, desc_A1crd, desc_A2pos, desc_A2crd, desc_A3pos, desc_A3crd};
+  if (!isBuiltin3DFormat(A1format, A2format, A3format))
+  {
+    read_input_ND<T>(fileID, 3, formats, desc_crds, desc_Aval, readMode);
+    return;
+  }
+  if (readArraysFromBinaryCache(fileID, 3, formats, readMode, desc_crds, desc_Aval))
+    return;
+
+  FileReaderWrapper<T> FileReader (fileID, true);  // init of COO_3d_tensor
+  int64_t dims[3] = {FileReader.coo_3dtensor->num_index_i, FileReader.coo_3dtensor->num_index_j, FileReader.coo_3dtensor->num_index_k};
+
+  if (A1format == Compressed_nonunique && A2format == singleton && A3format == singleton)
+  {
+    // std::cout << "COO detail: " << coo_3dtensor.num_index_i << ", " << coo_3dtensor.num_index_j << ", " << coo_3dtensor.num_index_k << ", " << coo_3dtensor.num_nonzeros << "\n";
+    std::stable_sort(FileReader.coo_3dtensor->coo_3dtuples, FileReader.coo_3dtensor->coo_3dtuples + FileReader.coo_3dtensor->num_nonzeros, Coo3DTensorComparator());
+    desc_A1pos->data[0] = 0;
+    desc_A1pos->data[1] = FileReader.coo_3dtensor->num_nonzeros;
+
+    for (int64_t i = 0; i < FileReader.coo_3dtensor->num_nonzeros; i++)
+    {
+      desc_A1crd->data[i] = FileReader.coo_3dtensor->coo_3dtuples[i].index_i;
+      desc_A2crd->data[i] = FileReader.coo_3dtensor->coo_3dtuples[i].index_j;
+      desc_A3crd->data[i] = FileReader.coo_3dtensor->coo_3dtuples[i].index_k;
+    }
+    if (!pattern_read)
+    {
+      for (int64_t i = 0; i < FileReader.coo_3dtensor->num_nonzeros; i++)
+        desc_Aval->data[i] = FileReader.coo_3dtensor->coo_3dtuples[i].val;
+    }
+  }
+  // CSF
+  else if (A1format == Compressed_unique && A2format == Compressed_unique && A3format == Compressed_unique)
+  {
+    Csf3DTensor<T> &csf_3dtensor = *getConversion<Csf3DTensor<T>>(cacheKey<T>(fileID, CACHE_CSF_3D, selected_read), FileReader.coo_3dtensor);
+    FileReader.FileReaderWrapperFinalize();  // clear coo_3dtensor
+
+    // Print
+    // std::cout << "CSF detail: " << csf_3dtensor.num_index_i << ", " << csf_3dtensor.num_index_j << ", " << csf_3dtensor.num_index_k << ", " << csf_3dtensor.num_nonzeros << "\n";
+
+    // std::cout << "A1pos: ";
+    // for (int64_t i = 0; i < csf_3dtensor.A1pos_size; i++)
+    // {
+    //   std::cout << csf_3dtensor.A1pos[i] << " ";
+    // }
+    // std::cout << "\n";
+    // std::cout << "A1crd: ";
+    // for (int64_t i = 0; i < csf_3dtensor.A1crd_size; i++)
+    // {
+    //   std::cout << csf_3dtensor.A1crd[i] << " ";
+    // }
+    // std::cout << "\n";
+    // std::cout << "A2pos: ";
+    // for (int64_t i = 0; i < csf_3dtensor.A2pos_size; i++)
+    // {
+    //   std::cout << csf_3dtensor.A2pos[i] << " ";
+    // }
+    // std::cout << "\n";
+    // std::cout << "A2crd: ";
+    // for (int64_t i = 0; i < csf_3dtensor.A2crd_size; i++)
+    // {
+    //   std::cout << csf_3dtensor.A2crd[i] << " ";
+    // }
+    // std::cout << "\n";
+    // std::cout << "A3pos: ";
+    // for (int64_t i = 0; i < csf_3dtensor.A3pos_size; i++)
+    // {
+    //   std::cout << csf_3dtensor.A3pos[i] << " ";
+    // }
+    // std::cout << "\n";
+    // std::cout << "A3crd: ";
+    // for (int64_t i = 0; i < csf_3dtensor.A3crd_size; i++)
+    // {
+    //   std::cout << csf_3dtensor.A3crd[i] << " ";
+    // }
+    // std::cout << "\n";
+    // std::cout << "Aval: ";
+    // for (int64_t i = 0; i < csf_3dtensor.Aval_size; i++)
+    // {
+    //   std::cout << csf_3dtensor.Aval[i] << " ";
+    // }
+    // std::cout << "\n";
+
+    // Fill data
+    for (int64_t i = 0; i < csf_3dtensor.A1pos_size; i++)
+    {
+      desc_A1pos->data[i] = csf_3dtensor.A1pos[i];
+    }
+    for (int64_t i = 0; i < csf_3dtensor.A1crd_size; i++)
+    {
+      desc_A1crd->data[i] = csf_3dtensor.A1crd[i];
+    }
+    for (int64_t i = 0; i < csf_3dtensor.A2pos_size; i++)
+    {
+      desc_A2pos->data[i] = csf_3dtensor.A2pos[i];
+    }
+    for (int64_t i = 0; i < csf_3dtensor.A2crd_size; i++)
+    {
+      desc_A2crd->data[i] = csf_3dtensor.A2crd[i];
+    }
+    for (int64_t i = 0; i < csf_3dtensor.A3pos_size; i++)
+    {
+      desc_A3pos->data[i] = csf_3dtensor.A3pos[i];
+    }
+    for (int64_t i = 0; i < csf_3dtensor.A3crd_size; i++)
+    {
+      desc_A3crd->data[i] = csf_3dtensor.A3crd[i];
+    }
+    for (int64_t i = 0; !pattern_read && i < csf_3dtensor.Aval_size; i++)
+    {
+      desc_Aval->data[i] = csf_3dtensor.Aval[i];
+    }
+
+    releaseCached(cacheKey<T>(fileID, CACHE_CSF_3D, selected_read));
+  }
+  // Mode-Generic
+  else if (A1format == Compressed_nonunique && A2format == singleton && A3format == Dense)
+  {
+    // std::cout << "Mode-Generic format\n";
+    Mg3DTensor<T> &mg_3dtensor = *getConversion<Mg3DTensor<T>>(cacheKey<T>(fileID, CACHE_MG_3D, selected_read), FileReader.coo_3dtensor);
+    FileReader.FileReaderWrapperFinalize();  // clear coo_3dtensor
+
+    // Print
+    // std::cout << "ModeGeneric detail: " << mg_3dtensor.num_index_i << ", " << mg_3dtensor.num_index_j << ", " << mg_3dtensor.num_index_k << ", " << mg_3dtensor.num_nonzeros << "\n";
+
+    // std::cout << "A1pos: ";
+    // for(int64_t i = 0; i < mg_3dtensor.A1pos_size; i++){
+    //   std::cout << mg_3dtensor.A1pos[i] << " " ;
+    // }
+    // std::cout << "\n";
+    // std::cout << "A1crd: ";
+    // for(int64_t i = 0; i < mg_3dtensor.A1crd_size; i++){
+    //   std::cout << mg_3dtensor.A1crd[i] << " " ;
+    // }
+    // std::cout << "\n";
+    // std::cout << "A2crd: ";
+    // for(int64_t i = 0; i < mg_3dtensor.A2crd_size; i++){
+    //   std::cout << mg_3dtensor.A2crd[i] << " " ;
+    // }
+    // std::cout << "\n";
+    // std::cout << "A3pos: ";
+    // for(int64_t i = 0; i < mg_3dtensor.A3pos_size; i++){
+    //   std::cout << mg_3dtensor.A3pos[i] << " " ;
+    // }
+    // std::cout << "\n";
+    // std::cout << "Aval: ";
+    // for(int64_t i = 0; i < mg_3dtensor.Aval_size; i++){
+    //   std::cout << mg_3dtensor.Aval[i] << " " ;
+    // }
+    // std::cout << "\n";
+
+    // Fill data
+    for (int64_t i = 0; i < mg_3dtensor.A1pos_size; i++)
+    {
+      desc_A1pos->data[i] = mg_3dtensor.A1pos[i];
+    }
+    for (int64_t i = 0; i < mg_3dtensor.A1crd_size; i++)
+    {
+      desc_A1crd->data[i] = mg_3dtensor.A1crd[i];
+    }
+    for (int64_t i = 0; i < mg_3dtensor.A2crd_size; i++)
+    {
+      desc_A2crd->data[i] = mg_3dtensor.A2crd[i];
+    }
+    for (int64_t i = 0; i < mg_3dtensor.A3pos_size; i++)
+    {
+      desc_A3pos->data[i] = mg_3dtensor.A3pos[i];
+    }
+    for (int64_t i = 0; !pattern_read && i < mg_3dtensor.Aval_size; i++)
+    {
+      desc_Aval->data[i] = mg_3dtensor.Aval[i];
+    }
+    // std::cout << "Finish Mode-generic format conversion\n";
+
+    releaseCached(cacheKey<T>(fileID, CACHE_MG_3D, selected_read));
+  }
+  else
+  {
+    assert(false && "unsupported tensor 3D format\n");
+  }
+
+  writeBinaryCache(fileID, 3, formats, readMode, dims, desc_crds, desc_Aval);
+}
+
+// helper func: whether the input of fileID is worth parsing in the
+// background. Inputs that cannot be read are left to the read calls to
+// report, and inputs with an up-to-date binary sidecar file are not parsed.
+bool isPrefetchable(int32_t fileID, int rank, const int32_t *formats, int32_t readMode,
+                    size_t value_bytes, const char *extension)
+{
+  const char *env = getenv("COMET_PREFETCH");
+  if ((env && strcmp(env, "0") == 0) || fileID < 0 || fileID > 9999)
+    return false;
+
+  std::string filename = getSparseFileName(fileID);
+  if (filename.empty() || filename.find(extension) == std::string::npos ||
+      BinaryCacheFile::IsContainer(filename))
+    return false;
+
+  BinaryCacheFile cache;
+  return !cache.Open(filename, rank, formats, readMode, value_bytes);
+}
+
+// helper func: estimated bytes of the tensor cache objects built from the
+// input of fileID, from the number of nonzeros in its problem description:
+// the coordinates and the value of every nonzero, twice for the mirrored
+// nonzeros of symmetric matrices, and for the COO tensor a level tensor is
+// built from. Returns 0 if the description cannot be read.
+size_t estimateInputBytes(int32_t fileID, int rank, size_t value_bytes)
+{
+  FILE *fp = fopen(getSparseFileName(fileID).c_str(), "r");
+  if (!fp)
+    return 0;
+
+  bool market = (rank == 2);
+  bool symmetric = false;
+  std::vector<int64_t> fields;
+  string line;
+  char buffer[1024];
+  while (fields.empty() && fgets(buffer, sizeof(buffer), fp))
+  {
+    line += buffer;
+    if (line.back() != '\n' && !feof(fp))
+      continue; // the rest of a long line
+
+    const char *l = line.c_str();
+    const char *eol = l + line.size();
+    if (market && line.compare(0, 2, "%%") == 0)
+      symmetric = (line.find("symmetric") != string::npos);
+    else if (isDataLine(l, eol))
+    {
+      int64_t field;
+      while (parseIndex(l, eol, field))
+        fields.push_back(field);
+    }
+    line.clear();
+  }
+  fclose(fp);
+
+  if (fields.size() < (market ? 3 : 1) || fields.back() < 0)
+    return 0;
+  size_t nonzero_bytes = rank * sizeof(int64_t) + value_bytes;
+  return (size_t)fields[market ? 2 : fields.size() - 1] * nonzero_bytes * ((market && !symmetric) ? 1 : 2);
+}
+
+// Starts parsing the input of fileID in the background, into the tensor
+// cache objects the read calls with the same formats and readMode look for.
+// The read calls wait for the parse if it is still running. The objects
+// stay pinned until the first read call takes them, and inputs that would
+// not fit in the budget of the cache are left to the read calls.
+template <typename T>
+void prefetch_input_2D(int32_t fileID, int32_t A1format, int32_t A2format, int32_t readMode)
+{
+  int32_t formats[2] = {A1format, A2format};
+  if (!isPrefetchable(fileID, 2, formats, readMode, sizeof(T), ".mtx"))
+    return;
+
+  TensorCache::Get().Prefetch([=]()
+                              {
+                                int selected_matrix_read = getMatrixReadOption(readMode);
+                                bool pattern_read = isPatternRead(readMode);
+
+                                if (A1format == Dense && A2format == Compressed_unique)
+                                {
+                                  if (getCsrMarketReader<T>(fileID, selected_matrix_read, pattern_read))
+                                    holdCached(csrReaderKey<T>(fileID, selected_matrix_read, pattern_read));
+                                }
+                                else
+                                {
+                                  FileReaderWrapper<T> FileReader(fileID, false, selected_matrix_read);
+                                  FileReader.FileReaderWrapperHold();
+                                }
+                              },
+                              estimateInputBytes(fileID, 2, sizeof(T)));
+}
+
+template <typename T>
+void prefetch_input_ND(int32_t fileID, int rank, const int32_t *formats, int32_t readMode)
+{
+  if (!isPrefetchable(fileID, rank, formats, readMode, sizeof(T), ".tns"))
+    return;
+
+  std::vector<int32_t> level_formats(formats, formats + rank);
+  TensorCache::Get().Prefetch([=]()
+                              {
+                                int selected_read = getMatrixReadOption(readMode);
+                                if (getLevelTensor<T>(fileID, rank, level_formats.data(), selected_read))
+                                  holdCached(levelTensorKey<T>(fileID, rank, level_formats.data(), selected_read));
+                              },
+                              estimateInputBytes(fileID, rank, sizeof(T)));
+}
+
+template <typename T>
+void prefetch_input_3D(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t readMode)
+{
+  int32_t formats[3] = {A1format, A2format, A3format};
+  if (!isBuiltin3DFormat(A1format, A2format, A3format))
+  {
+    prefetch_input_ND<T>(fileID, 3, formats, readMode);
+    return;
+  }
+  if (!isPrefetchable(fileID, 3, formats, readMode, sizeof(T), ".tns"))
+    return;
+
+  TensorCache::Get().Prefetch([=]()
+                              {
+                                FileReaderWrapper<T> FileReader(fileID, true);
+                                FileReader.FileReaderWrapperHold();
+                              },
+                              estimateInputBytes(fileID, 3, sizeof(T)));
+}
+
+// Utility functions to read sparse matrices and fill in the pos and crd arrays per dimension
+extern "C" void read_input_2D_f32(int32_t fileID, int32_t A1format, int32_t A2format,
+                                  int A1pos_rank, void *A1pos_ptr,
+                                  int A1crd_rank, void *A1crd_ptr,
+                                  int A2pos_rank, void *A2pos_ptr,
+                                  int A2crd_rank, void *A2crd_ptr,
+                                  int Aval_rank, void *Aval_ptr, 
+                                  int32_t readMode)
+{
+  read_input_2D<float>(fileID, A1format, A2format,
+                       A1pos_rank, A1pos_ptr, A1crd_rank, A1crd_ptr,
+                       A2pos_rank, A2pos_ptr, A2crd_rank, A2crd_ptr,
+                       Aval_rank, Aval_ptr, readMode);
+}
+
+extern "C" void read_input_2D_f64(int32_t fileID, int32_t A1format,
+                                  int32_t A2format,
+                                  int A1pos_rank, void *A1pos_ptr,
+                                  int A1crd_rank, void *A1crd_ptr,
+                                  int A2pos_rank, void *A2pos_ptr,
+                                  int A2crd_rank, void *A2crd_ptr,
+                                  int Aval_rank, void *Aval_ptr,
+                                  int32_t readMode)
+{
+  read_input_2D<double>(fileID, A1format, A2format,
+                        A1pos_rank, A1pos_ptr, A1crd_rank, A1crd_ptr,
+                        A2pos_rank, A2pos_ptr, A2crd_rank, A2crd_ptr,
+                        Aval_rank, Aval_ptr, readMode);
+}
+
+extern "C" void read_input_3D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format,
+                                  int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                  int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                  int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                  int Aval_rank, void *Aval_ptr, int32_t readMode)
+{
+
+  read_input_3D<float>(fileID, A1format, A2format, A3format,
+                       A1pos_rank, A1pos_ptr, A1crd_rank, A1crd_ptr,
+                       A2pos_rank, A2pos_ptr, A2crd_rank, A2crd_ptr,
+                       A3pos_rank, A3pos_ptr, A3crd_rank, A3crd_ptr,
+                       Aval_rank, Aval_ptr, readMode);
+}
+
+extern "C" void read_input_3D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format,
+                                  int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                  int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                  int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                  int Aval_rank, void *Aval_ptr, int32_t readMode)
+{
+
+  read_input_3D<double>(fileID, A1format, A2format, A3format,
+                        A1pos_rank, A1pos_ptr, A1crd_rank, A1crd_ptr,
+                        A2pos_rank, A2pos_ptr, A2crd_rank, A2crd_ptr,
+                        A3pos_rank, A3pos_ptr, A3crd_rank, A3crd_ptr,
+                        Aval_rank, Aval_ptr, readMode);
+}
+
+// 64-bit staging copies of the i32 pos and crd arrays of a read_input_*_i32
+// call. The readers above fill the staging arrays, which are then narrowed
+// into the memrefs of the generated code.
+struct NarrowIndexArrays
+{
+  int count;
+  void **ptrs;
+  std::vector<std::vector<int64_t>> data;
+  std::vector<StridedMemRefType<int64_t, 1>> descs;
+
+  NarrowIndexArrays(int count, void **ptrs) : count(count), ptrs(ptrs), data(count), descs(count)
+  {
+    for (int i = 0; i < count; i++)
+    {
+      auto *desc32 = static_cast<StridedMemRefType<int32_t, 1> *>(ptrs[i]);
+      data[i].assign(desc32->data, desc32->data + desc32->sizes[0]);
+
+      descs[i].basePtr = data[i].data();
+      descs[i].data = data[i].data();
+      descs[i].offset = 0;
+      descs[i].sizes[0] = desc32->sizes[0];
+      descs[i].strides[0] = 1;
+    }
+  }
+
+  void *Get(int i)
+  {
+    return &descs[i];
+  }
+
+  void Narrow()
+  {
+    for (int i = 0; i < count; i++)
+    {
+      auto *desc32 = static_cast<StridedMemRefType<int32_t, 1> *>(ptrs[i]);
+      for (size_t k = 0; k < data[i].size(); k++)
+      {
+        if (data[i][k] < INT32_MIN || data[i][k] > INT32_MAX)
+        {
+          fprintf(stderr, "ERROR: sparse tensor does not fit in 32-bit pos/crd arrays, read it with 64-bit indices\n");
+          exit(1);
+        }
+        desc32->data[k] = (int32_t)data[i][k];
+      }
+    }
+  }
+};
+
+template <typename T>
+void read_input_2D_i32(int32_t fileID, int32_t A1format, int32_t A2format,
+                       void *A1pos_ptr, void *A1crd_ptr, void *A2pos_ptr, void *A2crd_ptr,
+                       int Aval_rank, void *Aval_ptr, int32_t readMode)
+{
+  void *ptrs[4] = {A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr};
+  NarrowIndexArrays indices(4, ptrs);
+
+  read_input_2D<T>(fileID, A1format, A2format,
+                   1, indices.Get(0), 1, indices.Get(1),
+                   1, indices.Get(2), 1, indices.Get(3),
+                   Aval_rank, Aval_ptr, readMode);
+  indices.Narrow();
+}
+
+template <typename T>
+void read_input_3D_i32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format,
+                       void *A1pos_ptr, void *A1crd_ptr, void *A2pos_ptr, void *A2crd_ptr,
+                       void *A3pos_ptr, void *A3crd_ptr, int Aval_rank, void *Aval_ptr, int32_t readMode)
+{
+  void *ptrs[6] = {A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr, A3pos_ptr, A3crd_ptr};
+  NarrowIndexArrays indices(6, ptrs);
+
+  read_input_3D<T>(fileID, A1format, A2format, A3format,
+                   1, indices.Get(0), 1, indices.Get(1),
+                   1, indices.Get(2), 1, indices.Get(3),
+                   1, indices.Get(4), 1, indices.Get(5),
+                   Aval_rank, Aval_ptr, readMode);
+  indices.Narrow();
+}
+
+template <typename T>
+void read_input_ND(int32_t fileID, int rank, const int32_t *formats,
+                   void **crd_ptrs, void *Aval_ptr, int32_t readMode)
+{
+  std::vector<StridedMemRefType<int64_t, 1> *> desc_crds(2 * rank);
+  for (int i = 0; i < 2 * rank; i++)
+    desc_crds[i] = static_cast<StridedMemRefType<int64_t, 1> *>(crd_ptrs[i]);
+  read_input_ND<T>(fileID, rank, formats, desc_crds.data(), static_cast<StridedMemRefType<T, 1> *>(Aval_ptr), readMode);
+}
+
+template <typename T>
+void read_input_ND_i32(int32_t fileID, int rank, const int32_t *formats,
+                       void **crd_ptrs, void *Aval_ptr, int32_t readMode)
+{
+  NarrowIndexArrays indices(2 * rank, crd_ptrs);
+
+  std::vector<void *> index_ptrs(2 * rank);
+  for (int i = 0; i < 2 * rank; i++)
+    index_ptrs[i] = indices.Get(i);
+  read_input_ND<T>(fileID, rank, formats, index_ptrs.data(), Aval_ptr, readMode);
+  indices.Narrow();
+}
+
+// Same as above, for tensors read with 32-bit pos and crd arrays
+extern "C" void read_input_2D_f32_i32(int32_t fileID, int32_t A1format, int32_t A2format,
+                                      int A1pos_rank, void *A1pos_ptr,
+                                      int A1crd_rank, void *A1crd_ptr,
+                                      int A2pos_rank, void *A2pos_ptr,
+                                      int A2crd_rank, void *A2crd_ptr,
+                                      int Aval_rank, void *Aval_ptr,
+                                      int32_t readMode)
+{
+  read_input_2D_i32<float>(fileID, A1format, A2format, A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr,
+                           Aval_rank, Aval_ptr, readMode);
+}
+
+extern "C" void read_input_2D_f64_i32(int32_t fileID, int32_t A1format, int32_t A2format,
+                                      int A1pos_rank, void *A1pos_ptr,
+                                      int A1crd_rank, void *A1crd_ptr,
+                                      int A2pos_rank, void *A2pos_ptr,
+                                      int A2crd_rank, void *A2crd_ptr,
+                                      int Aval_rank, void *Aval_ptr,
+                                      int32_t readMode)
+{
+  read_input_2D_i32<double>(fileID, A1format, A2format, A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr,
+                            Aval_rank, Aval_ptr, readMode);
+}
+
+extern "C" void read_input_3D_f32_i32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format,
+                                      int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                      int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                      int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                      int Aval_rank, void *Aval_ptr, int32_t readMode)
+{
+  read_input_3D_i32<float>(fileID, A1format, A2format, A3format, A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr,
+                           A3pos_ptr, A3crd_ptr, Aval_rank, Aval_ptr, readMode);
+}
+
+extern "C" void read_input_3D_f64_i32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format,
+                                      int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                      int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                      int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                      int Aval_rank, void *Aval_ptr, int32_t readMode)
+{
+  read_input_3D_i32<double>(fileID, A1format, A2format, A3format, A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr,
+                            A3pos_ptr, A3crd_ptr, Aval_rank, Aval_ptr, readMode);
+}
+
+// Utility functions to read metadata about the input matrices, such as the size of pos and crd array
+extern "C" void read_input_sizes_2D_f32(int32_t fileID, int32_t A1format, int32_t A2format,
+                                        int A1pos_rank, void *A1pos_ptr, int32_t readMode)
+{
+  read_input_sizes_2D<float>(fileID, A1format, A2format, A1pos_rank, A1pos_ptr, readMode);
+}
+
+extern "C" void read_input_sizes_2D_f64(int32_t fileID, int32_t A1format, int32_t A2format,
+//                                        int A1pos_rank, void *A1pos_ptr, char *filename, int32_t readMode)
+                                        int A1pos_rank, void *A1pos_ptr, int32_t readMode)
+{
+  read_input_sizes_2D<double>(fileID, A1format, A2format, A1pos_rank, A1pos_ptr, readMode);
+}
+
+// Read 3D tensors
+extern "C" void read_input_sizes_3D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format,
+                                        int A1pos_rank, void *A1pos_ptr, int32_t readMode)
+{
+  read_input_sizes_3D<float>(fileID, A1format, A2format, A3format, A1pos_rank, A1pos_ptr, readMode);
+}
+
+extern "C" void read_input_sizes_3D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format,
+                                        int A1pos_rank, void *A1pos_ptr, int32_t readMode)
+{
+  read_input_sizes_3D<double>(fileID, A1format, A2format, A3format, A1pos_rank, A1pos_ptr, readMode);
+}
+
+// Background parsing of the inputs, emitted at function entry
+extern "C" void prefetch_input_2D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t readMode)
+{
+  prefetch_input_2D<float>(fileID, A1format, A2format, readMode);
+}
+
+extern "C" void prefetch_input_2D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t readMode)
+{
+  prefetch_input_2D<double>(fileID, A1format, A2format, readMode);
+}
+
+extern "C" void prefetch_input_3D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t readMode)
+{
+  prefetch_input_3D<float>(fileID, A1format, A2format, A3format, readMode);
+}
+
+extern "C" void prefetch_input_3D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t readMode)
+{
+  prefetch_input_3D<double>(fileID, A1format, A2format, A3format, readMode);
+}
+
+// Read tensors of rank 4 to 8, with any per-dimension format. The pos and
+// crd arrays are passed in the order A1pos, A1crd, A2pos, A2crd, ...
+
+extern "C" void read_input_sizes_4D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format,
+                                        int A1pos_rank, void *A1pos_ptr, int32_t readMode)
+{
+  int32_t formats[4] = {A1format, A2format, A3format, A4format};
+  read_input_sizes_ND<float>(fileID, 4, formats, static_cast<StridedMemRefType<int64_t, 1> *>(A1pos_ptr), readMode);
+}
+
+extern "C" void read_input_sizes_4D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format,
+                                        int A1pos_rank, void *A1pos_ptr, int32_t readMode)
+{
+  int32_t formats[4] = {A1format, A2format, A3format, A4format};
+  read_input_sizes_ND<double>(fileID, 4, formats, static_cast<StridedMemRefType<int64_t, 1> *>(A1pos_ptr), readMode);
+}
+
+extern "C" void read_input_4D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format,
+                                  int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                  int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                  int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                  int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                  int Aval_rank, void *Aval_ptr, int32_t readMode)
+{
+  int32_t formats[4] = {A1format, A2format, A3format, A4format};
+  void *crd_ptrs[8] = {A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr, A3pos_ptr, A3crd_ptr, A4pos_ptr, A4crd_ptr};
+  read_input_ND<float>(fileID, 4, formats, crd_ptrs, Aval_ptr, readMode);
+}
+
+extern "C" void read_input_4D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format,
+                                  int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                  int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                  int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                  int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                  int Aval_rank, void *Aval_ptr, int32_t readMode)
+{
+  int32_t formats[4] = {A1format, A2format, A3format, A4format};
+  void *crd_ptrs[8] = {A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr, A3pos_ptr, A3crd_ptr, A4pos_ptr, A4crd_ptr};
+  read_input_ND<double>(fileID, 4, formats, crd_ptrs, Aval_ptr, readMode);
+}
+
+extern "C" void read_input_4D_f32_i32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format,
+                                      int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                      int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                      int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                      int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                      int Aval_rank, void *Aval_ptr, int32_t readMode)
+{
+  int32_t formats[4] = {A1format, A2format, A3format, A4format};
+  void *crd_ptrs[8] = {A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr, A3pos_ptr, A3crd_ptr, A4pos_ptr, A4crd_ptr};
+  read_input_ND_i32<float>(fileID, 4, formats, crd_ptrs, Aval_ptr, readMode);
+}
+
+extern "C" void read_input_4D_f64_i32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format,
+                                      int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                      int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                      int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                      int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                      int Aval_rank, void *Aval_ptr, int32_t readMode)
+{
+  int32_t formats[4] = {A1format, A2format, A3format, A4format};
+  void *crd_ptrs[8] = {A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr, A3pos_ptr, A3crd_ptr, A4pos_ptr, A4crd_ptr};
+  read_input_ND_i32<double>(fileID, 4, formats, crd_ptrs, Aval_ptr, readMode);
+}
+
+extern "C" void prefetch_input_4D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t readMode)
+{
+  int32_t formats[4] = {A1format, A2format, A3format, A4format};
+  prefetch_input_ND<float>(fileID, 4, formats, readMode);
+}
+
+extern "C" void prefetch_input_4D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t readMode)
+{
+  int32_t formats[4] = {A1format, A2format, A3format, A4format};
+  prefetch_input_ND<double>(fileID, 4, formats, readMode);
+}
+
+extern "C" void read_input_sizes_5D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format,
+                                        int A1pos_rank, void *A1pos_ptr, int32_t readMode)
+{
+  int32_t formats[5] = {A1format, A2format, A3format, A4format, A5format};
+  read_input_sizes_ND<float>(fileID, 5, formats, static_cast<StridedMemRefType<int64_t, 1> *>(A1pos_ptr), readMode);
+}
+
+extern "C" void read_input_sizes_5D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format,
+                                        int A1pos_rank, void *A1pos_ptr, int32_t readMode)
+{
+  int32_t formats[5] = {A1format, A2format, A3format, A4format, A5format};
+  read_input_sizes_ND<double>(fileID, 5, formats, static_cast<StridedMemRefType<int64_t, 1> *>(A1pos_ptr), readMode);
+}
+
+extern "C" void read_input_5D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format,
+                                  int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                  int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                  int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                  int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                  int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                  int Aval_rank, void *Aval_ptr, int32_t readMode)
+{
+  int32_t formats[5] = {A1format, A2format, A3format, A4format, A5format};
+  void *crd_ptrs[10] = {A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr, A3pos_ptr, A3crd_ptr, A4pos_ptr, A4crd_ptr, A5pos_ptr, A5crd_ptr};
+  read_input_ND<float>(fileID, 5, formats, crd_ptrs, Aval_ptr, readMode);
+}
+
+extern "C" void read_input_5D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format,
+                                  int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                  int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                  int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                  int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                  int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                  int Aval_rank, void *Aval_ptr, int32_t readMode)
+{
+  int32_t formats[5] = {A1format, A2format, A3format, A4format, A5format};
+  void *crd_ptrs[10] = {A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr, A3pos_ptr, A3crd_ptr, A4pos_ptr, A4crd_ptr, A5pos_ptr, A5crd_ptr};
+  read_input_ND<double>(fileID, 5, formats, crd_ptrs, Aval_ptr, readMode);
+}
+
+extern "C" void read_input_5D_f32_i32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format,
+                                      int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                      int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                      int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                      int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                      int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                      int Aval_rank, void *Aval_ptr, int32_t readMode)
+{
+  int32_t formats[5] = {A1format, A2format, A3format, A4format, A5format};
+  void *crd_ptrs[10] = {A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr, A3pos_ptr, A3crd_ptr, A4pos_ptr, A4crd_ptr, A5pos_ptr, A5crd_ptr};
+  read_input_ND_i32<float>(fileID, 5, formats, crd_ptrs, Aval_ptr, readMode);
+}
+
+extern "C" void read_input_5D_f64_i32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format,
+                                      int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                      int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                      int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                      int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                      int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                      int Aval_rank, void *Aval_ptr, int32_t readMode)
+{
+  int32_t formats[5] = {A1format, A2format, A3format, A4format, A5format};
+  void *crd_ptrs[10] = {A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr, A3pos_ptr, A3crd_ptr, A4pos_ptr, A4crd_ptr, A5pos_ptr, A5crd_ptr};
+  read_input_ND_i32<double>(fileID, 5, formats, crd_ptrs, Aval_ptr, readMode);
+}
+
+extern "C" void prefetch_input_5D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t readMode)
+{
+  int32_t formats[5] = {A1format, A2format, A3format, A4format, A5format};
+  prefetch_input_ND<float>(fileID, 5, formats, readMode);
+}
+
+extern "C" void prefetch_input_5D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t readMode)
+{
+  int32_t formats[5] = {A1format, A2format, A3format, A4format, A5format};
+  prefetch_input_ND<double>(fileID, 5, formats, readMode);
+}
+
+extern "C" void read_input_sizes_6D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format,
+                                        int A1pos_rank, void *A1pos_ptr, int32_t readMode)
+{
+  int32_t formats[6] = {A1format, A2format, A3format, A4format, A5format, A6format};
+  read_input_sizes_ND<float>(fileID, 6, formats, static_cast<StridedMemRefType<int64_t, 1> *>(A1pos_ptr), readMode);
+}
+
+extern "C" void read_input_sizes_6D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format,
+                                        int A1pos_rank, void *A1pos_ptr, int32_t readMode)
+{
+  int32_t formats[6] = {A1format, A2format, A3format, A4format, A5format, A6format};
+  read_input_sizes_ND<double>(fileID, 6, formats, static_cast<StridedMemRefType<int64_t, 1> *>(A1pos_ptr), readMode);
+}
+
+extern "C" void read_input_6D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format,
+                                  int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                  int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                  int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                  int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                  int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                  int A6pos_rank, void *A6pos_ptr, int A6crd_rank, void *A6crd_ptr,
+                                  int Aval_rank, void *Aval_ptr, int32_t readMode)
+{
+  int32_t formats[6] = {A1format, A2format, A3format, A4format, A5format, A6format};
+  void *crd_ptrs[12] = {A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr, A3pos_ptr, A3crd_ptr, A4pos_ptr, A4crd_ptr, A5pos_ptr, A5crd_ptr, A6pos_ptr, A6crd_ptr};
+  read_input_ND<float>(fileID, 6, formats, crd_ptrs, Aval_ptr, readMode);
+}
+
+extern "C" void read_input_6D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format,
+                                  int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                  int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                  int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                  int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                  int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                  int A6pos_rank, void *A6pos_ptr, int A6crd_rank, void *A6crd_ptr,
+                                  int Aval_rank, void *Aval_ptr, int32_t readMode)
+{
+  int32_t formats[6] = {A1format, A2format, A3format, A4format, A5format, A6format};
+  void *crd_ptrs[12] = {A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr, A3pos_ptr, A3crd_ptr, A4pos_ptr, A4crd_ptr, A5pos_ptr, A5crd_ptr, A6pos_ptr, A6crd_ptr};
+  read_input_ND<double>(fileID, 6, formats, crd_ptrs, Aval_ptr, readMode);
+}
+
+extern "C" void read_input_6D_f32_i32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format,
+                                      int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                      int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                      int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                      int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                      int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                      int A6pos_rank, void *A6pos_ptr, int A6crd_rank, void *A6crd_ptr,
+                                      int Aval_rank, void *Aval_ptr, int32_t readMode)
+{
+  int32_t formats[6] = {A1format, A2format, A3format, A4format, A5format, A6format};
+  void *crd_ptrs[12] = {A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr, A3pos_ptr, A3crd_ptr, A4pos_ptr, A4crd_ptr, A5pos_ptr, A5crd_ptr, A6pos_ptr, A6crd_ptr};
+  read_input_ND_i32<float>(fileID, 6, formats, crd_ptrs, Aval_ptr, readMode);
+}
+
+extern "C" void read_input_6D_f64_i32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format,
+                                      int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                      int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                      int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                      int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                      int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                      int A6pos_rank, void *A6pos_ptr, int A6crd_rank, void *A6crd_ptr,
+                                      int Aval_rank, void *Aval_ptr, int32_t readMode)
+{
+  int32_t formats[6] = {A1format, A2format, A3format, A4format, A5format, A6format};
+  void *crd_ptrs[12] = {A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr, A3pos_ptr, A3crd_ptr, A4pos_ptr, A4crd_ptr, A5pos_ptr, A5crd_ptr, A6pos_ptr, A6crd_ptr};
+  read_input_ND_i32<double>(fileID, 6, formats, crd_ptrs, Aval_ptr, readMode);
+}
+
+extern "C" void prefetch_input_6D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format, int32_t readMode)
+{
+  int32_t formats[6] = {A1format, A2format, A3format, A4format, A5format, A6format};
+  prefetch_input_ND<float>(fileID, 6, formats, readMode);
+}
+
+extern "C" void prefetch_input_6D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format, int32_t readMode)
+{
+  int32_t formats[6] = {A1format, A2format, A3format, A4format, A5format, A6format};
+  prefetch_input_ND<double>(fileID, 6, formats, readMode);
+}
+
+extern "C" void read_input_sizes_7D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format, int32_t A7format,
+                                        int A1pos_rank, void *A1pos_ptr, int32_t readMode)
+{
+  int32_t formats[7] = {A1format, A2format, A3format, A4format, A5format, A6format, A7format};
+  read_input_sizes_ND<float>(fileID, 7, formats, static_cast<StridedMemRefType<int64_t, 1> *>(A1pos_ptr), readMode);
+}
+
+extern "C" void read_input_sizes_7D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format, int32_t A7format,
+                                        int A1pos_rank, void *A1pos_ptr, int32_t readMode)
+{
+  int32_t formats[7] = {A1format, A2format, A3format, A4format, A5format, A6format, A7format};
+  read_input_sizes_ND<double>(fileID, 7, formats, static_cast<StridedMemRefType<int64_t, 1> *>(A1pos_ptr), readMode);
+}
+
+extern "C" void read_input_7D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format, int32_t A7format,
+                                  int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                  int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                  int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                  int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                  int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                  int A6pos_rank, void *A6pos_ptr, int A6crd_rank, void *A6crd_ptr,
+                                  int A7pos_rank, void *A7pos_ptr, int A7crd_rank, void *A7crd_ptr,
+                                  int Aval_rank, void *Aval_ptr, int32_t readMode)
+{
+  int32_t formats[7] = {A1format, A2format, A3format, A4format, A5format, A6format, A7format};
+  void *crd_ptrs[14] = {A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr, A3pos_ptr, A3crd_ptr, A4pos_ptr, A4crd_ptr, A5pos_ptr, A5crd_ptr, A6pos_ptr, A6crd_ptr, A7pos_ptr, A7crd_ptr};
+  read_input_ND<float>(fileID, 7, formats, crd_ptrs, Aval_ptr, readMode);
+}
+
+extern "C" void read_input_7D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format, int32_t A7format,
+                                  int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                  int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                  int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                  int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                  int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                  int A6pos_rank, void *A6pos_ptr, int A6crd_rank, void *A6crd_ptr,
+                                  int A7pos_rank, void *A7pos_ptr, int A7crd_rank, void *A7crd_ptr,
+                                  int Aval_rank, void *Aval_ptr, int32_t readMode)
+{
+  int32_t formats[7] = {A1format, A2format, A3format, A4format, A5format, A6format, A7format};
+  void *crd_ptrs[14] = {A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr, A3pos_ptr, A3crd_ptr, A4pos_ptr, A4crd_ptr, A5pos_ptr, A5crd_ptr, A6pos_ptr, A6crd_ptr, A7pos_ptr, A7crd_ptr};
+  read_input_ND<double>(fileID, 7, formats, crd_ptrs, Aval_ptr, readMode);
+}
+
+extern "C" void read_input_7D_f32_i32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format, int32_t A7format,
+                                      int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                      int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                      int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                      int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                      int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                      int A6pos_rank, void *A6pos_ptr, int A6crd_rank, void *A6crd_ptr,
+                                      int A7pos_rank, void *A7pos_ptr, int A7crd_rank, void *A7crd_ptr,
+                                      int Aval_rank, void *Aval_ptr, int32_t readMode)
+{
+  int32_t formats[7] = {A1format, A2format, A3format, A4format, A5format, A6format, A7format};
+  void *crd_ptrs[14] = {A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr, A3pos_ptr, A3crd_ptr, A4pos_ptr, A4crd_ptr, A5pos_ptr, A5crd_ptr, A6pos_ptr, A6crd_ptr, A7pos_ptr, A7crd_ptr};
+  read_input_ND_i32<float>(fileID, 7, formats, crd_ptrs, Aval_ptr, readMode);
+}
+
+extern "C" void read_input_7D_f64_i32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format, int32_t A7format,
+                                      int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                      int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                      int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                      int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                      int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                      int A6pos_rank, void *A6pos_ptr, int A6crd_rank, void *A6crd_ptr,
+                                      int A7pos_rank, void *A7pos_ptr, int A7crd_rank, void *A7crd_ptr,
+                                      int Aval_rank, void *Aval_ptr, int32_t readMode)
+{
+  int32_t formats[7] = {A1format, A2format, A3format, A4format, A5format, A6format, A7format};
+  void *crd_ptrs[14] = {A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr, A3pos_ptr, A3crd_ptr, A4pos_ptr, A4crd_ptr, A5pos_ptr, A5crd_ptr, A6pos_ptr, A6crd_ptr, A7pos_ptr, A7crd_ptr};
+  read_input_ND_i32<double>(fileID, 7, formats, crd_ptrs, Aval_ptr, readMode);
+}
+
+extern "C" void prefetch_input_7D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format, int32_t A7format, int32_t readMode)
+{
+  int32_t formats[7] = {A1format, A2format, A3format, A4format, A5format, A6format, A7format};
+  prefetch_input_ND<float>(fileID, 7, formats, readMode);
+}
+
+extern "C" void prefetch_input_7D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format, int32_t A7format, int32_t readMode)
+{
+  int32_t formats[7] = {A1format, A2format, A3format, A4format, A5format, A6format, A7format};
+  prefetch_input_ND<double>(fileID, 7, formats, readMode);
+}
+
+extern "C" void read_input_sizes_8D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format, int32_t A7format, int32_t A8format,
+                                        int A1pos_rank, void *A1pos_ptr, int32_t readMode)
+{
+  int32_t formats[8] = {A1format, A2format, A3format, A4format, A5format, A6format, A7format, A8format};
+  read_input_sizes_ND<float>(fileID, 8, formats, static_cast<StridedMemRefType<int64_t, 1> *>(A1pos_ptr), readMode);
+}
+
+extern "C" void read_input_sizes_8D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format, int32_t A7format, int32_t A8format,
+                                        int A1pos_rank, void *A1pos_ptr, int32_t readMode)
+{
+  int32_t formats[8] = {A1format, A2format, A3format, A4format, A5format, A6format, A7format, A8format};
+  read_input_sizes_ND<double>(fileID, 8, formats, static_cast<StridedMemRefType<int64_t, 1> *>(A1pos_ptr), readMode);
+}
+
+extern "C" void read_input_8D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format, int32_t A7format, int32_t A8format,
+                                  int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                  int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                  int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                  int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                  int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                  int A6pos_rank, void *A6pos_ptr, int A6crd_rank, void *A6crd_ptr,
+                                  int A7pos_rank, void *A7pos_ptr, int A7crd_rank, void *A7crd_ptr,
+                                  int A8pos_rank, void *A8pos_ptr, int A8crd_rank, void *A8crd_ptr,
+                                  int Aval_rank, void *Aval_ptr, int32_t readMode)
+{
+  int32_t formats[8] = {A1format, A2format, A3format, A4format, A5format, A6format, A7format, A8format};
+  void *crd_ptrs[16] = {A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr, A3pos_ptr, A3crd_ptr, A4pos_ptr, A4crd_ptr, A5pos_ptr, A5crd_ptr, A6pos_ptr, A6crd_ptr, A7pos_ptr, A7crd_ptr, A8pos_ptr, A8crd_ptr};
+  read_input_ND<float>(fileID, 8, formats, crd_ptrs, Aval_ptr, readMode);
+}
+
+extern "C" void read_input_8D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format, int32_t A7format, int32_t A8format,
+                                  int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                  int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                  int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                  int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                  int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                  int A6pos_rank, void *A6pos_ptr, int A6crd_rank, void *A6crd_ptr,
+                                  int A7pos_rank, void *A7pos_ptr, int A7crd_rank, void *A7crd_ptr,
+                                  int A8pos_rank, void *A8pos_ptr, int A8crd_rank, void *A8crd_ptr,
+                                  int Aval_rank, void *Aval_ptr, int32_t readMode)
+{
+  int32_t formats[8] = {A1format, A2format, A3format, A4format, A5format, A6format, A7format, A8format};
+  void *crd_ptrs[16] = {A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr, A3pos_ptr, A3crd_ptr, A4pos_ptr, A4crd_ptr, A5pos_ptr, A5crd_ptr, A6pos_ptr, A6crd_ptr, A7pos_ptr, A7crd_ptr, A8pos_ptr, A8crd_ptr};
+  read_input_ND<double>(fileID, 8, formats, crd_ptrs, Aval_ptr, readMode);
+}
+
+extern "C" void read_input_8D_f32_i32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format, int32_t A7format, int32_t A8format,
+                                      int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                      int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                      int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                      int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                      int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                      int A6pos_rank, void *A6pos_ptr, int A6crd_rank, void *A6crd_ptr,
+                                      int A7pos_rank, void *A7pos_ptr, int A7crd_rank, void *A7crd_ptr,
+                                      int A8pos_rank, void *A8pos_ptr, int A8crd_rank, void *A8crd_ptr,
+                                      int Aval_rank, void *Aval_ptr, int32_t readMode)
+{
+  int32_t formats[8] = {A1format, A2format, A3format, A4format, A5format, A6format, A7format, A8format};
+  void *crd_ptrs[16] = {A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr, A3pos_ptr, A3crd_ptr, A4pos_ptr, A4crd_ptr, A5pos_ptr, A5crd_ptr, A6pos_ptr, A6crd_ptr, A7pos_ptr, A7crd_ptr, A8pos_ptr, A8crd_ptr};
+  read_input_ND_i32<float>(fileID, 8, formats, crd_ptrs, Aval_ptr, readMode);
+}
+
+extern "C" void read_input_8D_f64_i32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format, int32_t A7format, int32_t A8format,
+                                      int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                      int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                      int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                      int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                      int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                      int A6pos_rank, void *A6pos_ptr, int A6crd_rank, void *A6crd_ptr,
+                                      int A7pos_rank, void *A7pos_ptr, int A7crd_rank, void *A7crd_ptr,
+                                      int A8pos_rank, void *A8pos_ptr, int A8crd_rank, void *A8crd_ptr,
+                                      int Aval_rank, void *Aval_ptr, int32_t readMode)
+{
+  int32_t formats[8] = {A1format, A2format, A3format, A4format, A5format, A6format, A7format, A8format};
+  void *crd_ptrs[16] = {A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr, A3pos_ptr, A3crd_ptr, A4pos_ptr, A4crd_ptr, A5pos_ptr, A5crd_ptr, A6pos_ptr, A6crd_ptr, A7pos_ptr, A7crd_ptr, A8pos_ptr, A8crd_ptr};
+  read_input_ND_i32<double>(fileID, 8, formats, crd_ptrs, Aval_ptr, readMode);
+}
+
+extern "C" void prefetch_input_8D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format, int32_t A7format, int32_t A8format, int32_t readMode)
+{
+  int32_t formats[8] = {A1format, A2format, A3format, A4format, A5format, A6format, A7format, A8format};
+  prefetch_input_ND<float>(fileID, 8, formats, readMode);
+}
+
+extern "C" void prefetch_input_8D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format, int32_t A7format, int32_t A8format, int32_t readMode)
+{
+  int32_t formats[8] = {A1format, A2format, A3format, A4format, A5format, A6format, A7format, A8format};
+  prefetch_input_ND<double>(fileID, 8, formats, readMode);
+}
+
+extern "C" void comet_tensor_cache_set_budget(int64_t bytes)
+{
+  TensorCache::Get().SetBudget(bytes > 0 ? (size_t)bytes : 0);
+}
+
+extern "C" void comet_tensor_cache_pin(int32_t fileID)
+{
+  TensorCache::Get().PinFile(fileID);
+}
+
+extern "C" void comet_tensor_cache_unpin(int32_t fileID)
+{
+  TensorCache::Get().UnpinFile(fileID);
+}
+
+extern "C" void comet_tensor_cache_clear()
+{
+  TensorCache::Get().Clear();
+}
+
+extern "C" void comet_tensor_cache_print_stats()
+{
+  TensorCache::Get().PrintStats();
+}
+
+
+//===----------------------------------------------------------------------===//
+// Streaming sparse inputs in row panels.
+//===----------------------------------------------------------------------===//
+
+/**
+ * A row-independent kernel such as C = A * B, with a CSR matrix A and a
+ * dense vector or matrix B (SpMV, SpMM), needs a single row of A at a time,
+ * so A does not have to fit in memory. With --opt-stream-panels, such a
+ * kernel is lowered to comet_stream_csr_mult_*, which reads A from its
+ * binary container (a .cbin input, or its COMET_BINARY_CACHE sidecar file)
+ * in panels of consecutive rows of COMET_STREAM_PANEL_BYTES bytes (K, M and
+ * G suffixes are accepted; default: 64M).
+ *
+ * A loader thread copies the next panel out of the mapped file while the
+ * current one is multiplied, and the pages it has copied are dropped, so at
+ * most two panels of A are resident at any time. Inputs without a container
+ * are read into memory as usual, and multiplied by the same panels.
+ */
+
+// Rows [row_begin, row_end) of a CSR matrix. pos holds the row_end -
+// row_begin + 1 positions of the rows, crd and val start at position pos[0].
+template <typename T>
+struct CsrPanelView
+{
+  int64_t row_begin;
+  int64_t row_end;
+  const int64_t *pos;
+  const int64_t *crd;
+  const T *val; // NULL for pattern-only reads: every nonzero is 1
+};
+
+template <typename T>
+struct CsrPanelStream
+{
+  int64_t num_rows;
+  int64_t num_cols;
+  const int64_t *pos;
+  const int64_t *crd;
+  const T *val;
+  bool mapped;                 // whether the arrays are in the mapped container
+  std::vector<int64_t> bounds; // panel p holds rows [bounds[p], bounds[p + 1])
+
+  CsrPanelStream(int64_t num_rows, int64_t num_cols, const int64_t *pos, const int64_t *crd,
+                 const T *val, bool mapped)
+      : num_rows(num_rows), num_cols(num_cols), pos(pos), crd(crd), val(val), mapped(mapped) {}
+
+  static size_t PanelBytes()
+  {
+    if (char *env = getenv("COMET_STREAM_PANEL_BYTES"))
+      return std::max(TensorCache::ParseBytes(env), (size_t)1);
+    return (size_t)64 << 20;
+  }
+
+  /**
+   * Splits the rows into panels of about panel_bytes bytes of crd and val
+   * arrays. A panel holds at least one row. Only the pos entries at the
+   * bounds of the panels are looked at.
+   */
+  void Split(size_t panel_bytes)
+  {
+    size_t nonzero_bytes = sizeof(int64_t) + (val ? sizeof(T) : 0);
+    int64_t panel_nonzeros = std::max((int64_t)(panel_bytes / nonzero_bytes), (int64_t)1);
+
+    bounds.assign(1, 0);
+    while (bounds.back() < num_rows)
+    {
+      int64_t first = bounds.back();
+      // the last row whose end still fits in the panel
+      int64_t last = std::upper_bound(pos + first + 1, pos + num_rows + 1, pos[first] + panel_nonzeros) - pos - 1;
+      bounds.push_back(std::max(last, first + 1));
+    }
+  }
+
+  int64_t NumPanels() const
+  {
+    return (int64_t)bounds.size() - 1;
+  }
+
+  // View of panel p straight on the source arrays
+  CsrPanelView<T> View(int64_t p) const
+  {
+    CsrPanelView<T> view;
+    view.row_begin = bounds[p];
+    view.row_end = bounds[p + 1];
+    view.pos = pos + view.row_begin;
+    view.crd = crd + view.pos[0];
+    view.val = val ? val + view.pos[0] : NULL;
+    return view;
+  }
+
+  /**
+   * Copies panel p to buffer, and drops the pages of the source arrays that
+   * it covers. Returns the view of the copy.
+   */
+  CsrPanelView<T> Load(int64_t p, std::vector<char> &buffer) const
+  {
+    CsrPanelView<T> source = View(p);
+    int64_t num_pos = source.row_end - source.row_begin + 1;
+    int64_t num_nonzeros = source.pos[num_pos - 1] - source.pos[0];
+    size_t pos_bytes = num_pos * sizeof(int64_t);
+    size_t crd_bytes = num_nonzeros * sizeof(int64_t);
+    size_t val_bytes = source.val ? num_nonzeros * sizeof(T) : 0;
+    buffer.resize(pos_bytes + crd_bytes + val_bytes);
+
+    char *data = buffer.data();
+    memcpy(data, source.pos, pos_bytes);
+    memcpy(data + pos_bytes, source.crd, crd_bytes);
+    if (source.val)
+      memcpy(data + pos_bytes + crd_bytes, source.val, val_bytes);
+
+    DropPages(source.pos, pos_bytes);
+    DropPages(source.crd, crd_bytes);
+    if (source.val)
+      DropPages(source.val, val_bytes);
+
+    CsrPanelView<T> view = source;
+    view.pos = reinterpret_cast<const int64_t *>(data);
+    view.crd = reinterpret_cast<const int64_t *>(data + pos_bytes);
+    view.val = source.val ? reinterpret_cast<const T *>(data + pos_bytes + crd_bytes) : NULL;
+    return view;
+  }
+
+  // Drops the whole pages of the mapped file inside [begin, begin + bytes)
+  static void DropPages(const void *begin, size_t bytes)
+  {
+#ifndef _WIN32
+    static const uintptr_t page_size = sysconf(_SC_PAGE_SIZE);
+    uintptr_t first = ((uintptr_t)begin + page_size - 1) & ~(page_size - 1);
+    uintptr_t last = ((uintptr_t)begin + bytes) & ~(page_size - 1);
+    if (first < last)
+      madvise((void *)first, last - first, MADV_DONTNEED);
+#endif
+  }
+
+  /**
+   * Calls func(view) on every panel in order. Panels of a mapped container
+   * are copied by a loader thread, one panel ahead of func.
+   */
+  template <typename Func>
+  void ForEachPanel(Func func)
+  {
+    int64_t num_panels = NumPanels();
+    if (!mapped)
+    {
+      for (int64_t p = 0; p < num_panels; p++)
+        func(View(p));
+      return;
+    }
+
+    // two buffers: the loader fills panel p + 1 while panel p is used
+    std::vector<char> buffers[2];
+    CsrPanelView<T> views[2];
+    int64_t num_loaded = 0;
+    int64_t num_used = 0;
+    std::mutex mutex;
+    std::condition_variable cond;
+
+    std::thread loader([&]()
+                       {
+                         for (int64_t p = 0; p < num_panels; p++)
+                         {
+                           {
+                             std::unique_lock<std::mutex> lock(mutex);
+                             cond.wait(lock, [&]()
+                                       { return p - num_used < 2; });
+                           }
+                           CsrPanelView<T> view = Load(p, buffers[p % 2]);
+                           std::lock_guard<std::mutex> lock(mutex);
+                           views[p % 2] = view;
+                           num_loaded = p + 1;
+                           cond.notify_all();
+                         }
+                       });
+
+    for (int64_t p = 0; p < num_panels; p++)
+    {
+      CsrPanelView<T> view;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [&]()
+                  { return num_loaded > p; });
+        view = views[p % 2];
+      }
+      func(view);
+      std::lock_guard<std::mutex> lock(mutex);
+      num_used = p + 1;
+      cond.notify_all();
+    }
+    loader.join();
+  }
+};
+
+/**
+ * C = A * B for the rows of a panel of A. B and C are vectors (SpMV) or
+ * matrices (SpMM). The rows of the panel are split in blocks that are
+ * multiplied in parallel.
+ */
+template <typename T>
+void multiplyCsrPanel(const CsrPanelView<T> &A, const DynamicMemRefType<T> &B, const DynamicMemRefType<T> &C)
+{
+  int64_t num_cols = (C.rank == 2) ? C.sizes[1] : 1;
+  int64_t B_row_stride = B.strides[0];
+  int64_t B_col_stride = (B.rank == 2) ? B.strides[1] : 0;
+  int64_t C_row_stride = C.strides[0];
+  int64_t C_col_stride = (C.rank == 2) ? C.strides[1] : 0;
+  const T *B_data = B.data + B.offset;
+  T *C_data = C.data + C.offset;
+
+  static const int64_t MIN_BLOCK_ROWS = 256;
+  int64_t num_rows = A.row_end - A.row_begin;
+  int num_threads = getNumThreads();
+  int num_blocks = (int)std::min((int64_t)num_threads * 4, (num_rows + MIN_BLOCK_ROWS - 1) / MIN_BLOCK_ROWS);
+  parallelFor(num_blocks, num_threads, [&](int b)
+              {
+                int64_t first = num_rows * b / num_blocks;
+                int64_t last = num_rows * (b + 1) / num_blocks;
+                for (int64_t i = first; i < last; i++)
+                {
+                  T *C_row = C_data + (A.row_begin + i) * C_row_stride;
+                  for (int64_t k = 0; k < num_cols; k++)
+                    C_row[k * C_col_stride] = 0;
+                  for (int64_t e = A.pos[i] - A.pos[0]; e < A.pos[i + 1] - A.pos[0]; e++)
+                  {
+                    T a = A.val ? A.val[e] : (T)1;
+                    const T *B_row = B_data + A.crd[e] * B_row_stride;
+                    for (int64_t k = 0; k < num_cols; k++)
+                      C_row[k * C_col_stride] += a * B_row[k * B_col_stride];
+                  }
+                }
+              });
+}
+
+template <typename T>
+void stream_csr_mult(int32_t fileID, int32_t readMode, const DynamicMemRefType<T> &B, const DynamicMemRefType<T> &C)
+{
+  int32_t formats[2] = {Dense, Compressed_unique};
+  bool pattern_read = isPatternRead(readMode);
+
+  // the container of the input, or the arrays read into memory
+  BinaryCacheFile cache;
+  std::vector<int64_t> sizes(7);
+  std::vector<int64_t> A1pos, A1crd, A2pos, A2crd;
+  std::vector<T> Aval;
+  CsrPanelStream<T> *stream;
+  if (cache.Open(getSparseFileName(fileID), 2, formats, readMode, sizeof(T)))
+  {
+    const T *val = (pattern_read || cache.sizes[4] == 0) ? NULL : reinterpret_cast<const T *>(cache.arrays[4]);
+    stream = new CsrPanelStream<T>(cache.sizes[5], cache.sizes[6],
+                                   reinterpret_cast<const int64_t *>(cache.arrays[2]),
+                                   reinterpret_cast<const int64_t *>(cache.arrays[3]), val, true);
   }
   else
   {
-    assert(false && "unsupported tensor 3D format\n");
-  }
+    StridedMemRefType<int64_t, 1> desc_sizes = {sizes.data(), sizes.data(), 0, {7}, {1}};
+    read_input_sizes_2D<T>(fileID, Dense, Compressed_unique, 1, &desc_sizes, readMode);
+    A1pos.resize(sizes[0]);
+    A1crd.resize(sizes[1]);
+    A2pos.resize(sizes[2]);
+    A2crd.resize(sizes[3]);
+    Aval.resize(sizes[4]);
+    StridedMemRefType<int64_t, 1> desc_A1pos = {A1pos.data(), A1pos.data(), 0, {sizes[0]}, {1}};
+    StridedMemRefType<int64_t, 1> desc_A1crd = {A1crd.data(), A1crd.data(), 0, {sizes[1]}, {1}};
+    StridedMemRefType<int64_t, 1> desc_A2pos = {A2pos.data(), A2pos.data(), 0, {sizes[2]}, {1}};
+    StridedMemRefType<int64_t, 1> desc_A2crd = {A2crd.data(), A2crd.data(), 0, {sizes[3]}, {1}};
+    StridedMemRefType<T, 1> desc_Aval = {Aval.data(), Aval.data(), 0, {sizes[4]}, {1}};
+    read_input_2D<T>(fileID, Dense, Compressed_unique, 1, &desc_A1pos, 1, &desc_A1crd,
+                     1, &desc_A2pos, 1, &desc_A2crd, 1, &desc_Aval, readMode);
+    stream = new CsrPanelStream<T>(sizes[5], sizes[6], A2pos.data(), A2crd.data(),
+                                   Aval.empty() ? NULL : Aval.data(), false);
+  }
+
+  int64_t rank = B.rank;
+  if (rank != C.rank || rank < 1 || rank > 2 || B.sizes[0] != stream->num_cols ||
+      C.sizes[0] != stream->num_rows || (rank == 2 && B.sizes[1] != C.sizes[1]))
+  {
+    fprintf(stderr, "ERROR: the dimensions of the streamed product do not match\n");
+    exit(1);
+  }
+
+  stream->Split(CsrPanelStream<T>::PanelBytes());
+  stream->ForEachPanel([&](const CsrPanelView<T> &panel)
+                       { multiplyCsrPanel(panel, B, C); });
+  delete stream;
+}
+
+// C = A * B, with the CSR matrix A of fileID streamed in row panels
+extern "C" void comet_stream_csr_mult_f32(int32_t fileID, int32_t readMode,
+                                          int64_t B_rank, void *B_ptr, int64_t C_rank, void *C_ptr)
+{
+  UnrankedMemRefType<float> B = {B_rank, B_ptr};
+  UnrankedMemRefType<float> C = {C_rank, C_ptr};
+  stream_csr_mult<float>(fileID, readMode, DynamicMemRefType<float>(B), DynamicMemRefType<float>(C));
+}
+
+extern "C" void comet_stream_csr_mult_f64(int32_t fileID, int32_t readMode,
+                                          int64_t B_rank, void *B_ptr, int64_t C_rank, void *C_ptr)
+{
+  UnrankedMemRefType<double> B = {B_rank, B_ptr};
+  UnrankedMemRefType<double> C = {C_rank, C_ptr};
+  stream_csr_mult<double>(fileID, readMode, DynamicMemRefType<double>(B), DynamicMemRefType<double>(C));
+}
+
+//===----------------------------------------------------------------------===//
+// Writing result tensors to files.
+//===----------------------------------------------------------------------===//
+
+/**
+ * comet_write(tensor, fileID) writes a tensor to the file named by the
+ * OUTPUT_FILE_NAME<fileID> (or OUTPUT_FILE_NAME for fileID 9999)
+ * environmental variable. The extension of the file selects the format:
+ *   .mtx   Matrix Market: coordinate format for sparse matrices, array
+ *          format for dense ones
+ *   .cbin  the binary container of the sidecar cache (BinaryCacheHeader),
+ *          with the pos/crd/val arrays of the tensor
+ *   other  FROSTT: one nonzero per line, its 1-based coordinates and value,
+ *          after a line with the size of every dimension and the number of
+ *          nonzeros, as the readers expect
+ *
+ * The text formats are produced in chunks of lines, formatted on several
+ * threads and written out in order.
+ */
+
+// helper func: name of the output file behind fileID, or an empty string
+std::string getOutputFileName(int32_t fileID)
+{
+  char *pOutput = NULL;
+  if (fileID >= 0 && fileID < 9999)
+    pOutput = getenv(("OUTPUT_FILE_NAME" + std::to_string(fileID)).c_str());
+  else if (fileID == 9999)
+    pOutput = getenv("OUTPUT_FILE_NAME");
+
+  return pOutput ? std::string(pOutput) : std::string();
+}
+
+enum OutputFormat
+{
+  OUTPUT_FROSTT = 0,
+  OUTPUT_MARKET,
+  OUTPUT_BINARY
+};
+
+int getOutputFormat(const string &filename)
+{
+  if (hasSuffix(filename, ".mtx"))
+    return OUTPUT_MARKET;
+  if (hasSuffix(filename, ".cbin"))
+    return OUTPUT_BINARY;
+  return OUTPUT_FROSTT;
+}
+
+// Appends the decimal digits of the non-negative v at buf, and returns the
+// end of them
+static inline char *formatIndex(char *buf, int64_t v)
+{
+  char digits[20];
+  int n = 0;
+  do
+  {
+    digits[n++] = '0' + (char)(v % 10);
+    v /= 10;
+  } while (v != 0);
+  while (n > 0)
+    *buf++ = digits[--n];
+  return buf;
 }
 
-template <typename T>
-void read_input_3D(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format, int A1pos_rank, void *A1pos_ptr,
-                   int A1crd_rank, void *A1crd_ptr, int A2pos_rank, void *A2pos_ptr, int A2crd_rank,
-                   void *A2crd_ptr, int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
-                   int Aval_rank, void *Aval_ptr, int32_t readMode)
+// Appends v at buf, and returns the end of it. Integral values are written
+// as integers, the others with the fewest of 15 or 17 significant digits
+// that read back as the same value.
+static inline char *formatValue(char *buf, double v)
 {
-  // FIXME: readMode is for future use.
+  if (v == std::floor(v) && std::fabs(v) < 9007199254740992.0)
+  {
+    if (v < 0)
+      *buf++ = '-';
+    return formatIndex(buf, (int64_t)std::fabs(v));
+  }
+  int n = snprintf(buf, 32, "%.15g", v);
+  if (strtod(buf, NULL) != v)
+    n = snprintf(buf, 32, "%.17g", v);
+  return buf + n;
+}
 
-  auto *desc_A1pos = static_cast<StridedMemRefType<int64_t, 1> *>(A1pos_ptr);
-  auto *desc_A1crd = static_cast<StridedMemRefType<int64_t, 1> *>(A1crd_ptr);
-  auto *desc_A2pos = static_cast<StridedMemRefType<int64_t, 1> *>(A2pos_ptr);
-  auto *desc_A2crd = static_cast<StridedMemRefType<int64_t, 1> *>(A2crd_ptr);
-  auto *desc_A3pos = static_cast<StridedMemRefType<int64_t, 1> *>(A3pos_ptr);
-  auto *desc_A3crd = static_cast<StridedMemRefType<int64_t, 1> *>(A3crd_ptr);
-  auto *desc_Aval = static_cast<StridedMemRefType<T, 1> *>(Aval_ptr);
+// Longest line: up to 20 characters per coordinate and 32 for the value
+static inline size_t maxLineBytes(int rank)
+{
+  return 21 * rank + 33;
+}
 
-  FileReaderWrapper<T> FileReader (fileID, true);  // init of COO_3d_tensor
+// Lines formatted by one task
+const int64_t WRITE_CHUNK_LINES = 1 << 16;
 
-  if (A1format == Compressed_nonunique && A2format == singleton && A3format == singleton)
+/**
+ * Writes num_lines lines to fp. format_lines(first, last, buf) formats the
+ * lines [first, last) at buf, of at most max_line_bytes each, and returns
+ * the end of them. Chunks of lines are formatted in parallel, a batch at a
+ * time, and written out in order. Returns false if a write failed.
+ */
+template <typename Func>
+bool writeLines(FILE *fp, int64_t num_lines, size_t max_line_bytes, Func format_lines)
+{
+  int num_threads = getNumThreads();
+  int64_t num_chunks = (num_lines + WRITE_CHUNK_LINES - 1) / WRITE_CHUNK_LINES;
+  int64_t batch_chunks = std::max<int64_t>(1, 4 * (int64_t)num_threads);
+
+  std::vector<std::vector<char>> buffers(std::min(batch_chunks, num_chunks));
+  std::vector<size_t> lengths(buffers.size());
+  bool ok = true;
+  for (int64_t batch = 0; ok && batch < num_chunks; batch += batch_chunks)
   {
-    // std::cout << "COO detail: " << coo_3dtensor.num_index_i << ", " << coo_3dtensor.num_index_j << ", " << coo_3dtensor.num_index_k << ", " << coo_3dtensor.num_nonzeros << "\n";
-    std::stable_sort(FileReader.coo_3dtensor->coo_3dtuples, FileReader.coo_3dtensor->coo_3dtuples + FileReader.coo_3dtensor->num_nonzeros, Coo3DTensorComparator());
-    desc_A1pos->data[0] = 0;
-    desc_A1pos->data[1] = FileReader.coo_3dtensor->num_nonzeros;
+    int num_tasks = (int)std::min(batch_chunks, num_chunks - batch);
+    parallelFor(num_tasks, num_threads, [&](int task)
+                {
+                  int64_t first = (batch + task) * WRITE_CHUNK_LINES;
+                  int64_t last = std::min(num_lines, first + WRITE_CHUNK_LINES);
+                  buffers[task].resize((last - first) * max_line_bytes);
+                  char *end = format_lines(first, last, buffers[task].data());
+                  lengths[task] = end - buffers[task].data();
+                });
+    for (int task = 0; ok && task < num_tasks; task++)
+      ok = fwrite(buffers[task].data(), 1, lengths[task], fp) == lengths[task];
+  }
+  return ok;
+}
+
+// Writes the first line of FROSTT files: the size of every dimension, and
+// the number of nonzeros
+template <typename Func>
+bool writeFrosttHeader(FILE *fp, int rank, Func dimension_size, int64_t nnz)
+{
+  string header;
+  for (int k = 0; k < rank; k++)
+    header += std::to_string(dimension_size(k)) + " ";
+  header += std::to_string(nnz) + "\n";
+  return fwrite(header.data(), 1, header.size(), fp) == header.size();
+}
 
-    for (int i = 0; i < FileReader.coo_3dtensor->num_nonzeros; i++)
+/**
+ * A sparse tensor to write, by storage level: the format and the size of
+ * every level, the dimension it stores, and its pos and crd arrays (of 32 or
+ * 64-bit indices). Only CSC stores its dimensions in another order (see
+ * write_sparse_2D).
+ */
+template <typename I>
+struct SparseTensorOutput
+{
+  int rank;
+  std::vector<int32_t> formats;
+  std::vector<int64_t> dims;
+  std::vector<int> dimension;
+  std::vector<const I *> pos, crd;
+  const double *val;
+
+  // number of positions of every storage level; the last is the number of
+  // nonzeros
+  std::vector<int64_t> num_positions;
+
+  void CountPositions()
+  {
+    num_positions.resize(rank);
+    int64_t num_parents = 1;
+    for (int d = 0; d < rank; d++)
     {
-      desc_A1crd->data[i] = FileReader.coo_3dtensor->coo_3dtuples[i].index_i;
-      desc_A2crd->data[i] = FileReader.coo_3dtensor->coo_3dtuples[i].index_j;
-      desc_A3crd->data[i] = FileReader.coo_3dtensor->coo_3dtuples[i].index_k;
-      desc_Aval->data[i] = FileReader.coo_3dtensor->coo_3dtuples[i].val;
+      if (formats[d] == Dense)
+        num_parents *= dims[d];
+      else if (formats[d] == Compressed_unique || formats[d] == Compressed_nonunique)
+        num_parents = pos[d][num_parents];
+      num_positions[d] = num_parents;
     }
   }
-  // CSF
-  else if (A1format == Compressed_unique && A2format == Compressed_unique && A3format == Compressed_unique)
+
+  int64_t NumNonZeros() const { return num_positions[rank - 1]; }
+
+  // size of dimension k
+  int64_t DimensionSize(int k) const
   {
-    Csf3DTensor<T> csf_3dtensor(FileReader.coo_3dtensor);
-    FileReader.FileReaderWrapperFinalize();  // clear coo_3dtensor
+    return dims[std::find(dimension.begin(), dimension.end(), k) - dimension.begin()];
+  }
 
-    // Print
-    // std::cout << "CSF detail: " << csf_3dtensor.num_index_i << ", " << csf_3dtensor.num_index_j << ", " << csf_3dtensor.num_index_k << ", " << csf_3dtensor.num_nonzeros << "\n";
+  // coordinate in dimension d of the position p of level d
+  int64_t Coordinate(int d, int64_t p) const
+  {
+    return (formats[d] == Dense) ? p % dims[d] : (int64_t)crd[d][p];
+  }
 
-    // std::cout << "A1pos: ";
-    // for (int i = 0; i < csf_3dtensor.A1pos_size; i++)
-    // {
-    //   std::cout << csf_3dtensor.A1pos[i] << " ";
-    // }
-    // std::cout << "\n";
-    // std::cout << "A1crd: ";
-    // for (int i = 0; i < csf_3dtensor.A1crd_size; i++)
-    // {
-    //   std::cout << csf_3dtensor.A1crd[i] << " ";
-    // }
-    // std::cout << "\n";
-    // std::cout << "A2pos: ";
-    // for (int i = 0; i < csf_3dtensor.A2pos_size; i++)
-    // {
-    //   std::cout << csf_3dtensor.A2pos[i] << " ";
-    // }
-    // std::cout << "\n";
-    // std::cout << "A2crd: ";
-    // for (int i = 0; i < csf_3dtensor.A2crd_size; i++)
-    // {
-    //   std::cout << csf_3dtensor.A2crd[i] << " ";
-    // }
-    // std::cout << "\n";
-    // std::cout << "A3pos: ";
-    // for (int i = 0; i < csf_3dtensor.A3pos_size; i++)
-    // {
-    //   std::cout << csf_3dtensor.A3pos[i] << " ";
-    // }
-    // std::cout << "\n";
-    // std::cout << "A3crd: ";
-    // for (int i = 0; i < csf_3dtensor.A3crd_size; i++)
-    // {
-    //   std::cout << csf_3dtensor.A3crd[i] << " ";
-    // }
-    // std::cout << "\n";
-    // std::cout << "Aval: ";
-    // for (int i = 0; i < csf_3dtensor.Aval_size; i++)
-    // {
-    //   std::cout << csf_3dtensor.Aval[i] << " ";
-    // }
-    // std::cout << "\n";
+  // position in level d - 1 of the parent of the position p of level d
+  int64_t Parent(int d, int64_t p) const
+  {
+    if (formats[d] == Dense)
+      return p / dims[d];
+    if (formats[d] == singleton)
+      return p;
+    const I *first = pos[d];
+    return std::upper_bound(first, first + num_positions[d - 1] + 1, (I)p) - first - 1;
+  }
 
-    // Fill data
-    for (int i = 0; i < csf_3dtensor.A1pos_size; i++)
-    {
-      desc_A1pos->data[i] = csf_3dtensor.A1pos[i];
-    }
-    for (int i = 0; i < csf_3dtensor.A1crd_size; i++)
-    {
-      desc_A1crd->data[i] = csf_3dtensor.A1crd[i];
-    }
-    for (int i = 0; i < csf_3dtensor.A2pos_size; i++)
-    {
-      desc_A2pos->data[i] = csf_3dtensor.A2pos[i];
-    }
-    for (int i = 0; i < csf_3dtensor.A2crd_size; i++)
+  // Same as Parent, knowing the parent of the previous position p - 1
+  int64_t NextParent(int d, int64_t p, int64_t parent) const
+  {
+    if (formats[d] == Dense || formats[d] == singleton)
+      return Parent(d, p);
+    while ((int64_t)pos[d][parent + 1] <= p)
+      parent++;
+    return parent;
+  }
+
+  /**
+   * Formats the nonzeros [first, last) as lines of coordinates and values.
+   * The path of positions from the first nonzero up to the root is found by
+   * binary searches, and then advanced nonzero after nonzero.
+   */
+  char *FormatLines(int64_t first, int64_t last, char *buf, int64_t base) const
+  {
+    std::vector<int64_t> path(rank), coords(rank);
+    for (int64_t e = first; e < last; e++)
     {
-      desc_A2crd->data[i] = csf_3dtensor.A2crd[i];
+      path[rank - 1] = e;
+      for (int d = rank - 1; d > 0; d--)
+      {
+        int64_t parent = (e == first) ? Parent(d, path[d]) : NextParent(d, path[d], path[d - 1]);
+        if (e != first && parent == path[d - 1])
+          break;
+        path[d - 1] = parent;
+      }
+
+      for (int d = 0; d < rank; d++)
+        coords[dimension[d]] = Coordinate(d, path[d]);
+      for (int d = 0; d < rank; d++)
+      {
+        buf = formatIndex(buf, coords[d] + base);
+        *buf++ = ' ';
+      }
+      buf = formatValue(buf, val[e]);
+      *buf++ = '\n';
     }
-    for (int i = 0; i < csf_3dtensor.A3pos_size; i++)
+    return buf;
+  }
+};
+
+/**
+ * Writes the arrays of a tensor to the binary container, by dimension as the
+ * readers lay them out. Index arrays are written as 64-bit integers. The
+ * dummy entries of the pos and crd arrays of dense and singleton levels are
+ * written as the readers fill them.
+ */
+template <typename I>
+bool writeBinaryOutput(FILE *fp, const string &filename, const SparseTensorOutput<I> &tensor)
+{
+  int rank = tensor.rank;
+  assert(rank <= BINARY_CACHE_MAX_RANK && "ERROR: the rank of the tensor is too large for the binary container.\n");
+
+  BinaryCacheHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, "COMETBIN", 8);
+  header.version = BINARY_CACHE_VERSION;
+  header.value_bytes = sizeof(double);
+  header.source_size = -1; // not built from an input file
+  header.rank = rank;
+  for (int d = 0; d < rank; d++)
+    header.formats[tensor.dimension[d]] = tensor.formats[d];
+  header.path_size = filename.size();
+  header.num_sizes = 3 * rank + 1;
+
+  std::vector<int64_t> sizes(header.num_sizes);
+  std::vector<std::vector<int64_t>> indices(2 * rank);
+  int64_t num_parents = 1;
+  for (int d = 0; d < rank; d++)
+  {
+    int dim = tensor.dimension[d];
+    std::vector<int64_t> &pos = indices[2 * dim];
+    std::vector<int64_t> &crd = indices[2 * dim + 1];
+    int64_t num = tensor.num_positions[d];
+    if (tensor.formats[d] == Dense)
     {
-      desc_A3pos->data[i] = csf_3dtensor.A3pos[i];
+      pos.assign(1, tensor.dims[d]);
+      crd.assign(1, -1);
     }
-    for (int i = 0; i < csf_3dtensor.A3crd_size; i++)
+    else if (tensor.formats[d] == singleton)
     {
-      desc_A3crd->data[i] = csf_3dtensor.A3crd[i];
+      pos.assign(1, -1);
+      crd.assign(tensor.crd[d], tensor.crd[d] + num);
     }
-    for (int i = 0; i < csf_3dtensor.Aval_size; i++)
+    else
     {
-      desc_Aval->data[i] = csf_3dtensor.Aval[i];
+      pos.assign(tensor.pos[d], tensor.pos[d] + num_parents + 1);
+      crd.assign(tensor.crd[d], tensor.crd[d] + num);
     }
+    sizes[2 * dim] = pos.size();
+    sizes[2 * dim + 1] = crd.size();
+    sizes[2 * rank + 1 + dim] = tensor.dims[d];
+    num_parents = num;
   }
-  // Mode-Generic
-  else if (A1format == Compressed_nonunique && A2format == singleton && A3format == Dense)
-  {
-    // std::cout << "Mode-Generic format\n";
-    Mg3DTensor<T> mg_3dtensor(FileReader.coo_3dtensor);
-    FileReader.FileReaderWrapperFinalize();  // clear coo_3dtensor
+  sizes[2 * rank] = tensor.NumNonZeros();
 
-    // Print
-    // std::cout << "ModeGeneric detail: " << mg_3dtensor.num_index_i << ", " << mg_3dtensor.num_index_j << ", " << mg_3dtensor.num_index_k << ", " << mg_3dtensor.num_nonzeros << "\n";
+  std::vector<const void *> arrays;
+  for (auto &index : indices)
+    arrays.push_back(index.data());
+  arrays.push_back(tensor.val);
 
-    // std::cout << "A1pos: ";
-    // for(int i = 0; i < mg_3dtensor.A1pos_size; i++){
-    //   std::cout << mg_3dtensor.A1pos[i] << " " ;
-    // }
-    // std::cout << "\n";
-    // std::cout << "A1crd: ";
-    // for(int i = 0; i < mg_3dtensor.A1crd_size; i++){
-    //   std::cout << mg_3dtensor.A1crd[i] << " " ;
-    // }
-    // std::cout << "\n";
-    // std::cout << "A2crd: ";
-    // for(int i = 0; i < mg_3dtensor.A2crd_size; i++){
-    //   std::cout << mg_3dtensor.A2crd[i] << " " ;
-    // }
-    // std::cout << "\n";
-    // std::cout << "A3pos: ";
-    // for(int i = 0; i < mg_3dtensor.A3pos_size; i++){
-    //   std::cout << mg_3dtensor.A3pos[i] << " " ;
-    // }
-    // std::cout << "\n";
-    // std::cout << "Aval: ";
-    // for(int i = 0; i < mg_3dtensor.Aval_size; i++){
-    //   std::cout << mg_3dtensor.Aval[i] << " " ;
-    // }
-    // std::cout << "\n";
+  return BinaryCacheFile::WriteContents(fp, header, filename, sizes.data(), arrays);
+}
 
-    // Fill data
-    for (int i = 0; i < mg_3dtensor.A1pos_size; i++)
-    {
-      desc_A1pos->data[i] = mg_3dtensor.A1pos[i];
-    }
-    for (int i = 0; i < mg_3dtensor.A1crd_size; i++)
-    {
-      desc_A1crd->data[i] = mg_3dtensor.A1crd[i];
-    }
-    for (int i = 0; i < mg_3dtensor.A2crd_size; i++)
-    {
-      desc_A2crd->data[i] = mg_3dtensor.A2crd[i];
-    }
-    for (int i = 0; i < mg_3dtensor.A3pos_size; i++)
-    {
-      desc_A3pos->data[i] = mg_3dtensor.A3pos[i];
-    }
-    for (int i = 0; i < mg_3dtensor.Aval_size; i++)
-    {
-      desc_Aval->data[i] = mg_3dtensor.Aval[i];
-    }
-    // std::cout << "Finish Mode-generic format conversion\n";
+template <typename I>
+void write_sparse_output(int32_t fileID, SparseTensorOutput<I> &tensor)
+{
+  string filename = getOutputFileName(fileID);
+  assert(!filename.empty() && "ERROR: OUTPUT_FILE_NAME environmental variable is not set");
+  FILE *fp = fopen(filename.c_str(), "wb");
+  if (!fp)
+  {
+    fprintf(stderr, "Error opening file %s\n", filename.c_str());
+    return;
   }
-  else
+
+  tensor.CountPositions();
+  int64_t nnz = tensor.NumNonZeros();
+  int64_t base = 1;
+  bool ok = true;
+  switch (getOutputFormat(filename))
   {
-    assert(false && "unsupported tensor 3D format\n");
+  case OUTPUT_BINARY:
+    ok = writeBinaryOutput(fp, filename, tensor);
+    break;
+  case OUTPUT_MARKET:
+    assert(tensor.rank == 2 && "ERROR: only matrices can be written to Matrix Market files.\n");
+    ok = fprintf(fp, "%%%%MatrixMarket matrix coordinate real general\n%" PRId64 " %" PRId64 " %" PRId64 "\n",
+                 tensor.DimensionSize(0), tensor.DimensionSize(1), nnz) > 0;
+    ok = ok && writeLines(fp, nnz, maxLineBytes(tensor.rank), [&tensor](int64_t first, int64_t last, char *buf)
+                          { return tensor.FormatLines(first, last, buf, 1); });
+    break;
+  case OUTPUT_FROSTT:
+    // the FROSTT reader keeps the coordinates of 3D tensors as they are in
+    // the file, and the matrix readers make them 0-based
+    base = (tensor.rank == 2) ? 1 : 0;
+    ok = writeFrosttHeader(fp, tensor.rank, [&tensor](int k)
+                           { return tensor.DimensionSize(k); },
+                           nnz);
+    ok = ok && writeLines(fp, nnz, maxLineBytes(tensor.rank), [&tensor, base](int64_t first, int64_t last, char *buf)
+                          { return tensor.FormatLines(first, last, buf, base); });
+    break;
   }
+  ok = (fclose(fp) == 0) && ok;
+  if (!ok)
+    fprintf(stderr, "Error writing file %s\n", filename.c_str());
 }
 
-// Utility functions to read sparse matrices and fill in the pos and crd arrays per dimension
-extern "C" void read_input_2D_f32(int32_t fileID, int32_t A1format, int32_t A2format,
-                                  int A1pos_rank, void *A1pos_ptr,
-                                  int A1crd_rank, void *A1crd_ptr,
-                                  int A2pos_rank, void *A2pos_ptr,
-                                  int A2crd_rank, void *A2crd_ptr,
-                                  int Aval_rank, void *Aval_ptr, 
-                                  int32_t readMode)
+template <typename I>
+void write_sparse_2D(int32_t fileID, int32_t A1format, int32_t A2format, int64_t dim1, int64_t dim2,
+                     void *A1pos_ptr, void *A1crd_ptr, void *A2pos_ptr, void *A2crd_ptr, void *Aval_ptr)
 {
-  read_input_2D<float>(fileID, A1format, A2format,
-                       A1pos_rank, A1pos_ptr, A1crd_rank, A1crd_ptr,
-                       A2pos_rank, A2pos_ptr, A2crd_rank, A2crd_ptr,
-                       Aval_rank, Aval_ptr, readMode);
+  SparseTensorOutput<I> tensor;
+  tensor.rank = 2;
+  tensor.formats = {A1format, A2format};
+  tensor.dims = {dim1, dim2};
+  tensor.dimension = {0, 1};
+  tensor.pos = {static_cast<StridedMemRefType<I, 1> *>(A1pos_ptr)->data,
+                static_cast<StridedMemRefType<I, 1> *>(A2pos_ptr)->data};
+  tensor.crd = {static_cast<StridedMemRefType<I, 1> *>(A1crd_ptr)->data,
+                static_cast<StridedMemRefType<I, 1> *>(A2crd_ptr)->data};
+  // CSC keeps the column pointers and the row indices in the arrays of the
+  // first dimension: its levels are the columns (dense), then the rows
+  if (A1format == Compressed_unique && A2format == Dense)
+  {
+    tensor.formats = {Dense, Compressed_unique};
+    tensor.dims = {dim2, dim1};
+    tensor.dimension = {1, 0};
+    std::swap(tensor.pos[0], tensor.pos[1]);
+    std::swap(tensor.crd[0], tensor.crd[1]);
+  }
+  tensor.val = static_cast<StridedMemRefType<double, 1> *>(Aval_ptr)->data;
+  write_sparse_output(fileID, tensor);
 }
 
-extern "C" void read_input_2D_f64(int32_t fileID, int32_t A1format,
-                                  int32_t A2format,
-                                  int A1pos_rank, void *A1pos_ptr,
-                                  int A1crd_rank, void *A1crd_ptr,
-                                  int A2pos_rank, void *A2pos_ptr,
-                                  int A2crd_rank, void *A2crd_ptr,
-                                  int Aval_rank, void *Aval_ptr,
-                                  int32_t readMode)
+template <typename I>
+void write_sparse_3D(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format,
+                     int64_t dim1, int64_t dim2, int64_t dim3,
+                     void *A1pos_ptr, void *A1crd_ptr, void *A2pos_ptr, void *A2crd_ptr,
+                     void *A3pos_ptr, void *A3crd_ptr, void *Aval_ptr)
 {
-  read_input_2D<double>(fileID, A1format, A2format,
-                        A1pos_rank, A1pos_ptr, A1crd_rank, A1crd_ptr,
-                        A2pos_rank, A2pos_ptr, A2crd_rank, A2crd_ptr,
-                        Aval_rank, Aval_ptr, readMode);
+  SparseTensorOutput<I> tensor;
+  tensor.rank = 3;
+  tensor.formats = {A1format, A2format, A3format};
+  tensor.dims = {dim1, dim2, dim3};
+  tensor.dimension = {0, 1, 2};
+  tensor.pos = {static_cast<StridedMemRefType<I, 1> *>(A1pos_ptr)->data,
+                static_cast<StridedMemRefType<I, 1> *>(A2pos_ptr)->data,
+                static_cast<StridedMemRefType<I, 1> *>(A3pos_ptr)->data};
+  tensor.crd = {static_cast<StridedMemRefType<I, 1> *>(A1crd_ptr)->data,
+                static_cast<StridedMemRefType<I, 1> *>(A2crd_ptr)->data,
+                static_cast<StridedMemRefType<I, 1> *>(A3crd_ptr)->data};
+  tensor.val = static_cast<StridedMemRefType<double, 1> *>(Aval_ptr)->data;
+  write_sparse_output(fileID, tensor);
 }
 
-extern "C" void read_input_3D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format,
-                                  int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
-                                  int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
-                                  int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
-                                  int Aval_rank, void *Aval_ptr, int32_t readMode)
+// Writes a dense tensor: to the binary container as a tensor with dense
+// dimensions only, to Matrix Market files in the array format (column by
+// column), and to the others as one line per element
+void write_dense_output(int32_t fileID, const DynamicMemRefType<double> &A)
 {
+  string filename = getOutputFileName(fileID);
+  assert(!filename.empty() && "ERROR: OUTPUT_FILE_NAME environmental variable is not set");
 
-  read_input_3D<float>(fileID, A1format, A2format, A3format,
-                       A1pos_rank, A1pos_ptr, A1crd_rank, A1crd_ptr,
-                       A2pos_rank, A2pos_ptr, A2crd_rank, A2crd_ptr,
-                       A3pos_rank, A3pos_ptr, A3crd_rank, A3crd_ptr,
-                       Aval_rank, Aval_ptr, readMode);
-}
+  int rank = (int)A.rank;
+  int64_t num_elements = 1;
+  for (int d = 0; d < rank; d++)
+    num_elements *= A.sizes[d];
 
-extern "C" void read_input_3D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format,
-                                  int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
-                                  int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
-                                  int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
-                                  int Aval_rank, void *Aval_ptr, int32_t readMode)
-{
+  // offset of the element of linear (row-major) index e
+  auto offset = [&A, rank](int64_t e)
+  {
+    int64_t off = A.offset;
+    for (int d = rank - 1; d >= 0; d--)
+    {
+      off += (e % A.sizes[d]) * A.strides[d];
+      e /= A.sizes[d];
+    }
+    return off;
+  };
 
-  read_input_3D<double>(fileID, A1format, A2format, A3format,
-                        A1pos_rank, A1pos_ptr, A1crd_rank, A1crd_ptr,
-                        A2pos_rank, A2pos_ptr, A2crd_rank, A2crd_ptr,
-                        A3pos_rank, A3pos_ptr, A3crd_rank, A3crd_ptr,
-                        Aval_rank, Aval_ptr, readMode);
+  int format = getOutputFormat(filename);
+  if (format == OUTPUT_BINARY)
+  {
+    std::vector<double> values(num_elements);
+    for (int64_t e = 0; e < num_elements; e++)
+      values[e] = A.data[offset(e)];
+
+    SparseTensorOutput<int64_t> tensor;
+    tensor.rank = rank;
+    tensor.formats.assign(rank, Dense);
+    tensor.dims.assign(A.sizes, A.sizes + rank);
+    for (int d = 0; d < rank; d++)
+      tensor.dimension.push_back(d);
+    tensor.pos.assign(rank, NULL);
+    tensor.crd.assign(rank, NULL);
+    tensor.val = values.data();
+    tensor.CountPositions();
+
+    FILE *fp = fopen(filename.c_str(), "wb");
+    bool ok = fp && writeBinaryOutput(fp, filename, tensor);
+    ok = fp && (fclose(fp) == 0) && ok;
+    if (!ok)
+      fprintf(stderr, "Error writing file %s\n", filename.c_str());
+    return;
+  }
+
+  FILE *fp = fopen(filename.c_str(), "wb");
+  if (!fp)
+  {
+    fprintf(stderr, "Error opening file %s\n", filename.c_str());
+    return;
+  }
+
+  bool ok = true;
+  if (format == OUTPUT_MARKET)
+  {
+    assert(rank == 2 && "ERROR: only matrices can be written to Matrix Market files.\n");
+    ok = fprintf(fp, "%%%%MatrixMarket matrix array real general\n%" PRId64 " %" PRId64 "\n",
+                 A.sizes[0], A.sizes[1]) > 0;
+    // column-major order
+    ok = ok && writeLines(fp, num_elements, maxLineBytes(0), [&A](int64_t first, int64_t last, char *buf)
+                          {
+                            for (int64_t e = first; e < last; e++)
+                            {
+                              int64_t i = e % A.sizes[0], j = e / A.sizes[0];
+                              buf = formatValue(buf, A.data[A.offset + i * A.strides[0] + j * A.strides[1]]);
+                              *buf++ = '\n';
+                            }
+                            return buf;
+                          });
+  }
+  else
+  {
+    ok = writeFrosttHeader(fp, rank, [&A](int k)
+                           { return A.sizes[k]; },
+                           num_elements);
+    ok = ok && writeLines(fp, num_elements, maxLineBytes(rank), [&A, rank, &offset](int64_t first, int64_t last, char *buf)
+                    {
+                      std::vector<int64_t> coords(rank);
+                      for (int64_t e = first; e < last; e++)
+                      {
+                        int64_t rest = e;
+                        for (int d = rank - 1; d >= 0; d--)
+                        {
+                          coords[d] = rest % A.sizes[d];
+                          rest /= A.sizes[d];
+                        }
+                        for (int d = 0; d < rank; d++)
+                        {
+                          buf = formatIndex(buf, coords[d] + 1);
+                          *buf++ = ' ';
+                        }
+                        buf = formatValue(buf, A.data[offset(e)]);
+                        *buf++ = '\n';
+                      }
+                      return buf;
+                    });
+  }
+  ok = (fclose(fp) == 0) && ok;
+  if (!ok)
+    fprintf(stderr, "Error writing file %s\n", filename.c_str());
 }
 
-// Utility functions to read metadata about the input matrices, such as the size of pos and crd array
-extern "C" void read_input_sizes_2D_f32(int32_t fileID, int32_t A1format, int32_t A2format,
-                                        int A1pos_rank, void *A1pos_ptr, int32_t readMode)
+// Write result tensors to the file of OUTPUT_FILE_NAME<fileID>
+extern "C" void comet_write_dense_f64(int32_t fileID, int64_t rank, void *ptr)
 {
-  read_input_sizes_2D<float>(fileID, A1format, A2format, A1pos_rank, A1pos_ptr, readMode);
+  UnrankedMemRefType<double> A = {rank, ptr};
+  write_dense_output(fileID, DynamicMemRefType<double>(A));
 }
 
-extern "C" void read_input_sizes_2D_f64(int32_t fileID, int32_t A1format, int32_t A2format,
-//                                        int A1pos_rank, void *A1pos_ptr, char *filename, int32_t readMode)
-                                        int A1pos_rank, void *A1pos_ptr, int32_t readMode)
+extern "C" void comet_write_sparse_2D_f64(int32_t fileID, int32_t A1format, int32_t A2format,
+                                          int64_t dim1, int64_t dim2,
+                                          int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                          int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                          int Aval_rank, void *Aval_ptr)
 {
-  read_input_sizes_2D<double>(fileID, A1format, A2format, A1pos_rank, A1pos_ptr, readMode);
+  write_sparse_2D<int64_t>(fileID, A1format, A2format, dim1, dim2,
+                           A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr, Aval_ptr);
 }
 
-// Read 3D tensors
-extern "C" void read_input_sizes_3D_f32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format,
-                                        int A1pos_rank, void *A1pos_ptr, int32_t readMode)
+extern "C" void comet_write_sparse_3D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format,
+                                          int64_t dim1, int64_t dim2, int64_t dim3,
+                                          int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                          int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                          int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                          int Aval_rank, void *Aval_ptr)
 {
-  read_input_sizes_3D<float>(fileID, A1format, A2format, A3format, A1pos_rank, A1pos_ptr, readMode);
+  write_sparse_3D<int64_t>(fileID, A1format, A2format, A3format, dim1, dim2, dim3,
+                           A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr, A3pos_ptr, A3crd_ptr, Aval_ptr);
 }
 
-extern "C" void read_input_sizes_3D_f64(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format,
-                                        int A1pos_rank, void *A1pos_ptr, int32_t readMode)
+// Same as above, for tensors with 32-bit pos and crd arrays
+extern "C" void comet_write_sparse_2D_f64_i32(int32_t fileID, int32_t A1format, int32_t A2format,
+                                              int64_t dim1, int64_t dim2,
+                                              int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                              int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                              int Aval_rank, void *Aval_ptr)
 {
-  read_input_sizes_3D<double>(fileID, A1format, A2format, A3format, A1pos_rank, A1pos_ptr, readMode);
+  write_sparse_2D<int32_t>(fileID, A1format, A2format, dim1, dim2,
+                           A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr, Aval_ptr);
 }
 
-int qsort_comp(const void *a, const void *b)
+extern "C" void comet_write_sparse_3D_f64_i32(int32_t fileID, int32_t A1format, int32_t A2format, int32_t A3format,
+                                              int64_t dim1, int64_t dim2, int64_t dim3,
+                                              int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                              int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                              int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                              int Aval_rank, void *Aval_ptr)
 {
-  return *((const int64_t *)a) - *((const int64_t *)b);
+  write_sparse_3D<int32_t>(fileID, A1format, A2format, A3format, dim1, dim2, dim3,
+                           A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr, A3pos_ptr, A3crd_ptr, Aval_ptr);
 }
 
+
 // Sort by rows, then columns
 struct qsortComparator
 {
@@ -2206,8 +5698,8 @@ struct qsortComparator
   }
 };
 
-extern "C" void quick_sort(int sizes_rank, void *sizes_ptr, int length)
+extern "C" void quick_sort(int sizes_rank, void *sizes_ptr, int64_t length)
 {
   auto *desc_ptr = static_cast<StridedMemRefType<int64_t, 1> *>(sizes_ptr);
-  std::qsort(desc_ptr->data, length, sizeof(int64_t), qsort_comp);
+  std::sort(desc_ptr->data, desc_ptr->data + length);
 }
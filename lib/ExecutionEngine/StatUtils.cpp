@@ -31,9 +31,15 @@
 #include <cstdio>
 #include <limits>
 #include <iomanip>
+#include <mutex>
 
 #include <random>
 
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
 //===----------------------------------------------------------------------===//
 // Small runtime support library for print some statistics.
 //===----------------------------------------------------------------------===//
@@ -85,14 +91,149 @@ extern "C" void print_space()
 //===----------------------------------------------------------------------===//
 // Small runtime support library for printing output scalar and tensors
 //===----------------------------------------------------------------------===//
+
+// Returns the file descriptor of the binary dump mode, or -1 if it is off.
+// COMET_PRINT_BINARY is a file descriptor number (e.g., 1 for stdout) or a
+// file name, which is truncated at the first print.
+static int getPrintDumpFd()
+{
+  static int fd = -1;
+  static std::once_flag once;
+  std::call_once(once, []
+                 {
+                   const char *env = getenv("COMET_PRINT_BINARY");
+                   if (!env || !*env)
+                     return;
+                   char *end;
+                   long n = strtol(env, &end, 10);
+                   if (*end == '\0' && n >= 0)
+                     fd = (int)n;
+                   else
+                   {
+                     fd = open(env, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+                     if (fd < 0)
+                       fprintf(stderr, "Cannot open COMET_PRINT_BINARY file %s, printing as text\n", env);
+                   }
+                 });
+  return fd;
+}
+
+// Writes all the buffers, resuming after partial writes
+static bool writeAll(int fd, struct iovec *iov, int iovcnt)
+{
+  while (iovcnt > 0)
+  {
+    ssize_t n = writev(fd, iov, iovcnt);
+    if (n < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    while (iovcnt > 0 && (size_t)n >= iov->iov_len)
+    {
+      n -= iov->iov_len;
+      iov++;
+      iovcnt--;
+    }
+    if (iovcnt > 0)
+    {
+      iov->iov_base = (char *)iov->iov_base + n;
+      iov->iov_len -= n;
+    }
+  }
+  return true;
+}
+
+// Copies the elements of M in row-major order
+template <typename T>
+static void packData(T *out, const T *base, int64_t dim, int64_t offset,
+                     const int64_t *sizes, const int64_t *strides, int64_t &pos)
+{
+  if (dim == 0)
+  {
+    out[pos++] = base[offset];
+    return;
+  }
+  for (int64_t i = 0; i < sizes[0]; i++)
+    packData(out, base, dim - 1, offset + i * strides[0], sizes + 1, strides + 1, pos);
+}
+
+// Writes M as a binary dump record. The elements of contiguous memrefs are
+// written from their buffer, the others are packed first.
+template <typename T>
+static void cometDumpMemRef(int fd, const DynamicMemRefType<T> &M, CometPrintDumpType type)
+{
+  CometPrintDumpHeader header;
+  memcpy(header.magic, COMET_PRINT_DUMP_MAGIC, sizeof(header.magic));
+  header.version = COMET_PRINT_DUMP_VERSION;
+  header.type = type;
+  header.rank = M.rank;
+
+  bool contiguous = true;
+  int64_t num_elements = 1;
+  for (int64_t d = M.rank - 1; d >= 0; d--)
+  {
+    if (M.sizes[d] != 1 && M.strides[d] != num_elements)
+      contiguous = false;
+    num_elements *= M.sizes[d];
+  }
+  header.num_elements = num_elements;
+
+  std::vector<T> packed;
+  const T *data = M.data + M.offset;
+  if (!contiguous && num_elements > 0)
+  {
+    packed.resize(num_elements);
+    int64_t pos = 0;
+    packData(packed.data(), M.data, M.rank, M.offset, M.sizes, M.strides, pos);
+    data = packed.data();
+  }
+
+  struct iovec iov[3];
+  iov[0].iov_base = &header;
+  iov[0].iov_len = sizeof(header);
+  iov[1].iov_base = (void *)M.sizes;
+  iov[1].iov_len = M.rank * sizeof(int64_t);
+  iov[2].iov_base = (void *)data;
+  iov[2].iov_len = num_elements * sizeof(T);
+
+  // records of concurrent prints must not interleave
+  static std::mutex dump_mutex;
+  std::lock_guard<std::mutex> lock(dump_mutex);
+  if (!writeAll(fd, iov, 3))
+    fprintf(stderr, "Error writing COMET_PRINT_BINARY record: %s\n", strerror(errno));
+}
+
+// Prints M as text, or dumps it in binary if COMET_PRINT_BINARY is set
+template <typename T>
+static void cometPrintOrDumpMemRef(UnrankedMemRefType<T> &M, CometPrintDumpType type)
+{
+  int fd = getPrintDumpFd();
+  if (fd < 0)
+  {
+    cometPrintMemRef(M);
+    return;
+  }
+  // text printed before must come before the record
+  std::cout.flush();
+  fflush(stdout);
+  cometDumpMemRef(fd, DynamicMemRefType<T>(M), type);
+}
+
 extern "C" void _mlir_ciface_comet_print_memref_f64(UnrankedMemRefType<double> *M)
 {
-  cometPrintMemRef(*M);
+  cometPrintOrDumpMemRef(*M, PRINT_DUMP_F64);
 }
 
 extern "C" void _mlir_ciface_comet_print_memref_i64(UnrankedMemRefType<int64_t> *M)
 {
-  cometPrintMemRef(*M);
+  cometPrintOrDumpMemRef(*M, PRINT_DUMP_I64);
+}
+
+extern "C" void _mlir_ciface_comet_print_memref_i32(UnrankedMemRefType<int32_t> *M)
+{
+  cometPrintOrDumpMemRef(*M, PRINT_DUMP_I32);
 }
 
 extern "C" void comet_print_memref_f64(int64_t rank, void *ptr)
@@ -105,4 +246,10 @@ extern "C" void comet_print_memref_i64(int64_t rank, void *ptr)
 {
   UnrankedMemRefType<int64_t> descriptor = {rank, ptr};
   _mlir_ciface_comet_print_memref_i64(&descriptor);
+}
+
+extern "C" void comet_print_memref_i32(int64_t rank, void *ptr)
+{
+  UnrankedMemRefType<int32_t> descriptor = {rank, ptr};
+  _mlir_ciface_comet_print_memref_i32(&descriptor);
 }
\ No newline at end of file
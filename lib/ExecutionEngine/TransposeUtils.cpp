@@ -28,12 +28,17 @@
 //===----------------------------------------------------------------------===//
 
 #include "comet/ExecutionEngine/RunnerUtils.h"
+#include "comet/ExecutionEngine/ParallelUtils.h"
 
 #include <vector>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <stdlib.h>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <random>
 
 // Parallel sorting algorithms
 #include <algorithm>
@@ -42,19 +47,25 @@ using namespace std;
 
 enum SortingOption
 {
-  NO_SORT = 1, // default: re-traverse instead of sorting
+  HISTOGRAM = 0, // counting sort by each output dimension
+  NO_SORT = 1, // re-traverse instead of sorting
   SEQ_QSORT = 2,
   PAR_QSORT = 3,
   RADIX_BUCKET = 4,
   COUNT_RADIX = 5,
-  COUNT_QUICK = 6
+  COUNT_QUICK = 6,
+  AUTO = 7 // default: picks HISTOGRAM, RADIX_BUCKET or PAR_QSORT from a cost model
 };
 
 void getSortType(int &selected_sort_type) {
   selected_sort_type = -1;
   if (getenv("SORT_TYPE")) {
     char *sort_type = getenv("SORT_TYPE");
-    if (strcmp(sort_type, "NO_SORT") == 0) 
+    if (strcmp(sort_type, "AUTO") == 0)
+      selected_sort_type = AUTO;
+    else if (strcmp(sort_type, "HISTOGRAM") == 0)
+      selected_sort_type = HISTOGRAM;
+    else if (strcmp(sort_type, "NO_SORT") == 0) 
       selected_sort_type = NO_SORT;
     else if (strcmp(sort_type, "SEQ_QSORT") == 0) 
       selected_sort_type = SEQ_QSORT;
@@ -68,381 +79,583 @@ void getSortType(int &selected_sort_type) {
       selected_sort_type = COUNT_QUICK;
     else 
       assert(selected_sort_type != -1 && "\n\nError: SORT_TYPE environmental variable for sparse transpose is not recognized!\n"
-             "\tValid Options are: NO_SORT, SEQ_QSORT, PAR_QSORT, RADIX_BUCKET, COUNT_RADIX, COUNT_QUICK.\n\n\n");
+             "\tValid Options are: AUTO, HISTOGRAM, NO_SORT, SEQ_QSORT, PAR_QSORT, RADIX_BUCKET, COUNT_RADIX, COUNT_QUICK.\n\n\n");
   } else {
-    selected_sort_type = NO_SORT; // default
+    selected_sort_type = AUTO; // default
   }
 }
 
+/**
+ * Coordinates of the nonzeros of a sparse tensor, in structure-of-arrays
+ * layout: one flat array per dimension. The order of the nonzeros is kept
+ * apart in a permutation, so sorting moves 8-byte indices (or packed keys)
+ * and never the coordinates themselves.
+ */
 struct coo_t
 {
-  vector<int32_t> coords;
-  double val;
+  vector<vector<int64_t>> coords; // coords[d][e]: coordinate of nonzero e in dimension d
+  vector<int64_t> perm;           // perm[i]: nonzero at position i of the order
+
+  coo_t(int num_dims, int64_t nnz) : coords(num_dims, vector<int64_t>(nnz)), perm(nnz)
+  {
+    for (int64_t e = 0; e < nnz; e++)
+      perm[e] = e;
+  }
+
+  int num_dims() const { return (int)coords.size(); }
+  int64_t size() const { return (int64_t)perm.size(); }
+
+  // coordinate in dimension d of the nonzero at position i
+  int64_t crd(int d, int64_t i) const { return coords[d][perm[i]]; }
 };
 
-struct bucket
+// A packed key and the nonzero it belongs to
+template <typename Key>
+struct sort_entry_t
 {
-  int left;
-  int right;
+  Key key;
+  int64_t nz;
 };
 
 //===----------------------------------------------------------------------===//
 // Different sorting algorithms
 //===----------------------------------------------------------------------===//
 
-bool sort_compare_coords(struct coo_t p, struct coo_t q)
+template <typename Key>
+bool sort_compare_keys(const sort_entry_t<Key> &p, const sort_entry_t<Key> &q)
 {
-  // Get the values at given addresses
-  struct coo_t l = p;
-  struct coo_t r = q;
+  return p.key < q.key;
+}
 
-  for (unsigned long i = 0; i < l.coords.size(); ++i)
-  {
-    if (l.coords[i] < r.coords[i])
-    {
-      return true;
-    }
-    else if (l.coords[i] > r.coords[i])
-    {
-      return false;
-    }
-  }
-  return false;
+template <typename Key>
+int qsort_compare_keys(const void *p, const void *q)
+{
+  const Key l = ((const sort_entry_t<Key> *)p)->key;
+  const Key r = ((const sort_entry_t<Key> *)q)->key;
+  return (l < r) ? -1 : (l > r);
 }
 
-int qsort_compare_coords(const void *p, const void *q)
+// Number of threads to sort n entries with: COMET_NUM_THREADS at most,
+// and no more than one thread per 32K entries
+int sort_threads(int64_t n)
 {
-  // Get the values at given addresses
-  const struct coo_t l = *(const struct coo_t *)p;
-  const struct coo_t r = *(const struct coo_t *)q;
+  const int64_t min_entries_per_thread = 1 << 15;
+  int64_t num_threads = std::min<int64_t>(getNumThreads(), n / min_entries_per_thread);
+  return num_threads > 1 ? (int)num_threads : 1;
+}
+
+// first entry of the slice of thread t, when n entries are split in num_threads slices
+inline int64_t slice_begin(int64_t n, int t, int num_threads)
+{
+  return n * t / num_threads;
+}
 
-  for (unsigned long i = 0; i < l.coords.size(); ++i)
+/**
+ * @brief Stable parallel counting sort pass: every thread counts the keys of
+ * its slice of the entries, the counts are turned into the output offset
+ * of every (key, thread) pair, and every thread scatters its slice.
+ *
+ * @param key_of returns the key of an entry, in [0, num_keys)
+ * @param offsets if not NULL, gets the num_keys + 1 offsets of each key in the output
+ */
+template <typename Entry, typename KeyOf>
+void parallel_counting_pass(const vector<Entry> &ary, vector<Entry> &sorted, int64_t num_keys,
+                            KeyOf key_of, int num_threads, vector<int64_t> *offsets = NULL)
+{
+  int64_t n = ary.size();
+  vector<vector<int64_t>> counts(num_threads, vector<int64_t>(num_keys, 0));
+  parallelFor(num_threads, num_threads, [&](int t)
+              {
+                vector<int64_t> &count = counts[t];
+                for (int64_t i = slice_begin(n, t, num_threads); i < slice_begin(n, t + 1, num_threads); i++)
+                  count[key_of(ary[i])]++;
+              });
+
+  // entries with the same key are laid out by thread, so the pass is stable
+  int64_t sum = 0;
+  if (offsets)
+    offsets->assign(num_keys + 1, 0);
+  for (int64_t k = 0; k < num_keys; k++)
   {
-    if (l.coords[i] < r.coords[i])
+    if (offsets)
+      (*offsets)[k] = sum;
+    for (int t = 0; t < num_threads; t++)
     {
-      return -1;
-    }
-    else if (l.coords[i] > r.coords[i])
-    {
-      return 1;
+      int64_t count = counts[t][k];
+      counts[t][k] = sum;
+      sum += count;
     }
   }
-  return 0;
+  if (offsets)
+    (*offsets)[num_keys] = sum;
+
+  sorted.resize(n);
+  parallelFor(num_threads, num_threads, [&](int t)
+              {
+                vector<int64_t> &offset = counts[t];
+                for (int64_t i = slice_begin(n, t, num_threads); i < slice_begin(n, t + 1, num_threads); i++)
+                  sorted[offset[key_of(ary[i])]++] = ary[i];
+              });
 }
 
-bool sort_compare_coord_2(struct coo_t p, struct coo_t q)
+// Number of threads of a counting pass of n entries over num_keys keys:
+// the per-thread counts should not outweigh the entries
+int histogram_threads(int64_t n, int64_t num_keys)
 {
-  // sort with k dimension as the key in (i, j, k)
-  return (p.coords[2] < q.coords[2]);
+  int num_threads = sort_threads(n);
+  if (num_keys > 0)
+    num_threads = (int)std::max<int64_t>(1, std::min<int64_t>(num_threads, 2 * n / num_keys));
+  return num_threads;
 }
 
-bool sort_compare_coord_1(struct coo_t p, struct coo_t q)
+/**
+ * @brief Stable counting sort of n entries by key: fills order with the
+ * entries in increasing key order, entries with the same key keeping their
+ * order in the input order (or in 0..n-1 if the input order is empty).
+ * Runs in O(n + num_keys).
+ *
+ * @param key key of each entry, in [0, num_keys)
+ * @param num_keys number of distinct keys
+ * @param order the entries to sort (input) and the sorted entries (output)
+ * @param offsets if not NULL, gets the num_keys + 1 offsets of each key in order
+ */
+void histogram_sort(const int64_t *key, int64_t n, int64_t num_keys,
+                    vector<int64_t> &order, vector<int64_t> *offsets = NULL)
 {
-  // sort with j dimension as the key in (i, j, k)
-  return (p.coords[1] < q.coords[1]);
+  if (order.empty())
+  {
+    order.resize(n);
+    for (int64_t i = 0; i < n; i++)
+      order[i] = i;
+  }
+
+  int num_threads = histogram_threads(n, num_keys);
+  vector<int64_t> sorted;
+  parallel_counting_pass(order, sorted, num_keys, [key](int64_t e)
+                         { return key[e]; },
+                         num_threads, offsets);
+  order.swap(sorted);
 }
 
-bool sort_compare_coord_0(struct coo_t p, struct coo_t q)
+// returns the number of distinct keys in key[0..n), taken as max + 1
+int64_t num_histogram_keys(const int64_t *key, int64_t n)
 {
-  // sort with i dimension as the key in (i, j, k)
-  return (p.coords[0] < q.coords[0]);
+  int64_t maxx = -1;
+  for (int64_t i = 0; i < n; i++)
+    maxx = std::max(maxx, key[i]);
+  return maxx + 1;
 }
 
-// A function to swap two elements
-void swap(struct coo_t *a, struct coo_t *b)
+// stable counting sort of the nonzeros by their coordinate in dimension d
+void count_sort(coo_t &coo, int d)
 {
-  struct coo_t t = *a;
-  *a = *b;
-  *b = t;
+  const int64_t *key = coo.coords[d].data();
+  histogram_sort(key, coo.size(), num_histogram_keys(key, coo.size()), coo.perm);
 }
 
-/* This function takes last element as pivot, places
-the pivot element at its correct position in sorted
-array, and places all smaller (smaller than pivot) to
-left of pivot and all greater elements to right of pivot */
-int partition(vector<struct coo_t> &ary, int low, int high, int mod)
+// LSD radix sort of the packed keys, one byte per pass, each pass in
+// parallel with per-thread histograms
+template <typename Key>
+void radix_bucket(vector<sort_entry_t<Key>> &ary, int key_bits)
 {
-  // pivot
-  struct coo_t pivot = ary[high];
-  // Index of smaller element and indicates the right position of pivot found so far
-  int i = (low - 1);
-
-  for (int j = low; j <= high - 1; j++)
+  int num_threads = sort_threads(ary.size());
+  vector<sort_entry_t<Key>> sorted;
+  for (int shift = 0; shift < key_bits; shift += 8)
   {
-    // If current element is smaller than the pivot
-    if (ary[j].coords[mod] < pivot.coords[mod])
-    {
-      i++; // increment index of smaller element
-      swap(&ary[i], &ary[j]);
-    }
+    parallel_counting_pass(ary, sorted, 256, [shift](const sort_entry_t<Key> &entry)
+                           { return (int64_t)((entry.key >> shift) & 0xff); },
+                           num_threads);
+    ary.swap(sorted);
   }
-  swap(&ary[i + 1], &ary[high]);
-  return (i + 1);
 }
 
-/* The QuickSort function
-arr[] --> Array to be sorted,
-low --> Starting index,
-high --> Ending index,
-mod --> the coords mode to sort on (0, 1, 2, 3, ..)
-*/
-void quick_sort(vector<struct coo_t> &ary, int low, int high, int mod)
+// Merge sort in parallel: every thread sorts a slice, and the sorted
+// slices are merged pairwise, the merges of a round in parallel
+template <typename Entry, typename Compare>
+void parallel_merge_sort(vector<Entry> &ary, Compare comp)
 {
-  if (low < high)
+  int64_t n = ary.size();
+  int num_threads = sort_threads(n);
+  if (num_threads <= 1)
   {
-    /* pi is partitioning index, ary[p] is now at right place */
-    int pi = partition(ary, low, high, mod);
+    sort(ary.begin(), ary.end(), comp);
+    return;
+  }
+
+  parallelFor(num_threads, num_threads, [&](int t)
+              { sort(ary.begin() + slice_begin(n, t, num_threads), ary.begin() + slice_begin(n, t + 1, num_threads), comp); });
 
-    // Separately sort elements before
-    // partition and after partition
-    quick_sort(ary, low, pi - 1, mod);
-    quick_sort(ary, pi + 1, high, mod);
+  vector<Entry> merged(n);
+  for (int width = 1; width < num_threads; width *= 2)
+  {
+    int num_merges = (num_threads + 2 * width - 1) / (2 * width);
+    parallelFor(num_merges, num_merges, [&](int m)
+                {
+                  int64_t lo = slice_begin(n, 2 * m * width, num_threads);
+                  int64_t mid = slice_begin(n, std::min(2 * m * width + width, num_threads), num_threads);
+                  int64_t hi = slice_begin(n, std::min(2 * m * width + 2 * width, num_threads), num_threads);
+                  std::merge(ary.begin() + lo, ary.begin() + mid, ary.begin() + mid, ary.begin() + hi,
+                             merged.begin() + lo, comp);
+                });
+    ary.swap(merged);
   }
 }
 
-void count_sort(vector<struct coo_t> &ary, int n, int mode)
+// This hybrid sort function that combines count sort and quick sort,
+// which use count sort for the 1st mode, and then quick sort on the
+// remaining modes within buckets
+template <typename Key>
+void count_quick(vector<sort_entry_t<Key>> &ary, const coo_t &coo)
 {
-  // count sort for mode m
-  vector<coo_t> sorted_ary(n);
-  int maxx = 0, i;
-  for (i = 0; i < n; i++)
+  vector<int64_t> buckets(1, 0);
+  for (int64_t i = 1; i <= coo.size(); i++)
   {
-    if (maxx < ary[i].coords[mode])
-      maxx = ary[i].coords[mode];
+    if (i == coo.size() || coo.crd(0, i) != coo.crd(0, i - 1))
+      buckets.push_back(i);
   }
-  // Create a count array to store count of individual
-  // characters and initialize count array as 0
-  vector<int> count(maxx + 1);
-  fill(count.begin(), count.end(), 0);
-
-  // Store count of each number
-  for (i = 0; i < n; ++i)
-    ++count[ary[i].coords[mode]];
-
-  // Change count[i] so that count[i] now contains actual
-  // position of this character in output array
-  for (i = 1; i <= maxx; ++i)
+
+  int num_buckets = (int)buckets.size() - 1;
+  parallelFor(num_buckets, sort_threads(coo.size()), [&](int b)
+              { sort(ary.begin() + buckets[b], ary.begin() + buckets[b + 1], sort_compare_keys<Key>); });
+}
+
+/**
+ * @brief Sorts the nonzeros by keys that pack their coordinates, the first
+ * dimension in the most significant bits: the keys compare like the
+ * coordinates in lexicographic order.
+ *
+ * @param bits number of bits of the coordinates of each dimension
+ */
+template <typename Key>
+void sort_packed_keys(int sort_type, coo_t &coo, const vector<int> &bits)
+{
+  int64_t n = coo.size();
+  int key_bits = 0;
+  for (int b : bits)
+    key_bits += b;
+
+  if (sort_type == COUNT_QUICK)
+    count_sort(coo, 0);
+
+  vector<sort_entry_t<Key>> entries(n);
+  for (int64_t i = 0; i < n; i++)
   {
-    count[i] += count[i - 1];
+    int64_t e = coo.perm[i];
+    Key key = 0;
+    for (int d = 0; d < coo.num_dims(); d++)
+      key = (key << bits[d]) | (Key)coo.coords[d][e];
+    entries[i].key = key;
+    entries[i].nz = e;
   }
 
-  // Build the output character array
-  for (i = n - 1; i >= 0; --i)
+  switch (sort_type)
   {
-    sorted_ary[count[ary[i].coords[mode]] - 1] = ary[i];
-    --count[ary[i].coords[mode]];
+  case SEQ_QSORT:
+    std::qsort((void *)entries.data(), n, sizeof(sort_entry_t<Key>), qsort_compare_keys<Key>);
+    break;
+  case PAR_QSORT:
+    parallel_merge_sort(entries, sort_compare_keys<Key>);
+    break;
+  case RADIX_BUCKET:
+    radix_bucket(entries, key_bits);
+    break;
+  case COUNT_QUICK:
+    count_quick(entries, coo);
+    break;
   }
 
-  // Copy the sorted array to arr
-  for (i = 0; i < n; ++i)
-    ary[i] = sorted_ary[i];
+  for (int64_t i = 0; i < n; i++)
+    coo.perm[i] = entries[i].nz;
 }
 
-void radix_bucket(vector<struct coo_t> &ary, int n)
+// number of bits taken by value
+int value_bits(int64_t value)
 {
-  int bucket_cnt[10];
-  int i, j, k, r, NOP = 0 /*#digits*/, divisor = 1, maxx = 0, pass1, pass2;
-  struct coo_t **bucket = new struct coo_t *[10];
+  int bits = 0;
+  while (bits < 63 && (value >> bits) != 0)
+    bits++;
+  return bits;
+}
 
-  for (i = 0; i < 10; i++)
-  {
-    bucket[i] = new struct coo_t[n];
-  }
+// number of bits taken by the largest coordinate in crd
+int coord_bits(const vector<int64_t> &crd)
+{
+  int64_t maxx = 0;
+  for (int64_t c : crd)
+    maxx = std::max(maxx, c);
+  return value_bits(maxx);
+}
 
-  for (pass1 = 1; pass1 >= 0; pass1--)
-  {
-    // find the max val
-    maxx = 0;
-    for (i = 0; i < n; i++)
-    {
-      if (maxx < ary[i].coords[pass1])
-        maxx = ary[i].coords[pass1];
-    }
+// largest packed key the sorts support, in bits
+#ifdef __SIZEOF_INT128__
+const int max_key_bits = 128;
+#else
+const int max_key_bits = 64;
+#endif
 
-    // digists
-    NOP = 0;
-    while (maxx != 0)
-    {
-      maxx = maxx / 10;
-      ++NOP;
-    }
+/**
+ * Costs that the AUTO option compares the sorting algorithms with, in
+ * nanoseconds of a single thread. The defaults were measured on a x86-64
+ * server; COMET_SORT_CALIBRATION measures them on the host instead (see
+ * getSortCosts).
+ */
+struct sort_costs_t
+{
+  double count_pass; // per entry, per counting pass
+  double count_key;  // per key and thread, per counting pass
+  double radix_pass; // per entry, per byte of the packed keys
+  double compare;    // per entry, per log2 of the number of entries
+};
 
-    divisor = 1;
-    for (pass2 = 0; pass2 < NOP; pass2++)
-    {
-      for (i = 0; i < 10; i++)
-      {
-        bucket_cnt[i] = 0;
-      }
-      for (i = 0; i < n; i++)
-      {
-        r = (ary[i].coords[pass1] / divisor) % 10;
-        bucket[r][bucket_cnt[r]] = ary[i];
-        bucket_cnt[r] += 1;
-      }
-      i = 0;
-      for (k = 0; k < 10; k++)
-      {
-        for (j = 0; j < bucket_cnt[k]; j++)
-        {
-          ary[i] = bucket[k][j];
-          i++;
-        }
-      }
-      divisor *= 10;
-    }
-  }
+const sort_costs_t &getSortCosts();
+
+/**
+ * @brief Picks the algorithm of the AUTO option: the counting sort
+ * (HISTOGRAM), the radix sort of packed keys (RADIX_BUCKET) or the
+ * comparison sort (PAR_QSORT) with the lowest estimated time.
+ *
+ * @param n number of nonzeros
+ * @param pass_keys number of keys of each counting pass, i.e., extent of
+ *      each output dimension the nonzeros need to be sorted by
+ * @param key_bits number of bits of the packed keys
+ */
+int chooseSortType(int64_t n, const vector<int64_t> &pass_keys, int key_bits)
+{
+  const sort_costs_t &costs = getSortCosts();
+  int num_threads = sort_threads(n);
 
-  // deallocate array
-  for (i = 0; i < 10; i++)
+  double counting = 0;
+  for (int64_t num_keys : pass_keys)
   {
-    delete[] bucket[i];
+    int threads = histogram_threads(n, num_keys);
+    counting += costs.count_pass * n / threads + costs.count_key * num_keys * threads;
   }
-  delete[] bucket;
+
+  double radix = std::numeric_limits<double>::infinity();
+  if (key_bits <= max_key_bits)
+    radix = costs.radix_pass * n * ((key_bits + 7) / 8) / num_threads;
+
+  double comparison = costs.compare * n * std::log2((double)std::max<int64_t>(n, 2)) / num_threads;
+
+  if (counting <= radix && counting <= comparison)
+    return HISTOGRAM;
+  return (radix <= comparison) ? RADIX_BUCKET : PAR_QSORT;
 }
 
-// generate buckets for next sorting based on mode in question
-void generate_buckets(vector<coo_t> &coo_ts, int mode, vector<bucket> &buckets)
+/**
+ * @brief Number of trailing output dimensions the nonzeros are already in
+ * order of. When the nonzeros are sorted by the input dimensions, a stable
+ * sort by the leading output dimensions keeps them in order of the trailing
+ * ones, as long as these come in the same relative order in the input.
+ *
+ * @param out_dims out_dims[d] is the input dimension that becomes output dimension d
+ */
+int presorted_dims(const coo_t &coo, const int *out_dims)
 {
-  int count = 1;
-  vector<int> counts;
-  counts.push_back(0);
-  for (unsigned long i = 1; i < coo_ts.size(); i++)
+  int num_dims = coo.num_dims();
+  vector<const int64_t *> in_crds(num_dims);
+  for (int d = 0; d < num_dims; d++)
+    in_crds[out_dims[d]] = coo.coords[d].data();
+
+  for (int64_t e = 1; e < coo.size(); e++)
   {
-    if (coo_ts[i].coords[mode] == coo_ts[i - 1].coords[mode])
-    {
-      count++;
-    }
-    else
+    for (int d = 0; d < num_dims; d++)
     {
-      counts.push_back(count);
-      count++;
+      if (in_crds[d][e - 1] < in_crds[d][e])
+        break;
+      if (in_crds[d][e - 1] > in_crds[d][e])
+        return 0; // not sorted
     }
   }
-  counts.push_back(count);
 
-  // merge previous bucket into new counts
-  for (unsigned long i = 0; i < buckets.size(); i++)
+  int m = 1;
+  while (m < num_dims && out_dims[num_dims - m - 1] < out_dims[num_dims - m])
+    m++;
+  return m;
+}
+
+//===----------------------------------------------------------------------===//
+//===----------------------------------------------------------------------===//
+/**
+ * @brief Differet sorting algorithm for sparse transpse taking COO coordinates as input
+ *
+ * @param sort_type specify the sort algorithm to use
+ * @param coo the COO coordinates of the nonzeros, in output dimension order:
+ *      for example, (j, i) for a 2D transpose. Its permutation is sorted.
+ * @param presorted number of trailing dimensions the nonzeros are already
+ *      in order of (see presorted_dims), which the counting sort skips
+ */
+void transpose_sort(int sort_type, coo_t &coo, int presorted = 0)
+{
+  int num_dims = coo.num_dims();
+  if (sort_type == AUTO)
   {
-    counts.push_back(buckets[i].right);
+    vector<int64_t> pass_keys;
+    for (int d = 0; d < num_dims - presorted; d++)
+      pass_keys.push_back(num_histogram_keys(coo.coords[d].data(), coo.size()));
+
+    int key_bits = 0;
+    for (int d = 0; d < num_dims; d++)
+      key_bits += coord_bits(coo.coords[d]);
+
+    sort_type = chooseSortType(coo.size(), pass_keys, key_bits);
   }
-  sort(counts.begin(), counts.end());
-  //__gnu_parallel::sort(counts.begin(), counts.end());
-  buckets.clear();
-  buckets.shrink_to_fit();
 
-  for (unsigned int i = 1; i < counts.size(); i++)
+  switch (sort_type)
   {
-    if (counts[i - 1] < counts[i])
+  case NO_SORT:
+    return;
+  case HISTOGRAM:
+    // least significant dimension first: every pass is stable
+    for (int d = num_dims - 1 - presorted; d >= 0; d--)
+      count_sort(coo, d);
+    return;
+  case COUNT_RADIX:
+    if (num_dims == 2)
     {
-      // if (bucket)
-      struct bucket abucket
-      {
-        counts[i - 1], counts[i]
-      };
-      buckets.push_back(abucket);
+      // it only reqires to sort the first dimension
+      count_sort(coo, 0);
+      return;
     }
+    for (int d = num_dims - 1; d >= 0; d--)
+      count_sort(coo, d);
+    return;
   }
-}
 
-// This hybrid sort function that combines count sort and quick sort,
-// which use count sort for the 1st mode, and then quick sort on the
-// remaining modes within buckets
-void count_quick(vector<struct coo_t> &ary, int n, int num_dims)
-{
-  vector<bucket> buckets; // buckets generated by first sort
-  count_sort(ary, n, 0);
-  generate_buckets(ary, 0, buckets);
-  for (unsigned long i = 0; i < buckets.size(); i++)
+  // the other algorithms sort keys packed into 64 or 128 bits
+  vector<int> bits(num_dims);
+  int key_bits = 0;
+  for (int d = 0; d < num_dims; d++)
   {
-    //__gnu_parallel::sort(&ary[buckets[i].left], &ary[buckets[i].right], sort_compare_coord_1);
-    sort(&ary[buckets[i].left], &ary[buckets[i].right], sort_compare_coord_1);
+    bits[d] = coord_bits(coo.coords[d]);
+    key_bits += bits[d];
   }
-  if (num_dims > 2)
+
+  if (key_bits <= 64)
   {
-    generate_buckets(ary, 1, buckets); // buckets generated by second sort
-    for (unsigned long i = 0; i < buckets.size(); i++)
-    {
-      //__gnu_parallel::sort(&ary[buckets[i].left], &ary[buckets[i].right], sort_compare_coord_2);
-      sort(&ary[buckets[i].left], &ary[buckets[i].right], sort_compare_coord_2);
-    }
+    sort_packed_keys<uint64_t>(sort_type, coo, bits);
+    return;
+  }
+#ifdef __SIZEOF_INT128__
+  if (key_bits <= 128)
+  {
+    sort_packed_keys<unsigned __int128>(sort_type, coo, bits);
+    return;
   }
+#endif
+  // coordinates too large to pack: compare them dimension by dimension
+  stable_sort(coo.perm.begin(), coo.perm.end(), [&coo](int64_t p, int64_t q)
+              {
+                for (int d = 0; d < coo.num_dims(); d++)
+                {
+                  if (coo.coords[d][p] != coo.coords[d][q])
+                    return coo.coords[d][p] < coo.coords[d][q];
+                }
+                return false;
+              });
 }
 
-void count_radix(vector<struct coo_t> &ary, int n, int num_dims)
+// Times sort_type on n random nonzeros of a rows x cols matrix, in nanoseconds
+double time_transpose_sort(int sort_type, int64_t n, int64_t rows, int64_t cols)
 {
-  
-  if (num_dims == 2)
+  coo_t coo(2, n);
+  std::mt19937_64 gen(n);
+  for (int64_t e = 0; e < n; e++)
   {
-    // it only reqires to sort the first dimension
-    count_sort(ary, n, 0);
+    coo.coords[0][e] = gen() % rows;
+    coo.coords[1][e] = gen() % cols;
   }
 
-  if (num_dims == 3)
+  auto start = std::chrono::steady_clock::now();
+  transpose_sort(sort_type, coo);
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+// Measures the costs of the sorting algorithms on the host
+sort_costs_t calibrateSortCosts()
+{
+  const int64_t n = 1 << 20;
+  int num_threads = sort_threads(n);
+  sort_costs_t costs;
+
+  // two passes over 1K keys
+  costs.count_pass = time_transpose_sort(HISTOGRAM, n, 1 << 10, 1 << 10) * num_threads / (2.0 * n);
+
+  // a pass over as many keys as entries, and a pass over a single key
+  int threads = histogram_threads(n, n);
+  double keys_time = time_transpose_sort(HISTOGRAM, n, 1, n) - costs.count_pass * n / threads - costs.count_pass * n / num_threads;
+  costs.count_key = std::max(0.0, keys_time / ((double)n * threads));
+
+  // 20-bit keys, i.e., three passes
+  costs.radix_pass = time_transpose_sort(RADIX_BUCKET, n, 1 << 10, 1 << 10) * num_threads / (3.0 * n);
+
+  costs.compare = time_transpose_sort(PAR_QSORT, n, 1 << 10, 1 << 10) * num_threads / (n * std::log2((double)n));
+  return costs;
+}
+
+/**
+ * @brief Returns the costs the AUTO option uses. If the COMET_SORT_CALIBRATION
+ * environmental variable names a file, the costs are read from it; if the
+ * file does not exist, they are measured on the host and saved to it.
+ */
+const sort_costs_t &getSortCosts()
+{
+  static const sort_costs_t costs = []()
   {
-    // for best performance, we want something to decide how many dimensions to sort
-    // all dimensions or partial dimensions? 
-    int sort_dims = 3;
-    switch (sort_dims)
-    {
-    case 0:
-      // neglect sorting
-      break;
-    case 1:
-      count_sort(ary, n, 0);
-      break;
-    case 2:
-      count_sort(ary, n, 1);
-      count_sort(ary, n, 0);
-      break;
-    case 3:
-      count_sort(ary, n, 2);
-      count_sort(ary, n, 1);
-      count_sort(ary, n, 0);
-      break;
-    default:
-      assert(false && "ERROR: wrong dimensions for 3D tensors\n");
-      break;
-    }
-  }
+    sort_costs_t costs = {20.0, 15.0, 20.0, 9.0};
+    const char *filename = getenv("COMET_SORT_CALIBRATION");
+    if (!filename || filename[0] == '\0')
+      return costs;
+
+    std::ifstream in(filename);
+    if (in >> costs.count_pass >> costs.count_key >> costs.radix_pass >> costs.compare)
+      return costs;
+
+    costs = calibrateSortCosts();
+    std::ofstream out(filename);
+    out << costs.count_pass << " " << costs.count_key << " " << costs.radix_pass << " " << costs.compare << "\n";
+    if (!out)
+      fprintf(stderr, "Warning: cannot save the sort calibration to %s\n", filename);
+    return costs;
+  }();
+
+  return costs;
 }
 
-//===----------------------------------------------------------------------===//
-//===----------------------------------------------------------------------===//
 /**
- * @brief Differet sorting algorithm for sparse transpse taking COO coordinates as input
- * 
- * @param sort_type specify the sort algorithm to use
- * @param coo_ts the COO coordinates: for 2D, for example, (i, j, val)
- * @param sz number of coordinates within coo_ts
- * @param num_dims number of dimensions: 2D or 3D
- * @param output_permutation the output permutation to transpose, 
- *      such as i, j, k (input perm) to j, k, i (output perm)
+ * @brief Re-traverses the index space of the output, dimension by dimension,
+ * to order the nonzeros without sorting (the NO_SORT option).
+ *
+ * @param dim_sizes sizes of the output dimensions
  */
-void transpose_sort(int sort_type, vector<coo_t> &coo_ts, int sz,
-                    int num_dims, int output_permutation)
+void transpose_retraverse(coo_t &coo, const int64_t *dim_sizes)
 {
-  switch (sort_type)
+  int num_dims = coo.num_dims();
+  int64_t sz = coo.size();
+  vector<int64_t> perm;
+  perm.reserve(sz);
+
+  // visit every index of the output, the last dimension fastest
+  vector<int64_t> index(num_dims, 0);
+  while (true)
   {
-  case SEQ_QSORT:
-    std::qsort((void *)&coo_ts[0], sz, sizeof(struct coo_t), qsort_compare_coords);
-    break;
-  case PAR_QSORT:
-    //__gnu_parallel::sort(coo_ts.begin(), coo_ts.end(), sort_compare_coords);
-    sort(coo_ts.begin(), coo_ts.end(), sort_compare_coords);
-    break;
-  case RADIX_BUCKET:
-    radix_bucket(coo_ts, sz);
-    break;
-  case COUNT_RADIX:
-    count_radix(coo_ts, sz, num_dims);
-    break;
-  case COUNT_QUICK:
-    count_quick(coo_ts, sz, num_dims);
-    break;
-  case NO_SORT:
-    break;
+    for (int64_t k = 0; k < sz; ++k)
+    {
+      int d = 0;
+      while (d < num_dims && coo.coords[d][k] == index[d])
+        d++;
+      if (d == num_dims)
+        perm.push_back(k);
+    }
+
+    int d = num_dims - 1;
+    while (d >= 0 && ++index[d] > dim_sizes[d])
+      index[d--] = 0;
+    if (d < 0)
+      break;
   }
+  coo.perm.swap(perm);
 }
 
 /**
@@ -509,8 +722,8 @@ void transpose_2D(int32_t A1format, int32_t A2format, int A1pos_rank, void *A1po
 
   auto *desc_sizes = static_cast<StridedMemRefType<int64_t, 1> *>(sizes_ptr);
 
-  int rowSize = desc_sizes->data[5];
-  int colSize = desc_sizes->data[6];
+  int64_t rowSize = desc_sizes->data[5];
+  int64_t colSize = desc_sizes->data[6];
 
   if ((A1format == Compressed_nonunique && A2format == singleton) || (A1format == singleton && A2format == Compressed_nonunique))
   {
@@ -541,53 +754,39 @@ void transpose_2D(int32_t A1format, int32_t A2format, int A1pos_rank, void *A1po
   if (Aspformat.compare("COO") == 0 && Bspformat.compare("COO") == 0)
   {
 
-    int sz = desc_Aval->sizes[0];
-    // vector of coordinates
-    vector<coo_t> coo_ts(sz);
+    int64_t sz = desc_Aval->sizes[0];
+
+    //===----------------------------------------------------------------------===//
+    // marshalling data: the coordinates in transposed (j, i) order
+    //===----------------------------------------------------------------------===//
+    coo_t coo(num_dims, sz);
+    for (int64_t i = 0; i < sz; ++i)
+    {
+      coo.coords[0][i] = desc_A2crd->data[i];
+      coo.coords[1][i] = desc_A1crd->data[i];
+    }
 
-    int m=0;
     if (selected_sort_type == NO_SORT) { // coordinates are not sorted
-      for (int i=0; i < colSize+1; ++i) {
-	      for (int j=0; j < rowSize+1; ++j) {
-	        for (int k=0; k < sz; ++k) {
-	          if (desc_A1crd->data[k] == j && desc_A2crd->data[k] == i) {
-	            coo_ts[m].coords.push_back(desc_A2crd->data[k]); 
-	            coo_ts[m].coords.push_back(desc_A1crd->data[k]); 
-      	      coo_ts[m].val = desc_Aval->data[k];
-	            ++m;
-	          }
-	        }
-	      }
-      }
+      int64_t trans_dim_sizes[2] = {colSize, rowSize};
+      transpose_retraverse(coo, trans_dim_sizes);
     } else {
-
-      // dimension, so we need to use indexing map for transpose
-      //===----------------------------------------------------------------------===//
-      // marshalling data for each sorting algorithms
-      //===----------------------------------------------------------------------===//
-      for (int i = 0; i < sz; ++i)
-      {
-        coo_ts[i].coords.push_back(desc_A2crd->data[i]);
-        coo_ts[i].coords.push_back(desc_A1crd->data[i]);
-        coo_ts[i].val = desc_Aval->data[i];
-      }
-
       //===----------------------------------------------------------------------===//
       // Different sorting algorithm
       //===----------------------------------------------------------------------===//
-      transpose_sort(selected_sort_type, coo_ts, sz, num_dims, 0);
+      const int out_dims[2] = {1, 0};
+      transpose_sort(selected_sort_type, coo, presorted_dims(coo, out_dims));
     }
-    
+
     //===----------------------------------------------------------------------===//
     // push transposed coords to output tensors
     //===----------------------------------------------------------------------===//
-    for (int i = 0; i < sz; ++i)
+    for (int64_t i = 0; i < coo.size(); ++i)
     {
-      desc_B1crd->data[i] = coo_ts[i].coords[0];
-      desc_B2crd->data[i] = coo_ts[i].coords[1];
-      desc_Bval->data[i] = coo_ts[i].val;
+      desc_B1crd->data[i] = coo.crd(0, i);
+      desc_B2crd->data[i] = coo.crd(1, i);
+      desc_Bval->data[i] = desc_Aval->data[coo.perm[i]];
     }
-    
+
     // B2 pos should have two values: data[0]: 0 and data[1]: sz 
     desc_B1pos->sizes[0] = 2;
     desc_B1pos->data[1] = sz;
@@ -603,19 +802,58 @@ void transpose_2D(int32_t A1format, int32_t A2format, int A1pos_rank, void *A1po
 
   if (Aspformat.compare("CSR") == 0 && Bspformat.compare("CSR") == 0)
   {
-    if (selected_sort_type == NO_SORT) // coordinates are not sorted
+    if (selected_sort_type == AUTO)
+    {
+      // the rows of A are sorted: only the columns need a counting pass
+      int64_t nnz = desc_A2pos->data[rowSize];
+      selected_sort_type = chooseSortType(nnz, {colSize}, value_bits(colSize - 1) + value_bits(rowSize - 1));
+    }
+
+    if (selected_sort_type == HISTOGRAM)
+    {
+      // count the nonzeros of every column of A, i.e., row of B, and scatter
+      // the nonzeros of A in order: each row of B gets increasing column indices
+      int64_t BRowSize = colSize;
+      int64_t BNnz = desc_A2pos->data[rowSize];
+
+      vector<int64_t> order, offsets;
+      histogram_sort(desc_A2crd->data, BNnz, BRowSize, order, &offsets);
+
+      desc_B2pos->sizes[0] = BRowSize + 1;
+      for (int64_t k = 0; k <= BRowSize; k++)
+        desc_B2pos->data[k] = offsets[k];
+
+      vector<int64_t> rows(BNnz);
+      for (int64_t i = 0; i < rowSize; i++)
+        for (int64_t j = desc_A2pos->data[i]; j < desc_A2pos->data[i + 1]; j++)
+          rows[j] = i;
+
+      for (int64_t j = 0; j < BNnz; j++)
+      {
+        desc_B2crd->data[j] = rows[order[j]];
+        desc_Bval->data[j] = desc_Aval->data[order[j]];
+      }
+
+      desc_B1pos->data[0] = BRowSize;
+      desc_B1crd->data[0] = -1;
+
+      // switch row and col size
+      desc_sizes->data[5] = colSize;
+      desc_sizes->data[6] = rowSize;
+    }
+    else if (selected_sort_type == NO_SORT) // coordinates are not sorted
     {
       // 1) not by sorting: only works for CSR/matrices
       // Atomic-based Transposition: retraverse the matrix from the transposed direction
       // B's row size == input's col size
-      int BRowSize = desc_sizes->data[6];
-      int BColSize = desc_sizes->data[5];
+      int64_t BRowSize = desc_sizes->data[6];
+      int64_t BColSize = desc_sizes->data[5];
 
       // B's col pos size == B's #rows + 1
       desc_B2pos->sizes[0] = BRowSize + 1;
-      int count = 0;
+      int64_t count = 0;
       desc_B2pos->data[0] = count;
-      int i, j, k;
+      int64_t i, j, k;
       for (k = 0; k < BRowSize; k++)
       {
         for (i = 0; i < BColSize; i++)
@@ -646,66 +884,47 @@ void transpose_2D(int32_t A1format, int32_t A2format, int A1pos_rank, void *A1po
       //===----------------------------------------------------------------------===//
       // marshalling data
       //===----------------------------------------------------------------------===//
-      // vector of coordinates
-      int i, j;
-      int BNnz = desc_Aval->sizes[0];
-      vector<coo_t> coo_ts(BNnz);
-      int pos = 0;
-      int counter = 0;
-      for (i = 0; i < BNnz; ++i)
+      // coordinates in transposed (j, i) order
+      int64_t i, j;
+      int64_t BNnz = desc_Aval->sizes[0];
+      coo_t coo(num_dims, BNnz);
+      for (i = 0; i < desc_A2pos->sizes[0] - 1; ++i)
       {
-        coo_ts[i].coords.push_back(desc_A2crd->data[i]);
-        coo_ts[i].val = desc_Aval->data[i];
-        counter++;
-        for (j = 0; j < desc_A2pos->sizes[0] - 1; j++)
+        for (j = desc_A2pos->data[i]; j < desc_A2pos->data[i + 1]; ++j)
         {
-          if (counter > desc_A2pos->data[j] && counter <= desc_A2pos->data[j + 1])
-          {
-            pos = j;
-          }
+          coo.coords[0][j] = desc_A2crd->data[j];
+          coo.coords[1][j] = i;
         }
-        coo_ts[i].coords.push_back(pos);
       }
       // sort the first dim
       //===----------------------------------------------------------------------===//
       // Different sorting algorithm
       //===----------------------------------------------------------------------===//
       //
-      transpose_sort(selected_sort_type, coo_ts, BNnz, num_dims, 0);
+      transpose_sort(selected_sort_type, coo, 1);
 
       // push sorted data back to B
-      int BRowSize = colSize;
+      int64_t BRowSize = colSize;
       desc_B1pos->data[0] = BRowSize;
       desc_B1crd->data[0] = -1;
 
       desc_B2pos->sizes[0] = BRowSize + 1; // resize
-      // push pos to B
-      counter = 1;
-      j = 1;
-      for (i = 1; i < BNnz; i++)
+      // push pos to B: every row of B up to the row of nonzero i starts at i,
+      // including the empty rows before it
+      desc_B2pos->data[0] = 0;
+      j = 0;
+      for (i = 0; i < BNnz; i++)
       {
-        if (coo_ts[i - 1].coords[0] != coo_ts[i].coords[0])
-        {
-          desc_B2pos->data[j] = counter;
-          j++;
-        }
-        // for cases having a gap larger than 1, e.g., 0 0 1 1 (gap > 1) 3 4 4
-        if (coo_ts[i].coords[0] - coo_ts[i-1].coords[0] > 1) {
-          int gap = coo_ts[i].coords[0] - coo_ts[i-1].coords[0] - 1;
-          while (gap > 0) {
-            desc_B2pos->data[j] = counter;
-            j++;
-            gap--;
-          }
-        }
-        counter++;
+        while (j < coo.crd(0, i))
+          desc_B2pos->data[++j] = i;
       }
-      desc_B2pos->data[j] = counter;
+      while (j < BRowSize)
+        desc_B2pos->data[++j] = BNnz;
       // push crd to B
       for (i = 0; i < BNnz; i++)
       {
-        desc_B2crd->data[i] = coo_ts[i].coords[1];
-        desc_Bval->data[i] = coo_ts[i].val;
+        desc_B2crd->data[i] = coo.crd(1, i);
+        desc_Bval->data[i] = desc_Aval->data[coo.perm[i]];
       }
 
       // switch row and col size
@@ -726,475 +945,250 @@ void transpose_2D(int32_t A1format, int32_t A2format, int A1pos_rank, void *A1po
   }
 }
 
+// Name of the sparse format of a tensor: "COO" if one dimension is
+// compressed non-unique and the others singleton, "CSF" if every dimension
+// is compressed unique, and an empty string otherwise
+std::string getSparseFormat(int num_dims, const int32_t *formats)
+{
+  int num_compressed_nonunique = 0, num_singleton = 0, num_compressed_unique = 0;
+  for (int d = 0; d < num_dims; d++)
+  {
+    num_compressed_nonunique += (formats[d] == Compressed_nonunique);
+    num_singleton += (formats[d] == singleton);
+    num_compressed_unique += (formats[d] == Compressed_unique);
+  }
+
+  if (num_compressed_nonunique == 1 && num_singleton == num_dims - 1)
+    return "COO";
+  if (num_compressed_unique == num_dims)
+    return "CSF";
+  return "";
+}
+
+/**
+ * @brief Sparse transpose of a tensor of any rank, in COO or CSF format, for
+ * any input and output permutation. The nonzeros are gathered as COO
+ * coordinates in output dimension order, sorted by transpose_sort, and
+ * stored back in the format of the output.
+ *
+ * @param num_dims rank of the tensors
+ * @param input_permutation permutation of the indices of A, one decimal digit
+ *      per dimension: for example, 2013 for A[k, i, j, l] with rank 4
+ * @param output_permutation permutation of the indices of B, likewise
+ * @param Aformats formats of the dimensions of A
+ * @param Aarrays pos and crd arrays of every dimension of A, then its val array
+ * @param Bformats formats of the dimensions of B
+ * @param Barrays pos and crd arrays of every dimension of B, then its val array
+ * @param sizes_ptr sizes of A: the sizes of its arrays, then the sizes of its
+ *      dimensions, starting at index 2 * num_dims + 1
+ */
 template <typename T>
-void transpose_3D(int32_t input_permutation, int32_t output_permutation,
-                  int32_t A1format, int32_t A2format, int32_t A3format,
-                  int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
-                  int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
-                  int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
-                  int Aval_rank, void *Aval_ptr,
-                  int32_t B1format, int32_t B2format, int32_t B3format,
-                  int B1pos_rank, void *B1pos_ptr, int B1crd_rank, void *B1crd_ptr,
-                  int B2pos_rank, void *B2pos_ptr, int B2crd_rank, void *B2crd_ptr,
-                  int B3pos_rank, void *B3pos_ptr, int B3crd_rank, void *B3crd_ptr,
-                  int Bval_rank, void *Bval_ptr, int sizes_rank, void *sizes_ptr)
+void transpose_ND(int num_dims, int32_t input_permutation, int32_t output_permutation,
+                  const int32_t *Aformats, void *const *Aarrays,
+                  const int32_t *Bformats, void *const *Barrays, void *sizes_ptr)
 {
   // Get sort type
   int selected_sort_type = 0;
   getSortType(selected_sort_type);
 
-  int num_dims = 3;
-
-  std::string Aspformat;
-  std::string Bspformat;
-
-  if ((A1format == Compressed_nonunique && A2format == singleton && A3format == singleton) ||
-      (A1format == singleton && A2format == Compressed_nonunique && A3format == singleton) ||
-      (A1format == singleton && A2format == singleton && A3format == Compressed_nonunique))
-  {
-    Aspformat.assign("COO");
-  }
-  else if (A1format == Compressed_unique &&
-           A2format == Compressed_unique &&
-           A3format == Compressed_unique)
-  {
-    Aspformat.assign("CSF");
-  }
-  else
+  std::string Aspformat = getSparseFormat(num_dims, Aformats);
+  std::string Bspformat = getSparseFormat(num_dims, Bformats);
+  if (Aspformat.empty())
   {
     assert(false && "ERROR: At this time, only COO and CSF formats are supported for input tensor.\n");
   }
-  if ((B1format == Compressed_nonunique && B2format == singleton && B3format == singleton) ||
-      (B1format == singleton && B2format == Compressed_nonunique && B3format == singleton) ||
-      (B1format == singleton && B2format == singleton && B3format == Compressed_nonunique))
+  if (Bspformat.empty())
   {
-    Bspformat.assign("COO");
+    assert(false && "ERROR: At this time, only COO and CSF formats are supported for output tensor.\n");
   }
-  else if (B1format == Compressed_unique &&
-           B2format == Compressed_unique &&
-           B3format == Compressed_unique)
+  if (Aspformat != Bspformat)
   {
-    Bspformat.assign("CSF");
+    assert(false && "ERROR: 'COO->CSF' and 'CSF->COO' are not supported for sparse tensor transpose.\n");
   }
-  else
+
+  vector<StridedMemRefType<int64_t, 1> *> desc_Apos(num_dims), desc_Acrd(num_dims);
+  vector<StridedMemRefType<int64_t, 1> *> desc_Bpos(num_dims), desc_Bcrd(num_dims);
+  for (int d = 0; d < num_dims; d++)
   {
-    assert(false && "ERROR: At this time, only COO and CSF formats are supported for output tensor.\n");
+    desc_Apos[d] = static_cast<StridedMemRefType<int64_t, 1> *>(Aarrays[2 * d]);
+    desc_Acrd[d] = static_cast<StridedMemRefType<int64_t, 1> *>(Aarrays[2 * d + 1]);
+    desc_Bpos[d] = static_cast<StridedMemRefType<int64_t, 1> *>(Barrays[2 * d]);
+    desc_Bcrd[d] = static_cast<StridedMemRefType<int64_t, 1> *>(Barrays[2 * d + 1]);
   }
-
-  //auto *desc_A1pos = static_cast<StridedMemRefType<int64_t, 1> *>(A1pos_ptr);
-  auto *desc_A1crd = static_cast<StridedMemRefType<int64_t, 1> *>(A1crd_ptr);
-  auto *desc_A2pos = static_cast<StridedMemRefType<int64_t, 1> *>(A2pos_ptr);
-  auto *desc_A2crd = static_cast<StridedMemRefType<int64_t, 1> *>(A2crd_ptr);
-  auto *desc_A3pos = static_cast<StridedMemRefType<int64_t, 1> *>(A3pos_ptr);
-  auto *desc_A3crd = static_cast<StridedMemRefType<int64_t, 1> *>(A3crd_ptr);
-  auto *desc_Aval = static_cast<StridedMemRefType<T, 1> *>(Aval_ptr);
-
-  auto *desc_B1pos = static_cast<StridedMemRefType<int64_t, 1> *>(B1pos_ptr);
-  auto *desc_B1crd = static_cast<StridedMemRefType<int64_t, 1> *>(B1crd_ptr);
-  auto *desc_B2pos = static_cast<StridedMemRefType<int64_t, 1> *>(B2pos_ptr);
-  auto *desc_B2crd = static_cast<StridedMemRefType<int64_t, 1> *>(B2crd_ptr);
-  auto *desc_B3pos = static_cast<StridedMemRefType<int64_t, 1> *>(B3pos_ptr);
-  auto *desc_B3crd = static_cast<StridedMemRefType<int64_t, 1> *>(B3crd_ptr);
-  auto *desc_Bval = static_cast<StridedMemRefType<T, 1> *>(Bval_ptr);
+  auto *desc_Aval = static_cast<StridedMemRefType<T, 1> *>(Aarrays[2 * num_dims]);
+  auto *desc_Bval = static_cast<StridedMemRefType<T, 1> *>(Barrays[2 * num_dims]);
 
   auto *desc_sizes = static_cast<StridedMemRefType<int64_t, 1> *>(sizes_ptr);
 
-  int mode_sz0 = desc_sizes->data[7];
-  int mode_sz1 = desc_sizes->data[8];
-  int mode_sz2 = desc_sizes->data[9];
-
-  int dim_sizes[3] = {mode_sz0, mode_sz1, mode_sz2};
-  int trans_dim_sizes[3] = {mode_sz0, mode_sz1, mode_sz2}; // sizes of dimensions after transposition of dimensions
-
-  if (Aspformat.compare("COO") == 0 && Bspformat.compare("COO") == 0)
+  //===----------------------------------------------------------------------===//
+  // marshalling data for permutation for transpose
+  //===----------------------------------------------------------------------===//
+  vector<int> idigits(num_dims), odigits(num_dims);
+  for (int d = num_dims - 1; d >= 0; d--)
   {
-    int sz = desc_Aval->sizes[0];
-
-    // vector of coordinates
-    vector<coo_t> coo_ts(sz);
+    idigits[d] = input_permutation % 10;
+    odigits[d] = output_permutation % 10;
+    input_permutation /= 10;
+    output_permutation /= 10;
+  }
 
-    //===----------------------------------------------------------------------===//
-    // marshalling data for permutation for transpose
-    //===----------------------------------------------------------------------===//
-    // There are 5 input cases: 012, 021, 102, 120, 201, 210
-    // There are 5 output cases: 012, 021, 102, 120, 201, 210
-    int idigists[3], odigists[3], i = 0;
-    for (int j = num_dims - 1; j >= 0; j--)
+  // the order depends on both input and output permutations
+  // for example, if the input is 201 and output is 102, the order
+  // should be (k, j, i): out_dims[i] is the dimension of A that
+  // becomes dimension i of B
+  vector<int> out_dims(num_dims);
+  vector<int64_t> trans_dim_sizes(num_dims); // sizes of dimensions after transposition of dimensions
+  for (int i = 0; i < num_dims; ++i)
+  {
+    out_dims[i] = i;
+    trans_dim_sizes[i] = desc_sizes->data[2 * num_dims + 1 + i];
+    for (int j = 0; j < num_dims; ++j)
     {
-      int tmp = pow(10, j);
-      idigists[i] = (input_permutation / tmp) % 10;
-      odigists[i] = (output_permutation / tmp) % 10;
-      ++i;
-    }
-    
-    // the order depends on both input and output permutations
-    // for example, if the input is 201 and output is 102, the order 
-    // should be (k, j, i)
-    for (int i = 0; i < num_dims; ++i) {
-      for (int j = 0; j < num_dims; ++j) {
-        if (odigists[i] == idigists[j]) {
-          trans_dim_sizes[i] = dim_sizes[j];
-          for (int k = 0; k < sz; ++k) {
-            switch (j)
-            {
-              case 0:
-                coo_ts[k].coords.push_back(desc_A1crd->data[k]);
-                break;
-
-              case 1:
-                coo_ts[k].coords.push_back(desc_A2crd->data[k]);
-                break;
-
-              case 2:
-                coo_ts[k].coords.push_back(desc_A3crd->data[k]);
-                break;
-
-              default:;
-                assert(false && "ERROR: incorrect output permutation\n");
-            }
-            coo_ts[k].val = desc_Aval->data[k];
-          }
-        }
-      }
-    }
-
-    if (selected_sort_type == NO_SORT) {
-      vector<coo_t> perm_coo_ts(sz);
-
-      // re-traverse from the target dimension
-      int m = 0;
-      for (int i=0; i < trans_dim_sizes[0]+1; ++i) {
-        for (int j=0; j < trans_dim_sizes[1]+1; ++j) {
-          for (int k=0; k < trans_dim_sizes[2]+1; ++k) {
-            for (int l=0; l < sz; ++l) {
-              if (i == coo_ts[l].coords[0] && j == coo_ts[l].coords[1] && k == coo_ts[l].coords[2]){
-                perm_coo_ts[m].coords.push_back(coo_ts[l].coords[0]);
-                perm_coo_ts[m].coords.push_back(coo_ts[l].coords[1]);
-                perm_coo_ts[m].coords.push_back(coo_ts[l].coords[2]);
-                perm_coo_ts[m].val = coo_ts[l].val;
-                ++m;
-              }
-            }
-          }
-        }
-      }
-
-      //===----------------------------------------------------------------------===//
-      // push transposed coords to output tensors
-      //===----------------------------------------------------------------------===//
-      for (i = 0; i < sz; ++i)
+      if (odigits[i] == idigits[j])
       {
-        desc_B1crd->data[i] = perm_coo_ts[i].coords[0];
-        desc_B2crd->data[i] = perm_coo_ts[i].coords[1];
-        desc_B3crd->data[i] = perm_coo_ts[i].coords[2];
-        desc_Bval->data[i] = perm_coo_ts[i].val;
-      }
-
-      
-    } else {
-      //===----------------------------------------------------------------------===//
-      // Different sorting algorithm
-      //===----------------------------------------------------------------------===//
-      transpose_sort(selected_sort_type, coo_ts, sz, num_dims, output_permutation);
-
-      //===----------------------------------------------------------------------===//
-      // push transposed coords to output tensors
-      //===----------------------------------------------------------------------===//
-      for (i = 0; i < sz; ++i) {
-        desc_B1crd->data[i] = coo_ts[i].coords[0];
-        desc_B2crd->data[i] = coo_ts[i].coords[1];
-        desc_B3crd->data[i] = coo_ts[i].coords[2];
-        desc_Bval->data[i] = coo_ts[i].val;
+        out_dims[i] = j;
+        trans_dim_sizes[i] = desc_sizes->data[2 * num_dims + 1 + j];
       }
     }
-    
-    // B2 pos should have two values: data[0]: 0 and data[1]: sz 
-    desc_B1pos->sizes[0] = 2;
-    desc_B1pos->data[1] = sz;
   }
 
-  if (Aspformat.compare("CSF") == 0 && Bspformat.compare("CSF") == 0)
-  {
-    int sz = desc_Aval->sizes[0];
+  int64_t sz = desc_Aval->sizes[0];
 
-    // vector of coordinates
-    vector<coo_t> coo_ts(sz);
+  // coordinates of the nonzeros, in input dimension order
+  vector<vector<int64_t>> Acoords(num_dims);
+  if (Aspformat == "COO")
+  {
+    for (int d = 0; d < num_dims; ++d)
+      Acoords[d].assign(desc_Acrd[d]->data, desc_Acrd[d]->data + sz);
+  }
+  else
+  {
+    // walk up the CSF tree from the leaves: node[e] is the node above
+    // nonzero e at the current level
+    vector<int64_t> node(sz);
+    for (int64_t e = 0; e < sz; ++e)
+      node[e] = e;
 
-    // initialization
-    for (int i = 0; i < sz; ++i)
+    for (int d = num_dims - 1; d >= 0; --d)
     {
-      coo_ts[i].coords.push_back(desc_A3crd->data[i]);
-      coo_ts[i].coords.push_back(desc_A3crd->data[i]);
-      coo_ts[i].coords.push_back(desc_A3crd->data[i]);
-      coo_ts[i].val = desc_Aval->data[i];
+      Acoords[d].resize(sz);
+      for (int64_t e = 0; e < sz; ++e)
+        Acoords[d][e] = desc_Acrd[d]->data[node[e]];
+
+      if (d == 0)
+        break;
+      const int64_t *pos = desc_Apos[d]->data;
+      vector<int64_t> parent(pos[desc_Apos[d]->sizes[0] - 1]);
+      for (int64_t p = 0; p < desc_Apos[d]->sizes[0] - 1; ++p)
+        for (int64_t k = pos[p]; k < pos[p + 1]; ++k)
+          parent[k] = p;
+      for (int64_t e = 0; e < sz; ++e)
+        node[e] = parent[node[e]];
     }
+  }
 
-    // fix coords for A1 and A2
-    int i = 0, j = 0, k = 0;
-    for (i = 0; i < desc_A2crd->sizes[0]; ++i)
-    {
-      for (j = desc_A3pos->data[i]; j < desc_A3pos->data[i + 1]; ++j)
-      {
-        coo_ts[k].coords[1] = desc_A2crd->data[i]; // for A2
-        k++;
-      }
-    }
-    k = 0;
-    for (i = 0; i < desc_A2pos->sizes[0] - 1; ++i)
-    {
-      for (j = desc_A3pos->data[desc_A2pos->data[i]]; j < desc_A3pos->data[desc_A2pos->data[i + 1]]; ++j)
-      {
-        coo_ts[k].coords[0] = desc_A1crd->data[i]; // for A1
-        k++;
-      }
-    }
+  // coordinates of the nonzeros, in output dimension order
+  coo_t coo(num_dims, sz);
+  for (int d = 0; d < num_dims; ++d)
+    coo.coords[d].swap(Acoords[out_dims[d]]);
 
-    vector<coo_t> perm_coo_ts(sz);
+  if (selected_sort_type == NO_SORT) {
+    // re-traverse from the target dimension
+    transpose_retraverse(coo, trans_dim_sizes.data());
+    sz = coo.size();
+  } else {
     //===----------------------------------------------------------------------===//
-    // marshalling data for permutation for transpose
+    // Different sorting algorithm
     //===----------------------------------------------------------------------===//
-    // There are 5 input cases: 012, 021, 102, 120, 201, 210
-    // There are 5 output cases: 012, 021, 102, 120, 201, 210
-    int idigists[3], odigists[3];
-    i = 0;
-    for (int j = num_dims - 1; j >= 0; j--)
-    {
-      int tmp = pow(10, j);
-      idigists[i] = (input_permutation / tmp) % 10;
-      odigists[i] = (output_permutation / tmp) % 10;
-      ++i;
-    }
-
-    // the order depends on both input and output permutations
-    // for example, if the input is 201 and output is 102, the order 
-    // should be (k, j, i)
-    for (int i = 0; i < num_dims; ++i) {
-      for (int j = 0; j < num_dims; ++j) {
-        if (odigists[i] == idigists[j]) {
-          trans_dim_sizes[i] = dim_sizes[j];
-          for (int k = 0; k < sz; ++k) {
-            switch (j)
-            {
-              case 0:
-                perm_coo_ts[k].coords.push_back(coo_ts[k].coords[0]);
-                break;
-
-              case 1:
-                perm_coo_ts[k].coords.push_back(coo_ts[k].coords[1]);
-                break;
-
-              case 2:
-                perm_coo_ts[k].coords.push_back(coo_ts[k].coords[2]);
-                break;
+    transpose_sort(selected_sort_type, coo, presorted_dims(coo, out_dims.data()));
+  }
 
-              default:;
-                assert(false && "ERROR: incorrect output permutation\n");
-            }
-            perm_coo_ts[k].val = coo_ts[k].val;
-          }
-        }
-      }
+  if (Bspformat == "COO")
+  {
+    //===----------------------------------------------------------------------===//
+    // push transposed coords to output tensors
+    //===----------------------------------------------------------------------===//
+    for (int64_t i = 0; i < sz; ++i)
+    {
+      for (int d = 0; d < num_dims; ++d)
+        desc_Bcrd[d]->data[i] = coo.crd(d, i);
+      desc_Bval->data[i] = desc_Aval->data[coo.perm[i]];
     }
 
-    if (selected_sort_type == NO_SORT) {
-
-      // re-traverse from the target dimension
-      int m = 0, l = 0;
-      for (i=0; i < trans_dim_sizes[0]+1; ++i) {
-        for (j=0; j < trans_dim_sizes[1]+1; ++j) {
-          for (k=0; k < trans_dim_sizes[2]+1; ++k) {
-            for (l=0; l < sz; ++l) {
-              if (i == perm_coo_ts[l].coords[0] && j == perm_coo_ts[l].coords[1] && k == perm_coo_ts[l].coords[2]){
-                coo_ts[m].coords[0] = perm_coo_ts[l].coords[0];
-                coo_ts[m].coords[1] = perm_coo_ts[l].coords[1];
-                coo_ts[m].coords[2] = perm_coo_ts[l].coords[2];
-                coo_ts[m].val = perm_coo_ts[l].val;
-                ++m;
-              }
-            }
-          }
-        }
-      }
-
-      //===----------------------------------------------------------------------===//
-      // Convert COO back to CSF
-      //===----------------------------------------------------------------------===//
-      // calculate B1crd, B2crd, B3crd
-      int counter = 0;
-      for (i = 0; i < sz - 1; i++)
-      {
-        desc_B1crd->data[counter] = coo_ts[i].coords[0];
-        if (coo_ts[i].coords[0] != coo_ts[i + 1].coords[0])
-        {
-          counter++;
-        }
-      }
-      desc_B1crd->data[counter] = coo_ts[i].coords[0];
-      desc_B1crd->sizes[0] = counter + 1;
-
-      counter = 0;
-      for (i = 0; i < sz - 1; i++)
-      {
-        desc_B2crd->data[counter] = coo_ts[i].coords[1];
-        if (coo_ts[i].coords[1] != coo_ts[i + 1].coords[1])
-        {
-          counter++;
-        }
-      }
-      desc_B2crd->data[counter] = coo_ts[i].coords[1];
-      desc_B2crd->sizes[0] = counter + 1;
-
-      for (i = 0; i < sz; i++)
-      {
-        desc_B3crd->data[i] = coo_ts[i].coords[2];
-        desc_Bval->data[i] = coo_ts[i].val;
-      }
-      desc_B3crd->sizes[0] = sz;
-      desc_Bval->sizes[0] = sz;
-
-      // calculate B1pos, B2pos, B3pos
-      desc_B1pos->data[0] = 0;
-      desc_B1pos->data[1] = desc_B1crd->sizes[0];
-      desc_B1pos->sizes[0] = 2;
-
-      desc_B2pos->data[0] = 0;
-      counter = 1;
-      j = 1;
-      for (i = 0; i < sz - 1; ++i)
-      {
-        if (coo_ts[i].coords[0] != coo_ts[i + 1].coords[0])
-        {
-          desc_B2pos->data[j] = counter;
-          j++;
-        }
-        if (coo_ts[i].coords[1] != coo_ts[i + 1].coords[1] ||
-            coo_ts[i].coords[0] != coo_ts[i + 1].coords[0])
-        {
-          counter++;
-        }
-      }
-      desc_B2pos->data[j] = counter;
-      desc_B2pos->sizes[0] = j + 1;
-
-      desc_B3pos->data[0] = 0;
-      counter = 1;
-      j = 1;
-      for (i = 0; i < sz - 1; ++i)
-      {
-        if (coo_ts[i].coords[1] != coo_ts[i + 1].coords[1] ||
-            coo_ts[i].coords[0] != coo_ts[i + 1].coords[0])
-        {
-          desc_B3pos->data[j] = counter;
-          j++;
-        }
-        if (coo_ts[i].coords[2] != coo_ts[i + 1].coords[2] ||
-            coo_ts[i].coords[1] != coo_ts[i + 1].coords[1] ||
-            coo_ts[i].coords[0] != coo_ts[i + 1].coords[0])
-        {
-          counter++;
-        }
-      }
-      desc_B3pos->data[j] = counter;
-      desc_B3pos->sizes[0] = j + 1;
-
-    } else { // end of NO_SORT  
-      //===----------------------------------------------------------------------===//
-      // Different sorting algorithm
-      //===----------------------------------------------------------------------===//
-      transpose_sort(selected_sort_type, perm_coo_ts, sz, num_dims, output_permutation);
-
-      //===----------------------------------------------------------------------===//
-      // Convert COO back to CSF
-      //===----------------------------------------------------------------------===//
-      // calculate B1crd, B2crd, B3crd
-      int counter = 0;
-      for (i = 0; i < sz - 1; i++)
-      {
-        desc_B1crd->data[counter] = perm_coo_ts[i].coords[0];
-        if (perm_coo_ts[i].coords[0] != perm_coo_ts[i + 1].coords[0])
-        {
-          counter++;
-        }
-      }
-      desc_B1crd->data[counter] = perm_coo_ts[i].coords[0];
-      desc_B1crd->sizes[0] = counter + 1;
-
-      counter = 0;
-      for (i = 0; i < sz - 1; i++)
-      {
-        desc_B2crd->data[counter] = perm_coo_ts[i].coords[1];
-        if (perm_coo_ts[i].coords[1] != perm_coo_ts[i + 1].coords[1])
-        {
-          counter++;
-        }
-      }
-      desc_B2crd->data[counter] = perm_coo_ts[i].coords[1];
-      desc_B2crd->sizes[0] = counter + 1;
-
-      for (i = 0; i < sz; i++)
-      {
-        desc_B3crd->data[i] = perm_coo_ts[i].coords[2];
-        desc_Bval->data[i] = perm_coo_ts[i].val;
-      }
-      desc_B3crd->sizes[0] = sz;
-      desc_Bval->sizes[0] = sz;
-
-      // calculate B1pos, B2pos, B3pos
-      desc_B1pos->data[0] = 0;
-      desc_B1pos->data[1] = desc_B1crd->sizes[0];
-      desc_B1pos->sizes[0] = 2;
+    // B1 pos should have two values: data[0]: 0 and data[1]: sz
+    desc_Bpos[0]->sizes[0] = 2;
+    desc_Bpos[0]->data[1] = sz;
+    return;
+  }
 
-      desc_B2pos->data[0] = 0;
-      counter = 1;
-      j = 1;
-      for (i = 0; i < sz - 1; ++i)
+  //===----------------------------------------------------------------------===//
+  // Convert COO back to CSF
+  //===----------------------------------------------------------------------===//
+  // level d of B gets a node for every distinct prefix of coordinates in
+  // dimensions 0..d, and the last level a node for every nonzero. counts[d]
+  // is the number of nodes of level d so far, and Bpos[d][p + 1] is the
+  // number of nodes of level d under the nodes 0..p of level d - 1.
+  vector<int64_t> counts(num_dims, 0);
+  for (int d = 0; d < num_dims; ++d)
+    desc_Bpos[d]->data[0] = 0;
+
+  for (int64_t i = 0; i < sz; ++i)
+  {
+    // first level where nonzero i leaves the path of nonzero i - 1
+    int level = 0;
+    if (i > 0)
+    {
+      level = num_dims - 1;
+      for (int d = 0; d < num_dims - 1; ++d)
       {
-        if (perm_coo_ts[i].coords[0] != perm_coo_ts[i + 1].coords[0])
+        if (coo.crd(d, i) != coo.crd(d, i - 1))
         {
-          desc_B2pos->data[j] = counter;
-          j++;
-        }
-        if (perm_coo_ts[i].coords[1] != perm_coo_ts[i + 1].coords[1] ||
-            perm_coo_ts[i].coords[0] != perm_coo_ts[i + 1].coords[0])
-        {
-          counter++;
+          level = d;
+          break;
         }
       }
-      desc_B2pos->data[j] = counter;
-      desc_B2pos->sizes[0] = j + 1;
+    }
 
-      desc_B3pos->data[0] = 0;
-      counter = 1;
-      j = 1;
-      for (i = 0; i < sz - 1; ++i)
-      {
-        if (perm_coo_ts[i].coords[1] != perm_coo_ts[i + 1].coords[1] ||
-            perm_coo_ts[i].coords[0] != perm_coo_ts[i + 1].coords[0])
-        {
-          desc_B3pos->data[j] = counter;
-          j++;
-        }
-        if (perm_coo_ts[i].coords[2] != perm_coo_ts[i + 1].coords[2] ||
-            perm_coo_ts[i].coords[1] != perm_coo_ts[i + 1].coords[1] ||
-            perm_coo_ts[i].coords[0] != perm_coo_ts[i + 1].coords[0])
-        {
-          counter++;
-        }
-      }
-      desc_B3pos->data[j] = counter;
-      desc_B3pos->sizes[0] = j + 1;
-    } // end of sorting  
+    for (int d = level; d < num_dims; ++d)
+    {
+      desc_Bcrd[d]->data[counts[d]++] = coo.crd(d, i);
+      if (d > 0)
+        desc_Bpos[d]->data[counts[d - 1]] = counts[d];
+    }
+    desc_Bval->data[i] = desc_Aval->data[coo.perm[i]];
   }
 
-  if (Aspformat.compare("CSF") == 0 && Bspformat.compare("COO") == 0)
+  desc_Bpos[0]->data[1] = counts[0];
+  desc_Bpos[0]->sizes[0] = 2;
+  for (int d = 0; d < num_dims; ++d)
   {
-    assert(false && "ERROR: 'CSF->COO' is not supported for sparse tensor transpose.\n");
+    desc_Bcrd[d]->sizes[0] = counts[d];
+    if (d > 0)
+      desc_Bpos[d]->sizes[0] = counts[d - 1] + 1;
   }
+  desc_Bval->sizes[0] = sz;
+}
 
-  if (Aspformat.compare("COO") == 0 && Bspformat.compare("CSF") == 0)
-  {
-    assert(false && "ERROR: 'COO->CSF' is not supported for sparse tensor transpose.\n");
-  }
+template <typename T>
+void transpose_3D(int32_t input_permutation, int32_t output_permutation,
+                  int32_t A1format, int32_t A2format, int32_t A3format,
+                  int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                  int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                  int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                  int Aval_rank, void *Aval_ptr,
+                  int32_t B1format, int32_t B2format, int32_t B3format,
+                  int B1pos_rank, void *B1pos_ptr, int B1crd_rank, void *B1crd_ptr,
+                  int B2pos_rank, void *B2pos_ptr, int B2crd_rank, void *B2crd_ptr,
+                  int B3pos_rank, void *B3pos_ptr, int B3crd_rank, void *B3crd_ptr,
+                  int Bval_rank, void *Bval_ptr, int sizes_rank, void *sizes_ptr)
+{
+  int32_t Aformats[3] = {A1format, A2format, A3format};
+  int32_t Bformats[3] = {B1format, B2format, B3format};
+  void *Aarrays[7] = {A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr, A3pos_ptr, A3crd_ptr, Aval_ptr};
+  void *Barrays[7] = {B1pos_ptr, B1crd_ptr, B2pos_ptr, B2crd_ptr, B3pos_ptr, B3crd_ptr, Bval_ptr};
+
+  transpose_ND<T>(3, input_permutation, output_permutation,
+                  Aformats, Aarrays, Bformats, Barrays, sizes_ptr);
 }
 
 // 2D tensors
@@ -1280,3 +1274,166 @@ extern "C" void transpose_3D_f64(int32_t input_permutation, int32_t output_permu
                        B3pos_rank, B3pos_ptr, B3crd_rank, B3crd_ptr,
                        Bval_rank, Bval_ptr, sizes_rank, sizes_ptr);
 }
+
+// 4D to 6D tensors: the same transpose as 3D, for any permutation
+extern "C" void transpose_4D_f32(int32_t input_permutation, int32_t output_permutation,
+                                 int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format,
+                                 int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                 int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                 int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                 int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                 int Aval_rank, void *Aval_ptr,
+                                 int32_t B1format, int32_t B2format, int32_t B3format, int32_t B4format,
+                                 int B1pos_rank, void *B1pos_ptr, int B1crd_rank, void *B1crd_ptr,
+                                 int B2pos_rank, void *B2pos_ptr, int B2crd_rank, void *B2crd_ptr,
+                                 int B3pos_rank, void *B3pos_ptr, int B3crd_rank, void *B3crd_ptr,
+                                 int B4pos_rank, void *B4pos_ptr, int B4crd_rank, void *B4crd_ptr,
+                                 int Bval_rank, void *Bval_ptr, int sizes_rank, void *sizes_ptr)
+{
+  int32_t Aformats[4] = {A1format, A2format, A3format, A4format};
+  int32_t Bformats[4] = {B1format, B2format, B3format, B4format};
+  void *Aarrays[9] = {A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr,
+                      A3pos_ptr, A3crd_ptr, A4pos_ptr, A4crd_ptr, Aval_ptr};
+  void *Barrays[9] = {B1pos_ptr, B1crd_ptr, B2pos_ptr, B2crd_ptr,
+                      B3pos_ptr, B3crd_ptr, B4pos_ptr, B4crd_ptr, Bval_ptr};
+
+  transpose_ND<float>(4, input_permutation, output_permutation,
+                      Aformats, Aarrays, Bformats, Barrays, sizes_ptr);
+}
+
+extern "C" void transpose_4D_f64(int32_t input_permutation, int32_t output_permutation,
+                                 int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format,
+                                 int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                 int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                 int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                 int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                 int Aval_rank, void *Aval_ptr,
+                                 int32_t B1format, int32_t B2format, int32_t B3format, int32_t B4format,
+                                 int B1pos_rank, void *B1pos_ptr, int B1crd_rank, void *B1crd_ptr,
+                                 int B2pos_rank, void *B2pos_ptr, int B2crd_rank, void *B2crd_ptr,
+                                 int B3pos_rank, void *B3pos_ptr, int B3crd_rank, void *B3crd_ptr,
+                                 int B4pos_rank, void *B4pos_ptr, int B4crd_rank, void *B4crd_ptr,
+                                 int Bval_rank, void *Bval_ptr, int sizes_rank, void *sizes_ptr)
+{
+  int32_t Aformats[4] = {A1format, A2format, A3format, A4format};
+  int32_t Bformats[4] = {B1format, B2format, B3format, B4format};
+  void *Aarrays[9] = {A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr,
+                      A3pos_ptr, A3crd_ptr, A4pos_ptr, A4crd_ptr, Aval_ptr};
+  void *Barrays[9] = {B1pos_ptr, B1crd_ptr, B2pos_ptr, B2crd_ptr,
+                      B3pos_ptr, B3crd_ptr, B4pos_ptr, B4crd_ptr, Bval_ptr};
+
+  transpose_ND<double>(4, input_permutation, output_permutation,
+                       Aformats, Aarrays, Bformats, Barrays, sizes_ptr);
+}
+
+extern "C" void transpose_5D_f32(int32_t input_permutation, int32_t output_permutation,
+                                 int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format,
+                                 int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                 int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                 int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                 int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                 int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                 int Aval_rank, void *Aval_ptr,
+                                 int32_t B1format, int32_t B2format, int32_t B3format, int32_t B4format, int32_t B5format,
+                                 int B1pos_rank, void *B1pos_ptr, int B1crd_rank, void *B1crd_ptr,
+                                 int B2pos_rank, void *B2pos_ptr, int B2crd_rank, void *B2crd_ptr,
+                                 int B3pos_rank, void *B3pos_ptr, int B3crd_rank, void *B3crd_ptr,
+                                 int B4pos_rank, void *B4pos_ptr, int B4crd_rank, void *B4crd_ptr,
+                                 int B5pos_rank, void *B5pos_ptr, int B5crd_rank, void *B5crd_ptr,
+                                 int Bval_rank, void *Bval_ptr, int sizes_rank, void *sizes_ptr)
+{
+  int32_t Aformats[5] = {A1format, A2format, A3format, A4format, A5format};
+  int32_t Bformats[5] = {B1format, B2format, B3format, B4format, B5format};
+  void *Aarrays[11] = {A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr, A3pos_ptr, A3crd_ptr,
+                       A4pos_ptr, A4crd_ptr, A5pos_ptr, A5crd_ptr, Aval_ptr};
+  void *Barrays[11] = {B1pos_ptr, B1crd_ptr, B2pos_ptr, B2crd_ptr, B3pos_ptr, B3crd_ptr,
+                       B4pos_ptr, B4crd_ptr, B5pos_ptr, B5crd_ptr, Bval_ptr};
+
+  transpose_ND<float>(5, input_permutation, output_permutation,
+                      Aformats, Aarrays, Bformats, Barrays, sizes_ptr);
+}
+
+extern "C" void transpose_5D_f64(int32_t input_permutation, int32_t output_permutation,
+                                 int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format,
+                                 int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                 int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                 int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                 int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                 int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                 int Aval_rank, void *Aval_ptr,
+                                 int32_t B1format, int32_t B2format, int32_t B3format, int32_t B4format, int32_t B5format,
+                                 int B1pos_rank, void *B1pos_ptr, int B1crd_rank, void *B1crd_ptr,
+                                 int B2pos_rank, void *B2pos_ptr, int B2crd_rank, void *B2crd_ptr,
+                                 int B3pos_rank, void *B3pos_ptr, int B3crd_rank, void *B3crd_ptr,
+                                 int B4pos_rank, void *B4pos_ptr, int B4crd_rank, void *B4crd_ptr,
+                                 int B5pos_rank, void *B5pos_ptr, int B5crd_rank, void *B5crd_ptr,
+                                 int Bval_rank, void *Bval_ptr, int sizes_rank, void *sizes_ptr)
+{
+  int32_t Aformats[5] = {A1format, A2format, A3format, A4format, A5format};
+  int32_t Bformats[5] = {B1format, B2format, B3format, B4format, B5format};
+  void *Aarrays[11] = {A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr, A3pos_ptr, A3crd_ptr,
+                       A4pos_ptr, A4crd_ptr, A5pos_ptr, A5crd_ptr, Aval_ptr};
+  void *Barrays[11] = {B1pos_ptr, B1crd_ptr, B2pos_ptr, B2crd_ptr, B3pos_ptr, B3crd_ptr,
+                       B4pos_ptr, B4crd_ptr, B5pos_ptr, B5crd_ptr, Bval_ptr};
+
+  transpose_ND<double>(5, input_permutation, output_permutation,
+                       Aformats, Aarrays, Bformats, Barrays, sizes_ptr);
+}
+
+extern "C" void transpose_6D_f32(int32_t input_permutation, int32_t output_permutation,
+                                 int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format,
+                                 int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                 int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                 int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                 int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                 int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                 int A6pos_rank, void *A6pos_ptr, int A6crd_rank, void *A6crd_ptr,
+                                 int Aval_rank, void *Aval_ptr,
+                                 int32_t B1format, int32_t B2format, int32_t B3format, int32_t B4format, int32_t B5format, int32_t B6format,
+                                 int B1pos_rank, void *B1pos_ptr, int B1crd_rank, void *B1crd_ptr,
+                                 int B2pos_rank, void *B2pos_ptr, int B2crd_rank, void *B2crd_ptr,
+                                 int B3pos_rank, void *B3pos_ptr, int B3crd_rank, void *B3crd_ptr,
+                                 int B4pos_rank, void *B4pos_ptr, int B4crd_rank, void *B4crd_ptr,
+                                 int B5pos_rank, void *B5pos_ptr, int B5crd_rank, void *B5crd_ptr,
+                                 int B6pos_rank, void *B6pos_ptr, int B6crd_rank, void *B6crd_ptr,
+                                 int Bval_rank, void *Bval_ptr, int sizes_rank, void *sizes_ptr)
+{
+  int32_t Aformats[6] = {A1format, A2format, A3format, A4format, A5format, A6format};
+  int32_t Bformats[6] = {B1format, B2format, B3format, B4format, B5format, B6format};
+  void *Aarrays[13] = {A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr, A3pos_ptr, A3crd_ptr,
+                       A4pos_ptr, A4crd_ptr, A5pos_ptr, A5crd_ptr, A6pos_ptr, A6crd_ptr, Aval_ptr};
+  void *Barrays[13] = {B1pos_ptr, B1crd_ptr, B2pos_ptr, B2crd_ptr, B3pos_ptr, B3crd_ptr,
+                       B4pos_ptr, B4crd_ptr, B5pos_ptr, B5crd_ptr, B6pos_ptr, B6crd_ptr, Bval_ptr};
+
+  transpose_ND<float>(6, input_permutation, output_permutation,
+                      Aformats, Aarrays, Bformats, Barrays, sizes_ptr);
+}
+
+extern "C" void transpose_6D_f64(int32_t input_permutation, int32_t output_permutation,
+                                 int32_t A1format, int32_t A2format, int32_t A3format, int32_t A4format, int32_t A5format, int32_t A6format,
+                                 int A1pos_rank, void *A1pos_ptr, int A1crd_rank, void *A1crd_ptr,
+                                 int A2pos_rank, void *A2pos_ptr, int A2crd_rank, void *A2crd_ptr,
+                                 int A3pos_rank, void *A3pos_ptr, int A3crd_rank, void *A3crd_ptr,
+                                 int A4pos_rank, void *A4pos_ptr, int A4crd_rank, void *A4crd_ptr,
+                                 int A5pos_rank, void *A5pos_ptr, int A5crd_rank, void *A5crd_ptr,
+                                 int A6pos_rank, void *A6pos_ptr, int A6crd_rank, void *A6crd_ptr,
+                                 int Aval_rank, void *Aval_ptr,
+                                 int32_t B1format, int32_t B2format, int32_t B3format, int32_t B4format, int32_t B5format, int32_t B6format,
+                                 int B1pos_rank, void *B1pos_ptr, int B1crd_rank, void *B1crd_ptr,
+                                 int B2pos_rank, void *B2pos_ptr, int B2crd_rank, void *B2crd_ptr,
+                                 int B3pos_rank, void *B3pos_ptr, int B3crd_rank, void *B3crd_ptr,
+                                 int B4pos_rank, void *B4pos_ptr, int B4crd_rank, void *B4crd_ptr,
+                                 int B5pos_rank, void *B5pos_ptr, int B5crd_rank, void *B5crd_ptr,
+                                 int B6pos_rank, void *B6pos_ptr, int B6crd_rank, void *B6crd_ptr,
+                                 int Bval_rank, void *Bval_ptr, int sizes_rank, void *sizes_ptr)
+{
+  int32_t Aformats[6] = {A1format, A2format, A3format, A4format, A5format, A6format};
+  int32_t Bformats[6] = {B1format, B2format, B3format, B4format, B5format, B6format};
+  void *Aarrays[13] = {A1pos_ptr, A1crd_ptr, A2pos_ptr, A2crd_ptr, A3pos_ptr, A3crd_ptr,
+                       A4pos_ptr, A4crd_ptr, A5pos_ptr, A5crd_ptr, A6pos_ptr, A6crd_ptr, Aval_ptr};
+  void *Barrays[13] = {B1pos_ptr, B1crd_ptr, B2pos_ptr, B2crd_ptr, B3pos_ptr, B3crd_ptr,
+                       B4pos_ptr, B4crd_ptr, B5pos_ptr, B5crd_ptr, B6pos_ptr, B6crd_ptr, Bval_ptr};
+
+  transpose_ND<double>(6, input_permutation, output_permutation,
+                       Aformats, Aarrays, Bformats, Barrays, sizes_ptr);
+}
@@ -21,72 +21,562 @@
 //
 //===----------------------------------------------------------------------===//
 //
-// Simple Blis subset interface implementation.
+// Simple Blis subset interface implementation: a BLIS-style GEMM driver that
+// packs the operands and runs the blocked loops around the micro-kernels.
 //
 //===----------------------------------------------------------------------===//
 
 #include "comet/ExecutionEngine/blis_interface.h"
 #include "comet/ExecutionEngine/generic_mkernel.h"
+#include "comet/ExecutionEngine/GemmBlocking.h"
+#include "comet/ExecutionEngine/ParallelUtils.h"
 
 #include <assert.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
 #include <iostream>
+#include <mutex>
+#include <string.h>
+#include <thread>
+#include <vector>
 
-extern "C" void _mlir_ciface_linalg_matmul_viewsxsxf64_viewsxsxf64_viewsxsxf64(
-    StridedMemRefType<double, 2> *A, StridedMemRefType<double, 2> *B,
-    StridedMemRefType<double, 2> *C)
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace
 {
-  if (A->strides[1] != B->strides[1] || A->strides[1] != C->strides[1] ||
-      A->strides[1] != 1 || A->sizes[0] < A->strides[1] ||
-      B->sizes[0] < B->strides[1] || C->sizes[0] < C->strides[1] ||
-      C->sizes[0] != A->sizes[0] || C->sizes[1] != B->sizes[1] ||
-      A->sizes[1] != B->sizes[0])
-  {
-    printMemRefMetaData(std::cerr, *A);
-    printMemRefMetaData(std::cerr, *B);
-    printMemRefMetaData(std::cerr, *C);
-    return;
+  // The BLIS gemm micro-kernel interface: C(m x n) := beta * C + alpha * A * B,
+  // with A packed in MR x k micro-panels and B in k x NR micro-panels. m and n
+  // may be smaller than MR and NR at the edges of C.
+  template <typename T>
+  using gemm_ukr_t = void (*)(dim_t m, dim_t n, dim_t k,
+                              T *alpha, T *a, T *b,
+                              T *beta, T *c, inc_t rs_c, inc_t cs_c,
+                              auxinfo_t *data, cntx_t *cntx);
+
+  // A micro-kernel and the blocking of the driver around it: blocking.mr and
+  // blocking.nr are the shape of the micro-kernel.
+  template <typename T>
+  struct GemmKernel
+  {
+    gemm_ukr_t<T> ukr;
+    GemmBlocking blocking;
+  };
+
+  // Arch-independent micro-kernel with the same interface: computes the full
+  // MR x NR block with the generic kernel, and adds its m x n part to C.
+  template <typename T, int64_t MR, int64_t NR>
+  void gemm_generic_ukr(dim_t m, dim_t n, dim_t k,
+                        T *alpha, T *a, T *b,
+                        T *beta, T *c, inc_t rs_c, inc_t cs_c,
+                        auxinfo_t *data, cntx_t *cntx)
+  {
+    T zero = 0;
+    T ab[MR * NR] = {0};
+    gemm_generic_noopt_mxn<T>(MR, NR, k, alpha, a, b, &zero, ab, NR, 1);
+
+    for (dim_t i = 0; i < m; i++)
+      for (dim_t j = 0; j < n; j++)
+        c[i * rs_c + j * cs_c] = ab[i * NR + j] + (*beta) * c[i * rs_c + j * cs_c];
+  }
+
+  // Buffer for packed panels, aligned to 64 bytes as the micro-kernels load
+  // the packed panels with aligned vector loads. Every thread has its own.
+  template <typename T>
+  T *getPackBuffer(std::vector<T> &buffer, size_t size)
+  {
+    size_t padding = 64 / sizeof(T);
+    if (buffer.size() < size + padding)
+      buffer.resize(size + padding);
+    uintptr_t address = reinterpret_cast<uintptr_t>(buffer.data());
+    return reinterpret_cast<T *>((address + 63) & ~(uintptr_t)63);
+  }
+
+  /**
+   * Packs the mc x kc block of A at a into micro-panels of MR rows, each
+   * stored column by column: ap[(i / MR) * MR * kc + l * MR + i % MR] =
+   * A(i, l). The rows of the last micro-panel past mc are zero.
+   */
+  template <typename T>
+  void packA(int64_t mc, int64_t kc, const T *a, int64_t rs_a, int64_t cs_a,
+             int64_t MR, T *ap)
+  {
+    for (int64_t ir = 0; ir < mc; ir += MR)
+    {
+      int64_t mr = std::min(MR, mc - ir);
+      for (int64_t l = 0; l < kc; l++)
+      {
+        const T *a_col = a + ir * rs_a + l * cs_a;
+        for (int64_t i = 0; i < mr; i++)
+          ap[i] = a_col[i * rs_a];
+        for (int64_t i = mr; i < MR; i++)
+          ap[i] = 0;
+        ap += MR;
+      }
+    }
+  }
+
+  /**
+   * Packs the kc x nc panel of B at b into micro-panels of NR columns, each
+   * stored row by row: bp[(j / NR) * NR * kc + l * NR + j % NR] = B(l, j).
+   * The columns of the last micro-panel past nc are zero.
+   */
+  template <typename T>
+  void packB(int64_t kc, int64_t nc, const T *b, int64_t rs_b, int64_t cs_b,
+             int64_t NR, T *bp)
+  {
+    for (int64_t jr = 0; jr < nc; jr += NR)
+    {
+      int64_t nr = std::min(NR, nc - jr);
+      for (int64_t l = 0; l < kc; l++)
+      {
+        const T *b_row = b + l * rs_b + jr * cs_b;
+        for (int64_t j = 0; j < nr; j++)
+          bp[j] = b_row[j * cs_b];
+        for (int64_t j = nr; j < NR; j++)
+          bp[j] = 0;
+        bp += NR;
+      }
+    }
+  }
+
+  /**
+   * C += A * B, for an m x k matrix A, a k x n matrix B and an m x n matrix
+   * C with any strides, by the five loops of BLIS around the micro-kernel:
+   *   jc: NC-wide panels of B and C
+   *   pc: KC-deep blocks of A and B; the KC x NC panel of B is packed
+   *   ic: MC-tall blocks of A and C; the MC x KC block of A is packed
+   *   jr: NR-wide micro-panels of the packed B
+   *   ir: MR-tall micro-panels of the packed A, multiplied by the micro-kernel
+   * The edge blocks of C are passed to the micro-kernel with their actual
+   * sizes.
+   */
+  template <typename T>
+  void gemmBlocked(int64_t m, int64_t n, int64_t k,
+                   const T *a, int64_t rs_a, int64_t cs_a,
+                   const T *b, int64_t rs_b, int64_t cs_b,
+                   T *c, int64_t rs_c, int64_t cs_c,
+                   const GemmKernel<T> &kernel)
+  {
+    static thread_local std::vector<T> a_buffer, b_buffer;
+    const GemmBlocking &blocking = kernel.blocking;
+    const int64_t MR = blocking.mr, NR = blocking.nr;
+    T one = 1;
+
+    for (int64_t jc = 0; jc < n; jc += blocking.nc)
+    {
+      int64_t nc = std::min(blocking.nc, n - jc);
+      int64_t nc_padded = (nc + NR - 1) / NR * NR;
+
+      for (int64_t pc = 0; pc < k; pc += blocking.kc)
+      {
+        int64_t kc = std::min(blocking.kc, k - pc);
+        T *bp = getPackBuffer(b_buffer, kc * nc_padded);
+        packB(kc, nc, b + pc * rs_b + jc * cs_b, rs_b, cs_b, NR, bp);
+
+        for (int64_t ic = 0; ic < m; ic += blocking.mc)
+        {
+          int64_t mc = std::min(blocking.mc, m - ic);
+          int64_t mc_padded = (mc + MR - 1) / MR * MR;
+          T *ap = getPackBuffer(a_buffer, mc_padded * kc);
+          packA(mc, kc, a + ic * rs_a + pc * cs_a, rs_a, cs_a, MR, ap);
+
+          for (int64_t jr = 0; jr < nc; jr += NR)
+          {
+            int64_t nr = std::min(NR, nc - jr);
+            for (int64_t ir = 0; ir < mc; ir += MR)
+            {
+              int64_t mr = std::min(MR, mc - ir);
+              kernel.ukr(mr, nr, kc, &one, ap + ir * kc, bp + jr * kc, &one,
+                         c + (ic + ir) * rs_c + (jc + jr) * cs_c, rs_c, cs_c,
+                         NULL, NULL);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  //===----------------------------------------------------------------------===//
+  // Thread pool of the GEMM driver
+  //===----------------------------------------------------------------------===//
+
+  // Number of threads of the GEMM driver: COMET_GEMM_NUM_THREADS, or the
+  // number of threads of the runtime library (COMET_NUM_THREADS). Read once,
+  // as a tiled matmul makes a library call per tile.
+  int getGemmNumThreads()
+  {
+    static const int num_threads = []()
+    {
+      int n = 0;
+      if (char *env = getenv("COMET_GEMM_NUM_THREADS"))
+        n = atoi(env);
+      return n > 0 ? n : getNumThreads();
+    }();
+
+    return num_threads;
+  }
+
+  // Pins the calling thread to the CPU of index tid among the num_threads
+  // threads of the pool, as selected by COMET_GEMM_AFFINITY: "compact" puts
+  // thread t on the t-th CPU the process may run on, "spread" spaces the
+  // threads evenly over these CPUs. Threads are not pinned otherwise.
+  void pinGemmThread(int tid, int num_threads)
+  {
+#ifdef __linux__
+    const char *env = getenv("COMET_GEMM_AFFINITY");
+    if (!env)
+      return;
+    bool compact = strcmp(env, "compact") == 0;
+    bool spread = strcmp(env, "spread") == 0;
+    if (!compact && !spread)
+      return;
+
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+      return;
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+      if (CPU_ISSET(cpu, &allowed))
+        cpus.push_back(cpu);
+    if (cpus.empty())
+      return;
+
+    int64_t index = compact ? tid : (int64_t)tid * cpus.size() / num_threads;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpus[index % cpus.size()], &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+  }
+
+  /**
+   * Persistent pool of the threads that run the GEMM driver, created at the
+   * first parallel GEMM so that later calls do not pay for starting threads.
+   * The calling thread takes part in the work as thread 0 and is not pinned,
+   * as the threads it creates would inherit its affinity. A GEMM called while
+   * the pool is busy (e.g., from several threads of the application) runs on
+   * its calling thread only.
+   */
+  class GemmThreadPool
+  {
+  public:
+    static GemmThreadPool &get()
+    {
+      static GemmThreadPool pool(getGemmNumThreads());
+      return pool;
+    }
+
+    int size() const { return (int)workers.size() + 1; }
+
+    // Calls func(task) for every task in [0, num_tasks), and returns when
+    // all of them are done
+    void run(int num_tasks, const std::function<void(int)> &func)
+    {
+      std::unique_lock<std::mutex> running(run_mutex, std::try_to_lock);
+      if (!running.owns_lock() || workers.empty() || num_tasks <= 1)
+      {
+        for (int task = 0; task < num_tasks; task++)
+          func(task);
+        return;
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &func;
+        job_tasks = num_tasks;
+        next_task = 0;
+        busy_workers = (int)workers.size();
+        generation++;
+      }
+      start_cv.notify_all();
+
+      runTasks(func, num_tasks);
+
+      std::unique_lock<std::mutex> lock(mutex);
+      done_cv.wait(lock, [this]()
+                   { return busy_workers == 0; });
+      job = NULL;
+    }
+
+    ~GemmThreadPool()
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+      }
+      start_cv.notify_all();
+      for (auto &worker : workers)
+        worker.join();
+    }
+
+  private:
+    GemmThreadPool(int num_threads)
+    {
+      for (int tid = 1; tid < num_threads; tid++)
+        workers.emplace_back([this, tid, num_threads]()
+                             { workerLoop(tid, num_threads); });
+    }
+
+    void runTasks(const std::function<void(int)> &func, int num_tasks)
+    {
+      for (int task = next_task++; task < num_tasks; task = next_task++)
+        func(task);
+    }
+
+    void workerLoop(int tid, int num_threads)
+    {
+      pinGemmThread(tid, num_threads);
+
+      uint64_t seen = 0;
+      while (true)
+      {
+        const std::function<void(int)> *func;
+        int num_tasks;
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          start_cv.wait(lock, [this, seen]()
+                        { return stop || generation != seen; });
+          if (stop)
+            return;
+          seen = generation;
+          func = job;
+          num_tasks = job_tasks;
+        }
+
+        runTasks(*func, num_tasks);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busy_workers == 0)
+          done_cv.notify_one();
+      }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex run_mutex; // held by the GEMM running on the pool
+    std::mutex mutex;     // protects the fields of the current job
+    std::condition_variable start_cv, done_cv;
+    const std::function<void(int)> *job = NULL;
+    int job_tasks = 0;
+    std::atomic<int> next_task{0};
+    int busy_workers = 0;
+    uint64_t generation = 0;
+    bool stop = false;
+  };
+
+  //===----------------------------------------------------------------------===//
+  // Selection of the micro-kernels
+  //===----------------------------------------------------------------------===//
+
+  // Family of micro-kernels that the host can run
+  enum class KernelFamily
+  {
+    GENERIC, // arch-independent kernels
+    HASWELL, // AVX2 kernels of BLIS haswell
+    SKX      // AVX-512 kernels
+  };
+
+  KernelFamily queryKernelFamily()
+  {
+    // get the micro-arch
+    switch (bli_cpuid_query_id())
+    {
+    case BLIS_ARCH_SKX:
+    case BLIS_ARCH_KNL:
+      return KernelFamily::SKX;
+    case BLIS_ARCH_HASWELL:
+    case BLIS_ARCH_ZEN:
+    case BLIS_ARCH_ZEN2:
+    case BLIS_ARCH_ZEN3:
+    {
+      // according to blis, the haswell gemm micro-kernels can be executed on
+      // these micro-archs. Hosts with AVX-512 that blis does not know as skx
+      // (e.g., Ice Lake, Sapphire Rapids, Zen 4, or skx parts with one FMA
+      // unit) are reported as haswell or zen3: use their AVX-512 too.
+      uint32_t family, model, features;
+      bli_cpuid_query(&family, &model, &features);
+      return (features & FEATURE_AVX512F) ? KernelFamily::SKX : KernelFamily::HASWELL;
+    }
+    default:
+      return KernelFamily::GENERIC;
+    }
+  }
+
+  // Blocking of the driver for an MR x NR micro-kernel on elements of T, from
+  // COMET_GEMM_BLOCKING: "host" (default), "haswell" or "MC,KC,NC" (see
+  // parseGemmBlocking)
+  template <typename T>
+  GemmBlocking getGemmBlocking(int64_t mr, int64_t nr)
+  {
+    const char *env = getenv("COMET_GEMM_BLOCKING");
+    GemmBlocking b;
+    if (!parseGemmBlocking(env ? env : "host", mr, nr, sizeof(T), getGemmNumThreads(), b))
+    {
+      std::cerr << "WARNING: invalid COMET_GEMM_BLOCKING " << env << ", using the blocking of the host\n";
+      parseGemmBlocking("host", mr, nr, sizeof(T), getGemmNumThreads(), b);
+    }
+    return b;
   }
 
-  double alpha = 1.0f;
-  double beta = 1.0f;
-  if (beta == -1.0)
+  // The dgemm micro-kernel of the host: AVX-512 14x16, Haswell 6x8, or the
+  // generic 6x8
+  GemmKernel<double> selectDgemmKernel(KernelFamily family)
   {
-    alpha *= -1.0;
-    beta = 1.0;
+    switch (family)
+    {
+    case KernelFamily::SKX:
+      return GemmKernel<double>{bli_dgemm_skx_avx512_14x16, getGemmBlocking<double>(14, 16)};
+    case KernelFamily::HASWELL:
+      return GemmKernel<double>{bli_dgemm_haswell_asm_6x8, getGemmBlocking<double>(6, 8)};
+    default:
+      //printf("WARNING: falling back to a generic gemm implementation that is arch-independent.\n");
+      return GemmKernel<double>{gemm_generic_ukr<double, 6, 8>, getGemmBlocking<double>(6, 8)};
+    }
   }
 
-  // get the micro-arch
-  arch_t id     = bli_cpuid_query_id();
-  const char* s = bli_arch_string(id);
-
-
-  // check the micro-arch and call the micro-kernel accordingly.
-  // according to blis, the haswell dgemm micro-kernel can be executed on multiple micro-archs.
-  if ( (strcmp("haswell",s) == 0) || 
-       (strcmp("zen", s) == 0) || (strcmp("zen2", s) == 0) || (strcmp("zen3", s) == 0) || 
-       (strcmp("skx", s) == 0) || (strcmp("knl", s) == 0) )
-  {  
-    bli_dgemm_haswell_asm_6x8 ( A->sizes[0], // m
-    			        B->sizes[1], // n
-    				A->sizes[1], // k
-    				&alpha, 
-                                A->data + A->offset,
-    				B->data + B->offset, 
-                                &beta,
-    				C->data + C->offset, C->strides[0], C->strides[1],
-    				NULL, NULL);
+  // The sgemm micro-kernel of the host: Haswell 6x16, or the generic 6x16
+  GemmKernel<float> selectSgemmKernel(KernelFamily family)
+  {
+    if (family == KernelFamily::GENERIC)
+      return GemmKernel<float>{gemm_generic_ukr<float, 6, 16>, getGemmBlocking<float>(6, 16)};
+    return GemmKernel<float>{bli_sgemm_haswell_asm_6x16, getGemmBlocking<float>(6, 16)};
   }
-  else
-  {
-    //printf("WARNING: falling back to a generic gemm implementation that is arch-independent.\n");
-    dgemm_generic_noopt_mxn ( (int64_t) A->sizes[0], // m
-			      (int64_t) B->sizes[1], // n
-			      (int64_t) A->sizes[1], // k
-                              &alpha, 
-                              A->data + A->offset,
-                              B->data + B->offset, 
-                              &beta,
-                              C->data + C->offset,
-                              (int64_t) C->strides[0], (int64_t) C->strides[1] ); 
-   }
+
+  // The micro-kernels are selected once, when the library is loaded
+  const KernelFamily host_kernel_family = queryKernelFamily();
+  const GemmKernel<double> host_dgemm_kernel = selectDgemmKernel(host_kernel_family);
+  const GemmKernel<float> host_sgemm_kernel = selectSgemmKernel(host_kernel_family);
+
+  template <typename T>
+  const GemmKernel<T> &getGemmKernel();
+
+  template <>
+  const GemmKernel<double> &getGemmKernel<double>() { return host_dgemm_kernel; }
+
+  template <>
+  const GemmKernel<float> &getGemmKernel<float>() { return host_sgemm_kernel; }
+
+  // Range [begin, end) of part i of a dimension of the given size split into
+  // num_parts parts, the parts starting at multiples of unit
+  void partRange(int64_t size, int64_t unit, int num_parts, int i,
+                 int64_t &begin, int64_t &end)
+  {
+    int64_t units = (size + unit - 1) / unit;
+    begin = std::min(size, units * i / num_parts * unit);
+    end = std::min(size, units * (i + 1) / num_parts * unit);
+  }
+
+  /**
+   * C += A * B on the GEMM thread pool. The NC and MC loops of the driver are
+   * split over the threads: C is cut into ways_m x ways_n blocks of whole
+   * micro-tiles, and every thread runs the blocked driver on its own block,
+   * packing its own panels of A and B. The ways are chosen to make the blocks
+   * as square as possible, which minimizes the packing every thread does.
+   * Small products run on the calling thread only.
+   */
+  template <typename T>
+  void gemmParallel(int64_t m, int64_t n, int64_t k,
+                    const T *a, int64_t rs_a, int64_t cs_a,
+                    const T *b, int64_t rs_b, int64_t cs_b,
+                    T *c, int64_t rs_c, int64_t cs_c)
+  {
+    const GemmKernel<T> &kernel = getGemmKernel<T>();
+    const GemmBlocking &blocking = kernel.blocking;
+    int64_t m_tiles = (m + blocking.mr - 1) / blocking.mr;
+    int64_t n_tiles = (n + blocking.nr - 1) / blocking.nr;
+    // smallest number of multiply-adds worth giving to a thread: one block of
+    // A by one micro-panel of B
+    int64_t work = m * n * k / (blocking.mc * blocking.kc * blocking.nr);
+    int num_threads = (int)std::min<int64_t>(std::min<int64_t>(work, m_tiles * n_tiles),
+                                             getGemmNumThreads());
+    if (num_threads <= 1)
+    {
+      gemmBlocked(m, n, k, a, rs_a, cs_a, b, rs_b, cs_b, c, rs_c, cs_c, kernel);
+      return;
+    }
+
+    GemmThreadPool &pool = GemmThreadPool::get();
+    num_threads = std::min(num_threads, pool.size());
+
+    // the factorization of the number of threads with the squarest blocks
+    int ways_m = 1, ways_n = 1;
+    for (; num_threads > 1; num_threads--)
+    {
+      double best = -1.0;
+      for (int wm = 1; wm <= num_threads; wm++)
+      {
+        int wn = num_threads / wm;
+        if (wm * wn != num_threads || wm > m_tiles || wn > n_tiles)
+          continue;
+        double perimeter = (double)m / wm + (double)n / wn;
+        if (best < 0.0 || perimeter < best)
+        {
+          best = perimeter;
+          ways_m = wm;
+          ways_n = wn;
+        }
+      }
+      if (best >= 0.0)
+        break;
+    }
+
+    pool.run(ways_m * ways_n, [&](int task)
+             {
+               int64_t i_begin, i_end, j_begin, j_end;
+               partRange(m, blocking.mr, ways_m, task % ways_m, i_begin, i_end);
+               partRange(n, blocking.nr, ways_n, task / ways_m, j_begin, j_end);
+               if (i_begin == i_end || j_begin == j_end)
+                 return;
+               gemmBlocked(i_end - i_begin, j_end - j_begin, k,
+                           a + i_begin * rs_a, rs_a, cs_a,
+                           b + j_begin * cs_b, rs_b, cs_b,
+                           c + i_begin * rs_c + j_begin * cs_c, rs_c, cs_c,
+                           kernel);
+             });
+  }
+
+  // linalg.matmul library call: C += A * B, for operands of any sizes and
+  // strides (e.g., the subviews of a tiled matmul, or whole matrices).
+  template <typename T>
+  void linalgMatmul(StridedMemRefType<T, 2> *A, StridedMemRefType<T, 2> *B,
+                    StridedMemRefType<T, 2> *C)
+  {
+    if (C->sizes[0] != A->sizes[0] || C->sizes[1] != B->sizes[1] ||
+        A->sizes[1] != B->sizes[0])
+    {
+      printMemRefMetaData(std::cerr, *A);
+      printMemRefMetaData(std::cerr, *B);
+      printMemRefMetaData(std::cerr, *C);
+      return;
+    }
+
+    int64_t m = A->sizes[0];
+    int64_t n = B->sizes[1];
+    int64_t k = A->sizes[1];
+    if (m == 0 || n == 0 || k == 0)
+      return;
+
+    gemmParallel(m, n, k,
+                 A->data + A->offset, A->strides[0], A->strides[1],
+                 B->data + B->offset, B->strides[0], B->strides[1],
+                 C->data + C->offset, C->strides[0], C->strides[1]);
+  }
+} // end anonymous namespace
+
+extern "C" void _mlir_ciface_linalg_matmul_viewsxsxf64_viewsxsxf64_viewsxsxf64(
+    StridedMemRefType<double, 2> *A, StridedMemRefType<double, 2> *B,
+    StridedMemRefType<double, 2> *C)
+{
+  linalgMatmul(A, B, C);
+}
+
+extern "C" void _mlir_ciface_linalg_matmul_viewsxsxf32_viewsxsxf32_viewsxsxf32(
+    StridedMemRefType<float, 2> *A, StridedMemRefType<float, 2> *B,
+    StridedMemRefType<float, 2> *C)
+{
+  linalgMatmul(A, B, C);
 }
@@ -0,0 +1,132 @@
+//===- bli_gemm_skx_avx512_d14x16.c - AVX-512 dgemm micro-kernel ---------===//
+//
+// Copyright 2022 Battelle Memorial Institute
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+// and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+// and the following disclaimer in the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//===----------------------------------------------------------------------===//
+
+// COMET: AVX-512 dgemm micro-kernel for the skx family (Skylake-X, Ice Lake,
+// Sapphire Rapids, Zen 4, ...), written with intrinsics after the 14x16
+// shape of the BLIS skx kernels: a 14 x 16 block of C is kept in 28 zmm
+// registers, the rows of a packed micro-panel of B are loaded as two zmm
+// registers, and the elements of A are broadcast. The function is compiled
+// for AVX-512 whatever the flags of the library, so it must only be called
+// on hosts that support it (see bli_cpuid_query).
+
+// COMET: Since we do not use all the functions, suppress compiler warnings.
+#ifdef __clang__
+  #pragma clang diagnostic push
+  #pragma clang diagnostic ignored "-Wunused-function"
+  #include "comet/blis/blis.h"
+  #pragma clang diagnostic pop
+#endif
+
+#ifdef __GNUC__
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wunused-function"
+  #pragma GCC diagnostic ignored "-Wtype-limits"
+  #include "comet/blis/blis.h"
+  #pragma GCC diagnostic pop
+#endif
+
+#include <immintrin.h>
+
+#define MR 14
+#define NR 16
+
+// c[i] += a(i, l) * b(l, 0..15), for the 14 rows i of the micro-tile
+#define RANK1_ROW(i) \
+	ai = _mm512_set1_pd( a[ i ] ); \
+	c##i##0 = _mm512_fmadd_pd( ai, b0, c##i##0 ); \
+	c##i##1 = _mm512_fmadd_pd( ai, b1, c##i##1 );
+
+// ct(i, 0..15) = alpha * c[i]
+#define STORE_ROW(i) \
+	_mm512_storeu_pd( ct + i * NR,     _mm512_mul_pd( alphav, c##i##0 ) ); \
+	_mm512_storeu_pd( ct + i * NR + 8, _mm512_mul_pd( alphav, c##i##1 ) );
+
+#define FOR_ROWS(M) \
+	M(0) M(1) M(2) M(3) M(4) M(5) M(6) \
+	M(7) M(8) M(9) M(10) M(11) M(12) M(13)
+
+#define DECLARE_ROW(i) __m512d c##i##0 = _mm512_setzero_pd(), c##i##1 = _mm512_setzero_pd();
+
+__attribute__((target("avx512f")))
+void bli_dgemm_skx_avx512_14x16
+     (
+       dim_t               m,
+       dim_t               n,
+       dim_t               k,
+       double*    restrict alpha,
+       double*    restrict a,
+       double*    restrict b,
+       double*    restrict beta,
+       double*    restrict c, inc_t rs_c, inc_t cs_c,
+       auxinfo_t* restrict data,
+       cntx_t*    restrict cntx
+     )
+{
+	FOR_ROWS( DECLARE_ROW )
+	__m512d ai, b0, b1;
+
+	for ( dim_t l = 0; l < k; ++l )
+	{
+		b0 = _mm512_load_pd( b );
+		b1 = _mm512_load_pd( b + 8 );
+
+		FOR_ROWS( RANK1_ROW )
+
+		a += MR;
+		b += NR;
+	}
+
+	// Scale the micro-tile by alpha into ct, then update C with it.
+	__m512d alphav = _mm512_set1_pd( *alpha );
+	double ct[ MR * NR ] __attribute__((aligned(64)));
+	FOR_ROWS( STORE_ROW )
+
+	if ( m == MR && n == NR && cs_c == 1 )
+	{
+		// Full micro-tile with contiguous rows of C: vector updates.
+		__m512d betav = _mm512_set1_pd( *beta );
+		for ( dim_t i = 0; i < MR; ++i )
+		{
+			double* restrict ci = c + i * rs_c;
+			__m512d t0 = _mm512_load_pd( ct + i * NR );
+			__m512d t1 = _mm512_load_pd( ct + i * NR + 8 );
+			if ( *beta != 0.0 )
+			{
+				t0 = _mm512_fmadd_pd( betav, _mm512_loadu_pd( ci ), t0 );
+				t1 = _mm512_fmadd_pd( betav, _mm512_loadu_pd( ci + 8 ), t1 );
+			}
+			_mm512_storeu_pd( ci, t0 );
+			_mm512_storeu_pd( ci + 8, t1 );
+		}
+		return;
+	}
+
+	// Edge micro-tiles and general strides: update the m x n part of C.
+	for ( dim_t i = 0; i < m; ++i )
+		for ( dim_t j = 0; j < n; ++j )
+		{
+			double* restrict cij = c + i * rs_c + j * cs_c;
+			*cij = ( *beta == 0.0 ) ? ct[ i * NR + j ]
+			                        : ct[ i * NR + j ] + ( *beta ) * ( *cij );
+		}
+}
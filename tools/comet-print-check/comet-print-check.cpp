@@ -0,0 +1,240 @@
+//===- comet-print-check.cpp - Reader of binary print dumps ---------------===//
+//
+// Copyright 2022 Battelle Memorial Institute
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of conditions
+// and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions
+// and the following disclaimer in the documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED
+// WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+// PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+//===----------------------------------------------------------------------===//
+//
+// Reads the records written by comet_print_memref_* in the binary dump mode
+// (COMET_PRINT_BINARY).
+//
+//   comet-print-check dump           prints the records as the text print mode
+//                                    does, e.g., to check them with FileCheck
+//   comet-print-check dump1 dump2    compares the records of two dumps and
+//                                    exits with 1 at the first difference
+//
+// Floating-point elements are compared with -rtol=<r> (default: 1e-12) and
+// -atol=<a> (default: 0), integer elements exactly.
+//
+//===----------------------------------------------------------------------===//
+
+#include "comet/ExecutionEngine/RunnerUtils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+  /// One record of a dump
+  struct DumpRecord
+  {
+    CometPrintDumpHeader header;
+    std::vector<int64_t> sizes;
+    const char *data; // points into the dump
+  };
+
+  /// All the records of a dump file
+  struct Dump
+  {
+    std::string filename;
+    std::vector<char> bytes;
+    std::vector<DumpRecord> records;
+
+    bool read(const std::string &name)
+    {
+      filename = name;
+      FILE *fp = fopen(name.c_str(), "rb");
+      if (!fp)
+      {
+        fprintf(stderr, "Cannot open %s\n", name.c_str());
+        return false;
+      }
+      char buf[1 << 16];
+      size_t n;
+      while ((n = fread(buf, 1, sizeof(buf), fp)) > 0)
+        bytes.insert(bytes.end(), buf, buf + n);
+      fclose(fp);
+
+      size_t pos = 0;
+      while (pos < bytes.size())
+      {
+        DumpRecord record;
+        if (bytes.size() - pos < sizeof(CometPrintDumpHeader))
+          return error(pos, "truncated header");
+        memcpy(&record.header, &bytes[pos], sizeof(CometPrintDumpHeader));
+        if (memcmp(record.header.magic, COMET_PRINT_DUMP_MAGIC, sizeof(record.header.magic)) != 0)
+          return error(pos, "not a print dump record");
+        if (record.header.version != COMET_PRINT_DUMP_VERSION)
+          return error(pos, "unsupported version");
+        if (record.header.type > PRINT_DUMP_I32 || record.header.rank < 0)
+          return error(pos, "corrupted header");
+        pos += sizeof(CometPrintDumpHeader);
+
+        int64_t rank = record.header.rank;
+        if ((int64_t)(bytes.size() - pos) < rank * (int64_t)sizeof(int64_t))
+          return error(pos, "truncated sizes");
+        record.sizes.resize(rank);
+        memcpy(record.sizes.data(), &bytes[pos], rank * sizeof(int64_t));
+        pos += rank * sizeof(int64_t);
+
+        int64_t data_bytes = record.header.num_elements * cometPrintDumpElementBytes(record.header.type);
+        if ((int64_t)(bytes.size() - pos) < data_bytes)
+          return error(pos, "truncated elements");
+        record.data = &bytes[pos];
+        pos += data_bytes;
+        records.push_back(record);
+      }
+      return true;
+    }
+
+    bool error(size_t pos, const char *msg)
+    {
+      fprintf(stderr, "%s: %s at byte %zu\n", filename.c_str(), msg, pos);
+      return false;
+    }
+  };
+
+  template <typename T>
+  T element(const DumpRecord &record, int64_t i)
+  {
+    T value;
+    memcpy(&value, record.data + i * sizeof(T), sizeof(T));
+    return value;
+  }
+
+  /// Prints a record as cometPrint does
+  void printRecord(const DumpRecord &record)
+  {
+    std::cout << "data = " << std::endl;
+    for (int64_t i = 0; i < record.header.num_elements; i++)
+    {
+      switch (record.header.type)
+      {
+      case PRINT_DUMP_F64:
+        std::cout << element<double>(record, i) << ",";
+        break;
+      case PRINT_DUMP_I64:
+        std::cout << element<int64_t>(record, i) << ",";
+        break;
+      case PRINT_DUMP_I32:
+        std::cout << element<int32_t>(record, i) << ",";
+        break;
+      }
+    }
+    std::cout << "\n";
+  }
+
+  /// Compares record r of two dumps, reporting the first difference
+  bool compareRecords(const DumpRecord &a, const DumpRecord &b, size_t r,
+                      double rtol, double atol)
+  {
+    if (a.header.type != b.header.type)
+    {
+      printf("record %zu: element types differ (%u vs %u)\n", r, a.header.type, b.header.type);
+      return false;
+    }
+    if (a.sizes != b.sizes)
+    {
+      printf("record %zu: shapes differ\n", r);
+      return false;
+    }
+    for (int64_t i = 0; i < a.header.num_elements; i++)
+    {
+      bool equal;
+      if (a.header.type == PRINT_DUMP_F64)
+      {
+        double x = element<double>(a, i), y = element<double>(b, i);
+        equal = (x == y) || (std::isnan(x) && std::isnan(y)) ||
+                std::fabs(x - y) <= atol + rtol * std::max(std::fabs(x), std::fabs(y));
+        if (!equal)
+          printf("record %zu, element %ld: %.17g vs %.17g\n", r, (long)i, x, y);
+      }
+      else if (a.header.type == PRINT_DUMP_I64)
+      {
+        equal = element<int64_t>(a, i) == element<int64_t>(b, i);
+        if (!equal)
+          printf("record %zu, element %ld: %ld vs %ld\n", r, (long)i,
+                 (long)element<int64_t>(a, i), (long)element<int64_t>(b, i));
+      }
+      else
+      {
+        equal = element<int32_t>(a, i) == element<int32_t>(b, i);
+        if (!equal)
+          printf("record %zu, element %ld: %d vs %d\n", r, (long)i,
+                 element<int32_t>(a, i), element<int32_t>(b, i));
+      }
+      if (!equal)
+        return false;
+    }
+    return true;
+  }
+} // end anonymous namespace
+
+int main(int argc, char **argv)
+{
+  double rtol = 1e-12, atol = 0.0;
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; i++)
+  {
+    if (strncmp(argv[i], "-rtol=", 6) == 0)
+      rtol = atof(argv[i] + 6);
+    else if (strncmp(argv[i], "-atol=", 6) == 0)
+      atol = atof(argv[i] + 6);
+    else
+      files.push_back(argv[i]);
+  }
+  if (files.size() != 1 && files.size() != 2)
+  {
+    fprintf(stderr, "usage: %s dump [dump2] [-rtol=<r>] [-atol=<a>]\n", argv[0]);
+    return 2;
+  }
+
+  Dump a;
+  if (!a.read(files[0]))
+    return 2;
+
+  if (files.size() == 1)
+  {
+    for (auto &record : a.records)
+      printRecord(record);
+    return 0;
+  }
+
+  Dump b;
+  if (!b.read(files[1]))
+    return 2;
+  if (a.records.size() != b.records.size())
+  {
+    printf("number of records differ (%zu vs %zu)\n", a.records.size(), b.records.size());
+    return 1;
+  }
+  for (size_t r = 0; r < a.records.size(); r++)
+  {
+    if (!compareRecords(a.records[r], b.records[r], r, rtol, atol))
+      return 1;
+  }
+  printf("%zu records match\n", a.records.size());
+  return 0;
+}